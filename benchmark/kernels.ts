@@ -0,0 +1,182 @@
+import * as Benchmark from 'benchmark';
+import * as fs from 'fs';
+import * as path from 'path';
+import { CLIB, Position } from '../src/position';
+
+/**
+ * Benchmarks each native kernel of the addon, and records its throughput under
+ * the build variant the addon was compiled with.
+ *
+ * ```
+ * npm run bench              # the portable build
+ * npm run bench -- native    # after `npm run compile:native`
+ * ```
+ *
+ * Results are kept per variant in `benchmark/results.json`, and every run
+ * prints the gain of each kernel over the portable build, once it has been
+ * recorded. The same suite drives profile collection for `compile:pgo`.
+ */
+const variant =
+  process.argv[2] || process.env.npm_config_build_variant || 'portable';
+const resultsFile = path.join(__dirname, 'results.json');
+
+/**
+ * Generates reproducible points, so that every variant (and every profiling
+ * run) measures the same work.
+ *
+ * @param {number} count Number of points
+ * @param {number} scale Range of each coordinate
+ * @return {Array} 2D Array of points
+ */
+function points(count: number, scale: number = 100): Array<Array<number>> {
+  let seed = 42;
+  const next = () => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return (seed / 2147483648) * scale;
+  };
+  const set = [];
+  for (let i = 0; i < count; ++i) {
+    set.push([next(), next()]);
+  }
+  return set;
+}
+
+const code = (c: string) => c.charCodeAt(0);
+const cloud = points(1000);
+const cities = points(200, 60);
+const small = points(16);
+const medium = points(24);
+const large = points(300);
+const sprawl = points(20000);
+const stops = points(120);
+const demands = stops.map((_, i) => (i ? 1 + (i % 3) : 0));
+const samples = points(500).sort((a, b) => a[0] - b[0]);
+const xs = new Float64Array(1 << 20).map((_, i) => i / (1 << 20));
+const ys = new Float64Array(xs.length);
+const slopes = new Float64Array(xs.length);
+const timestamps = new Float64Array(500).map((_, i) => i / 500);
+const series = new Float64Array(500 * 2000).map((_, i) => (i % 500) % 7);
+const track = Array.from(timestamps, (t, i) => [
+  t,
+  t * t + (i % 10 < 3 ? 5 : 0),
+]);
+const groups = [];
+for (let g = 0; g < 1000; ++g) {
+  groups.push(cloud.slice(g % 980, (g % 980) + 4 + (g % 9)));
+}
+const batch = Position.pack(groups);
+const index = new CLIB.SpatialIndex(cloud, code('t'));
+const route = new CLIB.Tour(points(2000), 0, code('t'), code('o'), 0);
+
+const suite = new Benchmark.Suite();
+suite
+  .add('mean', () => CLIB.mean(cloud))
+  .add('distance (1000)', () =>
+    CLIB.distance(cloud, [50, 50], code('m'), false),
+  )
+  .add('distance typed (1000)', () =>
+    CLIB.distance(cloud, [50, 50], code('m'), true),
+  )
+  .add('nearest 10 (1000)', () => index.nearest([50, 50], 10, false))
+  .add('within 10 (1000)', () => index.within([50, 50], 10, false))
+  .add('assign (20000 to 16)', () =>
+    CLIB.assign(sprawl, small, code('t'), true),
+  )
+  .add('assign (20000 to 1000)', () =>
+    CLIB.assign(sprawl, cloud, code('t'), true),
+  )
+  .add('geometric (l2)', () =>
+    CLIB.geometric(cloud, false, 1e-3, 10, code('t')),
+  )
+  .add('geometric (l1)', () =>
+    CLIB.geometric(cloud, false, 1e-3, 10, code('n')),
+  )
+  .add('geometric (haversine)', () =>
+    CLIB.geometric(cities, false, 1e-3, 10, code('h')),
+  )
+  .add('summary (1000)', () =>
+    CLIB.summary(cloud, false, 1e-3, 10, code('t')),
+  )
+  .add('minimax (l2)', () => CLIB.minimax(cloud, code('t'), false))
+  .add('minimax (haversine)', () => CLIB.minimax(cities, code('h'), false))
+  .add('medoid (20000, l2)', () =>
+    CLIB.medoid(sprawl, false, 1e-3, 10, code('t')),
+  )
+  .add('medoid (20000, l1)', () =>
+    CLIB.medoid(sprawl, false, 1e-3, 10, code('n')),
+  )
+  .add('tsp held-karp (16)', () => CLIB.tsp(small, 0, code('t'), code('o'), 0))
+  .add('tsp branch-and-bound (24)', () =>
+    CLIB.tsp(medium, 0, code('t'), code('c'), 0),
+  )
+  .add('tsp branch-and-bound (24, 1 ms deadline)', () =>
+    CLIB.tsp(medium, 0, code('t'), code('c'), 0, undefined, false, false, 1),
+  )
+  .add('tsp 2-opt (300)', () => CLIB.tsp(large, 0, code('t'), code('c'), 0))
+  .add('tsp hilbert curve (300)', () =>
+    CLIB.tsp(large, 0, code('t'), code('c'), 0, undefined, false, true),
+  )
+  .add('tsp hilbert curve (20000)', () =>
+    CLIB.tsp(sprawl, 0, code('t'), code('c'), 0, undefined, false, true),
+  )
+  .add('tour add and remove stop (2000)', () => {
+    route.addStop([50, 50], 8);
+    route.removeStop(2000, 8);
+  })
+  .add('vrp (120)', () => CLIB.vrp(stops, 4, 60, demands, 0, code('n')))
+  .add('best fit (500)', () => CLIB.bestFit(samples, 5))
+  .add('best fit batch (2000 series of 500)', () =>
+    CLIB.bestFitBatch(timestamps, series, 5),
+  )
+  .add('robust fit tukey (500, 30% outliers)', () =>
+    CLIB.robustFit(track, 2, code('t'), 0, 0, 0),
+  )
+  .add('robust fit ransac (500, 30% outliers)', () =>
+    CLIB.robustFit(track, 2, code('r'), 0, 0, 0),
+  )
+  .add('evaluate polynomial (1M)', () =>
+    CLIB.evalPolynomial([1, -2, 3, -4, 5, -6], xs, ys, slopes),
+  )
+  .add('geometric per call (1000 sets)', () =>
+    groups.forEach((group) =>
+      CLIB.geometric(group, false, 1e-3, 10, code('t')),
+    ),
+  )
+  .add('geometric batch (1000 sets)', () =>
+    CLIB.geometricBatch(
+      batch.points,
+      batch.offsets,
+      false,
+      1e-3,
+      10,
+      code('t'),
+    ),
+  )
+  .add('tsp per call (1000 sets)', () =>
+    groups.forEach((group) => CLIB.tsp(group, 0, code('t'), code('c'), 0)),
+  )
+  .add('tsp batch (1000 sets)', () =>
+    CLIB.tspBatch(batch.points, batch.offsets, 0, code('t'), code('c'), 0),
+  )
+  .on('cycle', (event) => console.log(String(event.target)))
+  .on('complete', function() {
+    const results = fs.existsSync(resultsFile)
+      ? JSON.parse(fs.readFileSync(resultsFile, 'utf8'))
+      : {};
+    results[variant] = {};
+    this.forEach((bench) => (results[variant][bench.name] = bench.hz));
+    fs.writeFileSync(resultsFile, JSON.stringify(results, null, 2) + '\n');
+
+    const baseline = results['portable'];
+    if (variant === 'portable' || !baseline) {
+      return;
+    }
+    console.log(`\ngain of ${variant} over portable:`);
+    Object.keys(results[variant]).forEach((name) => {
+      if (baseline[name]) {
+        const gain = results[variant][name] / baseline[name];
+        console.log(`  ${name}: ${gain.toFixed(2)}x`);
+      }
+    });
+  })
+  .run();
@@ -0,0 +1,109 @@
+import * as os from 'os';
+import * as path from 'path';
+
+/**
+ * Measures how the throughput of native work scales when it is fanned out
+ * across worker threads, each of which loads its own copy of the addon.
+ *
+ * ```
+ * npm run bench:workers            # up to one worker per core
+ * npm run bench:workers -- 8       # up to 8 workers
+ * ```
+ *
+ * Node 10 only has worker threads behind a flag:
+ *
+ * ```
+ * node --experimental-worker ./node_modules/.bin/ts-node benchmark/workers.ts
+ * ```
+ */
+let threads;
+try {
+  threads = require('worker_threads');
+} catch (e) {
+  console.log('worker threads are not available in this version of Node');
+  process.exit(0);
+}
+
+const maxWorkers = Number(process.argv[2]) || os.cpus().length;
+const jobs = 2400;
+
+const source = `
+  const { parentPort, workerData } = require('worker_threads');
+  const CLIB = require(workerData.bindings)({
+    bindings: 'api',
+    module_root: workerData.root,
+  });
+
+  let seed = 42;
+  const next = () => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return (seed / 2147483648) * 100;
+  };
+  const set = [];
+  for (let i = 0; i < 400; ++i) {
+    set.push([next(), next()]);
+  }
+
+  parentPort.on('message', (count) => {
+    for (let j = 0; j < count; ++j) {
+      CLIB.geometric(set, false, 1e-3, 10, 't'.charCodeAt(0));
+      CLIB.tsp(set.slice(0, 60), 0, 't'.charCodeAt(0), 'c'.charCodeAt(0), 0);
+    }
+    parentPort.postMessage(count);
+  });
+  parentPort.postMessage(0);
+`;
+const workerData = {
+  bindings: require.resolve('bindings'),
+  root: path.join(__dirname, '..'),
+};
+
+/**
+ * Starts a worker, resolving once it has loaded the addon.
+ *
+ * @return {Promise} The ready worker
+ */
+function spawn(): Promise<any> {
+  return new Promise((resolve, reject) => {
+    const worker = new threads.Worker(source, { eval: true, workerData });
+    worker.once('message', () => resolve(worker));
+    worker.once('error', reject);
+  });
+}
+
+/**
+ * Splits a fixed number of jobs across a number of workers.
+ *
+ * @param {number} count Number of workers
+ * @return {Promise} Jobs completed per second
+ */
+async function measure(count: number): Promise<number> {
+  const workers = await Promise.all(Array.from({ length: count }, spawn));
+  const start = process.hrtime();
+  await Promise.all(
+    workers.map(
+      (worker, w) =>
+        new Promise((resolve) => {
+          worker.once('message', resolve);
+          worker.postMessage(
+            Math.floor(jobs / count) + (w < jobs % count ? 1 : 0),
+          );
+        }),
+    ),
+  );
+  const [seconds, nanoseconds] = process.hrtime(start);
+  await Promise.all(workers.map((worker) => worker.terminate()));
+  return jobs / (seconds + nanoseconds / 1e9);
+}
+
+(async () => {
+  let single;
+  for (let count = 1; count <= maxWorkers; count *= 2) {
+    const hz = await measure(count);
+    single = single || hz;
+    console.log(
+      `${count} worker(s): ${hz.toFixed(1)} jobs/s, ` +
+        `${(hz / single).toFixed(2)}x over one worker`,
+    );
+  }
+})();
@@ -1,13 +1,48 @@
 {
     'variables': {
+        'variables': {
+            # portable, native, pgo-generate, or pgo-use; picked at install
+            # time with `npm install --build_variant=<variant>`
+            'build_variant%':
+                '<!(node -p "process.env.npm_config_build_variant || \'portable\'")',
+            'PGO_DIR%': '<(module_root_dir)/.pgo',
+            # static_library or shared_library; the kind of the standalone C
+            # library, picked with `npm install --library_type=<type>`
+            'library_type%':
+                '<!(node -p "process.env.npm_config_library_type || \'static_library\'")'
+        },
+        'build_variant%': '<(build_variant)',
+        'library_type%': '<(library_type)',
         'FLAGS':
             '-Wall -Werror -Wextra\
              -Wno-unused-parameter\
              -Wshadow -Wfloat-equal -Wpointer-arith\
              -Wstrict-prototypes\
-             -pedantic -pedantic-errors\
-             -O2'
-
+             -pedantic -pedantic-errors',
+        'conditions': [
+            ['build_variant=="native"', {
+                'OPT_FLAGS': '-O3 -march=native -flto',
+                'LINK_FLAGS': '-O3 -march=native -flto'
+            }],
+            ['build_variant=="pgo-generate"', {
+                'OPT_FLAGS':
+                    '-O3 -march=native\
+                     -fprofile-generate=<(PGO_DIR) -fprofile-update=atomic',
+                'LINK_FLAGS': '-fprofile-generate=<(PGO_DIR)'
+            }],
+            ['build_variant=="pgo-use"', {
+                'OPT_FLAGS':
+                    '-O3 -march=native -flto\
+                     -fprofile-use=<(PGO_DIR) -fprofile-correction\
+                     -Wno-missing-profile',
+                'LINK_FLAGS': '-O3 -march=native -flto -fprofile-use=<(PGO_DIR)'
+            }],
+            ['build_variant!="native" and build_variant!="pgo-generate" and\
+              build_variant!="pgo-use"', {
+                'OPT_FLAGS': '-O2',
+                'LINK_FLAGS': ''
+            }]
+        ]
     },
     'targets': [
         {
@@ -16,9 +51,9 @@
                 '<!@(ls -1 src/native/*.c)',
                 '<!@(ls -1 src/native/toolkit/*.c)',
             ],
-            'cflags': ['-std=c99 <(FLAGS)'],
+            'cflags': ['-std=c99 <(FLAGS) <(OPT_FLAGS)'],
             'xcode_settings': {
-                'OTHER_CFLAGS': ['-std=c99', '<(FLAGS)'],
+                'OTHER_CFLAGS': ['-std=c99', '<(FLAGS)', '<(OPT_FLAGS)'],
                 'MACOSX_DEPLOYMENT_TARGET': '10.10'
             }
         },
@@ -26,18 +61,67 @@
             'target_name': 'api',
             'sources': [
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/array.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/hilbert.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/ips.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/matrix.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/metric.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/parallel.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/point_file.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/spatial_index.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/toolkit/stats.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/cartesian.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/point_set.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/polynomial.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/tour.o',
                 '<(module_root_dir)/build/Release/obj.target/__c/src/native/tsp.o',
+                '<(module_root_dir)/build/Release/obj.target/__c/src/native/vrp.o',
                 '<!@(ls -1 src/native/wrapper/*.cpp)',
             ],
-            'cflags': ['-std=c++11'],
+            'cflags': ['-std=c++11 <(OPT_FLAGS)'],
+            'ldflags': ['-pthread <(LINK_FLAGS)'],
+            'xcode_settings': {
+                'OTHER_CFLAGS': ['-std=c++11',  '-stdlib=libc++', '<(OPT_FLAGS)'],
+                'OTHER_LDFLAGS': ['-stdlib=libc++', '<(LINK_FLAGS)'],
+                'MACOSX_DEPLOYMENT_TARGET': '10.10'
+            }
+        },
+        {
+            # the C library on its own, for use without Node.js through
+            # src/native/meethere.h
+            'target_name': 'meethere',
+            'type': '<(library_type)',
+            'product_prefix': 'lib',
+            'sources': [
+                '<!@(ls -1 src/native/*.c)',
+                '<!@(ls -1 src/native/toolkit/*.c)',
+            ],
+            'cflags': ['-std=c99 -fPIC <(FLAGS) <(OPT_FLAGS)'],
+            'ldflags': ['-pthread <(LINK_FLAGS)'],
+            'direct_dependent_settings': {
+                'include_dirs': ['src/native']
+            },
+            'link_settings': {
+                'libraries': ['-lm', '-pthread']
+            },
+            'xcode_settings': {
+                'OTHER_CFLAGS': ['-std=c99', '<(FLAGS)', '<(OPT_FLAGS)'],
+                'OTHER_LDFLAGS': ['<(LINK_FLAGS)'],
+                'MACOSX_DEPLOYMENT_TARGET': '10.10'
+            }
+        },
+        {
+            # streams point files through the C library; see
+            # `build/Release/meethere --help`
+            'target_name': 'meethere-cli',
+            'type': 'executable',
+            'product_name': 'meethere',
+            'dependencies': ['meethere'],
+            'sources': ['<!@(ls -1 src/native/cli/*.c)'],
+            'cflags': ['-std=c99 <(FLAGS) <(OPT_FLAGS)'],
+            'ldflags': ['<(LINK_FLAGS)'],
             'xcode_settings': {
-                'OTHER_CFLAGS': ['-std=c++11',  '-stdlib=libc++'],
-                'OTHER_LDFLAGS': ['-stdlib=libc++'],
+                'OTHER_CFLAGS': ['-std=c99', '<(FLAGS)', '<(OPT_FLAGS)'],
+                'OTHER_LDFLAGS': ['<(LINK_FLAGS)'],
                 'MACOSX_DEPLOYMENT_TARGET': '10.10'
             }
         }
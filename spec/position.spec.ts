@@ -1,6 +1,10 @@
 import { Position } from '../src/index';
+import { CLIB } from '../src/position';
 import { expect } from 'chai';
 import 'mocha';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
 
 describe('Position', () => {
   describe('instantiation', () => {
@@ -78,7 +82,7 @@ describe('Position', () => {
         [6.3, 8.1],
         [9, 2.8],
       ]);
-      expect(test.bestPath).to.deep.equal([0, 2, 7, 1, 4, 5, 9, 3, 6, 8, 10]);
+      expect(test.bestPath).to.deep.equal([0, 2, 7, 1, 5, 4, 9, 3, 6, 8, 10]);
     });
     it('finds naive~shortest drive paths', () => {
       const test = new Position([
@@ -94,19 +98,300 @@ describe('Position', () => {
         [6.3, 8.1],
         [9, 2.8],
       ]);
-      expect(test.quickPath).to.deep.equal([0, 2, 7, 1, 4, 5, 9, 3, 6, 8, 10]);
+      expect(test.quickPath).to.deep.equal([0, 2, 7, 1, 5, 4, 9, 3, 6, 8, 10]);
+    });
+    it('finds shortest closed and fixed-end tours', () => {
+      const points = [[0, 0], [3, 4], [3, 0], [0, 4]];
+      const closed = new Position(points, { tour: 'closed' });
+      expect(closed.bestPath).to.deep.equal([0, 3, 1, 2]);
+      expect(closed.bestPathCost).to.equal(14);
+      const fixed = new Position(points, { tour: 'fixed', endIndex: 1 });
+      expect(fixed.bestPath).to.deep.equal([0, 2, 3, 1]);
+      expect(fixed.bestPathCost).to.equal(11);
+      expect(fixed.quickPathCost).to.equal(13);
+    });
+    it('measures tours under other metrics', () => {
+      const points = [[0, 0], [3, 4], [3, 0], [0, 4]];
+      const l1 = new Position(points, { tour: 'closed', metric: 'l1' });
+      expect(l1.bestPathCost).to.equal(14);
+      // prettier-ignore
+      const costMatrix = new Float64Array([
+        0, 1, 9, 9,
+        9, 0, 1, 9,
+        9, 9, 0, 1,
+        1, 9, 9, 0,
+      ]);
+      const roads = new Position(points, { tour: 'closed', costMatrix });
+      expect(roads.bestPath).to.deep.equal([0, 1, 2, 3]);
+      expect(roads.bestPathCost).to.equal(4);
+      const short = new Position(points, { costMatrix: costMatrix.slice(1) });
+      expect(() => short.bestPath).to.throw(RangeError);
+      expect(() => short.center).to.throw(RangeError);
+      expect(() => short.medoid()).to.throw(RangeError);
+      const cities = new Position([[51.5074, -0.1278], [48.8566, 2.3522]], {
+        metric: 'haversine',
+      });
+      expect(Math.round(cities.bestPathCost)).to.equal(344);
+    });
+    it('approximates tours along a Hilbert curve', () => {
+      const grid = [];
+      for (let i = 0; i < 100; ++i) {
+        grid.push([i % 10, Math.floor(i / 10)]);
+      }
+      const exact = new Position(grid, { tour: 'closed', startIndex: 42 });
+      const curve = new Position(grid, {
+        tour: 'closed',
+        startIndex: 42,
+        approximate: true,
+      });
+      const path = curve.bestPath;
+      expect(path[0]).to.equal(42);
+      expect(path.slice().sort((a, b) => a - b)).to.deep.equal(
+        grid.map((_, i) => i),
+      );
+      expect(curve.bestPathCost).to.be.at.most(1.25 * exact.bestPathCost);
+
+      const fixed = new Position(grid, {
+        tour: 'fixed',
+        endIndex: 7,
+        approximate: true,
+      });
+      expect(fixed.bestPath[0]).to.equal(0);
+      expect(fixed.bestPath[99]).to.equal(7);
+
+      // the last stop and the return leg move like any other
+      ['open', 'closed'].forEach((tour) => {
+        const points = [[3, 9], [5, 9], [7, 7], [9, 9]];
+        const line = new Position(points, { tour, approximate: true });
+        expect(line.bestPathCost).to.be.closeTo(
+          new Position(points, { tour }).bestPathCost,
+          1e-9,
+        );
+      });
+    });
+    it('routes a capacitated fleet', () => {
+      const test = new Position([[0, 0], [1, 0], [2, 0], [0, 1], [0, 2]]);
+      const fleet = test.vrp({
+        vehicles: 2,
+        capacities: 2,
+        demands: [0, 1, 1, 1, 1],
+      });
+      expect(
+        fleet.routes.map((route) => route.slice().sort()).sort(),
+      ).to.deep.equal([[1, 2], [3, 4]]);
+      expect(fleet.unserved).to.deep.equal([]);
+      expect(fleet.cost).to.equal(8);
+      expect(() =>
+        CLIB.vrp(test.locations, 2, 2, [0, 1, 1, 1, 1], 5, 't'.charCodeAt(0)),
+      ).to.throw(RangeError);
+      expect(() => test.vrp({ vehicles: 2, capacities: [2] })).to.throw(
+        RangeError,
+      );
+      expect(() => test.vrp({ vehicles: 2, capacities: [2, NaN] })).to.throw(
+        RangeError,
+      );
+      expect(() => test.vrp({ vehicles: 2, capacities: -1 })).to.throw(
+        RangeError,
+      );
+
+      // prettier-ignore
+      const costMatrix = new Float64Array([
+        0, 5, 5,
+        5, 0, 5,
+        5, 5, 0,
+      ]);
+      const roads = new Position([[0, 0], [1, 0], [2, 0]], { costMatrix });
+      expect(roads.vrp({ vehicles: 1 }).cost).to.equal(15);
     });
     it('calculates polynomial', () => {
       const test = new Position([[0, 1], [1, 2], [3, 10]]);
       expect(
         test.polynomial.map((v) => Math.round(v * 1e6) / 1e6),
-      ).to.deep.equal([1, -0, 1]);
+      ).to.deep.equal([1, 0, 1]);
+    });
+    it('fits points far from the origin', () => {
+      const xs = Float64Array.from({ length: 41 }, (_, i) => 1000 + i / 4);
+      const cubic = (x) =>
+        1 + 2 * (x - 1005) - (x - 1005) ** 2 / 2 + (x - 1005) ** 3 / 10;
+      const test = new Position(Array.from(xs, (x) => [x, cubic(x)]), {
+        degree: 3,
+      });
+      test.evaluate(xs).forEach((value, i) => {
+        expect(value).to.be.closeTo(cubic(xs[i]), 1e-6);
+      });
+    });
+    it('fits polynomials that resist outliers', () => {
+      const points = [];
+      for (let i = 0; i < 60; ++i) {
+        const x = i / 6;
+        const noise = ((i * 7) % 11) / 1100 - 0.005;
+        points.push([x, 1 - x + (x * x) / 2 + (i % 5 === 3 ? 40 + i : noise)]);
+      }
+      const test = new Position(points, { degree: 2 });
+      const round = (v) => Math.round(v * 100) / 100 + 0;
+      expect(test.polynomial.map(round)).to.not.deep.equal([1, -1, 0.5]);
+      const huber = test.robustPolynomial();
+      expect(huber.coefficients.map(round)).to.deep.equal([1, -1, 0.5]);
+      expect(huber.partial).to.equal(false);
+      expect(huber.iterations).to.be.above(0);
+      expect(huber.precision).to.be.at.most(1e-10);
+      const outliers = Array.from(huber.inliers).filter((_, i) => i % 5 === 3);
+      expect(outliers).to.deep.equal(outliers.map(() => 0));
+      ['tukey', 'ransac'].forEach((method) => {
+        const fit = test.robustPolynomial({ method });
+        expect(fit.coefficients.map(round)).to.deep.equal([1, -1, 0.5]);
+        expect(fit.count).to.equal(48);
+        expect(Array.from(fit.inliers)).to.deep.equal(
+          points.map((_, i) => (i % 5 === 3 ? 0 : 1)),
+        );
+      });
+      const sample = new Position([[0, 1], [1, 2], [2, 5], [3, 40], [4, 17]], {
+        degree: 2,
+      });
+      const fit = sample.robustPolynomial({ method: 'ransac', threshold: 0.5 });
+      expect(fit.coefficients.map(round)).to.deep.equal([1, 0, 1]);
+      expect(Array.from(fit.inliers)).to.deep.equal([1, 1, 1, 0, 1]);
+      expect(fit.count).to.equal(4);
+      expect(fit.partial).to.equal(false);
+      expect(fit.precision).to.be.below(0.01);
+      const column = new Position([[1, 1], [1, 2], [1, 3]], { degree: 1 });
+      const stuck = column.robustPolynomial({ method: 'ransac' });
+      expect(stuck.count).to.equal(0);
+      expect(Array.from(stuck.inliers)).to.deep.equal([0, 0, 0]);
+      expect(stuck.coefficients).to.deep.equal(column.polynomial);
+    });
+    it('fits many series on the same x coordinates', () => {
+      const xs = new Float64Array([0, 1, 2, 3, 4]);
+      const sets = [[1, 2, 5, 10, 17], [0, 2, 4, 6, 8], [3, 2, 3, 6, 11]];
+      const series = new Float64Array([].concat(...sets));
+      const round = (v) => Math.round(v * 1e6) / 1e6 + 0;
+      const fits = Array.from(Position.bestFits(xs, series, 2), round);
+      expect(fits).to.deep.equal([1, 0, 1, 0, 2, 0, 3, -2, 1]);
+      sets.forEach((ys, s) => {
+        const single = new Position(ys.map((y, i) => [xs[i], y]), {
+          degree: 2,
+        });
+        expect(single.polynomial.map(round)).to.deep.equal(
+          fits.slice(3 * s, 3 * s + 3),
+        );
+      });
+      expect(() => Position.bestFits(xs, new Float64Array(7), 2)).to.throw(
+        RangeError,
+      );
+    });
+    it('evaluates the polynomial into given arrays', () => {
+      const test = new Position([[0, 1], [1, 2], [3, 10]]);
+      const xs = new Float64Array([-1, 0, 2, 4]);
+      const values = new Float64Array(4);
+      const first = new Float64Array(4);
+      const second = new Float64Array(4);
+      expect(test.evaluate(xs, values, first, second)).to.equal(values);
+      const round = (array) =>
+        Array.from(array, (v) => Math.round(v * 1e6) / 1e6);
+      expect(round(values)).to.deep.equal([2, 1, 5, 17]);
+      expect(round(first)).to.deep.equal([-2, 0, 4, 8]);
+      expect(round(second)).to.deep.equal([2, 2, 2, 2]);
+      expect(
+        Array.from(CLIB.evalPolynomial([1, 2, 3], xs, new Float64Array(4))),
+      ).to.deep.equal([2, 1, 17, 57]);
+      expect(() =>
+        CLIB.evalPolynomial([1], xs, new Float64Array(2)),
+      ).to.throw(RangeError);
+    });
+  });
+  describe('minimax center', () => {
+    it('finds the center of the smallest enclosing circle', () => {
+      const test = new Position([[0, 0], [4, 0], [0, 4], [1, 1]]);
+      const [x, y] = test.minimaxCenter;
+      expect(x).to.be.closeTo(2, 1e-9);
+      expect(y).to.be.closeTo(2, 1e-9);
+      expect(test.minimaxCost).to.be.closeTo(Math.sqrt(8), 1e-9);
+      expect(test.minimaxCost).to.be.below(
+        Math.max(
+          ...test.locations.map((l) =>
+            Math.hypot(l[0] - test.center[0], l[1] - test.center[1]),
+          ),
+        ),
+      );
+
+      const manhattan = new Position([[0, 0], [2, 0], [0, 2]], {
+        metric: 'l1',
+      });
+      expect(manhattan.minimaxCost).to.be.closeTo(2, 1e-9);
+
+      const cities = new Position(
+        [[40.7128, -74.006], [34.0522, -118.2437], [41.8781, -87.6298]],
+        { metric: 'haversine' },
+      );
+      const center = cities.minimaxCenter;
+      expect(center[0]).to.be.within(34, 42);
+      expect(center[1]).to.be.within(-119, -74);
+      const { distances } = CLIB.distance(
+        cities.locations,
+        center,
+        'm'.charCodeAt(0),
+        false,
+      );
+      expect(cities.minimaxCost).to.be.closeTo(Math.max(...distances), 1e-6);
+    });
+  });
+  describe('medoid', () => {
+    it('finds the location with the least net cost to the others', () => {
+      const locations = Array.from({ length: 400 }, (_, i) => [
+        40 + ((i * 7919) % 997) / 997,
+        -74 + ((i * 104729) % 991) / 991,
+      ]);
+      const netCosts = {
+        l2: (from: Array<number>) =>
+          locations.reduce(
+            (sum, l) => sum + Math.hypot(l[0] - from[0], l[1] - from[1]),
+            0,
+          ),
+        l1: (from: Array<number>) =>
+          locations.reduce(
+            (sum, l) =>
+              sum + Math.abs(l[0] - from[0]) + Math.abs(l[1] - from[1]),
+            0,
+          ),
+        haversine: (from: Array<number>) =>
+          CLIB.distance(
+            locations,
+            from,
+            'm'.charCodeAt(0),
+            false,
+          ).distances.reduce((sum: number, d: number) => sum + d, 0),
+      };
+
+      Object.keys(netCosts).forEach((metric) => {
+        const costs = locations.map(netCosts[metric]);
+        const least = costs.indexOf(Math.min(...costs));
+        const medoid = new Position(locations, { metric }).medoid();
+        expect(medoid.index).to.equal(least);
+        expect(medoid.location).to.deep.equal(locations[least]);
+        expect(medoid.cost).to.be.closeTo(costs[least], 1e-6);
+      });
+
+      // prettier-ignore
+      const costMatrix = new Float64Array([
+        0, 1, 9,
+        5, 0, 1,
+        1, 2, 0,
+      ]);
+      const roads = new Position([[0, 0], [1, 0], [2, 0]], { costMatrix });
+      expect(roads.medoid()).to.deep.equal({
+        index: 1,
+        location: [1, 0],
+        cost: 3,
+      });
+      expect(() => new Position([]).medoid()).to.throw(RangeError);
     });
   });
   describe('calculates cost', () => {
     it('calculates cost for mean', () => {
       const test = new Position([[0, 0], [0, 1], [1, 0]]);
       expect(test.meanCost).to.equal(1.9621165057908914);
+      const l1 = new Position([[0, 0], [0, 1], [1, 0]], { metric: 'l1' });
+      expect(l1.meanCost).to.be.closeTo(8 / 3, 1e-12);
     });
     it('calculates cost for center', () => {
       const test = new Position([[0, 0], [0, 1], [1, 0]]);
@@ -116,5 +401,409 @@ describe('Position', () => {
       const test = new Position([[1, 2], [5, 6.6], [-7, 8.1], [3.1, -1.7]]);
       expect(test.geometricSignificance).to.equal(0.06535988277952172);
     });
+    it('summarizes the locations in one call', () => {
+      const locations = [[1, 2], [5, 6.6], [-7, 8.1], [3.1, -1.7]];
+      ['l2', 'l1', 'haversine'].forEach((metric) => {
+        const test = new Position(locations, { metric });
+        const summary = test.summary();
+        expect(summary.mean).to.deep.equal(test.mean);
+        expect(summary.meanCost).to.equal(test.meanCost);
+        expect(summary.center).to.deep.equal(test.center);
+        expect(summary.centerCost).to.equal(test.centerCost);
+        expect(summary.significance).to.equal(
+          (test.meanCost - test.centerCost) / test.meanCost,
+        );
+      });
+
+      const summary = new Position(locations).summary();
+      expect(summary.min).to.deep.equal([-7, -1.7]);
+      expect(summary.max).to.deep.equal([5, 8.1]);
+      expect(summary.variance[0]).to.be.closeTo(20.876875, 1e-9);
+      expect(summary.variance[1]).to.be.closeTo(14.9525, 1e-9);
+    });
+  });
+  describe('returns typed results', () => {
+    it('hands native results over as typed arrays', () => {
+      const test = new Position([[0, 0], [5, 10], [3, 4], [1, 7], [6, 2]]);
+      expect(test.typedBestPath).to.be.instanceof(Uint32Array);
+      expect(Array.from(test.typedBestPath)).to.deep.equal(test.bestPath);
+      expect(Array.from(test.typedQuickPath)).to.deep.equal(test.quickPath);
+      expect(Array.from(test.typedCenter)).to.deep.equal(test.center);
+      expect(Array.from(test.typedMean)).to.deep.equal(test.mean);
+      expect(Array.from(test.typedPolynomial)).to.deep.equal(test.polynomial);
+
+      const fleet = { vehicles: 2, capacities: 2, demands: [0, 1, 1, 1, 1] };
+      const typed = test.typedVrp(fleet);
+      const routes = test.vrp(fleet);
+      expect(typed.routes.map((route) => Array.from(route))).to.deep.equal(
+        routes.routes,
+      );
+      expect(Array.from(typed.unserved)).to.deep.equal(routes.unserved);
+      expect(typed.cost).to.equal(routes.cost);
+    });
+  });
+  describe('point files', () => {
+    const locations = [[1, 2], [5, 6.6], [-7, 8.1], [3.1, -1.7], [0.5, 4]];
+    const file = path.join(os.tmpdir(), `meethere-${process.pid}.pset`);
+    afterEach(() => {
+      if (fs.existsSync(file)) {
+        fs.unlinkSync(file);
+      }
+    });
+    it('solves over a memory-mapped point file', () => {
+      const test = new Position(locations);
+      test.toFile(file);
+      const mapped = Position.fromFile(file, { stats: true });
+      expect(mapped.center).to.deep.equal(test.center);
+      expect(mapped.stats.counters.pointsMarshalled).to.equal(0);
+      expect(mapped.mean).to.deep.equal(test.mean);
+      expect(mapped.bestPath).to.deep.equal(test.bestPath);
+      expect(mapped.vrp({ vehicles: 2 })).to.deep.equal(
+        test.vrp({ vehicles: 2 }),
+      );
+      expect(mapped.stats.counters.pointsMarshalled).to.equal(0);
+      expect(mapped.polynomial).to.deep.equal(test.polynomial);
+      expect(mapped.nearest([0, 0], 2)).to.deep.equal(test.nearest([0, 0], 2));
+      expect(mapped.locations).to.deep.equal(locations);
+      const miles = 'm'.charCodeAt(0);
+      expect(
+        CLIB.distance(new CLIB.PointFile(file), [0, 0], miles, false),
+      ).to.deep.equal(CLIB.distance(locations, [0, 0], miles, false));
+      mapped.add([2, 2]);
+      expect(mapped.locations).to.have.lengthOf(6);
+      expect(mapped.nearest([2, 2]).indices).to.deep.equal([5]);
+    });
+    it('stores weights and single-precision coordinates', () => {
+      new Position(locations).toFile(file, {
+        weights: [1, 2, 3, 4, 5],
+        float32: true,
+      });
+      const points = new CLIB.PointFile(file);
+      expect(points.size()).to.equal(5);
+      expect(points.weights(false)).to.deep.equal([1, 2, 3, 4, 5]);
+      points
+        .locations()
+        .forEach((location, i) =>
+          expect(location[0]).to.equal(Math.fround(locations[i][0])),
+        );
+      expect(Position.fromFile(file).mean[0]).to.be.closeTo(0.52, 1e-6);
+      points.close();
+      expect(() => points.locations()).to.throw();
+    });
+    it('rejects files that are not point files', () => {
+      fs.writeFileSync(file, 'not a point file');
+      expect(() => Position.fromFile(file)).to.throw();
+      expect(() => Position.fromFile(`${file}.missing`)).to.throw();
+      const swapped = Buffer.alloc(48);
+      swapped.write('PSET');
+      if (os.endianness() === 'LE') {
+        swapped.writeUInt32BE(1, 4);
+      } else {
+        swapped.writeUInt32LE(1, 4);
+      }
+      fs.writeFileSync(file, swapped);
+      expect(() => Position.fromFile(file)).to.throw(/byte order/);
+    });
+  });
+  describe('solves batches', () => {
+    it('solves many sets in one call', () => {
+      const sets = [
+        [[0, 0], [0, 1], [1, 0]],
+        [[1, 2], [5, 6.6], [-7, 8.1], [3.1, -1.7]],
+        [],
+        [[0, 0], [3, 4], [3, 0], [0, 4], [1, 1]],
+      ];
+      const { points, offsets } = Position.pack(sets);
+      expect(Array.from(offsets)).to.deep.equal([0, 3, 7, 7, 12]);
+      const code = (c: string) => c.charCodeAt(0);
+
+      const centers = CLIB.geometricBatch(
+        points,
+        offsets,
+        false,
+        1e-3,
+        10,
+        code('t'),
+      );
+      const means = CLIB.meanBatch(points, offsets);
+      const tours = CLIB.tspBatch(points, offsets, 0, code('t'), code('c'), 0);
+      sets.forEach((set, s) => {
+        if (!set.length) {
+          return;
+        }
+        const test = new Position(set, { tour: 'closed' });
+        expect(
+          Array.from(centers.centers.slice(2 * s, 2 * s + 2)),
+        ).to.deep.equal(test.center);
+        expect(centers.scores[s]).to.equal(test.centerCost);
+        expect(
+          Array.from(means.centers.slice(2 * s, 2 * s + 2)),
+        ).to.deep.equal(test.mean);
+        expect(
+          Array.from(tours.orders.slice(offsets[s], offsets[s + 1])),
+        ).to.deep.equal(test.bestPath);
+        expect(tours.costs[s]).to.equal(test.bestPathCost);
+      });
+      expect(() => CLIB.meanBatch(points, [0, 13])).to.throw(RangeError);
+      expect(() => CLIB.meanBatch(points, [-1, 2])).to.throw(RangeError);
+      expect(() => CLIB.meanBatch(points, [-4e9, 2])).to.throw(RangeError);
+      expect(() =>
+        CLIB.tspBatch(points, offsets, 3, code('t'), code('c'), 0),
+      ).to.throw(RangeError);
+      expect(
+        () => new Position(sets[3], { startIndex: 50 }).bestPath,
+      ).to.throw(RangeError);
+    });
+  });
+  describe('maintains tours', () => {
+    it('adds and removes stops without solving again', () => {
+      let seed = 7;
+      const next = () => {
+        seed = (seed * 1103515245 + 12345) % 2147483648;
+        return (seed / 2147483648) * 100;
+      };
+      const locations = [];
+      for (let i = 0; i < 60; ++i) {
+        locations.push([next(), next()]);
+      }
+      const cost = (plane, path) =>
+        path
+          .slice(1)
+          .reduce(
+            (sum, stop, i) =>
+              sum +
+              Math.hypot(
+                plane.locations[stop][0] - plane.locations[path[i]][0],
+                plane.locations[stop][1] - plane.locations[path[i]][1],
+              ),
+            0,
+          );
+      const isTour = (plane, path) =>
+        expect(path.slice().sort((a, b) => a - b)).to.deep.equal(
+          plane.locations.map((location, i) => i),
+        );
+
+      const plane = new Position(locations.slice(), { stats: true });
+      expect(plane.path).to.deep.equal(plane.bestPath);
+
+      const at = plane.addStop([50, 50], 4);
+      expect(plane.stats.counters.costMatrixBuilds).to.equal(0);
+      expect(plane.path[at]).to.equal(60);
+      isTour(plane, plane.path);
+      expect(plane.pathCost).to.be.closeTo(cost(plane, plane.path), 1e-9);
+
+      expect(plane.removeStop(locations[10], 4)).to.deep.equal(locations[10]);
+      expect(plane.removeStop([-1, -1])).to.equal(-1);
+      plane.add([10, 90]);
+      plane.remove(locations[20]);
+      plane.move(locations[30], [20, 20]);
+      expect(plane.path[0]).to.equal(0);
+      isTour(plane, plane.path);
+      expect(plane.pathCost).to.be.closeTo(cost(plane, plane.path), 1e-9);
+
+      const line = new Position([[0, 0], [2, 0]], { tour: 'closed' });
+      expect(line.addStop([1, 0])).to.equal(1);
+      expect(line.path).to.deep.equal([0, 2, 1]);
+      expect(line.pathCost).to.equal(4);
+      expect(
+        () => new Position([[0, 0], [2, 0]], { endIndex: 2 }).path,
+      ).to.throw(RangeError);
+
+      const replaced = new Position([[0, 0], [1, 0], [2, 0]]);
+      expect(replaced.path).to.deep.equal([0, 1, 2]);
+      expect(replaced.nearest([2, 0]).indices).to.deep.equal([2]);
+      replaced.locations = [[0, 0], [1, 0], [2, 0], [3, 0], [4, 0]];
+      expect(replaced.remove([4, 0])).to.deep.equal([4, 0]);
+      expect(replaced.locations.length).to.equal(4);
+      replaced.add([5, 0]);
+      expect(replaced.path).to.deep.equal([0, 1, 2, 3, 4]);
+      expect(replaced.nearest([4.9, 0]).indices).to.deep.equal([4]);
+    });
+  });
+  describe('searches neighbours', () => {
+    it('finds nearest and nearby locations', () => {
+      const locations = [];
+      for (let i = 0; i < 200; ++i) {
+        locations.push([(i * 37) % 101, (i * 53) % 97]);
+      }
+      const test = new Position(locations);
+      const brute = (point: Array<number>) =>
+        locations
+          .map((l, i) => [Math.hypot(l[0] - point[0], l[1] - point[1]), i])
+          .sort((a, b) => a[0] - b[0] || a[1] - b[1]);
+
+      const check = (point: Array<number>) => {
+        const expected = brute(point);
+        const near = test.nearest(point, 5);
+        expect(near.indices).to.deep.equal(
+          expected.slice(0, 5).map((e) => e[1]),
+        );
+        near.distances.forEach((d, i) =>
+          expect(d).to.be.closeTo(expected[i][0], 1e-9),
+        );
+        const found = test.within(point, 20);
+        expect(found.indices.slice().sort((a, b) => a - b)).to.deep.equal(
+          expected
+            .filter((e) => e[0] <= 20)
+            .map((e) => e[1])
+            .sort((a, b) => a - b),
+        );
+      };
+
+      check([50, 50]);
+      test.add([50.5, 50.5]);
+      test.move(locations[3], [49, 49]);
+      test.remove(locations[0]);
+      check([50, 50]);
+      expect(test.nearest([50.4, 50.4]).indices).to.deep.equal([
+        locations.length - 1,
+      ]);
+      locations.push([0, 0]);
+      expect(test.nearest([0, 0]).indices).to.deep.equal([
+        locations.length - 1,
+      ]);
+    });
+    it('assigns locations to their nearest centers', () => {
+      const locations = [];
+      for (let i = 0; i < 500; ++i) {
+        locations.push([((i * 37) % 101) - 50, ((i * 53) % 97) - 48]);
+      }
+      const measures: { [metric: string]: Function } = {
+        l2: (c: Array<number>) =>
+          locations.map((l) => Math.hypot(l[0] - c[0], l[1] - c[1])),
+        l1: (c: Array<number>) =>
+          locations.map((l) => Math.abs(l[0] - c[0]) + Math.abs(l[1] - c[1])),
+        haversine: (c: Array<number>) =>
+          CLIB.distance(locations, c, 'm'.charCodeAt(0), false).distances,
+      };
+
+      Object.keys(measures).forEach((metric) =>
+        [5, 100].forEach((count) => {
+          const centers = locations.slice(0, count).map((l) => [l[1], l[0]]);
+          const table = centers.map((c) => measures[metric](c));
+          const found = new Position(locations, { metric }).assign(centers);
+          locations.forEach((_, i) => {
+            const best = Math.min(...table.map((row) => row[i]));
+            expect(found.distances[i]).to.be.closeTo(best, 1e-6);
+            expect(table[found.indices[i]][i]).to.be.closeTo(best, 1e-6);
+          });
+        }),
+      );
+      expect(
+        new Position([[0, 0], [5, 5], [1, 1]]).assign([[0, 1], [6, 6]]).indices,
+      ).to.deep.equal([0, 1, 0]);
+    });
+  });
+  describe('bounds solves', () => {
+    it('settles for the best result within its limits', () => {
+      const locations = [];
+      for (let i = 0; i < 60; ++i) {
+        locations.push([(i * 37) % 101, (i * 53) % 97]);
+      }
+      const order = (path: Array<number>, n: number) =>
+        expect(path.slice().sort((a, b) => a - b)).to.deep.equal(
+          locations.slice(0, n).map((_, i) => i),
+        );
+
+      const center = new Position(locations, { epsilon: 1e-6 });
+      const full = center.anytimeCenter();
+      expect(full.partial).to.equal(false);
+      expect(full.precision).to.be.at.most(1e-6);
+      const cut = new Position(locations, {
+        epsilon: 1e-6,
+        maxIterations: 2,
+      }).anytimeCenter();
+      expect(cut.partial).to.equal(true);
+      expect(cut.iterations).to.equal(2);
+      expect(cut.precision).to.be.above(1e-6);
+      expect(cut.score).to.be.at.least(full.score);
+
+      [12, 30, 60].forEach((n) => {
+        const exact = new Position(locations.slice(0, n)).anytimePath();
+        expect(exact.partial).to.equal(false);
+        if (n === 12) {
+          expect(exact.precision).to.equal(0);
+        }
+        const limited = new Position(locations.slice(0, n), {
+          maxIterations: 1,
+        }).anytimePath();
+        order(limited.order, n);
+        expect(limited.partial).to.equal(true);
+        expect(limited.iterations).to.equal(1);
+        expect(limited.cost).to.be.at.least(exact.cost - 1e-9);
+        expect(limited.precision).to.be.above(0);
+        expect(limited.precision).to.be.below(1);
+      });
+
+      const curve = new Position(locations, {
+        approximate: true,
+        deadlineMs: 50,
+      }).anytimePath();
+      order(curve.order, 60);
+      expect(Number.isNaN(curve.precision)).to.equal(true);
+    });
+  });
+  describe('runs in worker threads', () => {
+    it('loads a copy of the addon in each worker', () => {
+      let threads;
+      try {
+        threads = require('worker_threads');
+      } catch (e) {
+        return; // worker threads are not available in this version of Node
+      }
+      const source = `
+        const { parentPort, workerData } = require('worker_threads');
+        const CLIB = require(workerData.bindings)({
+          bindings: 'api',
+          module_root: workerData.root,
+        });
+        CLIB.setStats(true);
+        const { center } = CLIB.mean(workerData.points, false);
+        parentPort.postMessage({ center, calls: CLIB.stats().counters.calls });
+      `;
+      const workerData = {
+        bindings: require.resolve('bindings'),
+        root: path.join(__dirname, '..'),
+        points: [[0, 0], [2, 0], [2, 2], [0, 2]],
+      };
+      const run = () =>
+        new Promise((resolve, reject) => {
+          const worker = new threads.Worker(source, { eval: true, workerData });
+          worker.on('message', resolve);
+          worker.on('error', reject);
+        });
+
+      const wasEnabled = CLIB.setStats(false);
+      return Promise.all([run(), run(), run()]).then((results: Array<any>) => {
+        results.forEach(({ center, calls }) => {
+          expect(center).to.deep.equal([1, 1]);
+          expect(calls).to.equal(1);
+        });
+        expect(CLIB.stats().enabled).to.equal(false);
+        CLIB.setStats(wasEnabled);
+      });
+    });
+  });
+  describe('collects stats', () => {
+    it('reports native stats', () => {
+      const test = new Position([[0, 0], [0, 1], [1, 0]], { stats: true });
+      test.center;
+      expect(test.stats.counters.calls).to.equal(1);
+      expect(test.stats.counters.pointsMarshalled).to.equal(3);
+      expect(test.stats.counters.centerIterations).to.be.above(0);
+      expect(test.stats.timers.compute).to.be.at.least(0);
+      test.add([2, 3]);
+      test.add([4, 1]);
+      test.bestPath;
+      expect(test.stats.counters.heldKarpSolves).to.equal(1);
+      expect(test.stats.counters.centerIterations).to.equal(0);
+      const wasEnabled = CLIB.setStats(true);
+      CLIB.distance(test.locations, [0, 0], 'm'.charCodeAt(0), false);
+      const stats = CLIB.stats();
+      CLIB.setStats(wasEnabled);
+      expect(stats.counters.calls).to.equal(1);
+      expect(stats.counters.pointsMarshalled).to.equal(5);
+      expect(stats.timers.compute).to.be.at.least(0);
+    });
   });
 });
@@ -35,7 +35,158 @@ export interface CenterOptions {
   epsilon?: number;
   bounds?: number;
   startIndex?: number;
+  endIndex?: number;
+  tour?: string;
+  approximate?: boolean;
+  metric?: string;
+  costMatrix?: Float64Array;
   degree?: number;
+  stats?: boolean;
+  deadlineMs?: number;
+  maxIterations?: number;
+}
+
+/**
+ * Describes an AnytimeCenter Object
+ *
+ * @interface
+ */
+export interface AnytimeCenter {
+  center: Array<number>;
+  score: number;
+  partial: boolean;
+  precision: number;
+  iterations: number;
+}
+
+/**
+ * Describes an AnytimePath Object
+ *
+ * @interface
+ */
+export interface AnytimePath {
+  order: Array<number>;
+  cost: number;
+  partial: boolean;
+  precision: number;
+  iterations: number;
+}
+
+/**
+ * Describes a FleetOptions Object
+ *
+ * @interface
+ */
+export interface FleetOptions {
+  vehicles: number;
+  capacities?: number | Array<number>;
+  demands?: Array<number>;
+}
+
+/**
+ * Describes a FleetRoutes Object
+ *
+ * @interface
+ */
+export interface FleetRoutes {
+  routes: Array<Array<number>>;
+  unserved: Array<number>;
+  cost: number;
+}
+
+/**
+ * Describes a TypedFleetRoutes Object
+ *
+ * @interface
+ */
+export interface TypedFleetRoutes {
+  routes: Array<Uint32Array>;
+  unserved: Uint32Array;
+  cost: number;
+}
+
+/**
+ * Describes a RobustFitOptions Object
+ *
+ * @interface
+ */
+export interface RobustFitOptions {
+  method?: string;
+  threshold?: number;
+  iterations?: number;
+  budget?: number;
+}
+
+/**
+ * Describes a RobustFit Object
+ *
+ * @interface
+ */
+export interface RobustFit {
+  coefficients: Array<number>;
+  inliers: Uint8Array;
+  count: number;
+  partial: boolean;
+  precision: number;
+  iterations: number;
+}
+
+/**
+ * Describes a PointBatch Object
+ *
+ * @interface
+ */
+export interface PointBatch {
+  points: Float64Array;
+  offsets: Uint32Array;
+}
+
+/**
+ * Describes a Neighbors Object
+ *
+ * @interface
+ */
+export interface Neighbors {
+  indices: Array<number>;
+  distances: Array<number>;
+}
+
+/**
+ * Describes a Summary Object
+ *
+ * @interface
+ */
+export interface Summary {
+  mean: Array<number>;
+  meanCost: number;
+  center: Array<number>;
+  centerCost: number;
+  significance: number;
+  min: Array<number>;
+  max: Array<number>;
+  variance: Array<number>;
+}
+
+/**
+ * Describes a Medoid Object
+ *
+ * @interface
+ */
+export interface Medoid {
+  index: number;
+  location: Array<number>;
+  cost: number;
+}
+
+/**
+ * Describes a NativeStats Object
+ *
+ * @interface
+ */
+export interface NativeStats {
+  enabled: boolean;
+  counters: { [name: string]: number };
+  timers: { [name: string]: number };
 }
 
 /**
@@ -82,3 +233,13 @@ export interface TimeZoneOptions {
   timestamp?: Date | number;
   language?: string;
 }
+
+/**
+ * Describes a PointFileOptions Object
+ *
+ * @interface
+ */
+export interface PointFileOptions {
+  weights?: Array<number>;
+  float32?: boolean;
+}
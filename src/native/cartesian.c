@@ -1,13 +1,9 @@
 #include "cartesian.h"
 
-#include "toolkit/matrix.h"
+#include "toolkit/kernel.h"
 
 #include <math.h>
 
-static const float EARTH_RADIUS_METERS = 6371e3;
-static const float METER_TO_KM         = 1e-3;
-static const float METER_TO_MI         = 6.2137119223733e-4;
-
 /**
  * @brief   Calculates the earthly distance between two cartesian points.
  * @details Uses the Haversine formula to calculate the distance between two
@@ -36,16 +32,14 @@ static double haversine_distance(const double start_latitude,
                                  const double end_longitude,
                                  const char   unit)
 {
-  const double delta_latitude  = end_latitude - start_latitude;
-  const double delta_longitude = end_longitude - start_longitude;
-
-  const double a = pow(sin(delta_latitude / 2), 2) +
-                   cos(start_latitude) * cos(end_latitude) *
-                       pow(sin(delta_longitude / 2), 2);
-  const double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-  const double d = c * EARTH_RADIUS_METERS;
+  const double c = kernel_haversine_arc(start_latitude,
+                                        cos(start_latitude),
+                                        end_latitude,
+                                        cos(end_latitude),
+                                        end_longitude - start_longitude);
+  const double d = c * KERNEL_EARTH_RADIUS_METERS;
 
-  return d * (unit == 'm' ? METER_TO_KM : METER_TO_MI);
+  return d * kernel_meters_to(unit);
 }
 
 const struct cartesian Cartesian = {.haversine_distance = haversine_distance};
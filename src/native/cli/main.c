@@ -0,0 +1,580 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../meethere.h"
+#include "point_stream.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @enum
+ * @brief  Limits on the work held in memory at once
+ *
+ * @prop   SETS_PER_THREAD    sets read ahead for each worker thread
+ * @prop   WINDOW_POINTS      points read ahead across all sets, beyond which
+ *                            no further set is read until the window is
+ *                            solved
+ * @prop   DISTANCE_BLOCK     distances computed before a block of matrix
+ *                            rows is written out
+ * @prop   DISTANCE_GRAIN     distances each thread computes at the least
+ */
+enum
+{
+  SETS_PER_THREAD = 4,
+  WINDOW_POINTS   = 1 << 22,
+  DISTANCE_BLOCK  = 1 << 20,
+  DISTANCE_GRAIN  = 1 << 12
+};
+
+/**
+ * @enum
+ * @brief  What to compute for each set
+ *
+ * @prop   COMMAND_CENTER     a center, by the chosen method
+ * @prop   COMMAND_TOUR       the shortest tour through the set
+ * @prop   COMMAND_FIT        the best-fit polynomial through the set
+ * @prop   COMMAND_DISTANCES  the distance matrix of the set
+ */
+enum Command
+{
+  COMMAND_CENTER,
+  COMMAND_TOUR,
+  COMMAND_FIT,
+  COMMAND_DISTANCES
+};
+
+/**
+ * @enum
+ * @brief  How a center is found
+ *
+ * @prop   CENTER_MEAN       the mean
+ * @prop   CENTER_GEOMETRIC  the geometric median
+ * @prop   CENTER_MINIMAX    the center of the smallest enclosing circle
+ */
+enum CenterMethod
+{
+  CENTER_MEAN,
+  CENTER_GEOMETRIC,
+  CENTER_MINIMAX
+};
+
+/**
+ * @struct
+ * @brief  Options given on the command line
+ *
+ * @prop   command     what to compute
+ * @prop   center      how to find centers
+ * @prop   tour        shape of tours
+ * @prop   solver      how tours are constructed
+ * @prop   metric      how distance is measured
+ * @prop   epsilon     margin of error of geometric centers
+ * @prop   degree      degree of fitted polynomials, or 0 to guess it
+ * @prop   binary      whether to write distance matrices as raw doubles
+ * @prop   quiet       whether to leave out the throughput report
+ */
+struct Options
+{
+  enum Command      command;
+  enum CenterMethod center;
+  enum TourType     tour;
+  enum TSPMethod    solver;
+  enum MetricType   metric;
+  double            epsilon;
+  uint64_t          degree;
+  bool              binary;
+  bool              quiet;
+};
+
+/**
+ * @struct
+ * @brief  A set read ahead, and what was computed for it
+ *
+ * @prop   set         the points
+ * @prop   center      center found
+ * @prop   cost        cost of the center or tour
+ * @prop   order       tour found, to be `free`d
+ * @prop   fit         coefficients of the polynomial found, to be `free`d
+ * @prop   degree      degree of the polynomial found
+ */
+struct Job
+{
+  struct StreamedSet set;
+  double             center[2];
+  double             cost;
+  uint64_t *         order;
+  double *           fit;
+  uint64_t           degree;
+};
+
+/**
+ * @struct
+ * @brief  Sets read ahead, solved together across threads
+ *
+ * @prop   options     options of the run
+ * @prop   metric      how distance is measured
+ * @prop   jobs        the sets
+ */
+struct Window
+{
+  const struct Options *        options;
+  const struct DistanceMetric * metric;
+  struct Job *                  jobs;
+};
+
+/**
+ * @struct
+ * @brief  A block of rows of a distance matrix
+ *
+ * @prop   metric      how distance is measured
+ * @prop   points      points of the set
+ * @prop   num_points  number of points
+ * @prop   first       first row of the block
+ * @prop   rows        distances of the block, row after row
+ */
+struct DistanceBlock
+{
+  const struct DistanceMetric * metric;
+  const double (*points)[2];
+  uint64_t num_points;
+  uint64_t first;
+  double * rows;
+};
+
+static const char * USAGE =
+    "usage: meethere <command> [options] [file ...]\n"
+    "\n"
+    "Reads sets of points from point files, or from CSV text of `x,y` lines\n"
+    "where blank lines separate sets, and writes one CSV line per set.\n"
+    "Without files, or with `-`, CSV is read from standard input.\n"
+    "\n"
+    "commands:\n"
+    "  center       set,x,y,cost of the center of each set\n"
+    "  tour         set,cost,order of the shortest tour through each set\n"
+    "  fit          set,a_0,...,a_k of the best-fit polynomial of each set\n"
+    "  distances    the distance matrix of each set, row by row\n"
+    "\n"
+    "options:\n"
+    "  --method mean|geometric|minimax   how to find centers [geometric]\n"
+    "  --tour open|closed                shape of tours [open]\n"
+    "  --curve                           approximate tours along a Hilbert\n"
+    "                                    curve, in O(n log n)\n"
+    "  --metric l2|l1|haversine          how to measure distance [l2]\n"
+    "  --epsilon <e>                     margin of geometric centers [1e-3]\n"
+    "  --degree <k>                      degree of fits [guessed]\n"
+    "  --binary                          write distances as native doubles\n"
+    "  --quiet                           leave out the throughput report\n";
+
+/**
+ * @brief   Reports a failure and exits.
+ *
+ * @param   message          what went wrong
+ */
+static void __fail(const char * message)
+{
+  fprintf(stderr, "meethere: %s\n", message);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief   Reports a misuse of the command line and exits.
+ *
+ * @param   message          what was wrong
+ * @param   arg              the argument at fault
+ */
+static void __usage(const char * message, const char * arg)
+{
+  fprintf(stderr, "meethere: %s `%s`\n\n%s", message, arg, USAGE);
+  exit(2);
+}
+
+/**
+ * @brief   Picks a value by name.
+ *
+ * @param   arg              the name given
+ * @param   names            accepted names, ending with NULL
+ *
+ * @return  position of the name among those accepted
+ */
+static int __choose(const char * arg, const char * const names[])
+{
+  for (int i = 0; names[i]; ++i) {
+    if (!strcmp(arg, names[i])) {
+      return i;
+    }
+  }
+  __usage("unknown value", arg);
+  return 0;
+}
+
+/**
+ * @brief   Parses the command and options, leaving the files in `argv`.
+ *
+ * @param   argc             number of arguments
+ * @param   argv             the arguments
+ * @param   files            set to the index of the first file
+ *
+ * @return  the options
+ */
+static struct Options __parse(const int argc, char * argv[], int * files)
+{
+  static const char * const COMMANDS[] = {
+      "center", "tour", "fit", "distances", NULL};
+  static const char * const METHODS[] = {"mean", "geometric", "minimax", NULL};
+  static const char * const TOURS[]   = {"open", "closed", NULL};
+  static const char * const METRICS[] = {"l1", "l2", "haversine", NULL};
+
+  if (argc < 2 || !strcmp(argv[1], "--help") || !strcmp(argv[1], "-h")) {
+    fputs(USAGE, argc < 2 ? stderr : stdout);
+    exit(argc < 2 ? 2 : EXIT_SUCCESS);
+  }
+
+  struct Options options = {(enum Command)__choose(argv[1], COMMANDS),
+                            CENTER_GEOMETRIC,
+                            TOUR_OPEN,
+                            TSP_BY_SIZE,
+                            METRIC_L2,
+                            1e-3,
+                            0,
+                            false,
+                            false};
+
+  int i = 2;
+  for (; i < argc && !strncmp(argv[i], "--", 2); ++i) {
+    const char * option = argv[i];
+    if (!strcmp(option, "--binary")) {
+      options.binary = true;
+      continue;
+    }
+    if (!strcmp(option, "--quiet")) {
+      options.quiet = true;
+      continue;
+    }
+    if (!strcmp(option, "--curve")) {
+      options.solver = TSP_HILBERT_CURVE;
+      continue;
+    }
+    if (i + 1 == argc) {
+      __usage("missing value of", option);
+    }
+
+    const char * value = argv[++i];
+    char *       end;
+    if (!strcmp(option, "--method")) {
+      options.center = (enum CenterMethod)__choose(value, METHODS);
+    } else if (!strcmp(option, "--tour")) {
+      options.tour = (enum TourType)__choose(value, TOURS);
+    } else if (!strcmp(option, "--metric")) {
+      options.metric = (enum MetricType)__choose(value, METRICS);
+    } else if (!strcmp(option, "--epsilon")) {
+      options.epsilon = strtod(value, &end);
+      if (*end || !(options.epsilon > 0)) {
+        __usage("invalid epsilon", value);
+      }
+    } else if (!strcmp(option, "--degree")) {
+      options.degree = strtoull(value, &end, 10);
+      if (*end || !options.degree) {
+        __usage("invalid degree", value);
+      }
+    } else {
+      __usage("unknown option", option);
+    }
+  }
+
+  *files = i;
+  return options;
+}
+
+/**
+ * @brief   Reads the monotonic clock.
+ *
+ * @return  seconds since an arbitrary point
+ */
+static double __seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief   Computes what was asked for a set.
+ *
+ * @param   window           options of the run
+ * @param   job              the set, filled with its results
+ */
+static void __solve(const struct Window * window, struct Job * job)
+{
+  const struct Options *        options = window->options;
+  const struct DistanceMetric * metric  = window->metric;
+  const double(*points)[2]              = job->set.points;
+  const uint64_t n                      = job->set.num_points;
+
+  if (options->command == COMMAND_CENTER) {
+    Grid_2D center;
+    if (options->center == CENTER_MINIMAX) {
+      center = PointSet.minimax_center(points, n, metric, &job->cost);
+    } else {
+      const struct GeometricCenterOptions opts = {
+          options->epsilon, 10, false, metric, 0, 0};
+      center = options->center == CENTER_MEAN
+                   ? PointSet.mean(points, n)
+                   : PointSet.geometric_median(points, n, &opts, NULL);
+    }
+    job->center[0] = center.x;
+    job->center[1] = center.y;
+    if (options->center != CENTER_MINIMAX) {
+      job->cost = Metric.net_distance(
+          metric, job->center, 2, (const double **)points, n);
+    }
+  } else if (options->command == COMMAND_TOUR) {
+    const struct TSPOptions opts = {
+        options->tour, 0, 0, options->solver, 0, 0};
+    job->order = TSP.solve(
+        (const double **)points, n, 2, &opts, metric, &job->cost, NULL);
+  } else if (options->command == COMMAND_FIT) {
+    double * x = Array.Scratch.double_array(2 * n);
+    double * y = x + n;
+    for (uint64_t i = 0; i < n; ++i) {
+      x[i] = points[i][0];
+      y[i] = points[i][1];
+    }
+    job->degree = options->degree ? options->degree
+                                  : Polynomial.guess_degree(x, y, n);
+    job->fit    = Polynomial.best_fit(x, y, n, job->degree);
+    Array.release(x);
+  }
+}
+
+/**
+ * @brief   Solves a range of the sets of a window.
+ *
+ * @param   begin            first set of the range
+ * @param   end              one past the last set of the range
+ * @param   context          the window
+ */
+static void __solve_range(const uint64_t begin,
+                          const uint64_t end,
+                          void * const   context)
+{
+  const struct Window * window = context;
+  for (uint64_t j = begin; j < end; ++j) {
+    __solve(window, &window->jobs[j]);
+  }
+}
+
+/**
+ * @brief   Writes what was computed for a set.
+ *
+ * @param   options          options of the run
+ * @param   id               number of the set among all those read
+ * @param   job              the set and its results
+ */
+static void __write(const struct Options * options,
+                    const uint64_t         id,
+                    const struct Job *     job)
+{
+  const unsigned long long set = id;
+  if (options->command == COMMAND_CENTER) {
+    printf("%llu,%.17g,%.17g,%.17g\n",
+           set,
+           job->center[0],
+           job->center[1],
+           job->cost);
+  } else if (options->command == COMMAND_TOUR) {
+    printf("%llu,%.17g,", set, job->cost);
+    for (uint64_t i = 0; i < job->set.num_points; ++i) {
+      printf(i ? " %llu" : "%llu", (unsigned long long)job->order[i]);
+    }
+    putchar('\n');
+  } else if (options->command == COMMAND_FIT) {
+    printf("%llu", set);
+    for (uint64_t i = 0; i <= job->degree; ++i) {
+      printf(",%.17g", job->fit[i]);
+    }
+    putchar('\n');
+  }
+}
+
+/**
+ * @brief   Computes a range of the rows of a block of a distance matrix.
+ *
+ * @param   begin            first row of the range, within the block
+ * @param   end              one past the last row of the range
+ * @param   context          the block
+ */
+static void __distance_rows(const uint64_t begin,
+                            const uint64_t end,
+                            void * const   context)
+{
+  const struct DistanceBlock * block = context;
+  const uint64_t               n     = block->num_points;
+  for (uint64_t r = begin; r < end; ++r) {
+    const double * from = block->points[block->first + r];
+    double *       row  = block->rows + r * n;
+    for (uint64_t j = 0; j < n; ++j) {
+      row[j] = Metric.distance(block->metric, from, block->points[j], 2);
+    }
+  }
+}
+
+/**
+ * @brief   Writes the distance matrix of a set, a block of rows at a time, so
+ *          that only a block is ever held in memory.
+ *
+ * @param   options          options of the run
+ * @param   metric           how distance is measured
+ * @param   set              the set
+ */
+static void __write_distances(const struct Options *        options,
+                              const struct DistanceMetric * metric,
+                              const struct StreamedSet *    set)
+{
+  const uint64_t n          = set->num_points;
+  const uint64_t block_rows = n < DISTANCE_BLOCK ? DISTANCE_BLOCK / n : 1;
+  const uint64_t grain      = n < DISTANCE_GRAIN ? DISTANCE_GRAIN / n : 1;
+  const uint64_t held       = n < block_rows ? n : block_rows;
+
+  struct DistanceBlock block = {metric, set->points, n, 0, NULL};
+  block.rows                 = Array.Scratch.double_array(held * n);
+
+  for (; block.first < n; block.first += block_rows) {
+    const uint64_t rows =
+        n - block.first < block_rows ? n - block.first : block_rows;
+    Parallel.for_range(0, rows, grain, __distance_rows, &block);
+
+    if (options->binary) {
+      fwrite(block.rows, sizeof(double), rows * n, stdout);
+      continue;
+    }
+    for (uint64_t r = 0; r < rows; ++r) {
+      for (uint64_t j = 0; j < n; ++j) {
+        printf(j ? ",%.17g" : "%.17g", block.rows[r * n + j]);
+      }
+      putchar('\n');
+    }
+  }
+  if (!options->binary) {
+    putchar('\n');
+  }
+
+  Array.release(block.rows);
+}
+
+/**
+ * @brief   Frees what was computed for a set, and the set.
+ *
+ * @param   job              the set and its results
+ */
+static void __release(struct Job * job)
+{
+  PointStream.release(&job->set);
+  free(job->order);
+  free(job->fit);
+  memset(job, 0, sizeof *job);
+}
+
+/**
+ * @brief   Streams sets of points through the library, a bounded window of sets
+ *          at a time, and reports throughput.
+ * @details Sets are read ahead until the window holds enough of them to keep
+ *          every worker thread busy or enough points to bound memory, then
+ *          solved across threads, written in the order they were read, and
+ *          freed. Distance matrices are instead written a block of rows at a
+ *          time, each block computed across threads.
+ */
+int main(int argc, char * argv[])
+{
+  int                  first_file;
+  const struct Options options = __parse(argc, argv, &first_file);
+
+  const struct DistanceMetric metric = {options.metric, 'm', NULL, 0};
+  const uint64_t window_sets = SETS_PER_THREAD * Parallel.num_threads();
+
+  static char * const STANDARD_INPUT[] = {"-"};
+  char * const *      files = first_file < argc ? argv + first_file
+                                                  : STANDARD_INPUT;
+  const int num_files = first_file < argc ? argc - first_file : 1;
+
+  struct Job *  jobs   = calloc(window_sets, sizeof *jobs);
+  struct Window window = {&options, &metric, jobs};
+
+  const double start      = __seconds();
+  uint64_t     num_sets   = 0;
+  uint64_t     num_points = 0;
+
+  struct PointInput * stream = NULL;
+  int                 file   = 0;
+  bool                done   = false;
+  while (!done) {
+    // read sets ahead until the window is full
+    uint64_t count  = 0;
+    uint64_t points = 0;
+    while (count < window_sets && points < WINDOW_POINTS) {
+      if (!stream) {
+        if (file == num_files) {
+          done = true;
+          break;
+        }
+        stream = PointStream.open(files[file]);
+        if (!stream) {
+          char message[512];
+          snprintf(message,
+                   sizeof message,
+                   "%s: %s",
+                   files[file],
+                   strerror(errno));
+          __fail(message);
+        }
+        ++file;
+      }
+
+      if (!PointStream.next(stream, &jobs[count].set)) {
+        if (PointStream.error(stream)) {
+          __fail(PointStream.error(stream));
+        }
+        PointStream.close(stream);
+        stream = NULL;
+        continue;
+      }
+      points += jobs[count].set.num_points;
+      ++count;
+    }
+
+    // solve the window across threads, and write it out in order
+    if (options.command != COMMAND_DISTANCES) {
+      Parallel.for_range(0, count, 1, __solve_range, &window);
+    }
+    for (uint64_t j = 0; j < count; ++j) {
+      if (options.command == COMMAND_DISTANCES) {
+        __write_distances(&options, &metric, &jobs[j].set);
+      } else {
+        __write(&options, num_sets + j, &jobs[j]);
+      }
+      __release(&jobs[j]);
+    }
+    num_sets += count;
+    num_points += points;
+  }
+
+  free(jobs);
+  if (fflush(stdout) || ferror(stdout)) {
+    __fail(strerror(errno));
+  }
+
+  if (!options.quiet) {
+    const double elapsed = __seconds() - start;
+    fprintf(stderr,
+            "meethere: %llu sets, %llu points in %.3f s "
+            "(%.0f points/s, %.1f sets/s, %llu threads)\n",
+            (unsigned long long)num_sets,
+            (unsigned long long)num_points,
+            elapsed,
+            elapsed > 0 ? num_points / elapsed : 0,
+            elapsed > 0 ? num_sets / elapsed : 0,
+            (unsigned long long)Parallel.num_threads());
+  }
+  return EXIT_SUCCESS;
+}
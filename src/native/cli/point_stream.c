@@ -0,0 +1,279 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "point_stream.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+  MAGIC_LENGTH    = 4,
+  ERROR_LENGTH    = 512,
+  INITIAL_CSV_SET = 1024
+};
+
+/**
+ * @struct
+ * @brief  A source of point sets
+ *
+ * @prop   path        name of the file, for messages
+ * @prop   csv         CSV text being read, or NULL for a point file
+ * @prop   mapped      point file whose set has not been read yet
+ * @prop   line        buffer holding the last line read
+ * @prop   capacity    size of the line buffer
+ * @prop   line_number number of the last line read
+ * @prop   message     why the stream stopped, or empty if it ended
+ */
+struct PointInput
+{
+  char *                path;
+  FILE *                csv;
+  struct MappedPoints * mapped;
+  char *                line;
+  size_t                capacity;
+  uint64_t              line_number;
+  char                  message[ERROR_LENGTH];
+};
+
+/**
+ * @brief   Opens a stream over a file, telling point files from CSV by their
+ *          magic.
+ *
+ * @param   path             file to read, or "-" for CSV on standard input
+ *
+ * @return  the stream, to be closed with `close`, or NULL if the file cannot be
+ *          read; `errno` tells why
+ */
+static struct PointInput * open_(const char * path)
+{
+  const bool standard = !strcmp(path, "-");
+  FILE *     csv      = standard ? stdin : fopen(path, "rb");
+  if (!csv) {
+    return NULL;
+  }
+
+  struct MappedPoints * mapped = NULL;
+  if (!standard) {
+    char       magic[MAGIC_LENGTH];
+    const bool is_point_file =
+        fread(magic, 1, MAGIC_LENGTH, csv) == MAGIC_LENGTH &&
+        !memcmp(magic, "PSET", MAGIC_LENGTH);
+    if (is_point_file) {
+      fclose(csv);
+      csv    = NULL;
+      mapped = PointFile.open(path);
+      if (!mapped) {
+        return NULL;
+      }
+    } else {
+      rewind(csv);
+    }
+  }
+
+  struct PointInput * stream = calloc(1, sizeof *stream);
+  stream->path               = malloc(strlen(path) + 1);
+  strcpy(stream->path, path);
+  stream->csv    = csv;
+  stream->mapped = mapped;
+
+  return stream;
+}
+
+/**
+ * @brief   Closes a stream. Sets already read stay valid.
+ *
+ * @param   stream           stream to close
+ */
+static void close_(struct PointInput * stream)
+{
+  if (stream->csv && stream->csv != stdin) {
+    fclose(stream->csv);
+  }
+  PointFile.close(stream->mapped);
+  free(stream->line);
+  free(stream->path);
+  free(stream);
+}
+
+/**
+ * @brief   Parses a line of CSV text as a point.
+ * @details Coordinates may be separated by a comma, a semicolon, or
+ *          whitespace; any further columns are ignored.
+ *
+ * @param   line             the line
+ * @param   point            filled with the point
+ *
+ * @return  whether the line holds a point
+ */
+static bool __parse_point(const char * line, double point[2])
+{
+  char * end;
+  point[0] = strtod(line, &end);
+  if (end == line) {
+    return false;
+  }
+
+  line = end;
+  while (isspace((unsigned char)*line)) {
+    ++line;
+  }
+  if (*line == ',' || *line == ';') {
+    ++line;
+  }
+
+  point[1] = strtod(line, &end);
+  if (end == line) {
+    return false;
+  }
+  while (isspace((unsigned char)*end)) {
+    ++end;
+  }
+  return !*end || *end == ',' || *end == ';';
+}
+
+/**
+ * @brief   Determines whether a line holds nothing but whitespace.
+ *
+ * @param   line             the line
+ *
+ * @return  whether the line is blank
+ */
+static bool __is_blank(const char * line)
+{
+  while (isspace((unsigned char)*line)) {
+    ++line;
+  }
+  return !*line;
+}
+
+/**
+ * @brief   Reads the set of a point file, in place unless its values must be
+ *          decoded from float32.
+ *
+ * @param   stream           stream over the point file
+ * @param   set              filled with the set
+ *
+ * @return  whether the file held any points
+ */
+static bool __next_mapped(struct PointInput * stream, struct StreamedSet * set)
+{
+  struct MappedPoints * file = stream->mapped;
+  stream->mapped             = NULL;
+  if (!file || !file->num_points) {
+    PointFile.close(file);
+    return false;
+  }
+
+  set->num_points = file->num_points;
+  set->file       = file;
+  if (file->float32) {
+    set->owned = malloc(file->num_points * sizeof *set->owned);
+    PointFile.read(file, 0, file->num_points, set->owned);
+    set->points = (const double(*)[2])set->owned;
+  } else {
+    set->points = (const double(*)[2])file->coords;
+  }
+  return true;
+}
+
+/**
+ * @brief   Reads the next non-empty set of a stream.
+ * @details Point files holding float64 values are read in place, and only one
+ *          set of CSV text is held in memory at a time, so memory is bounded
+ *          by the size of a set rather than of the stream. A leading line that
+ *          is not a point is skipped as a header.
+ *
+ * @param   stream           stream to read
+ * @param   set              filled with the set, to be given back with
+ *                           `release`
+ *
+ * @return  whether a set was read; if not, `error` tells whether the stream
+ *          ended or could not be read
+ */
+static bool next(struct PointInput * stream, struct StreamedSet * set)
+{
+  memset(set, 0, sizeof *set);
+  if (!stream->csv) {
+    return __next_mapped(stream, set);
+  }
+
+  uint64_t capacity = 0;
+  while (getline(&stream->line, &stream->capacity, stream->csv) >= 0) {
+    ++stream->line_number;
+    if (__is_blank(stream->line)) {
+      if (set->num_points) {
+        break;
+      }
+      continue;
+    }
+
+    double point[2];
+    if (!__parse_point(stream->line, point)) {
+      if (stream->line_number == 1) {
+        continue;
+      }
+      snprintf(stream->message,
+               ERROR_LENGTH,
+               "%s:%llu: expected a point as `x,y`",
+               stream->path,
+               (unsigned long long)stream->line_number);
+      PointStream.release(set);
+      return false;
+    }
+
+    if (set->num_points == capacity) {
+      capacity   = capacity ? 2 * capacity : INITIAL_CSV_SET;
+      set->owned = realloc(set->owned, capacity * sizeof *set->owned);
+    }
+    set->owned[set->num_points][0] = point[0];
+    set->owned[set->num_points][1] = point[1];
+    ++set->num_points;
+  }
+
+  if (ferror(stream->csv)) {
+    snprintf(stream->message,
+             ERROR_LENGTH,
+             "%s: %s",
+             stream->path,
+             strerror(errno));
+    PointStream.release(set);
+    return false;
+  }
+
+  set->points = (const double(*)[2])set->owned;
+  return set->num_points > 0;
+}
+
+/**
+ * @brief   Frees the memory held by a set.
+ *
+ * @param   set              set to free
+ */
+static void release(struct StreamedSet * set)
+{
+  free(set->owned);
+  PointFile.close(set->file);
+  memset(set, 0, sizeof *set);
+}
+
+/**
+ * @brief   Describes why a stream stopped yielding sets.
+ *
+ * @param   stream           the stream
+ *
+ * @return  a message naming the file and line at fault, or NULL if the stream
+ *          simply ended
+ */
+static const char * error(const struct PointInput * stream)
+{
+  return stream->message[0] ? stream->message : NULL;
+}
+
+const struct point_stream PointStream = {.open    = open_,
+                                         .close   = close_,
+                                         .next    = next,
+                                         .release = release,
+                                         .error   = error};
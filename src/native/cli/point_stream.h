@@ -0,0 +1,89 @@
+#ifndef CLI_POINT_STREAM_H
+#define CLI_POINT_STREAM_H
+
+#include "../toolkit/point_file.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct
+ * @brief  A source of point sets: a point file, which holds one set, or CSV
+ *         text of `x,y` lines, where blank lines separate sets
+ */
+struct PointInput;
+
+/**
+ * @struct
+ * @brief  One set of points read from a stream
+ *
+ * @prop   points      the points
+ * @prop   num_points  number of points
+ * @prop   owned       memory holding the points, if read into memory
+ * @prop   file        mapping holding the points, if read in place
+ */
+struct StreamedSet
+{
+  const double (*points)[2];
+  uint64_t              num_points;
+  double (*owned)[2];
+  struct MappedPoints * file;
+};
+
+struct point_stream
+{
+  /**
+   * @brief   Opens a stream over a file, telling point files from CSV by
+   *          their magic.
+   *
+   * @param   path             file to read, or "-" for CSV on standard input
+   *
+   * @return  the stream, to be closed with `close`, or NULL if the file cannot
+   *          be read; `errno` tells why
+   */
+  struct PointInput * (*open)(const char * path);
+
+  /**
+   * @brief   Closes a stream. Sets already read stay valid.
+   *
+   * @param   stream           stream to close
+   */
+  void (*close)(struct PointInput * stream);
+
+  /**
+   * @brief   Reads the next non-empty set of a stream.
+   * @details Point files holding float64 values are read in place, and only
+   *          one set of CSV text is held in memory at a time, so memory is
+   *          bounded by the size of a set rather than of the stream. A leading
+   *          line that is not a point is skipped as a header.
+   *
+   * @param   stream           stream to read
+   * @param   set              filled with the set, to be given back with
+   *                           `release`
+   *
+   * @return  whether a set was read; if not, `error` tells whether the stream
+   *          ended or could not be read
+   */
+  bool (*next)(struct PointInput * stream, struct StreamedSet * set);
+
+  /**
+   * @brief   Frees the memory held by a set.
+   *
+   * @param   set              set to free
+   */
+  void (*release)(struct StreamedSet * set);
+
+  /**
+   * @brief   Describes why a stream stopped yielding sets.
+   *
+   * @param   stream           the stream
+   *
+   * @return  a message naming the file and line at fault, or NULL if the
+   *          stream simply ended
+   */
+  const char * (*error)(const struct PointInput * stream);
+};
+
+extern const struct point_stream PointStream;
+
+#endif
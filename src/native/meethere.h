@@ -0,0 +1,32 @@
+#ifndef MEETHERE_H
+#define MEETHERE_H
+
+/**
+ * @file
+ * @brief  Public interface of the standalone C library, built by the
+ *         `meethere` target of `binding.gyp` without Node.js. Every module is
+ *         reached through its function table, such as `PointSet.mean` or
+ *         `TSP.solve`. Memory handed back by a module is freed as its
+ *         documentation says: with `free`, or with `Array.release` when it
+ *         was borrowed from `Array.Scratch`.
+ */
+
+#define MEETHERE_VERSION_MAJOR 0
+#define MEETHERE_VERSION_MINOR 3
+#define MEETHERE_VERSION_PATCH 0
+
+#include "cartesian.h"
+#include "point_set.h"
+#include "polynomial.h"
+#include "toolkit/array.h"
+#include "toolkit/hilbert.h"
+#include "toolkit/metric.h"
+#include "toolkit/parallel.h"
+#include "toolkit/point_file.h"
+#include "toolkit/spatial_index.h"
+#include "toolkit/stats.h"
+#include "tour.h"
+#include "tsp.h"
+#include "vrp.h"
+
+#endif
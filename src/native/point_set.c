@@ -1,8 +1,13 @@
 #include "point_set.h"
 
 #include "toolkit/array.h"
-#include "toolkit/ips.h"
+#include "toolkit/kernel.h"
+#include "toolkit/metric.h"
+#include "toolkit/parallel.h"
+#include "toolkit/spatial_index.h"
+#include "toolkit/stats.h"
 
+#include <float.h>
 #include <stdlib.h>
 
 enum NUM_DIRS
@@ -10,6 +15,24 @@ enum NUM_DIRS
   NUM_DIRS = 8
 };
 
+enum ASSIGN_BLOCK
+{
+  /**
+   * Centers scanned by each pass of an assignment, whose distances are held
+   * on the stack.
+   */
+  ASSIGN_BLOCK = 256
+};
+
+enum MEDOID_BATCH
+{
+  /**
+   * Candidates whose net distance is computed in full by each round of a
+   * medoid search.
+   */
+  MEDOID_BATCH = 32
+};
+
 /*
  *           (0,1)
  *    (-S2,S2)   (S2,S2)
@@ -25,6 +48,44 @@ static const struct
   double y[NUM_DIRS];
 } DELTA = {{-1, -S2, 0, S2, 1, S2, 0, -S2}, {0, S2, 1, S2, 0, -S2, -1, -S2}};
 
+/**
+ * Minimum number of sets solved by each thread of a batch.
+ */
+static const uint64_t BATCH_GRAIN = 16;
+
+/**
+ * Relative slack allowed when testing whether a circle holds a point, so that
+ * points on its boundary are not lost to rounding.
+ */
+static const double CIRCLE_SLACK = 1e-12;
+
+/**
+ * Minimum number of points assigned by each thread.
+ */
+static const uint64_t ASSIGN_GRAIN = 512;
+
+/**
+ * Number of centers from which points are assigned through a spatial index
+ * over the centers, rather than by scanning every center.
+ */
+static const uint64_t ASSIGN_INDEX_CENTERS = 64;
+
+/**
+ * Minimum number of distances measured by each thread of a medoid search.
+ */
+static const uint64_t MEDOID_GRAIN = 65536;
+
+/**
+ * Minimum number of candidates bounded by each thread of a medoid search.
+ */
+static const uint64_t MEDOID_BOUND_GRAIN = 4096;
+
+/**
+ * Relative slack allowed when dropping candidates of a medoid search, so that
+ * candidates tied with the best one up to rounding are still measured.
+ */
+static const double MEDOID_SLACK = 1e-9;
+
 /**
  * @brief   Finds the mean of a set of 2D points.
  * @details Assumes all points have equal weight. Puts the center of mass in a
@@ -37,54 +98,70 @@ static const struct
  */
 static Grid_2D mean(const double points[][DIM2], const uint64_t num_points)
 {
-  Grid_2D center = {0, 0};
-  for (uint64_t i = 0; i < num_points; ++i) {
-    center.x += points[i][0];
-    center.y += points[i][1];
-  }
-
-  center.x = center.x / num_points;
-  center.y = center.y / num_points;
-
-  return center;
+  return kernel_mean_2d((const double *)points, num_points);
 }
 
 /**
- * @brief   Finds the geometric median of a set of 2D points.
- * @details Fills an array with the geometric center of an arbitrary amount of
- *          points. Returns the score (total cost to center) of the geometric
- *          center.
- *          The algorithm is a simple Newtonian search. We iterate an
+ * @brief   Searches for the geometric median of a set of 2D points, starting
+ *          from their mean.
+ * @details The algorithm is a simple Newtonian search. We iterate an
  *          indiscriminate amount of times through smaller bounds until we
  *          approve some margin of error. Note that local maxima are a
  *          non-issue, as the geometric median is (unique and covergent for
  *          non-co-linear
  *          points)[http://www.stat.rutgers.edu/home/cunhui/papers/39.pdf].
+ *          Candidates are scored under the metric of the options, while the
+ *          initial step is sized by euclidean distance so that it stays in
+ *          the units of the coordinates. Once the deadline or iteration
+ *          limit of the options is reached, the best center so far is kept.
  *
- * @param   points     points to find the center of
+ * @param   flat       flattened points to find the center of
  * @param   num_points number of points
  * @param   options    specified margin of error, bound range, and subsearch
  *                     value
+ * @param   center     mean of the points
+ * @param   spread     net euclidean distance from the points to their mean
+ * @param   score      filled with the net distance from the points to the
+ *                     center found, under the metric of the options
+ * @param   report     if not NULL, filled with whether a limit of the options
+ *                     stopped the search, the steps taken, and the step size
+ *                     reached
  *
- * @return  pointer to geometric median of points
+ * @return  geometric median of points
  */
-static Grid_2D geometric_median(const double   points[][DIM2],
-                                const uint64_t num_points,
-                                const struct GeometricCenterOptions * options)
-{
-  // fill center to CoM, calculate initial score and step
-  Grid_2D center             = PointSet.mean(points, num_points);
-  double  __center_arr[DIM2] = {center.x, center.y};
-  double  score              = IPS.net_distance(DIM2,
-                                  (const double *)__center_arr,
-                                  DIM2,
-                                  (const double **)points,
-                                  num_points);
-  double  step               = score / num_points * options->bounds;
+static Grid_2D __descend(const double   flat[],
+                         const uint64_t num_points,
+                         const struct GeometricCenterOptions * options,
+                         Grid_2D                               center,
+                         const double                          spread,
+                         double *                              score,
+                         struct SolveReport *                  report)
+{
+  const struct DistanceMetric * metric =
+      options->metric ? options->metric : &METRIC_EUCLIDEAN;
+
+  // initial score and step from the CoM
+  double __center_arr[DIM2] = {center.x, center.y};
+  double step               = spread / num_points * options->bounds;
+  *score                    = spread;
+
+  // steps taken, and net distances evaluated
+  struct Deadline deadline =
+      deadline_start(options->deadline_ms, options->max_iterations);
+  uint64_t passes = 1;
+
+  if (metric->type != METRIC_L2) {
+    *score = kernel_net_metric_distance(metric,
+                                        __center_arr,
+                                        DIM2,
+                                        flat,
+                                        num_points);
+    ++passes;
+  }
 
   // descend gradient, searching for the function minimum, until the error
   // reaches some acceptable epsilon.
-  while (step > options->epsilon) {
+  while (step > options->epsilon && !deadline_reached(&deadline)) {
     bool improved = false;
 
     // check points a step in each direction to find the lowest cost
@@ -92,16 +169,17 @@ static Grid_2D geometric_median(const double   points[][DIM2],
       __center_arr[0] = center.x + step * DELTA.x[i];
       __center_arr[1] = center.y + step * DELTA.y[i];
 
-      const double _score = IPS.net_distance(DIM2,
-                                             (const double *)__center_arr,
-                                             DIM2,
-                                             (const double **)points,
-                                             num_points);
+      const double _score = kernel_net_metric_distance(metric,
+                                                       __center_arr,
+                                                       DIM2,
+                                                       flat,
+                                                       num_points);
+      ++passes;
 
-      if (_score < score) {
+      if (_score < *score) {
         center.x = __center_arr[0];
         center.y = __center_arr[1];
-        score    = _score;
+        *score   = _score;
         improved = true;
         break;
       }
@@ -112,8 +190,1246 @@ static Grid_2D geometric_median(const double   points[][DIM2],
     }
   }
 
+  Stats.count(STAT_CENTER_ITERATIONS, deadline.iterations);
+  Stats.count(STAT_NET_DISTANCE_PASSES, passes);
+
+  if (report) {
+    report->partial    = deadline.reached;
+    report->precision  = step;
+    report->iterations = deadline.iterations;
+  }
+
+  return center;
+}
+
+/**
+ * @brief   Finds the geometric median of a set of 2D points.
+ * @details Fills an array with the geometric center of an arbitrary amount of
+ *          points, searching outwards from their center of mass until the
+ *          margin of error, the deadline, or the iteration limit is reached.
+ *
+ * @param   points     points to find the center of
+ * @param   num_points number of points
+ * @param   options    specified margin of error, bound range, subsearch
+ *                     value, and limits
+ * @param   report     if not NULL, filled with whether a limit stopped the
+ *                     search, the steps taken, and the step size reached
+ *
+ * @return  pointer to geometric median of points
+ */
+static Grid_2D geometric_median(const double   points[][DIM2],
+                                const uint64_t num_points,
+                                const struct GeometricCenterOptions * options,
+                                struct SolveReport *                  report)
+{
+  const double * flat = (const double *)points;
+
+  // fill center to CoM, and find the spread around it
+  const Grid_2D center             = kernel_mean_2d(flat, num_points);
+  const double  __center_arr[DIM2] = {center.x, center.y};
+  const double  spread             = kernel_net_l2_distance(__center_arr,
+                                                            DIM2,
+                                                            flat,
+                                                            num_points);
+
+  double score;
+  return __descend(flat, num_points, options, center, spread, &score, report);
+}
+
+/**
+ * @brief   Summarizes a set of 2D points.
+ * @details Gives in one call what `mean`, `geometric_median`, and the net
+ *          distances to each would, along with the bounding box and variance.
+ *          Sums and bounds share a first pass over the points, and squared
+ *          deviations and distances to the mean a second; the search for the
+ *          geometric median then starts from the mean and its cost, and its
+ *          last score is the cost of the center.
+ *
+ * @param   points     points to summarize
+ * @param   num_points number of points
+ * @param   options    specified margin of error, bound range, subsearch value,
+ *                     and metric of the geometric median
+ *
+ * @return  summary of the points; all zero for an empty set
+ */
+static struct PointSummary
+summary(const double                          points[][DIM2],
+        const uint64_t                        num_points,
+        const struct GeometricCenterOptions * options)
+{
+  struct PointSummary S = {{0, 0}, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}, 0};
+  if (!num_points) {
+    return S;
+  }
+
+  // sums and bounds
+  const double * flat = (const double *)points;
+  S.min.x = S.max.x = flat[0];
+  S.min.y = S.max.y = flat[1];
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const double x = flat[2 * i];
+    const double y = flat[2 * i + 1];
+    S.mean.x += x;
+    S.mean.y += y;
+    S.min.x = x < S.min.x ? x : S.min.x;
+    S.max.x = x > S.max.x ? x : S.max.x;
+    S.min.y = y < S.min.y ? y : S.min.y;
+    S.max.y = y > S.max.y ? y : S.max.y;
+  }
+  S.mean.x = S.mean.x / num_points;
+  S.mean.y = S.mean.y / num_points;
+
+  // deviations and distances from the mean
+  double spread = 0;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const double dx = flat[2 * i] - S.mean.x;
+    const double dy = flat[2 * i + 1] - S.mean.y;
+    S.variance.x += dx * dx;
+    S.variance.y += dy * dy;
+    spread += sqrt(dx * dx + dy * dy);
+  }
+  S.variance.x = S.variance.x / num_points;
+  S.variance.y = S.variance.y / num_points;
+
+  S.center = __descend(flat,
+                       num_points,
+                       options,
+                       S.mean,
+                       spread,
+                       &S.center_cost,
+                       NULL);
+
+  // cost of the mean, measured as the cost of the center is
+  const struct DistanceMetric * metric =
+      options->metric ? options->metric : &METRIC_EUCLIDEAN;
+  const double __mean_arr[DIM2] = {S.mean.x, S.mean.y};
+  S.mean_cost                   = metric->type == METRIC_L2
+                                      ? spread
+                                      : kernel_net_metric_distance(metric,
+                                                                   __mean_arr,
+                                                                   DIM2,
+                                                                   flat,
+                                                                   num_points);
+  return S;
+}
+
+/**
+ * @struct
+ * @brief  A batch of point sets, packed one after another
+ *
+ * @prop   points  points of every set
+ * @prop   offsets index of the first point of each set, followed by the total
+ *                 number of points
+ * @prop   options options for the geometric center, or NULL for the mean
+ * @prop   centers filled with the center of each set
+ * @prop   scores  filled with the net distance to the center of each set
+ */
+struct __batch
+{
+  const double *                        points;
+  const uint64_t *                      offsets;
+  const struct GeometricCenterOptions * options;
+  double *                              centers;
+  double *                              scores;
+};
+
+/**
+ * @brief   Finds the centers of a range of sets in a batch.
+ *
+ * @param   begin            first set of the range
+ * @param   end              one past the last set of the range
+ * @param   context          the batch
+ */
+static void __batch_task(const uint64_t begin,
+                         const uint64_t end,
+                         void *         context)
+{
+  const struct __batch *        B      = context;
+  const struct DistanceMetric * metric = B->options && B->options->metric
+                                             ? B->options->metric
+                                             : &METRIC_EUCLIDEAN;
+
+  for (uint64_t s = begin; s < end; ++s) {
+    const uint64_t first      = B->offsets[s];
+    const uint64_t num_points = B->offsets[s + 1] - first;
+    const double * flat       = B->points + kernel_idx_2d(first, 0, DIM2);
+    double *       center_arr = B->centers + kernel_idx_2d(s, 0, DIM2);
+
+    const Grid_2D center =
+        B->options
+            ? geometric_median((const double(*)[DIM2])flat,
+                               num_points,
+                               B->options,
+                               NULL)
+            : kernel_mean_2d(flat, num_points);
+    center_arr[0] = center.x;
+    center_arr[1] = center.y;
+    B->scores[s]  = kernel_net_metric_distance(metric,
+                                               center_arr,
+                                               DIM2,
+                                               flat,
+                                               num_points);
+  }
+}
+
+/**
+ * @brief   Finds the mean of each of a batch of sets of 2D points.
+ * @details Set `s` is made of the points from `offsets[s]` up to
+ *          `offsets[s + 1]`. Sets are spread across worker threads.
+ *
+ * @param   points     points of every set, packed one set after another
+ * @param   offsets    index of the first point of each set, followed by the
+ *                     total number of points
+ * @param   num_sets   number of sets
+ * @param   centers    filled with the mean of each set
+ * @param   scores     filled with the net euclidean distance from each set to
+ *                     its mean
+ */
+static void mean_batch(const double   points[][DIM2],
+                       const uint64_t offsets[],
+                       const uint64_t num_sets,
+                       double         centers[][DIM2],
+                       double         scores[])
+{
+  struct __batch batch = {(const double *)points,
+                          offsets,
+                          NULL,
+                          (double *)centers,
+                          scores};
+  Parallel.for_range(0, num_sets, BATCH_GRAIN, __batch_task, &batch);
+}
+
+/**
+ * @brief   Finds the geometric median of each of a batch of sets of 2D points.
+ * @details Set `s` is made of the points from `offsets[s]` up to
+ *          `offsets[s + 1]`. Sets are spread across worker threads, and each
+ *          is searched as by `geometric_median`.
+ *
+ * @param   points     points of every set, packed one set after another
+ * @param   offsets    index of the first point of each set, followed by the
+ *                     total number of points
+ * @param   num_sets   number of sets
+ * @param   options    specified margin of error, bound range, subsearch value,
+ *                     and metric, shared by every set
+ * @param   centers    filled with the geometric median of each set
+ * @param   scores     filled with the net distance from each set to its
+ *                     geometric median, under the metric of the options
+ */
+static void geometric_median_batch(
+    const double                          points[][DIM2],
+    const uint64_t                        offsets[],
+    const uint64_t                        num_sets,
+    const struct GeometricCenterOptions * options,
+    double                                centers[][DIM2],
+    double                                scores[])
+{
+  struct __batch batch = {(const double *)points,
+                          offsets,
+                          options,
+                          (double *)centers,
+                          scores};
+  Parallel.for_range(0, num_sets, BATCH_GRAIN, __batch_task, &batch);
+}
+
+/**
+ * @struct
+ * @brief  A circle of the plane, or a cap of the unit sphere
+ *
+ * @prop   c center of the circle, as a 3D vector
+ * @prop   r straight-line distance from the center to the boundary
+ */
+struct __circle
+{
+  double c[3];
+  double r;
+};
+
+/**
+ * @brief   Determines whether a circle holds a point.
+ *
+ * @param   C                the circle
+ * @param   p                the point, as a 3D vector
+ *
+ * @return  whether the point is inside or on the circle
+ */
+static bool __holds(const struct __circle * C, const double p[3])
+{
+  return kernel_l2_distance(C->c, p, 3) <=
+         C->r * (1 + CIRCLE_SLACK) + CIRCLE_SLACK;
+}
+
+/**
+ * @brief   Sizes a circle, from its center, to reach the farthest of three
+ *          points.
+ *
+ * @param   C                the circle
+ * @param   a                the first point
+ * @param   b                the second point
+ * @param   c                the third point
+ */
+static void __reach(struct __circle * C,
+                    const double      a[3],
+                    const double      b[3],
+                    const double      c[3])
+{
+  C->r = fmax(kernel_l2_distance(C->c, a, 3),
+              fmax(kernel_l2_distance(C->c, b, 3),
+                   kernel_l2_distance(C->c, c, 3)));
+}
+
+/**
+ * @brief   Finds the smallest circle with two points on its boundary.
+ *
+ * @param   a                the first point
+ * @param   b                the second point
+ * @param   sphere           whether the points lie on the unit sphere
+ *
+ * @return  the circle
+ */
+static struct __circle __circle_2(const double a[3],
+                                  const double b[3],
+                                  const bool   sphere)
+{
+  struct __circle C;
+  for (uint64_t d = 0; d < 3; ++d) {
+    C.c[d] = (a[d] + b[d]) / 2;
+  }
+
+  const double norm = sqrt(C.c[0] * C.c[0] + C.c[1] * C.c[1] + C.c[2] * C.c[2]);
+  if (sphere && norm > DBL_EPSILON) {
+    for (uint64_t d = 0; d < 3; ++d) {
+      C.c[d] /= norm;
+    }
+  }
+
+  __reach(&C, a, b, b);
+  return C;
+}
+
+/**
+ * @brief   Finds the circle with three points on its boundary.
+ * @details Nearly collinear points fall back to the widest circle through two
+ *          of them.
+ *
+ * @param   a                the first point
+ * @param   b                the second point
+ * @param   c                the third point
+ * @param   sphere           whether the points lie on the unit sphere
+ *
+ * @return  the circle
+ */
+static struct __circle __circle_3(const double a[3],
+                                  const double b[3],
+                                  const double c[3],
+                                  const bool   sphere)
+{
+  const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  const double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  const double ab2   = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+  const double ac2   = ac[0] * ac[0] + ac[1] * ac[1] + ac[2] * ac[2];
+
+  struct __circle C;
+  if (sphere) {
+    // the center is the unit normal of the plane through the points, on
+    // their side of the sphere
+    const double n[3] = {ab[1] * ac[2] - ab[2] * ac[1],
+                         ab[2] * ac[0] - ab[0] * ac[2],
+                         ab[0] * ac[1] - ab[1] * ac[0]};
+    const double norm = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    const double side = n[0] * a[0] + n[1] * a[1] + n[2] * a[2] < 0 ? -1 : 1;
+
+    if (norm > DBL_EPSILON * sqrt(ab2 * ac2)) {
+      for (uint64_t d = 0; d < 3; ++d) {
+        C.c[d] = side * n[d] / norm;
+      }
+      __reach(&C, a, b, c);
+      return C;
+    }
+  } else {
+    const double det = 2 * (ab[0] * ac[1] - ab[1] * ac[0]);
+
+    if (fabs(det) > DBL_EPSILON * (ab2 + ac2)) {
+      C.c[0] = a[0] + (ac[1] * ab2 - ab[1] * ac2) / det;
+      C.c[1] = a[1] + (ab[0] * ac2 - ac[0] * ab2) / det;
+      C.c[2] = 0;
+      __reach(&C, a, b, c);
+      return C;
+    }
+  }
+
+  // collinear: the farthest two points span the others
+  const struct __circle C_ab = __circle_2(a, b, sphere);
+  const struct __circle C_ac = __circle_2(a, c, sphere);
+  const struct __circle C_bc = __circle_2(b, c, sphere);
+  C = C_ab.r > C_ac.r ? C_ab : C_ac;
+  return C.r > C_bc.r ? C : C_bc;
+}
+
+/**
+ * @brief   Finds the smallest circle enclosing a set of points.
+ * @details Welzl's algorithm, unrolled: whenever a point falls outside the
+ *          circle of the points before it, it must lie on the boundary of
+ *          their enclosing circle, which is found again with it fixed. Over
+ *          points in random order, each such rebuild is rare enough that the
+ *          expected time is linear.
+ *
+ * @param   P                points in random order, as 3D vectors
+ * @param   n                number of points; at least one
+ * @param   sphere           whether the points lie on the unit sphere
+ *
+ * @return  the enclosing circle
+ */
+static struct __circle __enclose(const double P[][3],
+                                 const uint64_t n,
+                                 const bool     sphere)
+{
+  struct __circle C = {{P[0][0], P[0][1], P[0][2]}, 0};
+
+  for (uint64_t i = 1; i < n; ++i) {
+    if (__holds(&C, P[i])) {
+      continue;
+    }
+
+    C = (struct __circle){{P[i][0], P[i][1], P[i][2]}, 0};
+    for (uint64_t j = 0; j < i; ++j) {
+      if (__holds(&C, P[j])) {
+        continue;
+      }
+
+      C = __circle_2(P[i], P[j], sphere);
+      for (uint64_t k = 0; k < j; ++k) {
+        if (!__holds(&C, P[k])) {
+          C = __circle_3(P[i], P[j], P[k], sphere);
+        }
+      }
+    }
+  }
+
+  return C;
+}
+
+/**
+ * @brief   Shuffles points, with a fixed seed so that results repeat.
+ *
+ * @param   P                points to shuffle, as 3D vectors
+ * @param   n                number of points
+ */
+static void __shuffle(double P[][3], const uint64_t n)
+{
+  uint64_t state = 0x9E3779B97F4A7C15u;
+
+  for (uint64_t i = n; i > 1; --i) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    const uint64_t j = state % i;
+    for (uint64_t d = 0; d < 3; ++d) {
+      const double swap = P[i - 1][d];
+      P[i - 1][d]       = P[j][d];
+      P[j][d]           = swap;
+    }
+  }
+}
+
+/**
+ * @brief   Finds the manhattan minimax center of a set of 2D points.
+ * @details Rotating the plane by 45 degrees turns manhattan distance into the
+ *          greatest difference along either axis, which the center of the
+ *          bounding box minimizes.
+ *
+ * @param   points     flattened points to find the center of
+ * @param   num_points number of points; at least one
+ *
+ * @return  manhattan minimax center of points
+ */
+static Grid_2D __minimax_l1(const double points[], const uint64_t num_points)
+{
+  double lo_u = INFINITY, hi_u = -INFINITY;
+  double lo_v = INFINITY, hi_v = -INFINITY;
+
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const double u = points[kernel_idx_2d(i, 0, DIM2)] +
+                     points[kernel_idx_2d(i, 1, DIM2)];
+    const double v = points[kernel_idx_2d(i, 0, DIM2)] -
+                     points[kernel_idx_2d(i, 1, DIM2)];
+    lo_u = fmin(lo_u, u);
+    hi_u = fmax(hi_u, u);
+    lo_v = fmin(lo_v, v);
+    hi_v = fmax(hi_v, v);
+  }
+
+  const double  u      = (lo_u + hi_u) / 2;
+  const double  v      = (lo_v + hi_v) / 2;
+  const Grid_2D center = {(u + v) / 2, (u - v) / 2};
+  return center;
+}
+
+/**
+ * @brief   Finds the minimax center of a set of 2D points: the point whose
+ *          greatest distance to any of the points is least.
+ * @details Under euclidean distance, this is the center of the smallest
+ *          circle enclosing the points, found by Welzl's randomized
+ *          incremental algorithm in expected linear time. Under haversine,
+ *          it is the center of the smallest cap of the sphere enclosing the
+ *          points, found the same way over unit vectors; the points are
+ *          expected to lie within a hemisphere. Under manhattan distance,
+ *          it is the center of the bounding box of the points rotated by 45
+ *          degrees. A custom matrix metric falls back to euclidean.
+ *
+ * @param   points     points to find the center of
+ * @param   num_points number of points
+ * @param   metric     how distance to the center is measured; NULL for
+ *                     euclidean
+ * @param   radius     filled with the greatest distance from the center to
+ *                     a point, under the metric
+ *
+ * @return  minimax center of points
+ */
+static Grid_2D minimax_center(const double                  points[][DIM2],
+                              const uint64_t                num_points,
+                              const struct DistanceMetric * metric,
+                              double *                      radius)
+{
+  const double * flat   = (const double *)points;
+  Grid_2D        center = {0, 0};
+
+  metric  = metric ? metric : &METRIC_EUCLIDEAN;
+  *radius = 0;
+  if (!num_points) {
+    return center;
+  }
+
+  if (metric->type == METRIC_L1) {
+    center = __minimax_l1(flat, num_points);
+  } else {
+    const bool sphere = metric->type == METRIC_HAVERSINE;
+    double(*P)[3] =
+        (double(*)[3])Array.Scratch.double_array(3 * num_points);
+
+    for (uint64_t i = 0; i < num_points; ++i) {
+      if (sphere) {
+        const double lat = points[i][0] / 180 * KERNEL_PI;
+        const double lng = points[i][1] / 180 * KERNEL_PI;
+        P[i][0]          = cos(lat) * cos(lng);
+        P[i][1]          = cos(lat) * sin(lng);
+        P[i][2]          = sin(lat);
+      } else {
+        P[i][0] = points[i][0];
+        P[i][1] = points[i][1];
+        P[i][2] = 0;
+      }
+    }
+
+    __shuffle(P, num_points);
+    const struct __circle C =
+        __enclose((const double(*)[3])P, num_points, sphere);
+    Array.release(P);
+
+    if (sphere) {
+      center.x = asin(fmax(-1, fmin(1, C.c[2]))) / KERNEL_PI * 180;
+      center.y = atan2(C.c[1], C.c[0]) / KERNEL_PI * 180;
+    } else {
+      center.x = C.c[0];
+      center.y = C.c[1];
+    }
+  }
+
+  const double center_arr[DIM2] = {center.x, center.y};
+  for (uint64_t i = 0; i < num_points; ++i) {
+    *radius = fmax(*radius,
+                   kernel_metric_distance(metric, center_arr, points[i], DIM2));
+  }
+
   return center;
 }
 
-const struct point_set PointSet = {.mean             = mean,
-                                   .geometric_median = geometric_median};
+/**
+ * @struct
+ * @brief  An assignment of points to their nearest centers
+ *
+ * @prop   points      points to assign
+ * @prop   centers     centers to assign the points to
+ * @prop   metric      how distance to a center is measured
+ * @prop   coordinates for a scan, the first, second, and third coordinates of
+ *                     every center one after another: the center itself, or
+ *                     its unit vector under haversine
+ * @prop   num_centers number of centers
+ * @prop   tree        for a search, a spatial index over the centers
+ * @prop   nearest     filled with the nearest center to each point
+ * @prop   distances   filled with the distance to the nearest center
+ */
+struct __assignment
+{
+  const double (*points)[DIM2];
+  const double (*centers)[DIM2];
+  const struct DistanceMetric * metric;
+  const double *                coordinates;
+  uint64_t                      num_centers;
+  const struct SpatialTree *    tree;
+  uint64_t *                    nearest;
+  double *                      distances;
+};
+
+/**
+ * @brief   Maps a point to the coordinates centers are scanned over.
+ *
+ * @param   metric           how distance is measured
+ * @param   point            the point
+ * @param   coordinates      filled with the point itself, or its unit vector
+ *                           under haversine
+ */
+static void __assign_coordinates(const struct DistanceMetric * metric,
+                                 const double                  point[DIM2],
+                                 double                        coordinates[3])
+{
+  if (metric->type == METRIC_HAVERSINE) {
+    const double lat = point[0] / 180 * KERNEL_PI;
+    const double lng = point[1] / 180 * KERNEL_PI;
+    coordinates[0]   = cos(lat) * cos(lng);
+    coordinates[1]   = cos(lat) * sin(lng);
+    coordinates[2]   = sin(lat);
+  } else {
+    coordinates[0] = point[0];
+    coordinates[1] = point[1];
+    coordinates[2] = 0;
+  }
+}
+
+/**
+ * @brief   Ranks a block of centers by their distance to a point.
+ * @details Each metric has its own branch-free loop over contiguous center
+ *          coordinates, which the compiler vectorizes. The ranks order the
+ *          centers as the metric does: manhattan distance, squared euclidean
+ *          distance, or the squared chord between unit vectors.
+ *
+ * @param   type             how distance is measured
+ * @param   p                coordinates of the point
+ * @param   x                first coordinate of each center
+ * @param   y                second coordinate of each center
+ * @param   z                third coordinate of each center
+ * @param   count            number of centers, at most `ASSIGN_BLOCK`
+ * @param   ranks            filled with the rank of each center
+ */
+static void __rank_centers(const enum MetricType type,
+                           const double          p[3],
+                           const double          x[],
+                           const double          y[],
+                           const double          z[],
+                           const uint64_t        count,
+                           double                ranks[])
+{
+  switch (type) {
+    case METRIC_L1:
+      for (uint64_t j = 0; j < count; ++j) {
+        ranks[j] = fabs(x[j] - p[0]) + fabs(y[j] - p[1]);
+      }
+      break;
+    case METRIC_HAVERSINE:
+      for (uint64_t j = 0; j < count; ++j) {
+        const double dx = x[j] - p[0];
+        const double dy = y[j] - p[1];
+        const double dz = z[j] - p[2];
+        ranks[j]        = dx * dx + dy * dy + dz * dz;
+      }
+      break;
+    case METRIC_L2:
+    case METRIC_MATRIX:
+    default:
+      for (uint64_t j = 0; j < count; ++j) {
+        const double dx = x[j] - p[0];
+        const double dy = y[j] - p[1];
+        ranks[j]        = dx * dx + dy * dy;
+      }
+      break;
+  }
+}
+
+/**
+ * @brief   Assigns a range of points to their nearest centers.
+ *
+ * @param   begin            first point of the range
+ * @param   end              one past the last point of the range
+ * @param   context          the assignment
+ */
+static void __assign_task(const uint64_t begin,
+                          const uint64_t end,
+                          void *         context)
+{
+  const struct __assignment * A = context;
+  const uint64_t              m = A->num_centers;
+  double                      ranks[ASSIGN_BLOCK];
+
+  for (uint64_t i = begin; i < end; ++i) {
+    if (A->tree) {
+      SpatialIndex.nearest(A->tree,
+                           A->points[i],
+                           1,
+                           A->nearest + i,
+                           A->distances + i);
+      continue;
+    }
+
+    double p[3];
+    __assign_coordinates(A->metric, A->points[i], p);
+
+    uint64_t best      = 0;
+    double   best_rank = INFINITY;
+    for (uint64_t first = 0; first < m; first += ASSIGN_BLOCK) {
+      const uint64_t count =
+          m - first < ASSIGN_BLOCK ? m - first : ASSIGN_BLOCK;
+      __rank_centers(A->metric->type,
+                     p,
+                     A->coordinates + first,
+                     A->coordinates + m + first,
+                     A->coordinates + 2 * m + first,
+                     count,
+                     ranks);
+      for (uint64_t j = 0; j < count; ++j) {
+        if (ranks[j] < best_rank) {
+          best_rank = ranks[j];
+          best      = first + j;
+        }
+      }
+    }
+
+    A->nearest[i]   = best;
+    A->distances[i] = kernel_metric_distance(A->metric,
+                                             A->points[i],
+                                             A->centers[best],
+                                             DIM2);
+  }
+}
+
+/**
+ * @brief   Assigns each of a set of 2D points to its nearest center.
+ * @details One pass over the points, split across worker threads, finds the
+ *          index of the nearest center to each point and the distance to it
+ *          under the metric. Few centers are scanned directly, a block at a
+ *          time through loops over squared euclidean distance, manhattan
+ *          distance, or squared chord length between unit vectors, which
+ *          order the centers as the metric does without its square roots and
+ *          trigonometry; many centers are searched through a spatial index
+ *          built over them once. A custom matrix metric falls back to
+ *          euclidean, and ties go to either center.
+ *
+ * @param   points      points to assign
+ * @param   num_points  number of points
+ * @param   centers     centers to assign the points to
+ * @param   num_centers number of centers, at least 1
+ * @param   metric      how distance to a center is measured; NULL for
+ *                      euclidean
+ * @param   nearest     filled with the index of the nearest center to each
+ *                      point
+ * @param   distances   filled with the distance from each point to its
+ *                      nearest center
+ */
+static void assign(const double                  points[][DIM2],
+                   const uint64_t                num_points,
+                   const double                  centers[][DIM2],
+                   const uint64_t                num_centers,
+                   const struct DistanceMetric * metric,
+                   uint64_t                      nearest[],
+                   double                        distances[])
+{
+  metric = metric ? metric : &METRIC_EUCLIDEAN;
+  if (!num_points || !num_centers) {
+    return;
+  }
+
+  struct SpatialTree * tree        = NULL;
+  double *             coordinates = NULL;
+  if (num_centers >= ASSIGN_INDEX_CENTERS) {
+    tree = SpatialIndex.New(metric, centers, num_centers);
+  } else {
+    coordinates = Array.Scratch.double_array(3 * num_centers);
+    for (uint64_t j = 0; j < num_centers; ++j) {
+      double c[3];
+      __assign_coordinates(metric, centers[j], c);
+      coordinates[j]                   = c[0];
+      coordinates[num_centers + j]     = c[1];
+      coordinates[2 * num_centers + j] = c[2];
+    }
+  }
+
+  struct __assignment assignment = {points,
+                                    centers,
+                                    metric,
+                                    coordinates,
+                                    num_centers,
+                                    tree,
+                                    nearest,
+                                    distances};
+  Parallel.for_range(0, num_points, ASSIGN_GRAIN, __assign_task, &assignment);
+
+  if (tree) {
+    SpatialIndex.free(tree);
+  } else {
+    Array.release(coordinates);
+  }
+}
+
+/**
+ * @struct
+ * @brief  A point whose net distance a medoid search has measured in full
+ *
+ * @prop   at       coordinates of the point: itself, or its unit vector under
+ *                  haversine
+ * @prop   cost     net distance from the points to it, in radians of arc under
+ *                  haversine
+ * @prop   sum      net distance the bounding planes are drawn against, which is
+ *                  convex over the coordinates: the cost itself, or the net
+ *                  chord between unit vectors under haversine
+ * @prop   gradient a gradient of the sum at the point
+ */
+struct __pivot
+{
+  double at[3];
+  double cost;
+  double sum;
+  double gradient[3];
+};
+
+/**
+ * @struct
+ * @brief  A point that may be the medoid
+ *
+ * @prop   distance squared distance to the geometric median over the
+ *                  coordinates, by which candidates are taken in order
+ * @prop   floor    greatest lower bound on the sum of the candidate from any
+ *                  plane so far
+ * @prop   index    index of the candidate among the points
+ */
+struct __candidate
+{
+  double   distance;
+  double   floor;
+  uint64_t index;
+};
+
+/**
+ * @struct
+ * @brief  A medoid search
+ *
+ * @prop   type        how distance is measured
+ * @prop   coordinates coordinates of every point: itself, or its unit vector
+ *                     under haversine
+ * @prop   num_points  number of points
+ * @prop   pivots      points measured by the current round
+ * @prop   num_pivots  number of pivots
+ * @prop   candidates  candidates left
+ */
+struct __medoid_search
+{
+  enum MetricType      type;
+  const double *       coordinates;
+  uint64_t             num_points;
+  struct __pivot *     pivots;
+  uint64_t             num_pivots;
+  struct __candidate * candidates;
+};
+
+/**
+ * @brief   Partially sorts candidates so that the nearest to the geometric
+ *          median come first.
+ *
+ * @param   C                candidates to partition
+ * @param   n                number of candidates
+ * @param   k                number of nearest candidates to move first; less
+ *                           than `n`
+ */
+static void __select_nearest(struct __candidate C[],
+                             const uint64_t     n,
+                             const uint64_t     k)
+{
+  const int64_t target = (int64_t)k;
+  int64_t       lo     = 0;
+  int64_t       hi     = (int64_t)n - 1;
+
+  while (lo < hi) {
+    const double pivot = C[(lo + hi) / 2].distance;
+    int64_t      i     = lo;
+    int64_t      j     = hi;
+    while (i <= j) {
+      while (C[i].distance < pivot) {
+        ++i;
+      }
+      while (C[j].distance > pivot) {
+        --j;
+      }
+      if (i <= j) {
+        const struct __candidate tmp = C[i];
+        C[i++]                       = C[j];
+        C[j--]                       = tmp;
+      }
+    }
+
+    // between j and i lie only copies of the pivot
+    if (target <= j) {
+      hi = j;
+    } else if (target >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Measures the net distance from every point to a pivot, and its
+ *          gradient.
+ * @details Each metric has its own loop. Points at the pivot itself add
+ *          nothing to the gradient, which keeps it a subgradient there.
+ *
+ * @param   M                the search
+ * @param   P                the pivot, whose coordinates are set
+ */
+static void __measure_pivot(const struct __medoid_search * M,
+                            struct __pivot *               P)
+{
+  const double * q    = M->coordinates;
+  double         cost = 0, sum = 0;
+  double         g[3] = {0, 0, 0};
+
+  switch (M->type) {
+    case METRIC_L1:
+      for (uint64_t j = 0; j < M->num_points; ++j, q += 3) {
+        const double dx = P->at[0] - q[0];
+        const double dy = P->at[1] - q[1];
+        sum += fabs(dx) + fabs(dy);
+        g[0] += (dx > 0) - (dx < 0);
+        g[1] += (dy > 0) - (dy < 0);
+      }
+      cost = sum;
+      break;
+    case METRIC_HAVERSINE:
+      for (uint64_t j = 0; j < M->num_points; ++j, q += 3) {
+        const double d[3]  = {P->at[0] - q[0],
+                             P->at[1] - q[1],
+                             P->at[2] - q[2]};
+        const double chord = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        if (chord > 0) {
+          const double inverse = 1 / chord;
+          sum += chord;
+          cost += 2 * asin(fmin(chord / 2, 1));
+          g[0] += d[0] * inverse;
+          g[1] += d[1] * inverse;
+          g[2] += d[2] * inverse;
+        }
+      }
+      break;
+    case METRIC_L2:
+    case METRIC_MATRIX:
+    default:
+      for (uint64_t j = 0; j < M->num_points; ++j, q += 3) {
+        const double dx = P->at[0] - q[0];
+        const double dy = P->at[1] - q[1];
+        const double d  = sqrt(dx * dx + dy * dy);
+        if (d > 0) {
+          const double inverse = 1 / d;
+          sum += d;
+          g[0] += dx * inverse;
+          g[1] += dy * inverse;
+        }
+      }
+      cost = sum;
+      break;
+  }
+
+  P->cost = cost;
+  P->sum  = sum;
+  for (uint64_t d = 0; d < 3; ++d) {
+    P->gradient[d] = g[d];
+  }
+}
+
+/**
+ * @brief   Measures a range of the pivots of a medoid search.
+ *
+ * @param   begin            first pivot of the range
+ * @param   end              one past the last pivot of the range
+ * @param   context          the search
+ */
+static void __pivot_task(const uint64_t begin,
+                         const uint64_t end,
+                         void *         context)
+{
+  const struct __medoid_search * M = context;
+  for (uint64_t k = begin; k < end; ++k) {
+    __measure_pivot(M, M->pivots + k);
+  }
+}
+
+/**
+ * @brief   Raises the floor of a range of the candidates of a medoid search
+ *          to the planes of its pivots.
+ * @details The sum is convex, so the plane through a pivot along its gradient
+ *          lies below it everywhere.
+ *
+ * @param   begin            first candidate of the range
+ * @param   end              one past the last candidate of the range
+ * @param   context          the search
+ */
+static void __bound_task(const uint64_t begin,
+                         const uint64_t end,
+                         void *         context)
+{
+  const struct __medoid_search * M = context;
+
+  for (uint64_t c = begin; c < end; ++c) {
+    struct __candidate * C = M->candidates + c;
+    const double *       q = M->coordinates + 3 * C->index;
+
+    for (uint64_t k = 0; k < M->num_pivots; ++k) {
+      const struct __pivot * P     = M->pivots + k;
+      const double           plane = P->sum +
+                           P->gradient[0] * (q[0] - P->at[0]) +
+                           P->gradient[1] * (q[1] - P->at[1]) +
+                           P->gradient[2] * (q[2] - P->at[2]);
+      C->floor = fmax(C->floor, plane);
+    }
+  }
+}
+
+/**
+ * @brief   Bounds the cost of a candidate of a medoid search from below.
+ * @details Under haversine, the arc over a chord `c` is `2 asin(c / 2)`, which
+ *          is convex and increasing, so the net arc over chords summing to at
+ *          least the floor is least when the chords are equal.
+ *
+ * @param   M                the search
+ * @param   floor            lower bound on the sum of the candidate
+ *
+ * @return  lower bound on the cost of the candidate
+ */
+static double __candidate_bound(const struct __medoid_search * M,
+                                const double                   floor)
+{
+  if (M->type != METRIC_HAVERSINE) {
+    return floor;
+  }
+  const double chord = fmax(floor, 0) / M->num_points;
+  return M->num_points * 2 * asin(fmin(chord / 2, 1));
+}
+
+/**
+ * @struct
+ * @brief  Net distances to each point of a matrix metric
+ *
+ * @prop   matrix  distances from each point, row by row, to each point
+ * @prop   size    number of points
+ * @prop   sums    filled with the net distance to each point
+ */
+struct __column_sums
+{
+  const double * matrix;
+  uint64_t       size;
+  double *       sums;
+};
+
+/**
+ * @brief   Sums a range of the columns of a matrix, a row at a time.
+ *
+ * @param   begin            first column of the range
+ * @param   end              one past the last column of the range
+ * @param   context          the matrix and its sums
+ */
+static void __column_task(const uint64_t begin,
+                          const uint64_t end,
+                          void *         context)
+{
+  const struct __column_sums * S = context;
+
+  for (uint64_t i = begin; i < end; ++i) {
+    S->sums[i] = 0;
+  }
+  for (uint64_t j = 0; j < S->size; ++j) {
+    const double * row = S->matrix + kernel_idx_2d(j, 0, S->size);
+    for (uint64_t i = begin; i < end; ++i) {
+      S->sums[i] += row[i];
+    }
+  }
+}
+
+/**
+ * @brief   Finds the medoid of the points of a matrix metric.
+ * @details The net distance to each point is the sum of its column, since
+ *          every trip ends there.
+ *
+ * @param   matrix           flattened `size x size` distances between points
+ * @param   size             number of points; at least one
+ * @param   cost             filled with the net distance to the medoid
+ *
+ * @return  index of the medoid
+ */
+static uint64_t __matrix_medoid(const double   matrix[],
+                                const uint64_t size,
+                                double *       cost)
+{
+  struct __column_sums S = {matrix, size, Array.Scratch.double_array(size)};
+  Parallel.for_range(0, size, MEDOID_GRAIN / size + 1, __column_task, &S);
+
+  uint64_t best = 0;
+  for (uint64_t i = 1; i < size; ++i) {
+    best = S.sums[i] < S.sums[best] ? i : best;
+  }
+  *cost = S.sums[best];
+
+  Array.release(S.sums);
+  return best;
+}
+
+/**
+ * @brief   Finds the medoid of a set of 2D points: the one whose net distance
+ *          to the others is least.
+ * @details Exact, without measuring every pair of points. The geometric median
+ *          is found first, and the points are taken as candidates in order of
+ *          their distance to it. Each round computes the net distance of the
+ *          nearest few candidates left in full, split across worker threads,
+ *          along with its gradient. Net distance is convex, so each gives a
+ *          plane bounding every other candidate from below, and candidates
+ *          bounded above the best so far are dropped. Under haversine, the
+ *          planes bound the net chord between unit vectors, whose arcs bound
+ *          the net distance in turn. A custom matrix metric over the points is
+ *          summed directly, by column; any other matrix falls back to
+ *          euclidean.
+ *
+ * @param   points     points to find the medoid of
+ * @param   num_points number of points
+ * @param   options    specified margin of error, bound range, subsearch value,
+ *                     limits, and metric; the first four only steer the search
+ *                     for the geometric median, which orders the candidates
+ * @param   cost       filled with the net distance from the points to the
+ *                     medoid, under the metric
+ *
+ * @return  index of the medoid; 0 for an empty set
+ */
+static uint64_t medoid(const double                          points[][DIM2],
+                       const uint64_t                        num_points,
+                       const struct GeometricCenterOptions * options,
+                       double *                              cost)
+{
+  const struct DistanceMetric * metric =
+      options->metric ? options->metric : &METRIC_EUCLIDEAN;
+
+  *cost = 0;
+  if (!num_points) {
+    return 0;
+  }
+  if (metric->type == METRIC_MATRIX) {
+    if (metric->size == num_points) {
+      return __matrix_medoid(metric->matrix, num_points, cost);
+    }
+    metric = &METRIC_EUCLIDEAN;
+  }
+
+  // the geometric median is the first pivot, and candidates are taken in
+  // order of their distance to it
+  const struct GeometricCenterOptions opts = {options->epsilon,
+                                              options->bounds,
+                                              options->subsearch,
+                                              metric,
+                                              options->deadline_ms,
+                                              options->max_iterations};
+  const Grid_2D center   = geometric_median(points, num_points, &opts, NULL);
+  const double  at[DIM2] = {center.x, center.y};
+
+  struct __pivot pivots[MEDOID_BATCH];
+  __assign_coordinates(metric, at, pivots[0].at);
+
+  double *             coordinates = Array.Scratch.double_array(3 * num_points);
+  struct __candidate * candidates  = malloc(num_points * sizeof *candidates);
+  for (uint64_t i = 0; i < num_points; ++i) {
+    double * q = coordinates + 3 * i;
+    __assign_coordinates(metric, points[i], q);
+
+    const double d[3] = {q[0] - pivots[0].at[0],
+                         q[1] - pivots[0].at[1],
+                         q[2] - pivots[0].at[2]};
+    candidates[i].distance = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    candidates[i].floor    = -INFINITY;
+    candidates[i].index    = i;
+  }
+
+  struct __medoid_search M = {metric->type,
+                              coordinates,
+                              num_points,
+                              pivots,
+                              1,
+                              candidates};
+  __measure_pivot(&M, pivots);
+  Parallel.for_range(0, num_points, MEDOID_BOUND_GRAIN, __bound_task, &M);
+
+  uint64_t best      = candidates[0].index;
+  double   best_cost = INFINITY;
+  uint64_t num_left  = num_points;
+  uint64_t passes    = 1;
+
+  while (num_left) {
+    // measure the nearest candidates left in full
+    M.num_pivots = num_left < MEDOID_BATCH ? num_left : MEDOID_BATCH;
+    if (M.num_pivots < num_left) {
+      __select_nearest(candidates, num_left, M.num_pivots);
+    }
+    for (uint64_t k = 0; k < M.num_pivots; ++k) {
+      const double * q = coordinates + 3 * candidates[k].index;
+      for (uint64_t d = 0; d < 3; ++d) {
+        pivots[k].at[d] = q[d];
+      }
+    }
+    Parallel.for_range(0,
+                       M.num_pivots,
+                       MEDOID_GRAIN / num_points + 1,
+                       __pivot_task,
+                       &M);
+    passes += M.num_pivots;
+
+    for (uint64_t k = 0; k < M.num_pivots; ++k) {
+      if (pivots[k].cost < best_cost) {
+        best_cost = pivots[k].cost;
+        best      = candidates[k].index;
+      }
+    }
+
+    // bound the rest by the planes of the pivots, and keep those that may
+    // still beat the best
+    M.candidates = candidates + M.num_pivots;
+    Parallel.for_range(0,
+                       num_left - M.num_pivots,
+                       MEDOID_BOUND_GRAIN,
+                       __bound_task,
+                       &M);
+
+    const double limit = best_cost * (1 + MEDOID_SLACK);
+    uint64_t     kept  = 0;
+    for (uint64_t c = M.num_pivots; c < num_left; ++c) {
+      if (__candidate_bound(&M, candidates[c].floor) <= limit) {
+        candidates[kept++] = candidates[c];
+      }
+    }
+    num_left     = kept;
+    M.candidates = candidates;
+  }
+
+  free(candidates);
+  Array.release(coordinates);
+
+  // measure the medoid again as `Metric.net_distance` would
+  *cost = kernel_net_metric_distance(metric,
+                                     points[best],
+                                     DIM2,
+                                     (const double *)points,
+                                     num_points);
+  Stats.count(STAT_NET_DISTANCE_PASSES, passes + 1);
+  return best;
+}
+
+const struct point_set PointSet = {
+    .mean                   = mean,
+    .geometric_median       = geometric_median,
+    .mean_batch             = mean_batch,
+    .geometric_median_batch = geometric_median_batch,
+    .summary                = summary,
+    .minimax_center         = minimax_center,
+    .assign                 = assign,
+    .medoid                 = medoid};
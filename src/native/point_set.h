@@ -1,7 +1,9 @@
 #ifndef POINT_SET_H
 #define POINT_SET_H
 
+#include "toolkit/deadline.h"
 #include "toolkit/grid.h"
+#include "toolkit/metric.h"
 
 #include <math.h>
 #include <stdbool.h>
@@ -16,15 +18,49 @@ enum DIM2
  * @struct
  * @brief  Options for how the geometric center should be calculated
  *
- * @prop   epsilon   acceptable margin of error
- * @prop   bounds    a multiplier of the range of points to search
- * @prop   subsearch whether to search obliquely
+ * @prop   epsilon        acceptable margin of error
+ * @prop   bounds         a multiplier of the range of points to search
+ * @prop   subsearch      whether to search obliquely
+ * @prop   metric         how distance to the center is measured; NULL for
+ *                        euclidean
+ * @prop   deadline_ms    milliseconds to search before settling for the best
+ *                        center so far, or 0 for no limit
+ * @prop   max_iterations steps to search before settling for the best center
+ *                        so far, or 0 for no limit
  */
 struct GeometricCenterOptions
 {
-  const double epsilon;
-  const double bounds;
-  const bool   subsearch;
+  const double                  epsilon;
+  const double                  bounds;
+  const bool                    subsearch;
+  const struct DistanceMetric * metric;
+  const double                  deadline_ms;
+  const uint64_t                max_iterations;
+};
+
+/**
+ * @struct
+ * @brief  Summary statistics of a set of 2D points
+ *
+ * @prop   mean        mean of the points
+ * @prop   mean_cost   net distance from the points to their mean, under the
+ *                     metric of the options
+ * @prop   min         least coordinate in each dimension
+ * @prop   max         greatest coordinate in each dimension
+ * @prop   variance    population variance in each dimension
+ * @prop   center      geometric median of the points
+ * @prop   center_cost net distance from the points to their geometric median,
+ *                     under the metric of the options
+ */
+struct PointSummary
+{
+  Grid_2D mean;
+  double  mean_cost;
+  Grid_2D min;
+  Grid_2D max;
+  Grid_2D variance;
+  Grid_2D center;
+  double  center_cost;
 };
 
 struct point_set
@@ -52,17 +88,177 @@ struct point_set
    *          non-issue, as the geometric median is (unique and covergent for
    *          non-co-linear
    *          points)[http://www.stat.rutgers.edu/home/cunhui/papers/39.pdf].
+   *          Candidates are scored under the metric of the options, while the
+   *          initial step is sized by euclidean distance so that it stays in
+   *          the units of the coordinates. The search is an anytime one: once
+   *          the deadline or iteration limit of the options is reached, the
+   *          best center so far is kept.
    *
    * @param   points     points to find the center of
    * @param   num_points number of points
-   * @param   options    specified margin of error, bound range, and subsearch
-   *                     value
+   * @param   options    specified margin of error, bound range, subsearch
+   *                     value, and limits
+   * @param   report     if not NULL, filled with whether a limit stopped the
+   *                     search, the steps taken, and the step size reached as
+   *                     its precision, to compare with the margin of error
    *
    * @return  pointer to geometric median of points
    */
   Grid_2D (*geometric_median)(const double points[][DIM2],
                               uint64_t     num_points,
-                              const struct GeometricCenterOptions * options);
+                              const struct GeometricCenterOptions * options,
+                              struct SolveReport *                  report);
+
+  /**
+   * @brief   Finds the mean of each of a batch of sets of 2D points.
+   * @details Set `s` is made of the points from `offsets[s]` up to
+   *          `offsets[s + 1]`. Sets are spread across worker threads.
+   *
+   * @param   points     points of every set, packed one set after another
+   * @param   offsets    index of the first point of each set, followed by the
+   *                     total number of points
+   * @param   num_sets   number of sets
+   * @param   centers    filled with the mean of each set
+   * @param   scores     filled with the net euclidean distance from each set
+   *                     to its mean
+   */
+  void (*mean_batch)(const double   points[][DIM2],
+                     const uint64_t offsets[],
+                     uint64_t       num_sets,
+                     double         centers[][DIM2],
+                     double         scores[]);
+
+  /**
+   * @brief   Finds the geometric median of each of a batch of sets of 2D
+   *          points.
+   * @details Set `s` is made of the points from `offsets[s]` up to
+   *          `offsets[s + 1]`. Sets are spread across worker threads, and
+   *          each is searched as by `geometric_median`.
+   *
+   * @param   points     points of every set, packed one set after another
+   * @param   offsets    index of the first point of each set, followed by the
+   *                     total number of points
+   * @param   num_sets   number of sets
+   * @param   options    specified margin of error, bound range, subsearch
+   *                     value, and metric, shared by every set
+   * @param   centers    filled with the geometric median of each set
+   * @param   scores     filled with the net distance from each set to its
+   *                     geometric median, under the metric of the options
+   */
+  void (*geometric_median_batch)(const double   points[][DIM2],
+                                 const uint64_t offsets[],
+                                 uint64_t       num_sets,
+                                 const struct GeometricCenterOptions * options,
+                                 double centers[][DIM2],
+                                 double scores[]);
+
+  /**
+   * @brief   Summarizes a set of 2D points.
+   * @details Gives in one call what `mean`, `geometric_median`, and the net
+   *          distances to each would, along with the bounding box and
+   *          variance. Sums and bounds share a first pass over the points, and
+   *          squared deviations and distances to the mean a second; the search
+   *          for the geometric median then starts from the mean and its cost,
+   *          and its last score is the cost of the center.
+   *
+   * @param   points     points to summarize
+   * @param   num_points number of points
+   * @param   options    specified margin of error, bound range, subsearch
+   *                     value, and metric of the geometric median
+   *
+   * @return  summary of the points; all zero for an empty set
+   */
+  struct PointSummary (*summary)(const double   points[][DIM2],
+                                 uint64_t       num_points,
+                                 const struct GeometricCenterOptions * options);
+
+  /**
+   * @brief   Finds the minimax center of a set of 2D points: the point whose
+   *          greatest distance to any of the points is least.
+   * @details Under euclidean distance, this is the center of the smallest
+   *          circle enclosing the points, found by Welzl's randomized
+   *          incremental algorithm in expected linear time. Under haversine,
+   *          it is the center of the smallest cap of the sphere enclosing the
+   *          points, found the same way over unit vectors; the points are
+   *          expected to lie within a hemisphere. Under manhattan distance,
+   *          it is the center of the bounding box of the points rotated by 45
+   *          degrees. A custom matrix metric falls back to euclidean.
+   *
+   * @param   points     points to find the center of
+   * @param   num_points number of points
+   * @param   metric     how distance to the center is measured; NULL for
+   *                     euclidean
+   * @param   radius     filled with the greatest distance from the center to
+   *                     a point, under the metric
+   *
+   * @return  minimax center of points
+   */
+  Grid_2D (*minimax_center)(const double                  points[][DIM2],
+                            uint64_t                      num_points,
+                            const struct DistanceMetric * metric,
+                            double *                      radius);
+
+  /**
+   * @brief   Assigns each of a set of 2D points to its nearest center.
+   * @details One pass over the points, split across worker threads, finds the
+   *          index of the nearest center to each point and the distance to it
+   *          under the metric. Few centers are scanned directly, a block at a
+   *          time through loops over squared euclidean distance, manhattan
+   *          distance, or squared chord length between unit vectors, which
+   *          order the centers as the metric does without its square roots and
+   *          trigonometry; many centers are searched through a spatial index
+   *          built over them once. A custom matrix metric falls back to
+   *          euclidean, and ties go to either center.
+   *
+   * @param   points      points to assign
+   * @param   num_points  number of points
+   * @param   centers     centers to assign the points to
+   * @param   num_centers number of centers, at least 1
+   * @param   metric      how distance to a center is measured; NULL for
+   *                      euclidean
+   * @param   nearest     filled with the index of the nearest center to each
+   *                      point
+   * @param   distances   filled with the distance from each point to its
+   *                      nearest center
+   */
+  void (*assign)(const double                  points[][DIM2],
+                 uint64_t                      num_points,
+                 const double                  centers[][DIM2],
+                 uint64_t                      num_centers,
+                 const struct DistanceMetric * metric,
+                 uint64_t                      nearest[],
+                 double                        distances[]);
+
+  /**
+   * @brief   Finds the medoid of a set of 2D points: the one whose net
+   *          distance to the others is least.
+   * @details Exact, without measuring every pair of points. The geometric
+   *          median is found first, and the points are taken as candidates in
+   *          order of their distance to it. Each round computes the net
+   *          distance of the nearest few candidates left in full, split across
+   *          worker threads, along with its gradient. Net distance is convex,
+   *          so each gives a plane bounding every other candidate from below,
+   *          and candidates bounded above the best so far are dropped. Under
+   *          haversine, the planes bound the net chord between unit vectors,
+   *          whose arcs bound the net distance in turn. A custom matrix metric
+   *          over the points is summed directly, by column; any other matrix
+   *          falls back to euclidean.
+   *
+   * @param   points     points to find the medoid of
+   * @param   num_points number of points
+   * @param   options    specified margin of error, bound range, subsearch
+   *                     value, limits, and metric; the first four only steer
+   *                     the search for the geometric median, which orders the
+   *                     candidates
+   * @param   cost       filled with the net distance from the points to the
+   *                     medoid, under the metric
+   *
+   * @return  index of the medoid; 0 for an empty set
+   */
+  uint64_t (*medoid)(const double                          points[][DIM2],
+                     uint64_t                              num_points,
+                     const struct GeometricCenterOptions * options,
+                     double *                              cost);
 };
 
 extern const struct point_set PointSet;
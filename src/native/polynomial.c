@@ -2,6 +2,8 @@
 
 #include "toolkit/array.h"
 #include "toolkit/matrix.h"
+#include "toolkit/parallel.h"
+#include "toolkit/stats.h"
 
 #include <math.h>
 #include <stdlib.h>
@@ -18,45 +20,66 @@
 static const uint64_t DEFAULT_DEGREE = 2;
 
 /**
- * @brief   Generates an augmented Vandermonde matrix for a polynomial of
- *          dimension `k`, consisting of a `(k + 1) x (k + 1)` Vandermonde
- *          matrix and a projected vector of dimension `k + 1`.
- * @details Expands the unique values of the Vandermonde matrix into a
- *          submatrix V, and places the projected vector in a subvector p on the
- *          RHS. Visually, the augmented matrix A becomes
- *            A = | V , p |
- *              = | n           ...  Σ^n(x_i^k)      | Σ^n(y_i)         |
- *                | Σ^n(x_i)    ...  Σ^n(x_i^(k+1))  | Σ^n(x_i * y_i)   |
- *                | ...         ...  ...             | ...              |
- *                | Σ^n(x_i^k)  ...  Σ^n(x_i^(2k))   | Σ^n(x_i^k * y_i) |.
- * @note    Returns a pointer to the flattened matrix.
- *
- * @param   V_unique          unique values of the Vandermonde matrix
- * @param   p                 the projected vector
- * @param   k                 dimension of the polynomial described by the
- *                            system
- *
- * @return  a pointer to the values of the augmented Vandermonde matrix.
+ * Minimum number of series fit per thread of a batch.
  */
-static double * __augmented_vandermonde(const double * V_uniq,
-                                        const double * p,
-                                        const uint64_t   k)
-{
-  const uint64_t rows = k + 1;
-  const uint64_t cols = k + 2;
-  double *     A    = Array.New.double_array(rows * cols);
+static const uint64_t FIT_BATCH_GRAIN = 16;
 
-  for (uint64_t r = 0; r < (k + 1); ++r) {
-    for (uint64_t c = 0; c < (k + 1); ++c) {
-      A[r * cols + c] = V_uniq[r + c];  // store values of Vandermonde matrix
-    }
+/**
+ * Minimum number of coordinates evaluated per thread.
+ */
+static const uint64_t EVALUATE_GRAIN = 1 << 16;
 
-    uint64_t last_in_row = r * cols + k + 1;  // [r][cols-1]; i.e. [r][k + 1]
-    A[last_in_row]     = p[r];              // store projected vector
-  }
+/**
+ * Default rounds of reweighting of a robust fit.
+ */
+static const uint64_t IRLS_MAX_ITERATIONS = 50;
 
-  return A;
-}
+/**
+ * Largest move of any coefficient, relative to the largest coefficient, at
+ * which reweighting has settled.
+ */
+static const double IRLS_TOLERANCE = 1e-10;
+
+/**
+ * Default number of RANSAC trials.
+ */
+static const uint64_t RANSAC_MAX_TRIALS = 1000;
+
+/**
+ * RANSAC trials drawn between checks for early termination.
+ */
+static const uint64_t RANSAC_ROUND = 64;
+
+/**
+ * Minimum number of RANSAC trials per thread.
+ */
+static const uint64_t RANSAC_GRAIN = 8;
+
+/**
+ * Probability that some RANSAC trial sampled only inliers, at which the
+ * trials stop.
+ */
+static const double RANSAC_CONFIDENCE = 0.99;
+
+/**
+ * Ratio of the standard deviation to the median absolute deviation of
+ * normally distributed residuals.
+ */
+static const double MAD_TO_SIGMA = 1.4826;
+
+/**
+ * Thresholds in standard deviations of the residuals: Huber and Tukey weights
+ * keep 95% efficiency on normally distributed residuals.
+ */
+static const double HUBER_TUNING  = 1.345;
+static const double TUKEY_TUNING  = 4.685;
+static const double RANSAC_TUNING = 2.5;
+
+/**
+ * Least threshold scaled from residuals, relative to the largest magnitude of
+ * any y coordinate.
+ */
+static const double RESIDUAL_FLOOR = 1e-9;
 
 /**
  * @brief   Generates the unique values of a Vandermonde matrix.
@@ -64,25 +87,43 @@ static double * __augmented_vandermonde(const double * V_uniq,
  *          matrix describing the best-fit polynomial of dimension `k` for
  *          that set has the unique values
  *            n, Σ^n(x_i), ... , Σ^n(x_i^k), ... , Σ^n(x_i^(2k)).
+ *          Powers of each `x_i` are accumulated by repeated multiplication
+ *          rather than `pow`. Each `x_i` is first mapped to
+ *          `(x_i - center) / spread`, and each term of the sums is scaled by
+ *          the weight of its point.
  *
  * @param   x_points          set of x point coordinates
+ * @param   weights           weight of each point, or NULL to weigh every
+ *                            point 1
  * @param   num_points        number of points
  * @param   k                 dimension of polynomial to generate a
  *                            Vandermonde matrix for
+ * @param   center            x coordinate mapped to 0
+ * @param   spread            distance from `center` mapped to 1
  *
  * @return  a pointer to an array of the unique values of the best-fit
- *          polynomial's Vandermonde matrix.
+ *          polynomial's Vandermonde matrix, borrowed from `Array.Scratch`.
  */
-static double * __vandermonde(const double x_points[],
+static double * __vandermonde(const double   x_points[],
+                              const double   weights[],
                               const uint64_t num_points,
-                              const uint64_t k)
+                              const uint64_t k,
+                              const double   center,
+                              const double   spread)
 {
   const uint64_t len    = 2 * k + 1;
-  double *     vmonde = Array.New.double_array(len);
+  double *     vmonde = Array.Scratch.double_array(len);
 
   for (uint64_t deg = 0; deg < len; ++deg) {
-    for (uint64_t i = 0; i < num_points; ++i) {  // Σ^n(x_i^(`deg`))
-      vmonde[deg] += pow(x_points[i], deg);
+    vmonde[deg] = 0;
+  }
+
+  for (uint64_t i = 0; i < num_points; ++i) {  // Σ^n(x_i^(`deg`))
+    const double x     = (x_points[i] - center) / spread;
+    double       power = weights ? weights[i] : 1;
+    for (uint64_t deg = 0; deg < len; ++deg) {
+      vmonde[deg] += power;
+      power *= x;
     }
   }
   return vmonde;
@@ -97,31 +138,195 @@ static double * __vandermonde(const double x_points[],
  *            | Σ^n(x_i * y_i)   |
  *            | ...              |
  *            | Σ^n(x_i^k * y_i) |.
+ *          Each `x_i` is first mapped to `(x_i - center) / spread`, and each
+ *          term of the sums is scaled by the weight of its point.
  *
  * @param   x_points          set of x point coordinates
  * @param   y_points          set of y point coordinates
+ * @param   weights           weight of each point, or NULL to weigh every
+ *                            point 1
  * @param   num_points        number of points
  * @param   k                 dimension of polynomial to generate a projected
  *                            vector for
+ * @param   center            x coordinate mapped to 0
+ * @param   spread            distance from `center` mapped to 1
  *
- * @return  a pointer to an array of the values of the projected vector.
+ * @return  a pointer to an array of the values of the projected vector,
+ *          borrowed from `Array.Scratch`.
  */
-static double * __projected_vector(const double x_points[],
-                                   const double y_points[],
+static double * __projected_vector(const double   x_points[],
+                                   const double   y_points[],
+                                   const double   weights[],
                                    const uint64_t num_points,
-                                   const uint64_t k)
+                                   const uint64_t k,
+                                   const double   center,
+                                   const double   spread)
 {
   const uint64_t len = k + 1;
-  double *     vec = Array.New.double_array(len);
+  double *     vec = Array.Scratch.double_array(len);
 
   for (uint64_t deg = 0; deg < len; ++deg) {
-    for (uint64_t i = 0; i < num_points; ++i) {  // Σ^n(x_i^(`deg`) * y_i)
-      vec[deg] += pow(x_points[i], deg) * y_points[i];
+    vec[deg] = 0;
+  }
+
+  for (uint64_t i = 0; i < num_points; ++i) {  // Σ^n(x_i^(`deg`) * y_i)
+    const double x     = (x_points[i] - center) / spread;
+    double       power = weights ? weights[i] * y_points[i] : y_points[i];
+    for (uint64_t deg = 0; deg < len; ++deg) {
+      vec[deg] += power;
+      power *= x;
     }
   }
   return vec;
 }
 
+/**
+ * @struct
+ * @brief  Factored normal equations of a least squares polynomial fit
+ *
+ * @prop   len        number of coefficients
+ * @prop   center     x coordinate mapped to 0
+ * @prop   spread     distance from `center` mapped to 1
+ * @prop   factor     Cholesky factor of the equilibrated Vandermonde matrix,
+ *                    or its LU factorization if it is not positive definite
+ * @prop   scale      symmetric scaling applied to each row and column
+ * @prop   pivots     row permutation of an LU factorization
+ * @prop   cholesky   whether `factor` is a Cholesky factor
+ */
+struct __normal_equations
+{
+  uint64_t   len;
+  double     center;
+  double     spread;
+  double *   factor;
+  double *   scale;
+  uint64_t * pivots;
+  bool       cholesky;
+};
+
+/**
+ * @brief   Factors the normal equations of a least squares polynomial fit.
+ * @details Powers of raw x coordinates far from 0 are nearly collinear, so
+ *          the fit is made in `t = (x - center) / spread`, which maps the
+ *          points onto `[-1, 1]`. The Vandermonde matrix of `t` is then scaled
+ *          to a unit diagonal, `D M D` with `D = diag(1 / sqrt(M_ii))`, which
+ *          bounds its condition number by the best any diagonal scaling
+ *          achieves. The scaled matrix is symmetric positive definite whenever
+ *          the points determine the polynomial, and is factored by Cholesky; a
+ *          degenerate matrix falls back to a pivoted LU factorization.
+ *
+ * @param   x_points          set of x point coordinates
+ * @param   weights           weight of each point, or NULL to weigh every
+ *                            point 1
+ * @param   num_points        number of points
+ * @param   k                 degree of the polynomial
+ * @param   N                 filled with the factorization, borrowed from
+ *                            `Array.Scratch` and given back by
+ *                            `__release_normal_equations`
+ */
+static void __factor_normal_equations(const double                x_points[],
+                                      const double                weights[],
+                                      const uint64_t              num_points,
+                                      const uint64_t              k,
+                                      struct __normal_equations * N)
+{
+  const uint64_t len = k + 1;
+
+  double min = INFINITY;
+  double max = -INFINITY;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    min = x_points[i] < min ? x_points[i] : min;
+    max = x_points[i] > max ? x_points[i] : max;
+  }
+  const double spread = (max - min) / 2;
+
+  N->len    = len;
+  N->center = isfinite(spread) ? min + spread : 0;
+  N->spread = spread > 0 && isfinite(spread) ? spread : 1;
+  N->factor = Array.Scratch.double_array(len * len);
+  N->scale  = Array.Scratch.double_array(len);
+  N->pivots = NULL;
+
+  double * V = __vandermonde(x_points,
+                             weights,
+                             num_points,
+                             k,
+                             N->center,
+                             N->spread);
+
+  for (uint64_t r = 0; r < len; ++r) {
+    const double d = V[2 * r];
+    N->scale[r]    = d > 0 && isfinite(d) ? 1 / sqrt(d) : 1;
+  }
+  for (uint64_t r = 0; r < len; ++r) {
+    for (uint64_t c = 0; c < len; ++c) {
+      N->factor[r * len + c] = N->scale[r] * V[r + c] * N->scale[c];
+    }
+  }
+
+  N->cholesky = Matrix.factor_cholesky(N->factor, len);
+  if (!N->cholesky) {
+    for (uint64_t r = 0; r < len; ++r) {
+      for (uint64_t c = 0; c < len; ++c) {
+        N->factor[r * len + c] = N->scale[r] * V[r + c] * N->scale[c];
+      }
+    }
+    N->pivots = Array.Scratch.uint64_t_array(len);
+    Matrix.factor_lu(N->factor, len, N->pivots);
+  }
+
+  Array.release(V);
+}
+
+/**
+ * @brief   Solves factored normal equations for the coefficients of a fit.
+ * @details Solves for the coefficients in `t`, then expands them back into
+ *          powers of `x`: dividing by `spread^i` gives a polynomial in
+ *          `x - center`, which repeated synthetic division shifts to `x`.
+ *
+ * @param   N                 factored normal equations
+ * @param   b                 projected vector, replaced by the coefficients
+ */
+static void __solve_normal_equations(const struct __normal_equations * N,
+                                     double                            b[])
+{
+  const uint64_t len = N->len;
+
+  for (uint64_t r = 0; r < len; ++r) {
+    b[r] *= N->scale[r];
+  }
+  if (N->cholesky) {
+    Matrix.solve_cholesky(N->factor, len, b);
+  } else {
+    Matrix.solve_lu(N->factor, len, N->pivots, b);
+  }
+
+  double power = 1;
+  for (uint64_t r = 0; r < len; ++r) {
+    b[r] *= N->scale[r] / power;
+    power *= N->spread;
+  }
+  for (uint64_t i = 0; i + 1 < len; ++i) {
+    for (uint64_t j = len - 1; j-- > i;) {
+      b[j] -= N->center * b[j + 1];
+    }
+  }
+}
+
+/**
+ * @brief   Gives back the buffers of factored normal equations.
+ *
+ * @param   N                 factored normal equations
+ */
+static void __release_normal_equations(struct __normal_equations * N)
+{
+  Array.release(N->factor);
+  Array.release(N->scale);
+  if (N->pivots) {
+    Array.release(N->pivots);
+  }
+}
+
 /**
  * @brief   Guesses the optimal degree of a polynomial function best fitting a
  *          set of points.
@@ -143,7 +348,7 @@ static uint64_t guess_degree(const double x[],
   }
 
   // copy, then sort y coordinates
-  double * sorted_y = Array.New.double_array(num_points);
+  double * sorted_y = Array.Scratch.double_array(num_points);
   for (uint64_t i = 0; i < num_points; ++i) {
     sorted_y[i] = y[i];
   }
@@ -174,7 +379,7 @@ static uint64_t guess_degree(const double x[],
     }
   }
 
-  free(sorted_y);
+  Array.release(sorted_y);
 
   return DEFAULT_DEGREE + extrema;
 }
@@ -201,7 +406,9 @@ static uint64_t guess_degree(const double x[],
  *
  *          Note that the only unique values in `M` are `n, Σ^n(x_i), ... ,
  *          Σ^n(x_i^k), ... , Σ^n(x_i^(2k))`. An optimization can be made by
- *          only evaluating these `2k + 1` values.
+ *          only evaluating these `2k + 1` values. The system is built over x
+ *          coordinates centered and scaled onto `[-1, 1]` and equilibrated,
+ *          then solved by Cholesky, as `M` is symmetric positive definite.
  *
  * @param   x_points          set of x point coordinates
  * @param   y_points          set of y point coordinates
@@ -219,24 +426,856 @@ static double * best_fit(const double x_points[],
 {
   const uint64_t dimension = polynomial_degree + 1;
 
-  double * M           = __vandermonde(x_points, num_points, polynomial_degree);
-  double * b           = __projected_vector(x_points,
+  struct __normal_equations N;
+  __factor_normal_equations(x_points, NULL, num_points, polynomial_degree, &N);
+
+  double * b = __projected_vector(x_points,
                                   y_points,
+                                  NULL,
                                   num_points,
-                                  polynomial_degree);
-  double * augmented_M = __augmented_vandermonde(M, b, polynomial_degree);
-
-  Matrix.eliminate_gaussian((double **)augmented_M, dimension);
+                                  polynomial_degree,
+                                  N.center,
+                                  N.spread);
+  __solve_normal_equations(&N, b);
 
-  double * x = Matrix.solve_reduced_augmented((const double **)augmented_M,
-                                              dimension);
+  double * x = Array.New.double_array(dimension);
+  for (uint64_t deg = 0; deg < dimension; ++deg) {
+    x[deg] = b[deg];
+  }
 
-  free(M);
-  free(b);
-  free(augmented_M);
+  __release_normal_equations(&N);
+  Array.release(b);
 
   return x;
 }
 
-const struct polynomial Polynomial = {.guess_degree = guess_degree,
-                                      .best_fit     = best_fit};
+/**
+ * @struct
+ * @brief  A batch of series fit against one factored Vandermonde matrix
+ *
+ * @prop   x_points   x coordinates shared by every series
+ * @prop   num_points number of x coordinates
+ * @prop   y_series   y coordinates of each series, column-major
+ * @prop   k          degree of every polynomial
+ * @prop   normal     factored normal equations
+ * @prop   coeffs     filled with the coefficients of each series
+ */
+struct __fit_batch
+{
+  const double *                    x_points;
+  uint64_t                          num_points;
+  const double *                    y_series;
+  uint64_t                          k;
+  const struct __normal_equations * normal;
+  double *                          coeffs;
+};
+
+/**
+ * @brief   Fits the series of a range of a batch.
+ *
+ * @param   begin            first series of the range
+ * @param   end              one past the last series of the range
+ * @param   context          the batch
+ */
+static void __fit_batch_task(const uint64_t begin,
+                             const uint64_t end,
+                             void *         context)
+{
+  const struct __fit_batch * B   = context;
+  const uint64_t             len = B->k + 1;
+
+  for (uint64_t s = begin; s < end; ++s) {
+    double * b = __projected_vector(B->x_points,
+                                    B->y_series + s * B->num_points,
+                                    NULL,
+                                    B->num_points,
+                                    B->k,
+                                    B->normal->center,
+                                    B->normal->spread);
+    __solve_normal_equations(B->normal, b);
+    for (uint64_t deg = 0; deg < len; ++deg) {
+      B->coeffs[s * len + deg] = b[deg];
+    }
+    Array.release(b);
+  }
+}
+
+/**
+ * @brief   Calculates the best-fit polynomial of each of a batch of series
+ *          sampled at the same x coordinates.
+ * @details The Vandermonde matrix depends only on the x coordinates, so it is
+ *          built and factored once; each series then only needs its projected
+ *          vector and a solve against the factorization. Series are spread
+ *          across worker threads.
+ *
+ * @param   x_points          x coordinates shared by every series
+ * @param   num_points        number of x coordinates
+ * @param   y_series          y coordinates of each series, column-major:
+ *                            series `s` spans `num_points` values from
+ *                            `y_series[s * num_points]`
+ * @param   num_series        number of series
+ * @param   polynomial_degree degree of every polynomial
+ * @param   coeffs            filled with the `polynomial_degree + 1`
+ *                            coefficients of each series, one series after
+ *                            another
+ */
+static void best_fit_batch(const double   x_points[],
+                           const uint64_t num_points,
+                           const double   y_series[],
+                           const uint64_t num_series,
+                           const uint64_t polynomial_degree,
+                           double         coeffs[])
+{
+  const uint64_t k = polynomial_degree;
+
+  struct __normal_equations N;
+  __factor_normal_equations(x_points, NULL, num_points, k, &N);
+
+  struct __fit_batch batch = {x_points, num_points, y_series, k, &N, coeffs};
+  Parallel.for_range(0, num_series, FIT_BATCH_GRAIN, __fit_batch_task, &batch);
+
+  __release_normal_equations(&N);
+}
+
+/**
+ * @brief   Evaluates a polynomial at one coordinate by Horner's scheme.
+ *
+ * @param   coeffs            coefficients, where each index corresponds to
+ *                            its degree
+ * @param   len               number of coefficients; at least 1
+ * @param   x                 coordinate to evaluate at
+ *
+ * @return  the value of the polynomial
+ */
+static double __horner(const double coeffs[], const uint64_t len, double x)
+{
+  double value = coeffs[len - 1];
+  for (uint64_t deg = len - 1; deg-- > 0;) {
+    value = value * x + coeffs[deg];
+  }
+  return value;
+}
+
+/**
+ * @brief   Fits a weighted least squares polynomial.
+ *
+ * @param   x_points          set of x point coordinates
+ * @param   y_points          set of y point coordinates
+ * @param   weights           weight of each point, or NULL to weigh every
+ *                            point 1
+ * @param   num_points        number of points
+ * @param   k                 degree of the polynomial
+ * @param   coeffs            filled with the `k + 1` coefficients
+ *
+ * @return  whether every coefficient is finite
+ */
+static bool __weighted_fit(const double   x_points[],
+                           const double   y_points[],
+                           const double   weights[],
+                           const uint64_t num_points,
+                           const uint64_t k,
+                           double         coeffs[])
+{
+  struct __normal_equations N;
+  __factor_normal_equations(x_points, weights, num_points, k, &N);
+
+  double * b = __projected_vector(x_points,
+                                  y_points,
+                                  weights,
+                                  num_points,
+                                  k,
+                                  N.center,
+                                  N.spread);
+  __solve_normal_equations(&N, b);
+
+  bool finite = true;
+  for (uint64_t deg = 0; deg <= k; ++deg) {
+    coeffs[deg] = b[deg];
+    finite      = finite && isfinite(b[deg]);
+  }
+
+  __release_normal_equations(&N);
+  Array.release(b);
+
+  return finite;
+}
+
+/**
+ * @brief   Finds the median of the magnitudes of a set of values.
+ * @details Selects the middle magnitude by quickselect, in linear expected
+ *          time.
+ *
+ * @param   values            values to find the median magnitude of
+ * @param   num_values        number of values; at least 1
+ *
+ * @return  the median magnitude, taking the upper of the middle two
+ */
+static double __median_magnitude(const double values[],
+                                 const uint64_t num_values)
+{
+  double * m = Array.Scratch.double_array(num_values);
+  for (uint64_t i = 0; i < num_values; ++i) {
+    m[i] = fabs(values[i]);
+  }
+
+  const int64_t middle = (int64_t)num_values / 2;
+  int64_t       lo     = 0;
+  int64_t       hi     = (int64_t)num_values - 1;
+  while (lo < hi) {
+    const double pivot = m[(lo + hi) / 2];
+    int64_t      i     = lo;
+    int64_t      j     = hi;
+    while (i <= j) {
+      while (m[i] < pivot) {
+        ++i;
+      }
+      while (m[j] > pivot) {
+        --j;
+      }
+      if (i <= j) {
+        __D_swap(m[i], m[j], double);
+        ++i;
+        --j;
+      }
+    }
+
+    // between j and i lie only copies of the pivot
+    if (middle <= j) {
+      hi = j;
+    } else if (middle >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+
+  const double median = m[middle];
+  Array.release(m);
+  return median;
+}
+
+/**
+ * @brief   Measures the residual of each point against a polynomial.
+ *
+ * @param   coeffs            coefficients of the polynomial
+ * @param   len               number of coefficients
+ * @param   x_points          set of x point coordinates
+ * @param   y_points          set of y point coordinates
+ * @param   num_points        number of points
+ * @param   residuals         filled with `y_i - p(x_i)` for each point
+ */
+static void __residuals(const double   coeffs[],
+                        const uint64_t len,
+                        const double   x_points[],
+                        const double   y_points[],
+                        const uint64_t num_points,
+                        double         residuals[])
+{
+  for (uint64_t i = 0; i < num_points; ++i) {
+    residuals[i] = y_points[i] - __horner(coeffs, len, x_points[i]);
+  }
+}
+
+/**
+ * @struct
+ * @brief  A robust fit in progress
+ *
+ * @prop   x_points   x coordinates of the points
+ * @prop   y_points   y coordinates of the points
+ * @prop   num_points number of points
+ * @prop   k          degree of the polynomial
+ * @prop   options    options of the fit
+ * @prop   deadline   time budget of the fit
+ * @prop   floor      least threshold scaled from residuals, so that points
+ *                    off an exact fit by rounding alone stay inliers
+ */
+struct __robust_fit
+{
+  const double *            x_points;
+  const double *            y_points;
+  uint64_t                  num_points;
+  uint64_t                  k;
+  const struct FitOptions * options;
+  struct Deadline *         deadline;
+  double                    floor;
+};
+
+/**
+ * @brief   Picks the threshold beyond which a residual marks an outlier of a
+ *          reweighted fit.
+ *
+ * @param   F                 the fit
+ * @param   residuals         residual of each point
+ *
+ * @return  the configured threshold, or else the tuning constant of the
+ *          method times a robust estimate of the standard deviation of the
+ *          residuals
+ */
+static double __threshold(const struct __robust_fit * F,
+                          const double                residuals[])
+{
+  if (F->options->threshold > 0) {
+    return F->options->threshold;
+  }
+
+  const double sigma =
+      MAD_TO_SIGMA * __median_magnitude(residuals, F->num_points);
+  const double tuning =
+      F->options->method == FIT_HUBER ? HUBER_TUNING : TUKEY_TUNING;
+  return fmax(tuning * sigma, F->floor);
+}
+
+/**
+ * @brief   Marks the points within a threshold of a polynomial.
+ *
+ * @param   residuals         residual of each point
+ * @param   num_points        number of points
+ * @param   threshold         greatest residual of an inlier
+ * @param   inliers           if not NULL, filled with 1 for each inlier and 0
+ *                            for each outlier
+ *
+ * @return  the number of inliers
+ */
+static uint64_t __mark_inliers(const double   residuals[],
+                               const uint64_t num_points,
+                               const double   threshold,
+                               uint8_t        inliers[])
+{
+  uint64_t count = 0;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const bool inlier = fabs(residuals[i]) <= threshold;
+    count += inlier;
+    if (inliers) {
+      inliers[i] = inlier;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief   Fits a polynomial by iteratively reweighted least squares.
+ * @details Each round weighs every point by its residual against the fit of
+ *          the round before, under Huber or Tukey weights, and stops once no
+ *          coefficient moves by more than a relative `1e-10`. The threshold is
+ *          rescaled each round unless configured.
+ *
+ * @param   F                 the fit
+ * @param   coeffs            filled with the coefficients
+ * @param   residuals         filled with the residuals of the fit
+ * @param   report            filled with the rounds taken, and the relative
+ *                            movement of the coefficients in the last one as
+ *                            the precision
+ *
+ * @return  the threshold of the final round
+ */
+static double __reweighted_fit(const struct __robust_fit * F,
+                               double                      coeffs[],
+                               double                      residuals[],
+                               struct SolveReport *        report)
+{
+  const double *            x_points   = F->x_points;
+  const double *            y_points   = F->y_points;
+  const uint64_t            num_points = F->num_points;
+  const uint64_t            k          = F->k;
+  const struct FitOptions * options    = F->options;
+
+  const uint64_t len        = k + 1;
+  const uint64_t iterations = options->max_iterations
+                                  ? options->max_iterations
+                                  : IRLS_MAX_ITERATIONS;
+  double *       weights    = Array.Scratch.double_array(num_points);
+  double *       next       = Array.Scratch.double_array(len);
+
+  __weighted_fit(x_points, y_points, NULL, num_points, k, coeffs);
+  __residuals(coeffs, len, x_points, y_points, num_points, residuals);
+  double threshold = __threshold(F, residuals);
+  double precision = threshold > 0 ? INFINITY : 0;
+
+  for (uint64_t round = 0; round < iterations; ++round) {
+    // residuals are all within rounding of a fit through most points
+    if (!(threshold > 0) || deadline_reached(F->deadline)) {
+      break;
+    }
+
+    for (uint64_t i = 0; i < num_points; ++i) {
+      const double r = fabs(residuals[i]);
+      if (options->method == FIT_HUBER) {
+        weights[i] = r <= threshold ? 1 : threshold / r;
+      } else {
+        const double u = r / threshold;
+        weights[i]     = u < 1 ? (1 - u * u) * (1 - u * u) : 0;
+      }
+    }
+    if (!__weighted_fit(x_points, y_points, weights, num_points, k, next)) {
+      break;
+    }
+
+    double largest = 0;
+    double moved   = 0;
+    for (uint64_t deg = 0; deg < len; ++deg) {
+      largest     = fmax(largest, fabs(next[deg]));
+      moved       = fmax(moved, fabs(next[deg] - coeffs[deg]));
+      coeffs[deg] = next[deg];
+    }
+    __residuals(coeffs, len, x_points, y_points, num_points, residuals);
+    threshold = __threshold(F, residuals);
+    precision = largest > 0 ? moved / largest : moved;
+    if (moved <= IRLS_TOLERANCE * largest) {
+      break;
+    }
+  }
+
+  Array.release(weights);
+  Array.release(next);
+
+  report->precision  = precision;
+  report->iterations = F->deadline->iterations;
+
+  return threshold;
+}
+
+/**
+ * @struct
+ * @brief  A round of RANSAC trials
+ *
+ * @prop   x_points   x coordinates of the points
+ * @prop   y_points   y coordinates of the points
+ * @prop   num_points number of points
+ * @prop   k          degree of the polynomial
+ * @prop   threshold  greatest residual of an inlier, or 0 to score trials by
+ *                    their median residual
+ * @prop   floor      least threshold scaled from a median residual
+ * @prop   first      index of the first trial of the round
+ * @prop   coeffs     filled with the coefficients of each trial of the round
+ * @prop   scores     filled with the score of each trial; lower is better
+ * @prop   counts     filled with the number of inliers of each trial
+ */
+struct __ransac_round
+{
+  const double * x_points;
+  const double * y_points;
+  uint64_t       num_points;
+  uint64_t       k;
+  double         threshold;
+  double         floor;
+  uint64_t       first;
+  double *       coeffs;
+  double *       scores;
+  uint64_t *     counts;
+};
+
+/**
+ * @brief   Runs a range of RANSAC trials.
+ * @details Each trial samples `k + 1` distinct points from a generator
+ *          seeded by the index of the trial, and fits them exactly. Given a
+ *          threshold, a trial scores the number of points beyond it; without
+ *          one, it scores its median residual, as least median of squares,
+ *          and counts the points within `RANSAC_TUNING` standard deviations
+ *          that median implies.
+ *
+ * @param   begin            first trial of the range
+ * @param   end              one past the last trial of the range
+ * @param   context          the round
+ */
+static void __ransac_task(const uint64_t begin,
+                          const uint64_t end,
+                          void *         context)
+{
+  const struct __ransac_round * R      = context;
+  const uint64_t                n      = R->num_points;
+  const uint64_t                len    = R->k + 1;
+  uint64_t *                    sample = Array.Scratch.uint64_t_array(len);
+  double *                      x      = Array.Scratch.double_array(len);
+  double *                      y      = Array.Scratch.double_array(len);
+  double *                      r      = Array.Scratch.double_array(n);
+
+  for (uint64_t t = begin; t < end; ++t) {
+    // splitmix64 gives well-mixed streams from consecutive seeds
+    uint64_t state = (t + 1) * 0x9E3779B97F4A7C15u;
+    for (uint64_t s = 0; s < len;) {
+      state += 0x9E3779B97F4A7C15u;
+      uint64_t z = state;
+      z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+      z          = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+      z ^= z >> 31;
+
+      const uint64_t pick  = z % n;
+      bool           fresh = true;
+      for (uint64_t p = 0; p < s; ++p) {
+        fresh = fresh && sample[p] != pick;
+      }
+      if (fresh) {
+        sample[s] = pick;
+        x[s]      = R->x_points[pick];
+        y[s]      = R->y_points[pick];
+        ++s;
+      }
+    }
+
+    const uint64_t at     = t - R->first;
+    double *       coeffs = R->coeffs + at * len;
+    if (!__weighted_fit(x, y, NULL, len, R->k, coeffs)) {
+      R->scores[at] = INFINITY;
+      R->counts[at] = 0;
+      continue;
+    }
+
+    __residuals(coeffs, len, R->x_points, R->y_points, n, r);
+    if (R->threshold > 0) {
+      R->counts[at] = __mark_inliers(r, n, R->threshold, NULL);
+      R->scores[at] = (double)(n - R->counts[at]);
+    } else {
+      const double median = __median_magnitude(r, n);
+      const double band = fmax(RANSAC_TUNING * MAD_TO_SIGMA * median, R->floor);
+      R->counts[at]     = __mark_inliers(r, n, band, NULL);
+      R->scores[at]     = median;
+    }
+  }
+
+  Array.release(sample);
+  Array.release(x);
+  Array.release(y);
+  Array.release(r);
+}
+
+/**
+ * @brief   Fits a polynomial by RANSAC, then refits it by least squares over
+ *          the inliers of the best trial.
+ * @details Trials run in parallel rounds. After each round, the share of
+ *          inliers of the best trial bounds the trials needed to sample only
+ *          inliers at least once with `RANSAC_CONFIDENCE`, and no more are
+ *          drawn. When no trial fits its sample, as when every point shares
+ *          an x coordinate, the plain least squares fit is kept and no point
+ *          is an inlier.
+ *
+ * @param   F                 the fit, of more than `k + 1` points
+ * @param   coeffs            filled with the coefficients
+ * @param   residuals         filled with the residuals of the fit
+ * @param   report            filled with the trials drawn, and the chance
+ *                            that none sampled only inliers, at the share of
+ *                            the best trial, as the precision
+ *
+ * @return  the threshold of an inlier, or NaN when no trial fit
+ */
+static double __ransac_fit(const struct __robust_fit * F,
+                           double                      coeffs[],
+                           double                      residuals[],
+                           struct SolveReport *        report)
+{
+  const double *            x_points   = F->x_points;
+  const double *            y_points   = F->y_points;
+  const uint64_t            num_points = F->num_points;
+  const uint64_t            k          = F->k;
+  const struct FitOptions * options    = F->options;
+
+  const uint64_t len    = k + 1;
+  uint64_t       trials = options->max_iterations ? options->max_iterations
+                                                  : RANSAC_MAX_TRIALS;
+
+  struct __ransac_round R = {
+      x_points,
+      y_points,
+      num_points,
+      k,
+      options->threshold > 0 ? options->threshold : 0,
+      F->floor,
+      0,
+      Array.Scratch.double_array(RANSAC_ROUND * len),
+      Array.Scratch.double_array(RANSAC_ROUND),
+      Array.Scratch.uint64_t_array(RANSAC_ROUND),
+  };
+
+  double   best_score = INFINITY;
+  uint64_t best_count = 0;
+  uint64_t drawn      = 0;
+  for (uint64_t first = 0; first < trials; first += RANSAC_ROUND) {
+    const uint64_t end = first + RANSAC_ROUND < trials ? first + RANSAC_ROUND
+                                                      : trials;
+    R.first = first;
+    drawn   = end;
+    Parallel.for_range(first, end, RANSAC_GRAIN, __ransac_task, &R);
+
+    // the earliest of equally good trials wins, however rounds are split
+    for (uint64_t t = first; t < end; ++t) {
+      if (R.scores[t - first] < best_score) {
+        best_score = R.scores[t - first];
+        best_count = R.counts[t - first];
+        for (uint64_t deg = 0; deg < len; ++deg) {
+          coeffs[deg] = R.coeffs[(t - first) * len + deg];
+        }
+      }
+    }
+
+    // trials needed to sample only inliers at least once, at the best share
+    if (best_count > k) {
+      const double share  = (double)best_count / num_points;
+      const double needed = log(1 - RANSAC_CONFIDENCE) /
+                            log(1 - pow(share, (double)len));
+      if (needed < trials) {
+        trials = needed > end ? (uint64_t)ceil(needed) : end;
+      }
+    }
+    if (end < trials && deadline_reached(F->deadline)) {
+      break;
+    }
+  }
+
+  Array.release(R.coeffs);
+  Array.release(R.scores);
+  Array.release(R.counts);
+
+  report->iterations = drawn;
+  report->precision =
+      best_count > k
+          ? pow(1 - pow((double)best_count / num_points, (double)len),
+                (double)drawn)
+          : 1;
+
+  // no trial fit its sample, so no point agrees with one
+  if (isinf(best_score)) {
+    __weighted_fit(x_points, y_points, NULL, num_points, k, coeffs);
+    __residuals(coeffs, len, x_points, y_points, num_points, residuals);
+    return NAN;
+  }
+
+  const double scaled    = RANSAC_TUNING * MAD_TO_SIGMA * best_score;
+  const double threshold = R.threshold > 0 ? R.threshold
+                                           : fmax(scaled, F->floor);
+
+  // refit over the consensus of the best trial
+  __residuals(coeffs, len, x_points, y_points, num_points, residuals);
+  if (best_count > k) {
+    double * weights = Array.Scratch.double_array(num_points);
+    double * refit   = Array.Scratch.double_array(len);
+    for (uint64_t i = 0; i < num_points; ++i) {
+      weights[i] = fabs(residuals[i]) <= threshold;
+    }
+    if (__weighted_fit(x_points, y_points, weights, num_points, k, refit)) {
+      for (uint64_t deg = 0; deg < len; ++deg) {
+        coeffs[deg] = refit[deg];
+      }
+      __residuals(coeffs, len, x_points, y_points, num_points, residuals);
+    }
+    Array.release(weights);
+    Array.release(refit);
+  }
+
+  return threshold;
+}
+
+/**
+ * @brief   Calculates a polynomial function for a set of 2D points that
+ *          resists outliers.
+ * @details Reweighting methods start from the least squares fit, then
+ *          repeatedly weigh each point by its residual and solve the weighted
+ *          normal equations, until the coefficients settle. RANSAC fits
+ *          random samples of `polynomial_degree + 1` points exactly, in
+ *          parallel rounds of trials, keeping the fit most points agree with;
+ *          it stops early once the share of agreeing points makes it 99%
+ *          likely that some trial sampled only inliers, and refits by least
+ *          squares over them. Without a threshold, RANSAC scores trials by
+ *          their median residual instead, as least median of squares. If no
+ *          sample can be fit, RANSAC keeps the least squares fit and counts no
+ *          inliers. Trials are seeded by their index, so results repeat. Every
+ *          method gives up at `budget_ms`, keeping the best fit so far, and
+ *          reports so as a partial fit.
+ *
+ * @param   x_points          set of x point coordinates
+ * @param   y_points          set of y point coordinates
+ * @param   num_points        number of points
+ * @param   polynomial_degree degree of polynomial function to approximate
+ * @param   options           method, threshold, and limits of the fit
+ * @param   coeffs            filled with the `polynomial_degree + 1`
+ *                            coefficients of the fit
+ * @param   inliers           if not NULL, filled with 1 for each point within
+ *                            the threshold of the fit, and 0 for each outlier
+ * @param   report            if not NULL, filled with whether the budget
+ *                            stopped the fit, the rounds or trials taken, and
+ *                            the relative movement of the coefficients in the
+ *                            last round, or the chance that no trial sampled
+ *                            only inliers, as the precision
+ *
+ * @return  the number of inliers
+ */
+static uint64_t robust_fit(const double              x_points[],
+                           const double              y_points[],
+                           const uint64_t            num_points,
+                           const uint64_t            polynomial_degree,
+                           const struct FitOptions * options,
+                           double                    coeffs[],
+                           uint8_t                   inliers[],
+                           struct SolveReport *      report)
+{
+  const uint64_t     k        = polynomial_degree;
+  struct Deadline    deadline = deadline_start(options->budget_ms, 0);
+  struct SolveReport R        = {false, 0, 0};
+
+  // too few points to tell outliers apart
+  if (num_points <= k + 1) {
+    __weighted_fit(x_points, y_points, NULL, num_points, k, coeffs);
+    for (uint64_t i = 0; inliers && i < num_points; ++i) {
+      inliers[i] = 1;
+    }
+    if (report) {
+      *report = R;
+    }
+    return num_points;
+  }
+
+  double largest = 0;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    if (isfinite(y_points[i])) {
+      largest = fmax(largest, fabs(y_points[i]));
+    }
+  }
+  const struct __robust_fit F = {x_points,
+                                 y_points,
+                                 num_points,
+                                 k,
+                                 options,
+                                 &deadline,
+                                 RESIDUAL_FLOOR * largest};
+
+  double *     residuals = Array.Scratch.double_array(num_points);
+  const double threshold = options->method == FIT_RANSAC
+                               ? __ransac_fit(&F, coeffs, residuals, &R)
+                               : __reweighted_fit(&F, coeffs, residuals, &R);
+  const uint64_t count =
+      __mark_inliers(residuals, num_points, threshold, inliers);
+
+  Array.release(residuals);
+
+  R.partial = deadline.reached;
+  if (report) {
+    *report = R;
+  }
+
+  return count;
+}
+
+/**
+ * @struct
+ * @brief  A polynomial to evaluate, and where to write its values
+ *
+ * @prop   coeffs     coefficients of the polynomial
+ * @prop   num_coeffs number of coefficients
+ * @prop   x          coordinates to evaluate at
+ * @prop   values     filled with the value at each coordinate
+ * @prop   first      filled with the first derivative, or NULL
+ * @prop   second     filled with the second derivative, or NULL
+ */
+struct __evaluation
+{
+  const double * coeffs;
+  uint64_t       num_coeffs;
+  const double * x;
+  double *       values;
+  double *       first;
+  double *       second;
+};
+
+/**
+ * @brief   Evaluates a polynomial over a range of coordinates.
+ * @details Carries the derivatives through Horner's scheme alongside the
+ *          value: each step folds the lower derivative into the higher one
+ *          before taking the next coefficient. Each kind of result has its own
+ *          loop, so that no step branches, and no coordinate depends on
+ *          another, so the loops vectorize.
+ *
+ * @param   begin            first coordinate of the range
+ * @param   end              one past the last coordinate of the range
+ * @param   context          the evaluation
+ */
+static void __evaluate_task(const uint64_t begin,
+                            const uint64_t end,
+                            void *         context)
+{
+  const struct __evaluation * E = context;
+  const double *              c = E->coeffs;
+  const uint64_t              k = E->num_coeffs - 1;
+
+  if (E->second) {
+    for (uint64_t j = begin; j < end; ++j) {
+      const double x  = E->x[j];
+      double       p  = c[k];
+      double       d1 = 0;
+      double       d2 = 0;
+      for (uint64_t i = k; i-- > 0;) {
+        d2 = d2 * x + d1;
+        d1 = d1 * x + p;
+        p  = p * x + c[i];
+      }
+      E->values[j] = p;
+      E->second[j] = 2 * d2;
+      if (E->first) {
+        E->first[j] = d1;
+      }
+    }
+  } else if (E->first) {
+    for (uint64_t j = begin; j < end; ++j) {
+      const double x  = E->x[j];
+      double       p  = c[k];
+      double       d1 = 0;
+      for (uint64_t i = k; i-- > 0;) {
+        d1 = d1 * x + p;
+        p  = p * x + c[i];
+      }
+      E->values[j] = p;
+      E->first[j]  = d1;
+    }
+  } else {
+    for (uint64_t j = begin; j < end; ++j) {
+      const double x = E->x[j];
+      double       p = c[k];
+      for (uint64_t i = k; i-- > 0;) {
+        p = p * x + c[i];
+      }
+      E->values[j] = p;
+    }
+  }
+}
+
+/**
+ * @brief   Evaluates a polynomial, and optionally its first and second
+ *          derivatives, at a set of x coordinates.
+ * @details Runs Horner's scheme on each coordinate independently, in loops the
+ *          compiler vectorizes, and splits large sets across worker threads.
+ *          Nothing is allocated; every result is written to the buffers
+ *          given.
+ *
+ * @param   coeffs            coefficients of the polynomial, where each index
+ *                            corresponds to its degree
+ * @param   num_coeffs        number of coefficients
+ * @param   x                 coordinates to evaluate at
+ * @param   num_points        number of coordinates
+ * @param   values            filled with the value at each coordinate
+ * @param   first             if not NULL, filled with the first derivative at
+ *                            each coordinate
+ * @param   second            if not NULL, filled with the second derivative at
+ *                            each coordinate
+ */
+static void evaluate(const double   coeffs[],
+                     const uint64_t num_coeffs,
+                     const double   x[],
+                     const uint64_t num_points,
+                     double         values[],
+                     double         first[],
+                     double         second[])
+{
+  // the zero polynomial, and its derivatives
+  static const double zero[1] = {0};
+
+  struct __evaluation E = {num_coeffs ? coeffs : zero,
+                           num_coeffs ? num_coeffs : 1,
+                           x,
+                           values,
+                           first,
+                           second};
+  Parallel.for_range(0, num_points, EVALUATE_GRAIN, __evaluate_task, &E);
+}
+
+const struct polynomial Polynomial = {.guess_degree   = guess_degree,
+                                      .best_fit       = best_fit,
+                                      .best_fit_batch = best_fit_batch,
+                                      .robust_fit     = robust_fit,
+                                      .evaluate       = evaluate};
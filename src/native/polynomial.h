@@ -1,8 +1,49 @@
 #ifndef POLYNOMIAL_H
 #define POLYNOMIAL_H
 
+#include "toolkit/deadline.h"
+
 #include <stdint.h>
 
+/**
+ * @enum
+ * @brief  How a fit resists outliers
+ *
+ * @prop   FIT_HUBER  reweighted least squares with Huber weights: residuals
+ *                    beyond the threshold count linearly instead of squared
+ * @prop   FIT_TUKEY  reweighted least squares with Tukey biweights: residuals
+ *                    beyond the threshold do not count at all
+ * @prop   FIT_RANSAC least squares over the largest set of points agreeing,
+ *                    within the threshold, with an exact fit through a random
+ *                    sample of points
+ */
+enum FitMethod
+{
+  FIT_HUBER,
+  FIT_TUKEY,
+  FIT_RANSAC
+};
+
+/**
+ * @struct
+ * @brief  Options for a robust fit
+ *
+ * @prop   method         how the fit resists outliers
+ * @prop   threshold      residual beyond which a point is an outlier, or 0 to
+ *                        scale it from the median absolute residual
+ * @prop   max_iterations rounds of reweighting, or trials of RANSAC, or 0 for
+ *                        the default of each method
+ * @prop   budget_ms      milliseconds to spend before settling for the best
+ *                        fit so far, or 0 for no limit
+ */
+struct FitOptions
+{
+  const enum FitMethod method;
+  const double         threshold;
+  const uint64_t       max_iterations;
+  const double         budget_ms;
+};
+
 struct polynomial
 {
   /**
@@ -58,6 +99,102 @@ struct polynomial
                        const double y_points[],
                        uint64_t     num_points,
                        uint64_t     polynomial_degree);
+
+  /**
+   * @brief   Calculates the best-fit polynomial of each of a batch of series
+   *          sampled at the same x coordinates.
+   * @details The Vandermonde matrix depends only on the x coordinates, so it is
+   *          built and factored once; each series then only needs its
+   *          projected vector and a solve against the factorization. Series
+   *          are spread across worker threads.
+   *
+   * @param   x_points          x coordinates shared by every series
+   * @param   num_points        number of x coordinates
+   * @param   y_series          y coordinates of each series, column-major:
+   *                            series `s` spans `num_points` values from
+   *                            `y_series[s * num_points]`
+   * @param   num_series        number of series
+   * @param   polynomial_degree degree of every polynomial
+   * @param   coeffs            filled with the `polynomial_degree + 1`
+   *                            coefficients of each series, one series after
+   *                            another
+   */
+  void (*best_fit_batch)(const double x_points[],
+                         uint64_t     num_points,
+                         const double y_series[],
+                         uint64_t     num_series,
+                         uint64_t     polynomial_degree,
+                         double       coeffs[]);
+
+  /**
+   * @brief   Calculates a polynomial function for a set of 2D points that
+   *          resists outliers.
+   * @details Reweighting methods start from the least squares fit, then
+   *          repeatedly weigh each point by its residual and solve the
+   *          weighted normal equations, until the coefficients settle. RANSAC
+   *          fits random samples of `polynomial_degree + 1` points exactly,
+   *          in parallel rounds of trials, keeping the fit most points agree
+   *          with; it stops early once the share of agreeing points makes
+   *          it 99% likely that some trial sampled only inliers, and refits
+   *          by least squares over them. Without a threshold, RANSAC scores
+   *          trials by their median residual instead, as least median of
+   *          squares. If no sample can be fit, RANSAC keeps the least
+   *          squares fit and counts no inliers. Trials are seeded by their
+   *          index, so results repeat. Every method gives up at `budget_ms`,
+   *          keeping the best fit so far, and reports so as a partial fit.
+   *
+   * @param   x_points          set of x point coordinates
+   * @param   y_points          set of y point coordinates
+   * @param   num_points        number of points
+   * @param   polynomial_degree degree of polynomial function to approximate
+   * @param   options           method, threshold, and limits of the fit
+   * @param   coeffs            filled with the `polynomial_degree + 1`
+   *                            coefficients of the fit
+   * @param   inliers           if not NULL, filled with 1 for each point within
+   *                            the threshold of the fit, and 0 for each outlier
+   * @param   report            if not NULL, filled with whether the budget
+   *                            stopped the fit, the rounds or trials taken, and
+   *                            the relative movement of the coefficients in the
+   *                            last round, or the chance that no trial sampled
+   *                            only inliers, as the precision
+   *
+   * @return  the number of inliers
+   */
+  uint64_t (*robust_fit)(const double              x_points[],
+                         const double              y_points[],
+                         uint64_t                  num_points,
+                         uint64_t                  polynomial_degree,
+                         const struct FitOptions * options,
+                         double                    coeffs[],
+                         uint8_t                   inliers[],
+                         struct SolveReport *      report);
+
+  /**
+   * @brief   Evaluates a polynomial, and optionally its first and second
+   *          derivatives, at a set of x coordinates.
+   * @details Runs Horner's scheme on each coordinate independently, in loops
+   *          the compiler vectorizes, and splits large sets across worker
+   *          threads. Nothing is allocated; every result is written to the
+   *          buffers given.
+   *
+   * @param   coeffs            coefficients of the polynomial, where each
+   *                            index corresponds to its degree
+   * @param   num_coeffs        number of coefficients
+   * @param   x                 coordinates to evaluate at
+   * @param   num_points        number of coordinates
+   * @param   values            filled with the value at each coordinate
+   * @param   first             if not NULL, filled with the first derivative
+   *                            at each coordinate
+   * @param   second            if not NULL, filled with the second derivative
+   *                            at each coordinate
+   */
+  void (*evaluate)(const double coeffs[],
+                   uint64_t     num_coeffs,
+                   const double x[],
+                   uint64_t     num_points,
+                   double       values[],
+                   double       first[],
+                   double       second[]);
 };
 
 extern const struct polynomial Polynomial;
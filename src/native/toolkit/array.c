@@ -1,10 +1,90 @@
 #include "array.h"
 
+#include "kernel.h"
+
+#include <pthread.h>
 #include <stdlib.h>
-#include <string.h>
+
+enum POOL_LIMITS
+{
+  /**
+   * log2 of the size of the smallest size class, in bytes. Smaller arrays are
+   * left to `malloc`, whose own caches serve them faster.
+   */
+  POOL_MIN_CLASS_LOG2 = 12,
+
+  /**
+   * Number of size classes; the largest holds 512 MiB.
+   */
+  POOL_NUM_CLASSES = 18,
+
+  /**
+   * Released arrays kept per size class.
+   */
+  POOL_DEPTH = 4
+};
+
+/**
+ * Most bytes a pool keeps in released arrays.
+ */
+static const uint64_t POOL_MAX_BYTES = (uint64_t)64 << 20;
+
+/**
+ * Marks an array outside of every size class.
+ */
+static const uint64_t UNPOOLED = UINT64_MAX;
+
+/**
+ * @struct
+ * @brief  The bookkeeping in front of every scratch array
+ * @details Padded to 16 bytes, so that the array keeps the alignment of
+ *          `malloc`.
+ *
+ * @prop   size_class size class of the array, or UNPOOLED
+ * @prop   next       next released array of the same class, while pooled
+ */
+struct __header
+{
+  uint64_t          size_class;
+  struct __header * next;
+};
+
+/**
+ * @struct
+ * @brief  The released arrays of one thread
+ *
+ * @prop   free_lists released arrays of each size class
+ * @prop   counts     number of released arrays of each size class
+ * @prop   bytes      bytes held in released arrays
+ * @prop   registered whether the pool is freed when its thread exits
+ */
+struct __pool
+{
+  struct __header * free_lists[POOL_NUM_CLASSES];
+  uint64_t          counts[POOL_NUM_CLASSES];
+  uint64_t          bytes;
+  int               registered;
+};
+
+/**
+ * Pool of the calling thread.
+ */
+static __thread struct __pool POOL = {{NULL}, {0}, 0, 0};
+
+/**
+ * Key whose destructor frees the pool of an exiting thread.
+ */
+static pthread_key_t POOL_KEY;
+
+/**
+ * Creates `POOL_KEY` once per process.
+ */
+static pthread_once_t POOL_KEY_ONCE = PTHREAD_ONCE_INIT;
 
 /**
  * @brief   Creates a dynamic array of doubles initialized to zero.
+ * @details The array is `calloc`ed, so large arrays are zeroed lazily by the
+ *          system, and is freed with `free`.
  *
  * @param   len               length of the array
  *
@@ -12,13 +92,13 @@
  */
 static inline double * double_array(const uint64_t len)
 {
-  double * res = (double *)malloc(len * sizeof(double));
-  memset(res, 0, len * sizeof(double));
-  return res;
+  return (double *)calloc(len ? len : 1, sizeof(double));
 }
 
 /**
  * @brief   Creates a dynamic array of uint64_t initialized to zero.
+ * @details The array is `calloc`ed, so large arrays are zeroed lazily by the
+ *          system, and is freed with `free`.
  *
  * @param   len               length of the array
  *
@@ -26,9 +106,155 @@ static inline double * double_array(const uint64_t len)
  */
 static inline uint64_t * uint64_t_array(const uint64_t len)
 {
-  uint64_t * res = (uint64_t *)malloc(len * sizeof(uint64_t));
-  memset(res, 0, len * sizeof(uint64_t));
-  return res;
+  return (uint64_t *)calloc(len ? len : 1, sizeof(uint64_t));
+}
+
+/**
+ * @brief   Determines the bytes held by arrays of a size class.
+ *
+ * @param   size_class        the size class
+ *
+ * @return  bytes held by each array of the class
+ */
+static uint64_t __class_bytes(const uint64_t size_class)
+{
+  return (uint64_t)1 << (size_class + POOL_MIN_CLASS_LOG2);
+}
+
+/**
+ * @brief   Frees every array kept by a pool.
+ *
+ * @param   pool              the pool
+ */
+static void __drain(void * pool)
+{
+  struct __pool * P = pool;
+
+  for (uint64_t c = 0; c < POOL_NUM_CLASSES; ++c) {
+    while (P->free_lists[c]) {
+      struct __header * head = P->free_lists[c];
+      P->free_lists[c]       = head->next;
+      free(head);
+    }
+    P->counts[c] = 0;
+  }
+  P->bytes = 0;
+}
+
+/**
+ * @brief   Creates the key that frees pools of exiting threads.
+ */
+static void __create_key(void)
+{
+  pthread_key_create(&POOL_KEY, __drain);
+}
+
+/**
+ * @brief   Borrows an uninitialized block from the pool of the calling
+ *          thread.
+ *
+ * @param   bytes             size of the block
+ *
+ * @return  pointer to the block, to be given back with `release`
+ */
+static void * __borrow(const uint64_t bytes)
+{
+  uint64_t size_class = 0;
+  while (size_class < POOL_NUM_CLASSES && __class_bytes(size_class) < bytes) {
+    ++size_class;
+  }
+
+  struct __header * header;
+  if (bytes < __class_bytes(0) / 2 || size_class == POOL_NUM_CLASSES) {
+    header = malloc(sizeof(struct __header) + bytes);
+    if (!header) {
+      return NULL;
+    }
+    header->size_class = UNPOOLED;
+    return header + 1;
+  }
+
+  if (POOL.free_lists[size_class]) {
+    header                       = POOL.free_lists[size_class];
+    POOL.free_lists[size_class]  = header->next;
+    POOL.bytes                  -= __class_bytes(size_class);
+    --POOL.counts[size_class];
+  } else {
+    header = malloc(sizeof(struct __header) + __class_bytes(size_class));
+    if (!header) {
+      return NULL;
+    }
+  }
+  header->size_class = size_class;
+  return header + 1;
+}
+
+/**
+ * @brief   Borrows an uninitialized array of doubles from the pool of the
+ *          calling thread.
+ * @details Arrays are drawn from power-of-two size classes, reusing the memory
+ *          of arrays released earlier, for working memory that is filled
+ *          before it is read and never leaves the call borrowing it.
+ *
+ * @param   len               length of the array
+ *
+ * @return  pointer to the array, to be given back with `Array.release` rather
+ *          than `free`
+ */
+static double * scratch_double_array(const uint64_t len)
+{
+  return (double *)__borrow(len * sizeof(double));
+}
+
+/**
+ * @brief   Borrows an uninitialized array of uint64_t from the pool of the
+ *          calling thread.
+ * @details Arrays are drawn from power-of-two size classes, reusing the memory
+ *          of arrays released earlier, for working memory that is filled
+ *          before it is read and never leaves the call borrowing it.
+ *
+ * @param   len               length of the array
+ *
+ * @return  pointer to the array, to be given back with `Array.release` rather
+ *          than `free`
+ */
+static uint64_t * scratch_uint64_t_array(const uint64_t len)
+{
+  return (uint64_t *)__borrow(len * sizeof(uint64_t));
+}
+
+/**
+ * @brief   Gives an array borrowed from `Array.Scratch` back to the pool of the
+ *          calling thread.
+ * @details The pool keeps a few arrays of each size class, up to a bound on
+ *          its total size, and frees the rest. Pools are freed when their
+ *          thread exits.
+ *
+ * @param   array             the array, or NULL
+ */
+static void release(void * array)
+{
+  if (!array) {
+    return;
+  }
+
+  struct __header * header     = (struct __header *)array - 1;
+  const uint64_t    size_class = header->size_class;
+  if (size_class == UNPOOLED || POOL.counts[size_class] >= POOL_DEPTH ||
+      POOL.bytes + __class_bytes(size_class) > POOL_MAX_BYTES) {
+    free(header);
+    return;
+  }
+
+  if (!POOL.registered) {
+    pthread_once(&POOL_KEY_ONCE, __create_key);
+    POOL.registered = pthread_setspecific(POOL_KEY, &POOL) == 0;
+  }
+
+  header->next                 = POOL.free_lists[size_class];
+  POOL.free_lists[size_class]  = header;
+  POOL.bytes                  += __class_bytes(size_class);
+  ++POOL.counts[size_class];
 }
 
 /**
@@ -45,9 +271,12 @@ static inline uint64_t idx_2d(const uint64_t row,
                               const uint64_t col,
                               const uint64_t num_cols)
 {
-  return row * num_cols + col;
+  return kernel_idx_2d(row, col, num_cols);
 }
 
-const struct array Array = {.New    = {.double_array   = double_array,
-                                    .uint64_t_array = uint64_t_array},
-                            .idx_2d = idx_2d};
+const struct array Array = {
+    .New     = {.double_array = double_array, .uint64_t_array = uint64_t_array},
+    .Scratch = {.double_array   = scratch_double_array,
+                .uint64_t_array = scratch_uint64_t_array},
+    .release = release,
+    .idx_2d  = idx_2d};
@@ -7,6 +7,8 @@ struct new_
 {
   /**
    * @brief   Creates a dynamic array of doubles initialized to zero.
+   * @details The array is `calloc`ed, so large arrays are zeroed lazily by
+   *          the system, and is freed with `free`.
    *
    * @param   len               length of the array
    *
@@ -16,6 +18,8 @@ struct new_
 
   /**
    * @brief   Creates a dynamic array of uint64_t initialized to zero.
+   * @details The array is `calloc`ed, so large arrays are zeroed lazily by
+   *          the system, and is freed with `free`.
    *
    * @param   len               length of the array
    *
@@ -24,9 +28,52 @@ struct new_
   uint64_t * (*uint64_t_array)(uint64_t len);
 };
 
+struct scratch_
+{
+  /**
+   * @brief   Borrows an uninitialized array of doubles from the pool of the
+   *          calling thread.
+   * @details Arrays are drawn from power-of-two size classes, reusing the
+   *          memory of arrays released earlier, for working memory that is
+   *          filled before it is read and never leaves the call borrowing it.
+   *
+   * @param   len               length of the array
+   *
+   * @return  pointer to the array, to be given back with `Array.release`
+   *          rather than `free`
+   */
+  double * (*double_array)(uint64_t len);
+
+  /**
+   * @brief   Borrows an uninitialized array of uint64_t from the pool of the
+   *          calling thread.
+   * @details Arrays are drawn from power-of-two size classes, reusing the
+   *          memory of arrays released earlier, for working memory that is
+   *          filled before it is read and never leaves the call borrowing it.
+   *
+   * @param   len               length of the array
+   *
+   * @return  pointer to the array, to be given back with `Array.release`
+   *          rather than `free`
+   */
+  uint64_t * (*uint64_t_array)(uint64_t len);
+};
+
 struct array
 {
-  const struct new_ New;
+  const struct new_     New;
+  const struct scratch_ Scratch;
+
+  /**
+   * @brief   Gives an array borrowed from `Array.Scratch` back to the pool of
+   *          the calling thread.
+   * @details The pool keeps a few arrays of each size class, up to a bound on
+   *          its total size, and frees the rest. Pools are freed when their
+   *          thread exits.
+   *
+   * @param   array             the array, or NULL
+   */
+  void (*release)(void * array);
 
   /**
    * @brief   Converts an index in a 2D array to the corresponding index in a
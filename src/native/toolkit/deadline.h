@@ -0,0 +1,109 @@
+#ifndef TOOLKIT_DEADLINE_H
+#define TOOLKIT_DEADLINE_H
+
+#include "stats.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Limits for anytime solvers, which settle for the best result found so far
+ * once they run out of time or iterations.
+ *
+ * The checks are `static inline`, like the kernels of `kernel.h`, since they
+ * run once per iteration of the loops they bound.
+ */
+
+/**
+ * @struct
+ * @brief  How far an anytime solve got
+ *
+ * @prop   partial     whether a limit stopped the solve before it finished
+ * @prop   precision   how close the result is known to be to the best one, in
+ *                     terms set by each solver
+ * @prop   iterations  iterations taken
+ */
+struct SolveReport
+{
+  bool     partial;
+  double   precision;
+  uint64_t iterations;
+};
+
+/**
+ * @struct
+ * @brief  Limits on an anytime solve, and the progress made against them
+ *
+ * @prop   started        timestamp the solve started at, from `Stats.now`
+ * @prop   deadline_ms    milliseconds allowed, or 0 for no limit
+ * @prop   max_iterations iterations allowed, or 0 for no limit
+ * @prop   iterations     iterations taken so far
+ * @prop   reached        whether a limit has been reached
+ */
+struct Deadline
+{
+  uint64_t started;
+  double   deadline_ms;
+  uint64_t max_iterations;
+  uint64_t iterations;
+  bool     reached;
+};
+
+/**
+ * @brief   Starts the clock on a solve.
+ *
+ * @param   deadline_ms      milliseconds allowed, or 0 for no limit
+ * @param   max_iterations   iterations allowed, or 0 for no limit
+ *
+ * @return  the limits, with no iterations taken
+ */
+static inline struct Deadline deadline_start(const double   deadline_ms,
+                                             const uint64_t max_iterations)
+{
+  struct Deadline D = {deadline_ms > 0 ? Stats.now() : 0,
+                       deadline_ms > 0 ? deadline_ms : 0,
+                       max_iterations,
+                       0,
+                       false};
+  return D;
+}
+
+/**
+ * @brief   Determines whether the time allowed has run out, without taking an
+ *          iteration, for checks within a long iteration.
+ *
+ * @param   D                the limits
+ *
+ * @return  whether a limit has been reached
+ */
+static inline bool deadline_passed(struct Deadline * D)
+{
+  if (!D->reached && D->deadline_ms > 0) {
+    D->reached = (double)(Stats.now() - D->started) >= D->deadline_ms * 1e6;
+  }
+  return D->reached;
+}
+
+/**
+ * @brief   Takes an iteration, unless a limit has been reached.
+ * @details Called before each iteration; once a limit is reached, every later
+ *          call refuses too, so nested loops unwind together.
+ *
+ * @param   D                the limits
+ *
+ * @return  whether a limit has been reached, in which case the iteration
+ *          should not be taken
+ */
+static inline bool deadline_reached(struct Deadline * D)
+{
+  if (!D->reached && D->max_iterations &&
+      D->iterations >= D->max_iterations) {
+    D->reached = true;
+  }
+  if (!deadline_passed(D)) {
+    ++D->iterations;
+  }
+  return D->reached;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "hilbert.h"
+
+#include "array.h"
+
+#include <math.h>
+#include <string.h>
+
+enum RADIX
+{
+  /**
+   * Bits of the curve index sorted by each pass.
+   */
+  RADIX_BITS = 8,
+
+  /**
+   * Buckets of each pass.
+   */
+  RADIX_BUCKETS = 1 << RADIX_BITS,
+
+  /**
+   * Passes needed to sort a 64-bit curve index.
+   */
+  RADIX_PASSES = 64 / RADIX_BITS
+};
+
+/**
+ * Largest cell coordinate of the grid the curve is drawn on.
+ */
+static const double GRID_MAX = 4294967295.0;
+
+/**
+ * @brief   Finds the index along a Hilbert curve of a cell of a `2^32` by
+ *          `2^32` grid.
+ * @details Walks down the quadrants from the largest, rotating and reflecting
+ *          the cell into the frame of each quadrant the curve enters.
+ *
+ * @param   x                column of the cell
+ * @param   y                row of the cell
+ *
+ * @return  index of the cell along the curve
+ */
+static uint64_t __curve_index(uint32_t x, uint32_t y)
+{
+  uint64_t d = 0;
+  for (uint32_t s = (uint32_t)1 << 31; s; s >>= 1) {
+    const uint32_t rx = (x & s) ? 1 : 0;
+    const uint32_t ry = (y & s) ? 1 : 0;
+    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+    if (!ry) {
+      if (rx) {
+        x = ~x;
+        y = ~y;
+      }
+      const uint32_t t = x;
+      x                = y;
+      y                = t;
+    }
+  }
+  return d;
+}
+
+/**
+ * @brief   Maps a coordinate to its cell along one side of the grid.
+ *
+ * @param   value            the coordinate
+ * @param   min              least coordinate of the bounding square
+ * @param   scale            cells per unit of the bounding square
+ *
+ * @return  the cell; coordinates that are not numbers fall in the first
+ */
+static uint32_t __cell(const double value,
+                       const double min,
+                       const double scale)
+{
+  const double cell = (value - min) * scale;
+  if (!(cell > 0)) {
+    return 0;
+  }
+  return cell < GRID_MAX ? (uint32_t)cell : (uint32_t)GRID_MAX;
+}
+
+/**
+ * @brief   Orders a set of points along a Hilbert curve over their bounding
+ *          square.
+ * @details Points close along the curve are close on the plane, so the order
+ *          is both an approximate tour and a cache-friendly layout. Each point
+ *          is mapped to a 64-bit curve index on a `2^32` by `2^32` grid, and
+ *          the indeces are radix sorted, in time linear in the number of
+ *          points. Vectors of higher dimension are ordered by their first two
+ *          coordinates.
+ *
+ * @param   points           points to order
+ * @param   num_points       number of points
+ * @param   dimension        dimension of the point vectors, at least 2
+ * @param   order            filled with the index of each point, in order
+ *                           along the curve
+ */
+static void order(const double   points[],
+                  const uint64_t num_points,
+                  const uint64_t dimension,
+                  uint64_t       order[])
+{
+  if (!num_points) {
+    return;
+  }
+
+  // a square keeps the curve from stretching along the longer side
+  double min_x = INFINITY;
+  double max_x = -INFINITY;
+  double min_y = INFINITY;
+  double max_y = -INFINITY;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const double * p = points + i * dimension;
+    min_x            = p[0] < min_x ? p[0] : min_x;
+    max_x            = p[0] > max_x ? p[0] : max_x;
+    min_y            = p[1] < min_y ? p[1] : min_y;
+    max_y            = p[1] > max_y ? p[1] : max_y;
+  }
+  const double side  = fmax(max_x - min_x, max_y - min_y);
+  const double scale = side > 0 && isfinite(side) ? GRID_MAX / side : 0;
+
+  uint64_t * keys      = Array.Scratch.uint64_t_array(num_points);
+  uint64_t * next_keys = Array.Scratch.uint64_t_array(num_points);
+  uint64_t * ids       = Array.Scratch.uint64_t_array(num_points);
+  uint64_t * next_ids  = order;
+
+  uint64_t counts[RADIX_PASSES][RADIX_BUCKETS];
+  memset(counts, 0, sizeof counts);
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const double * p = points + i * dimension;
+    keys[i]          = __curve_index(__cell(p[0], min_x, scale),
+                                     __cell(p[1], min_y, scale));
+    ids[i]           = i;
+    for (uint64_t pass = 0; pass < RADIX_PASSES; ++pass) {
+      ++counts[pass][(keys[i] >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+    }
+  }
+
+  // least significant digit first; a digit shared by every key moves nothing
+  for (uint64_t pass = 0; pass < RADIX_PASSES; ++pass) {
+    const uint64_t shift  = pass * RADIX_BITS;
+    uint64_t *     offset = counts[pass];
+    if (offset[(keys[0] >> shift) & (RADIX_BUCKETS - 1)] == num_points) {
+      continue;
+    }
+
+    uint64_t total = 0;
+    for (uint64_t b = 0; b < RADIX_BUCKETS; ++b) {
+      const uint64_t count = offset[b];
+      offset[b]            = total;
+      total += count;
+    }
+    for (uint64_t i = 0; i < num_points; ++i) {
+      const uint64_t at = offset[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+      next_keys[at]     = keys[i];
+      next_ids[at]      = ids[i];
+    }
+
+    uint64_t * swap = keys;
+    keys            = next_keys;
+    next_keys       = swap;
+    swap            = ids;
+    ids             = next_ids;
+    next_ids        = swap;
+  }
+
+  if (ids != order) {
+    memcpy(order, ids, num_points * sizeof(uint64_t));
+    next_ids = ids;
+  }
+
+  Array.release(keys);
+  Array.release(next_keys);
+  Array.release(next_ids);
+}
+
+/**
+ * @brief   Reorders a buffer of 2D points in place along a Hilbert curve.
+ * @details A layout pass for work that touches neighbouring points together,
+ *          such as cost matrix builds, spatial indexing, or sums over
+ *          neighbourhoods; the results of that work are mapped back to the
+ *          original points through `original`.
+ *
+ * @param   points           points to reorder
+ * @param   num_points       number of points
+ * @param   original         if not NULL, filled with the index each point had
+ *                           before it was moved
+ */
+static void sort(double         points[][2],
+                 const uint64_t num_points,
+                 uint64_t       original[])
+{
+  uint64_t * moved = Array.Scratch.uint64_t_array(num_points);
+  double *   copy  = Array.Scratch.double_array(2 * num_points);
+  order((const double *)points, num_points, 2, moved);
+
+  memcpy(copy, points, num_points * 2 * sizeof(double));
+  for (uint64_t i = 0; i < num_points; ++i) {
+    points[i][0] = copy[2 * moved[i]];
+    points[i][1] = copy[2 * moved[i] + 1];
+  }
+  if (original) {
+    memcpy(original, moved, num_points * sizeof(uint64_t));
+  }
+
+  Array.release(moved);
+  Array.release(copy);
+}
+
+const struct hilbert_curve Hilbert = {.order = order, .sort = sort};
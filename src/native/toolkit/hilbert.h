@@ -0,0 +1,46 @@
+#ifndef TOOLKIT_HILBERT_H
+#define TOOLKIT_HILBERT_H
+
+#include <stdint.h>
+
+struct hilbert_curve
+{
+  /**
+   * @brief   Orders a set of points along a Hilbert curve over their bounding
+   *          square.
+   * @details Points close along the curve are close on the plane, so the
+   *          order is both an approximate tour and a cache-friendly layout.
+   *          Each point is mapped to a 64-bit curve index on a `2^32` by
+   *          `2^32` grid, and the indeces are radix sorted, in time linear in
+   *          the number of points. Vectors of higher dimension are ordered by
+   *          their first two coordinates.
+   *
+   * @param   points           points to order
+   * @param   num_points       number of points
+   * @param   dimension        dimension of the point vectors, at least 2
+   * @param   order            filled with the index of each point, in order
+   *                           along the curve
+   */
+  void (*order)(const double points[],
+                uint64_t     num_points,
+                uint64_t     dimension,
+                uint64_t     order[]);
+
+  /**
+   * @brief   Reorders a buffer of 2D points in place along a Hilbert curve.
+   * @details A layout pass for work that touches neighbouring points together,
+   *          such as cost matrix builds, spatial indexing, or sums over
+   *          neighbourhoods; the results of that work are mapped back to the
+   *          original points through `original`.
+   *
+   * @param   points           points to reorder
+   * @param   num_points       number of points
+   * @param   original         if not NULL, filled with the index each point
+   *                           had before it was moved
+   */
+  void (*sort)(double points[][2], uint64_t num_points, uint64_t original[]);
+};
+
+extern const struct hilbert_curve Hilbert;
+
+#endif
@@ -1,11 +1,15 @@
 #include "ips.h"
 
+#include "kernel.h"
+
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 /**
  * @brief  Calculates the norm of a vector.
+ * @details The manhattan and euclidean norms are computed directly; other
+ *          degrees go through `pow`.
  *
  * @param  degree the degree of norm to calculate
  * @param  vec    vector to evaluate
@@ -18,14 +22,29 @@ static double norm(const uint64_t degree,
                    const uint64_t dim)
 {
   double sum = 0;
-  for (uint64_t i = 0; i < dim; ++i) {
-    sum += pow(fabs(vec[i]), degree);
+  switch (degree) {
+    case 1:
+      for (uint64_t i = 0; i < dim; ++i) {
+        sum += fabs(vec[i]);
+      }
+      return sum;
+    case 2:
+      for (uint64_t i = 0; i < dim; ++i) {
+        sum += vec[i] * vec[i];
+      }
+      return sqrt(sum);
+    default:
+      for (uint64_t i = 0; i < dim; ++i) {
+        sum += pow(fabs(vec[i]), degree);
+      }
+      return pow(sum, (1.0 / degree));
   }
-  return pow(sum, (1.0 / degree));
 }
 
 /**
  * @brief   Calculates the distance between two vectors using a norm.
+ * @details Calls the inlinable `kernel_norm_distance`, which computes the
+ *          manhattan and euclidean norms directly.
  *
  * @param   degree    the degree of norm to use
  * @param   vec1      the first vector
@@ -39,11 +58,7 @@ static double norm_distance(const uint64_t degree,
                             const double   vec2[],
                             const uint64_t dim)
 {
-  double sum = 0;
-  for (uint64_t i = 0; i < dim; ++i) {
-    sum += pow(fabs(vec1[i] - vec2[i]), degree);
-  }
-  return pow(sum, (1.0 / degree));
+  return kernel_norm_distance(degree, vec1, vec2, dim);
 }
 
 /**
@@ -66,11 +81,11 @@ static double net_distance(const uint64_t degree,
                            const double   neighbors[],
                            const uint64_t num_neighbors)
 {
-  double sum = 0;
-  for (uint64_t i = 0; i < num_neighbors; ++i) {
-    sum += IPS.norm_distance(degree, center, (neighbors + i * dim), dim);
-  }
-  return sum;
+  return kernel_net_norm_distance(degree,
+                                  center,
+                                  dim,
+                                  neighbors,
+                                  num_neighbors);
 }
 
 /**
@@ -0,0 +1,429 @@
+#ifndef TOOLKIT_KERNEL_H
+#define TOOLKIT_KERNEL_H
+
+#include "grid.h"
+#include "metric.h"
+
+#include <math.h>
+#include <stdint.h>
+
+/*
+ * Header-level kernels for the hot loops of the native library.
+ *
+ * The `Array`, `IPS`, and `Matrix` tables dispatch through function pointers
+ * defined in other translation units, which the compiler cannot inline. These
+ * kernels are `static inline` and specialized on norm (and, for the common
+ * planar case, on dimension), so that loops calling them compile to straight
+ * arithmetic. The tables remain the public API, and are implemented in terms
+ * of these kernels.
+ */
+
+/**
+ * @brief   Converts an index in a 2D array to the corresponding index in a
+ *          flattened array.
+ *
+ * @param   row              the row index of the 2D array
+ * @param   col              the column index of the 2D array
+ * @param   num_cols         the number of columns in the 2D array
+ *
+ * @return  the corresponding index in the flattened array
+ */
+static inline uint64_t kernel_idx_2d(const uint64_t row,
+                                     const uint64_t col,
+                                     const uint64_t num_cols)
+{
+  return row * num_cols + col;
+}
+
+/**
+ * @brief   Calculates the manhattan distance between two vectors.
+ *
+ * @param   vec1      the first vector
+ * @param   vec2      the second vector
+ * @param   dim       dimension of the vectors
+ *
+ * @return  the L1 distance between the vectors
+ */
+static inline double kernel_l1_distance(const double   vec1[],
+                                        const double   vec2[],
+                                        const uint64_t dim)
+{
+  double sum = 0;
+  for (uint64_t i = 0; i < dim; ++i) {
+    sum += fabs(vec1[i] - vec2[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief   Calculates the euclidean distance between two vectors.
+ *
+ * @param   vec1      the first vector
+ * @param   vec2      the second vector
+ * @param   dim       dimension of the vectors
+ *
+ * @return  the L2 distance between the vectors
+ */
+static inline double kernel_l2_distance(const double   vec1[],
+                                        const double   vec2[],
+                                        const uint64_t dim)
+{
+  double sum = 0;
+  for (uint64_t i = 0; i < dim; ++i) {
+    const double d = vec1[i] - vec2[i];
+    sum += d * d;
+  }
+  return sqrt(sum);
+}
+
+/**
+ * @brief   Calculates the manhattan distance between two planar points.
+ *
+ * @param   vec1      the first point
+ * @param   vec2      the second point
+ *
+ * @return  the L1 distance between the points
+ */
+static inline double kernel_l1_distance_2d(const double vec1[],
+                                           const double vec2[])
+{
+  return fabs(vec1[0] - vec2[0]) + fabs(vec1[1] - vec2[1]);
+}
+
+/**
+ * @brief   Calculates the euclidean distance between two planar points.
+ *
+ * @param   vec1      the first point
+ * @param   vec2      the second point
+ *
+ * @return  the L2 distance between the points
+ */
+static inline double kernel_l2_distance_2d(const double vec1[],
+                                           const double vec2[])
+{
+  const double dx = vec1[0] - vec2[0];
+  const double dy = vec1[1] - vec2[1];
+  return sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * @brief   Calculates the distance between two vectors using a norm.
+ * @details The manhattan and euclidean norms are computed directly, and
+ *          specialized for planar vectors; other degrees go through `pow`.
+ *
+ * @param   degree    the degree of norm to use
+ * @param   vec1      the first vector
+ * @param   vec2      the second vector
+ * @param   dim       dimension of vectors
+ *
+ * @return  the distance between two vectors
+ */
+static inline double kernel_norm_distance(const uint64_t degree,
+                                          const double   vec1[],
+                                          const double   vec2[],
+                                          const uint64_t dim)
+{
+  switch (degree) {
+    case 1:
+      return dim == 2 ? kernel_l1_distance_2d(vec1, vec2)
+                      : kernel_l1_distance(vec1, vec2, dim);
+    case 2:
+      return dim == 2 ? kernel_l2_distance_2d(vec1, vec2)
+                      : kernel_l2_distance(vec1, vec2, dim);
+    default: {
+      double sum = 0;
+      for (uint64_t i = 0; i < dim; ++i) {
+        sum += pow(fabs(vec1[i] - vec2[i]), degree);
+      }
+      return pow(sum, (1.0 / degree));
+    }
+  }
+}
+
+/**
+ * @brief   Calculates the net manhattan distance between a central point and
+ *          a set of neighbors.
+ *
+ * @param   center        the central point
+ * @param   dim           dimension of the vectors
+ * @param   neighbors     flattened neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net L1 distance from the center to each neighbor
+ */
+static inline double kernel_net_l1_distance(const double   center[],
+                                            const uint64_t dim,
+                                            const double   neighbors[],
+                                            const uint64_t num_neighbors)
+{
+  double sum = 0;
+  if (dim == 2) {
+    for (uint64_t i = 0; i < num_neighbors; ++i) {
+      sum += kernel_l1_distance_2d(center, neighbors + 2 * i);
+    }
+  } else {
+    for (uint64_t i = 0; i < num_neighbors; ++i) {
+      sum += kernel_l1_distance(center, neighbors + i * dim, dim);
+    }
+  }
+  return sum;
+}
+
+/**
+ * @brief   Calculates the net euclidean distance between a central point and
+ *          a set of neighbors.
+ *
+ * @param   center        the central point
+ * @param   dim           dimension of the vectors
+ * @param   neighbors     flattened neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net L2 distance from the center to each neighbor
+ */
+static inline double kernel_net_l2_distance(const double   center[],
+                                            const uint64_t dim,
+                                            const double   neighbors[],
+                                            const uint64_t num_neighbors)
+{
+  double sum = 0;
+  if (dim == 2) {
+    for (uint64_t i = 0; i < num_neighbors; ++i) {
+      sum += kernel_l2_distance_2d(center, neighbors + 2 * i);
+    }
+  } else {
+    for (uint64_t i = 0; i < num_neighbors; ++i) {
+      sum += kernel_l2_distance(center, neighbors + i * dim, dim);
+    }
+  }
+  return sum;
+}
+
+/**
+ * @brief   Calculates the net distance between a central point and a set of
+ *          neighbors using a norm.
+ *
+ * @param   degree        the degree of norm to use
+ * @param   center        the central point
+ * @param   dim           dimension of the vectors
+ * @param   neighbors     flattened neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net distance from the center to each neighbor
+ */
+static inline double kernel_net_norm_distance(const uint64_t degree,
+                                              const double   center[],
+                                              const uint64_t dim,
+                                              const double   neighbors[],
+                                              const uint64_t num_neighbors)
+{
+  switch (degree) {
+    case 1:
+      return kernel_net_l1_distance(center, dim, neighbors, num_neighbors);
+    case 2:
+      return kernel_net_l2_distance(center, dim, neighbors, num_neighbors);
+    default: {
+      double sum = 0;
+      for (uint64_t i = 0; i < num_neighbors; ++i) {
+        sum += kernel_norm_distance(degree, center, neighbors + i * dim, dim);
+      }
+      return sum;
+    }
+  }
+}
+
+/**
+ * Constants of haversine distance: pi, to convert degrees to radians, the
+ * mean radius of the earth, and the kilometers and miles in a meter.
+ */
+static const double KERNEL_PI                  = 3.14159265358979323846;
+static const float  KERNEL_EARTH_RADIUS_METERS = 6371e3;
+static const float  KERNEL_METER_TO_KM         = 1e-3;
+static const float  KERNEL_METER_TO_MI         = 6.2137119223733e-4;
+
+/**
+ * @brief   Picks the number of a unit of haversine distance in a meter.
+ *
+ * @param   unit      'm' for kilometers, or anything else for miles
+ *
+ * @return  the unit's share of a meter
+ */
+static inline double kernel_meters_to(const char unit)
+{
+  return unit == 'm' ? KERNEL_METER_TO_KM : KERNEL_METER_TO_MI;
+}
+
+/**
+ * @brief   Calculates the angle between two points of a sphere by the
+ *          Haversine formula.
+ * @details Takes the cosine of each latitude, so that a caller measuring one
+ *          point against many, or every pair of a set, computes each once.
+ *            a = sin²(Δφ/2) + cos φ1 ⋅ cos φ2 ⋅ sin²(Δλ/2)
+ *            c = 2 ⋅ atan2( √a, √(1−a) )
+ *
+ * @param   lat1      latitude of the first point, in radians
+ * @param   cos_lat1  cosine of `lat1`
+ * @param   lat2      latitude of the second point, in radians
+ * @param   cos_lat2  cosine of `lat2`
+ * @param   dlng      difference in longitude, in radians
+ *
+ * @return  the central angle between the points, in radians
+ */
+static inline double kernel_haversine_arc(const double lat1,
+                                          const double cos_lat1,
+                                          const double lat2,
+                                          const double cos_lat2,
+                                          const double dlng)
+{
+  const double sin_dlat = sin((lat2 - lat1) / 2);
+  const double sin_dlng = sin(dlng / 2);
+  const double a        = sin_dlat * sin_dlat +
+                   cos_lat1 * cos_lat2 * sin_dlng * sin_dlng;
+
+  return 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+/**
+ * @brief   Calculates the earthly distance between two latitude/longitude
+ *          points given in degrees.
+ *
+ * @param   vec1      the first `[latitude, longitude]` point
+ * @param   vec2      the second `[latitude, longitude]` point
+ * @param   unit      'm' for kilometers, or anything else for miles
+ *
+ * @return  distance between the points
+ */
+static inline double kernel_haversine_distance(const double vec1[],
+                                               const double vec2[],
+                                               const char   unit)
+{
+  const double lat1 = vec1[0] / 180 * KERNEL_PI;
+  const double lat2 = vec2[0] / 180 * KERNEL_PI;
+  const double dlng = (vec2[1] - vec1[1]) / 180 * KERNEL_PI;
+
+  return kernel_haversine_arc(lat1, cos(lat1), lat2, cos(lat2), dlng) *
+         KERNEL_EARTH_RADIUS_METERS * kernel_meters_to(unit);
+}
+
+/**
+ * @brief   Calculates the net earthly distance between a central point and a
+ *          set of latitude/longitude neighbors given in degrees.
+ * @details The center's latitude terms are computed once rather than per
+ *          neighbor.
+ *
+ * @param   center        the central `[latitude, longitude]` point
+ * @param   dim           dimension of the vectors
+ * @param   neighbors     flattened neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ * @param   unit          'm' for kilometers, or anything else for miles
+ *
+ * @return  the net distance from the center to each neighbor
+ */
+static inline double kernel_net_haversine_distance(const double   center[],
+                                                   const uint64_t dim,
+                                                   const double   neighbors[],
+                                                   const uint64_t num_neighbors,
+                                                   const char     unit)
+{
+  const double lat1 = center[0] / 180 * KERNEL_PI;
+  const double cos1 = cos(lat1);
+  double       arc  = 0;
+  for (uint64_t i = 0; i < num_neighbors; ++i) {
+    const double * p    = neighbors + i * dim;
+    const double   lat2 = p[0] / 180 * KERNEL_PI;
+    const double   dlng = (p[1] - center[1]) / 180 * KERNEL_PI;
+    arc += kernel_haversine_arc(lat1, cos1, lat2, cos(lat2), dlng);
+  }
+  return arc * KERNEL_EARTH_RADIUS_METERS * kernel_meters_to(unit);
+}
+
+/**
+ * @brief   Calculates the distance between two points under a metric.
+ * @note    Distances to arbitrary coordinates are euclidean under
+ *          `METRIC_MATRIX`.
+ *
+ * @param   metric    the metric to measure with
+ * @param   vec1      the first point
+ * @param   vec2      the second point
+ * @param   dim       dimension of the points
+ *
+ * @return  the distance between the points
+ */
+static inline double
+kernel_metric_distance(const struct DistanceMetric * metric,
+                       const double                  vec1[],
+                       const double                  vec2[],
+                       const uint64_t                dim)
+{
+  switch (metric->type) {
+    case METRIC_L1:
+      return kernel_norm_distance(1, vec1, vec2, dim);
+    case METRIC_HAVERSINE:
+      return kernel_haversine_distance(vec1, vec2, metric->unit);
+    case METRIC_L2:
+    case METRIC_MATRIX:
+    default:
+      return kernel_norm_distance(2, vec1, vec2, dim);
+  }
+}
+
+/**
+ * @brief   Calculates the net distance between a central point and a set of
+ *          neighbors under a metric.
+ * @details Dispatches on the metric once, then sums the distances in the loop
+ *          specialized for that metric.
+ *
+ * @param   metric        the metric to measure with
+ * @param   center        the central point
+ * @param   dim           dimension of the points
+ * @param   neighbors     flattened neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net distance from the center to each neighbor
+ */
+static inline double
+kernel_net_metric_distance(const struct DistanceMetric * metric,
+                           const double                  center[],
+                           const uint64_t                dim,
+                           const double                  neighbors[],
+                           const uint64_t                num_neighbors)
+{
+  switch (metric->type) {
+    case METRIC_L1:
+      return kernel_net_l1_distance(center, dim, neighbors, num_neighbors);
+    case METRIC_HAVERSINE:
+      return kernel_net_haversine_distance(center,
+                                           dim,
+                                           neighbors,
+                                           num_neighbors,
+                                           metric->unit);
+    case METRIC_L2:
+    case METRIC_MATRIX:
+    default:
+      return kernel_net_l2_distance(center, dim, neighbors, num_neighbors);
+  }
+}
+
+/**
+ * @brief   Finds the mean of a set of 2D points.
+ *
+ * @param   points     flattened points to measure
+ * @param   num_points number of points
+ *
+ * @return  mean of points
+ */
+static inline Grid_2D kernel_mean_2d(const double   points[],
+                                     const uint64_t num_points)
+{
+  Grid_2D center = {0, 0};
+  for (uint64_t i = 0; i < num_points; ++i) {
+    center.x += points[2 * i];
+    center.y += points[2 * i + 1];
+  }
+
+  center.x = center.x / num_points;
+  center.y = center.y / num_points;
+
+  return center;
+}
+
+#endif
@@ -1,9 +1,13 @@
 #include "matrix.h"
 
 #include "array.h"
-#include "ips.h"
+#include "kernel.h"
+#include "parallel.h"
+#include "stats.h"
 
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef __D_swap
 #define __D_swap(a, b, type) \
@@ -14,15 +18,30 @@
   }
 #endif
 
+/**
+ * Columns factored per panel of an LU factorization.
+ */
+static const uint64_t LU_BLOCK = 32;
+
+/**
+ * Columns of the trailing submatrix updated per pass over a panel.
+ */
+static const uint64_t LU_TILE = 512;
+
+/**
+ * Minimum number of trailing rows updated per thread.
+ */
+static const uint64_t LU_UPDATE_GRAIN = 64;
+
 /**
  * @brief   Performs in-place gaussian elimination on an augmented matrix.
  * @details Traverses the main diagonal in an `n x (n + 1)` augmented matrix,
  *          with primary matrix of size `n x n`. At each point `(i, i)` in the
- *          main diagonal, the coefficient `c` at `(i, i)` is compared to the
- *          coefficient `d` at column `i` of all lower rows. If `d > c`, the
- *          rows are swapped, bubbling zero rows to the bottom of the matrix.
- *          The lower rows are then eliminated using the third elementary row
- *          operation, producing a leading variable in row `i`.
+ *          main diagonal, the row with the coefficient of largest magnitude in
+ *          column `i`, on or below the diagonal, is swapped up to be the pivot,
+ *          bubbling zero rows to the bottom of the matrix. The lower rows are
+ *          then eliminated using the third elementary row operation, producing
+ *          a leading variable in row `i`.
  * @note    The matrix must be augmented and consistent.
  * @note    This is guaranteed to reduce the matrix to row echelon form, though
  *          not necessarily reduced row echelon form.
@@ -35,22 +54,31 @@ static void eliminate_gaussian(double * matrix, const uint64_t dim)
 {
   const uint64_t cols = dim + 1;
   for (uint64_t i = 0; i < dim; ++i) {
+    uint64_t pivot = i;
     for (uint64_t j = i + 1; j < dim; ++j) {
-      // swap rows if not in descending order
-      if (matrix[Array.idx_2d(j, i, cols)] > matrix[Array.idx_2d(i, i, cols)]) {
-        for (uint64_t k = 0; k <= dim; ++k) {
-          __D_swap(matrix[Array.idx_2d(i, k, cols)],
-                   matrix[Array.idx_2d(j, k, cols)],
-                   double);
-        }
+      if (fabs(matrix[kernel_idx_2d(j, i, cols)]) >
+          fabs(matrix[kernel_idx_2d(pivot, i, cols)])) {
+        pivot = j;
       }
+    }
 
-      // eliminate lower row
-      const double ratio = matrix[Array.idx_2d(j, i, cols)] /
-                           matrix[Array.idx_2d(i, i, cols)];
-      for (uint64_t k = 0; k <= dim; ++k) {
-        matrix[Array.idx_2d(j, k, cols)] -= ratio *
-                                            matrix[Array.idx_2d(i, k, cols)];
+    double * row_i = matrix + kernel_idx_2d(i, 0, cols);
+    if (pivot != i) {
+      double * row_p = matrix + kernel_idx_2d(pivot, 0, cols);
+      for (uint64_t k = i; k <= dim; ++k) {
+        __D_swap(row_i[k], row_p[k], double);
+      }
+    }
+    if (!(fabs(row_i[i]) > 0)) {
+      continue;
+    }
+
+    // eliminate lower rows; columns left of `i` are already zero
+    for (uint64_t j = i + 1; j < dim; ++j) {
+      double *     row_j = matrix + kernel_idx_2d(j, 0, cols);
+      const double ratio = row_j[i] / row_i[i];
+      for (uint64_t k = i; k <= dim; ++k) {
+        row_j[k] -= ratio * row_i[k];
       }
     }
   }
@@ -78,25 +106,408 @@ static double * solve_reduced_augmented(const double * matrix,
   // perform backwards substitution
   for (uint64_t i = dimension; i > 0; --i) {
     const uint64_t row = i - 1;
-    solution[row]      = matrix[Array.idx_2d(row, dimension, cols)];
+    solution[row]      = matrix[kernel_idx_2d(row, dimension, cols)];
 
     // subtract influence of all following coefficients
     for (uint64_t j = i; j < dimension; ++j) {
-      solution[row] -= matrix[Array.idx_2d(row, j, cols)] * solution[j];
+      solution[row] -= matrix[kernel_idx_2d(row, j, cols)] * solution[j];
     }
 
     // divide by leading coefficient
-    solution[i - 1] /= matrix[Array.idx_2d(i - 1, i - 1, cols)];
+    solution[i - 1] /= matrix[kernel_idx_2d(i - 1, i - 1, cols)];
   }
 
   return solution;
 }
 
+/**
+ * @struct
+ * @brief  The trailing submatrix of a blocked LU factorization, updated by
+ *         one factored panel
+ *
+ * @prop   matrix     matrix being factored
+ * @prop   n          number of rows and columns
+ * @prop   panel      first column of the panel
+ * @prop   width      number of columns of the panel
+ */
+struct __lu_update
+{
+  double * matrix;
+  uint64_t n;
+  uint64_t panel;
+  uint64_t width;
+};
+
+/**
+ * @brief   Subtracts `L21 U12` from a range of rows of the trailing
+ *          submatrix.
+ * @details Columns are taken a tile at a time, so the rows of `U12` stay in
+ *          cache across every row of the range. Each row update is a
+ *          contiguous multiply-subtract the compiler vectorizes.
+ *
+ * @param   begin            first row of the range
+ * @param   end              one past the last row of the range
+ * @param   context          the update
+ */
+static void __lu_update_task(const uint64_t begin,
+                             const uint64_t end,
+                             void *         context)
+{
+  const struct __lu_update * U     = context;
+  const uint64_t             n     = U->n;
+  const uint64_t             after = U->panel + U->width;
+
+  for (uint64_t tile = after; tile < n; tile += LU_TILE) {
+    const uint64_t tile_end = tile + LU_TILE < n ? tile + LU_TILE : n;
+    for (uint64_t i = begin; i < end; ++i) {
+      double * row_i = U->matrix + kernel_idx_2d(i, 0, n);
+      uint64_t k     = U->panel;
+
+      // four rows of U12 per pass load and store the row a quarter as often
+      for (; k + 4 <= after; k += 4) {
+        const double   l_0   = row_i[k];
+        const double   l_1   = row_i[k + 1];
+        const double   l_2   = row_i[k + 2];
+        const double   l_3   = row_i[k + 3];
+        const double * row_0 = U->matrix + kernel_idx_2d(k, 0, n);
+        const double * row_1 = row_0 + n;
+        const double * row_2 = row_1 + n;
+        const double * row_3 = row_2 + n;
+        for (uint64_t j = tile; j < tile_end; ++j) {
+          row_i[j] -= l_0 * row_0[j] + l_1 * row_1[j] + l_2 * row_2[j] +
+                      l_3 * row_3[j];
+        }
+      }
+      for (; k < after; ++k) {
+        const double   l_ik  = row_i[k];
+        const double * row_k = U->matrix + kernel_idx_2d(k, 0, n);
+        for (uint64_t j = tile; j < tile_end; ++j) {
+          row_i[j] -= l_ik * row_k[j];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Factors a square matrix in place into `PA = LU`, by gaussian
+ *          elimination with partial pivoting.
+ * @details At each column, the row with the entry of largest magnitude on or
+ *          below the diagonal is swapped up to be the pivot. Afterwards the
+ *          strict lower triangle holds `L`, whose diagonal is implicitly 1, and
+ *          the upper triangle holds `U`. A factorization solves any number of
+ *          right-hand sides with `solve_lu`.
+ *
+ *          Columns are factored in narrow panels: a panel is eliminated on its
+ *          own, the rows of `U` right of it are solved against its unit lower
+ *          triangle, and the trailing submatrix then takes the whole panel in
+ *          one cache-blocked pass, split by rows across worker threads.
+ *          Matrices no wider than a panel are factored unblocked.
+ *
+ * @param   matrix           row-major `dimension x dimension` matrix
+ * @param   dimension        number of rows and columns
+ * @param   pivots           filled with the original row held by each row
+ *
+ * @return  whether every pivot is nonzero; solutions of a singular matrix are
+ *          not finite
+ */
+static bool factor_lu(double         matrix[],
+                      const uint64_t dimension,
+                      uint64_t       pivots[])
+{
+  const uint64_t n       = dimension;
+  bool           regular = true;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    pivots[i] = i;
+  }
+
+  for (uint64_t panel = 0; panel < n; panel += LU_BLOCK) {
+    const uint64_t after = panel + LU_BLOCK < n ? panel + LU_BLOCK : n;
+
+    // factor the panel, swapping whole rows
+    for (uint64_t k = panel; k < after; ++k) {
+      // the largest entry of the column makes the most stable pivot
+      uint64_t pivot = k;
+      for (uint64_t i = k + 1; i < n; ++i) {
+        if (fabs(matrix[kernel_idx_2d(i, k, n)]) >
+            fabs(matrix[kernel_idx_2d(pivot, k, n)])) {
+          pivot = i;
+        }
+      }
+      if (pivot != k) {
+        double * row_k = matrix + kernel_idx_2d(k, 0, n);
+        double * row_p = matrix + kernel_idx_2d(pivot, 0, n);
+        for (uint64_t j = 0; j < n; ++j) {
+          __D_swap(row_k[j], row_p[j], double);
+        }
+        __D_swap(pivots[k], pivots[pivot], uint64_t);
+      }
+
+      const double * row_k = matrix + kernel_idx_2d(k, 0, n);
+      if (!(fabs(row_k[k]) > 0)) {
+        regular = false;
+        continue;
+      }
+
+      for (uint64_t i = k + 1; i < n; ++i) {
+        double *     row_i = matrix + kernel_idx_2d(i, 0, n);
+        const double ratio = row_i[k] / row_k[k];
+        row_i[k]           = ratio;
+        for (uint64_t j = k + 1; j < after; ++j) {
+          row_i[j] -= ratio * row_k[j];
+        }
+      }
+    }
+
+    if (after == n) {
+      break;
+    }
+
+    // U12 = L11^-1 A12
+    for (uint64_t k = panel; k < after; ++k) {
+      const double * row_k = matrix + kernel_idx_2d(k, 0, n);
+      for (uint64_t i = k + 1; i < after; ++i) {
+        double *     row_i = matrix + kernel_idx_2d(i, 0, n);
+        const double l_ik  = row_i[k];
+        for (uint64_t j = after; j < n; ++j) {
+          row_i[j] -= l_ik * row_k[j];
+        }
+      }
+    }
+
+    // A22 -= L21 U12
+    struct __lu_update update = {matrix, n, panel, after - panel};
+    Parallel.for_range(after, n, LU_UPDATE_GRAIN, __lu_update_task, &update);
+  }
+
+  return regular;
+}
+
+/**
+ * @brief   Solves `Ax = b` in place against a factorization of `A`.
+ * @details Permutes `b`, then substitutes forwards through `L` and backwards
+ *          through `U`, in time quadratic in the dimension.
+ *
+ * @param   lu               factorization from `factor_lu`
+ * @param   dimension        number of rows and columns
+ * @param   pivots           row permutation from `factor_lu`
+ * @param   b                right-hand side, replaced by the solution `x`
+ */
+static void solve_lu(const double   lu[],
+                     const uint64_t dimension,
+                     const uint64_t pivots[],
+                     double         b[])
+{
+  const uint64_t n = dimension;
+  double *       y = Array.Scratch.double_array(n);
+
+  // Ly = Pb
+  for (uint64_t i = 0; i < n; ++i) {
+    const double * row = lu + kernel_idx_2d(i, 0, n);
+    double         sum = b[pivots[i]];
+    for (uint64_t j = 0; j < i; ++j) {
+      sum -= row[j] * y[j];
+    }
+    y[i] = sum;
+  }
+
+  // Ux = y
+  for (uint64_t i = n; i-- > 0;) {
+    const double * row = lu + kernel_idx_2d(i, 0, n);
+    double         sum = y[i];
+    for (uint64_t j = i + 1; j < n; ++j) {
+      sum -= row[j] * b[j];
+    }
+    b[i] = sum / row[i];
+  }
+
+  Array.release(y);
+}
+
+/**
+ * @brief   Factors a symmetric positive-definite matrix in place into
+ *          `A = LL^T`.
+ * @details The Cholesky factor takes half the work of an LU factorization
+ *          and needs no pivoting, which suits normal equations such as those
+ *          of a least squares fit. Each entry of `L` is a dot product of two
+ *          contiguous rows already factored. Only the lower triangle is read
+ *          and written; the strict upper triangle is left as given.
+ *
+ * @param   matrix           row-major `dimension x dimension` matrix
+ * @param   dimension        number of rows and columns
+ *
+ * @return  whether the matrix is positive definite; if not, the matrix is
+ *          left partially factored and should be factored by `factor_lu`
+ *          from a fresh copy instead
+ */
+static bool factor_cholesky(double matrix[], const uint64_t dimension)
+{
+  const uint64_t n = dimension;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    double * row_i = matrix + kernel_idx_2d(i, 0, n);
+    for (uint64_t j = 0; j <= i; ++j) {
+      const double * row_j = matrix + kernel_idx_2d(j, 0, n);
+      double         sum   = row_i[j];
+      for (uint64_t k = 0; k < j; ++k) {
+        sum -= row_i[k] * row_j[k];
+      }
+
+      if (j < i) {
+        row_i[j] = sum / row_j[j];
+      } else if (sum > 0) {
+        row_i[i] = sqrt(sum);
+      } else {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Solves `Ax = b` in place against a Cholesky factorization of `A`.
+ * @details Substitutes forwards through `L`, then backwards through `L^T` a
+ *          row of `L` at a time, so both passes read `L` contiguously.
+ *
+ * @param   l                factorization from `factor_cholesky`
+ * @param   dimension        number of rows and columns
+ * @param   b                right-hand side, replaced by the solution `x`
+ */
+static void solve_cholesky(const double   l[],
+                           const uint64_t dimension,
+                           double         b[])
+{
+  const uint64_t n = dimension;
+
+  // Ly = b
+  for (uint64_t i = 0; i < n; ++i) {
+    const double * row = l + kernel_idx_2d(i, 0, n);
+    double         sum = b[i];
+    for (uint64_t j = 0; j < i; ++j) {
+      sum -= row[j] * b[j];
+    }
+    b[i] = sum / row[i];
+  }
+
+  // L^T x = y
+  for (uint64_t i = n; i-- > 0;) {
+    const double * row = l + kernel_idx_2d(i, 0, n);
+    b[i] /= row[i];
+    for (uint64_t j = 0; j < i; ++j) {
+      b[j] -= row[j] * b[i];
+    }
+  }
+}
+
+/**
+ * @brief   Creates a cost matrix based on distances among a set of vectors
+ *          under a metric.
+ * @details Fills index `(i, j)` with the distance from vector `i` to vector
+ *          `j`. Each metric is computed by its own loop: L1 and L2 fill the
+ *          upper triangle and mirror it, haversine precomputes the radian
+ *          latitude and its cosine once per vector, and a precomputed matrix is
+ *          copied as given.
+ *
+ * @param   metric           the metric to measure with
+ * @param   vectors          set of vectors to build a cost matrix for
+ * @param   num_vectors      number of vectors
+ * @param   dimension        dimension of the vectors
+ *
+ * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+ *          to be given back with `Array.release`
+ */
+static double * metric_cost_matrix(const struct DistanceMetric * metric,
+                                   const double *                vectors,
+                                   const uint64_t                num_vectors,
+                                   const uint64_t                dimension)
+{
+  const uint64_t n           = num_vectors;
+  const uint64_t started     = Stats.start();
+  double *       cost_matrix = Array.Scratch.double_array(n * n);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    cost_matrix[kernel_idx_2d(i, i, n)] = 0;
+  }
+
+  switch (metric->type) {
+    case METRIC_L1:
+      for (uint64_t i = 0; i < n; ++i) {
+        const double * a = vectors + i * dimension;
+        for (uint64_t j = i + 1; j < n; ++j) {
+          const double * b = vectors + j * dimension;
+          const double   d = dimension == 2
+                                 ? kernel_l1_distance_2d(a, b)
+                                 : kernel_l1_distance(a, b, dimension);
+          cost_matrix[kernel_idx_2d(i, j, n)] = d;
+          cost_matrix[kernel_idx_2d(j, i, n)] = d;
+        }
+      }
+      break;
+
+    case METRIC_HAVERSINE: {
+      const double to_unit = kernel_meters_to(metric->unit);
+      double *     lat     = Array.Scratch.double_array(n);
+      double *     cos_lat = Array.Scratch.double_array(n);
+      for (uint64_t i = 0; i < n; ++i) {
+        lat[i]     = vectors[kernel_idx_2d(i, 0, dimension)] / 180 * KERNEL_PI;
+        cos_lat[i] = cos(lat[i]);
+      }
+      for (uint64_t i = 0; i < n; ++i) {
+        const double lng1 = vectors[kernel_idx_2d(i, 1, dimension)];
+        for (uint64_t j = i + 1; j < n; ++j) {
+          const double lng2 = vectors[kernel_idx_2d(j, 1, dimension)];
+          const double dlng = (lng2 - lng1) / 180 * KERNEL_PI;
+          const double arc  = kernel_haversine_arc(
+              lat[i], cos_lat[i], lat[j], cos_lat[j], dlng);
+          const double d    = arc * KERNEL_EARTH_RADIUS_METERS * to_unit;
+          cost_matrix[kernel_idx_2d(i, j, n)] = d;
+          cost_matrix[kernel_idx_2d(j, i, n)] = d;
+        }
+      }
+      Array.release(lat);
+      Array.release(cos_lat);
+      break;
+    }
+
+    case METRIC_MATRIX:
+      if (metric->matrix && metric->size == n) {
+        memcpy(cost_matrix, metric->matrix, n * n * sizeof(double));
+        break;
+      }
+      // a matrix for some other set of points; measure the points instead
+      // fall through
+
+    case METRIC_L2:
+    default:
+      for (uint64_t i = 0; i < n; ++i) {
+        const double * a = vectors + i * dimension;
+        for (uint64_t j = i + 1; j < n; ++j) {
+          const double * b = vectors + j * dimension;
+          const double   d = dimension == 2
+                                 ? kernel_l2_distance_2d(a, b)
+                                 : kernel_l2_distance(a, b, dimension);
+          cost_matrix[kernel_idx_2d(i, j, n)] = d;
+          cost_matrix[kernel_idx_2d(j, i, n)] = d;
+        }
+      }
+      break;
+  }
+
+  Stats.count(STAT_COST_MATRIX_BUILDS, 1);
+  Stats.stop(STAT_COST_MATRIX, started);
+
+  return cost_matrix;
+}
+
 /**
  * @brief   Creates a cost matrix based on distances among a set of vectors.
  * @details For each two vectors `i, j` in the set, the distance `|i-j|` based
  *          on some inner product space is calculated and stored in index
- *          `(i, j)` of the cost matrix.
+ *          `(i, j)` of the cost matrix. The manhattan and euclidean norms are
+ *          built by their specialized loops in `metric_cost_matrix`.
  *
  * @param   vectors          set of vectors to build a cost matrix for
  * @param   num_vectors      number of vectors
@@ -104,32 +515,37 @@ static double * solve_reduced_augmented(const double * matrix,
  * @param   norm_degree      degree of the norm to use in calculating distance
  *                           between vectors
  *
- * @return  a pointer to the cost matrix
+ * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+ *          to be given back with `Array.release`
  */
 static double * cost_matrix(const double * vectors,
                             const uint64_t num_vectors,
                             const uint64_t dimension,
                             const uint64_t norm_degree)
 {
-  double * cost_matrix = Array.New.double_array(num_vectors * num_vectors);
+  if (norm_degree == 1 || norm_degree == 2) {
+    const struct DistanceMetric metric = {
+        norm_degree == 1 ? METRIC_L1 : METRIC_L2, 'm', NULL, 0};
+    return metric_cost_matrix(&metric, vectors, num_vectors, dimension);
+  }
+
+  const uint64_t n           = num_vectors;
+  const uint64_t started     = Stats.start();
+  double *       cost_matrix = Array.Scratch.double_array(n * n);
 
   for (uint64_t i = 0; i < num_vectors; ++i) {
+    const double * start = vectors + kernel_idx_2d(i, 0, dimension);
     for (uint64_t j = 0; j < num_vectors; ++j) {
-      double start[dimension];
-      double end[dimension];
-      for (uint64_t p = 0; p < dimension; ++p) {
-        start[p] = vectors[Array.idx_2d(i, p, dimension)];
-        end[p]   = vectors[Array.idx_2d(j, p, dimension)];
-      }
+      const double * end = vectors + kernel_idx_2d(j, 0, dimension);
 
-      cost_matrix[Array.idx_2d(i,
-                               j,
-                               num_vectors)] = IPS.norm_distance(norm_degree,
-                                                                 start,
-                                                                 end,
-                                                                 dimension);
+      cost_matrix[kernel_idx_2d(i, j, num_vectors)] =
+          kernel_norm_distance(norm_degree, start, end, dimension);
     }
   }
+
+  Stats.count(STAT_COST_MATRIX_BUILDS, 1);
+  Stats.stop(STAT_COST_MATRIX, started);
+
   return cost_matrix;
 }
 
@@ -170,7 +586,8 @@ static double * __WRAP_solve_reduced_augmented(const double * matrix[],
  * @param   norm_degree      degree of the norm to use in calculating distance
  *                           between vectors
  *
- * @return  a pointer to the cost matrix
+ * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+ *          to be given back with `Array.release`
  */
 static double * __WRAP_cost_matrix(const double * vectors[],
                                    const uint64_t num_vectors,
@@ -180,7 +597,34 @@ static double * __WRAP_cost_matrix(const double * vectors[],
   return cost_matrix((double *)vectors, num_vectors, dimension, norm_degree);
 }
 
+/**
+ * @brief   Wraps metric_cost_matrix for a better user API.
+ *
+ * @param   metric           the metric to measure with
+ * @param   vectors          set of vectors to build a cost matrix for
+ * @param   num_vectors      number of vectors
+ * @param   dimension        dimension of the vectors
+ *
+ * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+ *          to be given back with `Array.release`
+ */
+static double * __WRAP_metric_cost_matrix(const struct DistanceMetric * metric,
+                                          const double * vectors[],
+                                          const uint64_t num_vectors,
+                                          const uint64_t dimension)
+{
+  return metric_cost_matrix(metric,
+                            (const double *)vectors,
+                            num_vectors,
+                            dimension);
+}
+
 const struct matrix Matrix =
     {.eliminate_gaussian      = __WRAP_eliminate_gaussian,
      .solve_reduced_augmented = __WRAP_solve_reduced_augmented,
-     .cost_matrix             = __WRAP_cost_matrix};
+     .factor_lu               = factor_lu,
+     .solve_lu                = solve_lu,
+     .factor_cholesky         = factor_cholesky,
+     .solve_cholesky          = solve_cholesky,
+     .cost_matrix             = __WRAP_cost_matrix,
+     .metric_cost_matrix      = __WRAP_metric_cost_matrix};
@@ -1,6 +1,9 @@
 #ifndef TOOLKIT_MATRIX_H
 #define TOOLKIT_MATRIX_H
 
+#include "metric.h"
+
+#include <stdbool.h>
 #include <stdint.h>
 
 struct matrix
@@ -10,10 +13,11 @@ struct matrix
    * @details Traverses the main diagonal in an `n x (n + 1)` augmented matrix,
    *          with primary matrix of size `n x n`. At each point `(i, i)` in the
    *          main diagonal, the coefficient `c` at `(i, i)` is compared to the
-   *          coefficient `d` at column `i` of all lower rows. If `d > c`, the
-   *          rows are swapped, bubbling zero rows to the bottom of the matrix.
-   *          The lower rows are then eliminated using the third elementary row
-   *          operation, producing a leading variable in row `i`.
+   *          row with the coefficient of largest magnitude in column `i`, on
+   *          or below the diagonal, is swapped up to be the pivot, bubbling
+   *          zero rows to the bottom of the matrix. The lower rows are then
+   *          eliminated using the third elementary row operation, producing a
+   *          leading variable in row `i`.
    * @note    The matrix must be augmented and consistent.
    * @note    This is guaranteed to reduce the matrix to row echelon form,
    *          though not necessarily reduced row echelon form.
@@ -40,6 +44,75 @@ struct matrix
   double * (*solve_reduced_augmented)(const double * matrix[],
                                       uint64_t       dimension);
 
+  /**
+   * @brief   Factors a square matrix in place into `PA = LU`, by gaussian
+   *          elimination with partial pivoting.
+   * @details At each column, the row with the entry of largest magnitude on or
+   *          below the diagonal is swapped up to be the pivot. Afterwards the
+   *          strict lower triangle holds `L`, whose diagonal is implicitly 1,
+   *          and the upper triangle holds `U`. A factorization solves any
+   *          number of right-hand sides with `solve_lu`.
+   *
+   *          Columns are factored in narrow panels: a panel is eliminated on
+   *          its own, the rows of `U` right of it are solved against its unit
+   *          lower triangle, and the trailing submatrix then takes the whole
+   *          panel in one cache-blocked pass, split by rows across worker
+   *          threads. Matrices no wider than a panel are factored unblocked.
+   *
+   * @param   matrix           row-major `dimension x dimension` matrix
+   * @param   dimension        number of rows and columns
+   * @param   pivots           filled with the original row held by each row
+   *
+   * @return  whether every pivot is nonzero; solutions of a singular matrix
+   *          are not finite
+   */
+  bool (*factor_lu)(double matrix[], uint64_t dimension, uint64_t pivots[]);
+
+  /**
+   * @brief   Solves `Ax = b` in place against a factorization of `A`.
+   * @details Permutes `b`, then substitutes forwards through `L` and backwards
+   *          through `U`, in time quadratic in the dimension.
+   *
+   * @param   lu               factorization from `factor_lu`
+   * @param   dimension        number of rows and columns
+   * @param   pivots           row permutation from `factor_lu`
+   * @param   b                right-hand side, replaced by the solution `x`
+   */
+  void (*solve_lu)(const double   lu[],
+                   uint64_t       dimension,
+                   const uint64_t pivots[],
+                   double         b[]);
+
+  /**
+   * @brief   Factors a symmetric positive-definite matrix in place into
+   *          `A = LL^T`.
+   * @details The Cholesky factor takes half the work of an LU factorization
+   *          and needs no pivoting, which suits normal equations such as those
+   *          of a least squares fit. Each entry of `L` is a dot product of two
+   *          contiguous rows already factored. Only the lower triangle is read
+   *          and written; the strict upper triangle is left as given.
+   *
+   * @param   matrix           row-major `dimension x dimension` matrix
+   * @param   dimension        number of rows and columns
+   *
+   * @return  whether the matrix is positive definite; if not, the matrix is
+   *          left partially factored and should be factored by `factor_lu`
+   *          from a fresh copy instead
+   */
+  bool (*factor_cholesky)(double matrix[], uint64_t dimension);
+
+  /**
+   * @brief   Solves `Ax = b` in place against a Cholesky factorization of
+   *          `A`.
+   * @details Substitutes forwards through `L`, then backwards through `L^T` a
+   *          row of `L` at a time, so both passes read `L` contiguously.
+   *
+   * @param   l                factorization from `factor_cholesky`
+   * @param   dimension        number of rows and columns
+   * @param   b                right-hand side, replaced by the solution `x`
+   */
+  void (*solve_cholesky)(const double l[], uint64_t dimension, double b[]);
+
   /**
    * @brief   Creates a cost matrix based on distances among a set of vectors.
    * @details For each two vectors `i, j` in the set, the distance `|i-j|`
@@ -52,12 +125,35 @@ struct matrix
    * @param   norm_degree      degree of the norm to use in calculating distance
    *                           between vectors
    *
-   * @return  a pointer to the cost matrix
+   * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+   *          to be given back with `Array.release`
    */
   double * (*cost_matrix)(const double * vectors[],
                           uint64_t       num_vectors,
                           uint64_t       dimension,
                           uint64_t       norm_degree);
+
+  /**
+   * @brief   Creates a cost matrix based on distances among a set of vectors
+   *          under a metric.
+   * @details Fills index `(i, j)` with the distance from vector `i` to vector
+   *          `j`. Each metric is computed by its own loop: L1 and L2 fill the
+   *          upper triangle and mirror it, haversine precomputes the radian
+   *          latitude and its cosine once per vector, and a precomputed matrix
+   *          is copied as given.
+   *
+   * @param   metric           the metric to measure with
+   * @param   vectors          set of vectors to build a cost matrix for
+   * @param   num_vectors      number of vectors
+   * @param   dimension        dimension of the vectors
+   *
+   * @return  a pointer to the cost matrix, borrowed from `Array.Scratch` and
+   *          to be given back with `Array.release`
+   */
+  double * (*metric_cost_matrix)(const struct DistanceMetric * metric,
+                                 const double *                vectors[],
+                                 uint64_t                      num_vectors,
+                                 uint64_t                      dimension);
 };
 
 extern const struct matrix Matrix;
@@ -0,0 +1,81 @@
+#include "metric.h"
+
+#include "kernel.h"
+
+#include <stdlib.h>
+
+const struct DistanceMetric METRIC_EUCLIDEAN = {METRIC_L2, 'm', NULL, 0};
+
+/**
+ * @brief   Calculates the distance between two points under a metric.
+ *
+ * @param   metric    the metric to measure with
+ * @param   vec1      the first point
+ * @param   vec2      the second point
+ * @param   dim       dimension of the points
+ *
+ * @return  the distance between the points
+ */
+static double distance(const struct DistanceMetric * metric,
+                       const double                  vec1[],
+                       const double                  vec2[],
+                       const uint64_t                dim)
+{
+  return kernel_metric_distance(metric, vec1, vec2, dim);
+}
+
+/**
+ * @brief   Calculates the net distance between a central point and a set of
+ *          neighbors under a metric.
+ * @details Dispatches on the metric once, then sums the distances from the
+ *          center to each neighbor in a loop specialized for that metric.
+ *          Under the haversine metric the center's latitude terms are
+ *          computed once rather than per neighbor.
+ *
+ * @param   metric        the metric to measure with
+ * @param   center        the central point
+ * @param   dim           dimension of the points
+ * @param   neighbors     neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net distance from the center to each neighbor
+ */
+static double net_distance(const struct DistanceMetric * metric,
+                           const double                  center[],
+                           const uint64_t                dim,
+                           const double                  neighbors[],
+                           const uint64_t                num_neighbors)
+{
+  return kernel_net_metric_distance(metric,
+                                    center,
+                                    dim,
+                                    neighbors,
+                                    num_neighbors);
+}
+
+/**
+ * @brief   Wraps net_distance for a better user API.
+ *
+ * @param   metric        the metric to measure with
+ * @param   center        the central point
+ * @param   dim           dimension of the points
+ * @param   neighbors     neighbors to evaluate
+ * @param   num_neighbors number of neighbors
+ *
+ * @return  the net distance from the center to each neighbor
+ */
+static double __WRAP_net_distance(const struct DistanceMetric * metric,
+                                  const double                  center[],
+                                  const uint64_t                dim,
+                                  const double *                neighbors[],
+                                  const uint64_t                num_neighbors)
+{
+  return net_distance(metric,
+                      center,
+                      dim,
+                      (const double *)neighbors,
+                      num_neighbors);
+}
+
+const struct metric Metric = {.distance     = distance,
+                              .net_distance = __WRAP_net_distance};
@@ -0,0 +1,90 @@
+#ifndef TOOLKIT_METRIC_H
+#define TOOLKIT_METRIC_H
+
+#include <stdint.h>
+
+/**
+ * @enum
+ * @brief  Ways of measuring the distance between two points
+ *
+ * @prop   METRIC_L1        manhattan distance
+ * @prop   METRIC_L2        euclidean distance
+ * @prop   METRIC_HAVERSINE earthly distance between `[latitude, longitude]`
+ *                          points, in degrees
+ * @prop   METRIC_MATRIX    distances precomputed by the caller between points
+ *                          of a fixed set, such as road distances
+ */
+enum MetricType
+{
+  METRIC_L1,
+  METRIC_L2,
+  METRIC_HAVERSINE,
+  METRIC_MATRIX
+};
+
+/**
+ * @struct
+ * @brief  A distance metric
+ * @note   A precomputed matrix only describes the points it was built for, so
+ *         distances to arbitrary coordinates (such as a candidate center)
+ *         fall back to euclidean distance under `METRIC_MATRIX`.
+ *
+ * @prop   type        how distance is measured
+ * @prop   unit        for `METRIC_HAVERSINE`, 'm' for kilometers or anything
+ *                     else for miles
+ * @prop   matrix      for `METRIC_MATRIX`, a flattened `size x size` matrix
+ *                     whose entry `(i, j)` is the distance from point `i` to
+ *                     point `j`
+ * @prop   size        for `METRIC_MATRIX`, the number of points in `matrix`
+ */
+struct DistanceMetric
+{
+  const enum MetricType type;
+  const char            unit;
+  const double *        matrix;
+  const uint64_t        size;
+};
+
+struct metric
+{
+  /**
+   * @brief   Calculates the distance between two points under a metric.
+   *
+   * @param   metric    the metric to measure with
+   * @param   vec1      the first point
+   * @param   vec2      the second point
+   * @param   dim       dimension of the points
+   *
+   * @return  the distance between the points
+   */
+  double (*distance)(const struct DistanceMetric * metric,
+                     const double                  vec1[],
+                     const double                  vec2[],
+                     uint64_t                      dim);
+
+  /**
+   * @brief   Calculates the net distance between a central point and a set of
+   *          neighbors under a metric.
+   * @details Dispatches on the metric once, then sums the distances from the
+   *          center to each neighbor in a loop specialized for that metric.
+   *
+   * @param   metric        the metric to measure with
+   * @param   center        the central point
+   * @param   dim           dimension of the points
+   * @param   neighbors     neighbors to evaluate
+   * @param   num_neighbors number of neighbors
+   *
+   * @return  the net distance from the center to each neighbor
+   */
+  double (*net_distance)(const struct DistanceMetric * metric,
+                         const double                  center[],
+                         uint64_t                      dim,
+                         const double *                neighbors[],
+                         uint64_t                      num_neighbors);
+};
+
+extern const struct DistanceMetric METRIC_EUCLIDEAN;
+
+extern const struct metric Metric;
+
+#endif
@@ -0,0 +1,263 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel.h"
+
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+enum MAX_THREADS
+{
+  MAX_THREADS = 64
+};
+
+/**
+ * @struct
+ * @brief  A chunk of an index range handed to a worker thread
+ *
+ * @prop   begin   first index of the chunk
+ * @prop   end     one past the last index of the chunk
+ * @prop   task    work to perform on the chunk
+ * @prop   context   user data passed to the task
+ * @prop   stats     stats of the thread that split the range
+ * @prop   remaining chunks of the range not yet completed, guarded by
+ *                   `POOL_LOCK`
+ */
+struct __chunk
+{
+  uint64_t           begin;
+  uint64_t           end;
+  ParallelTask       task;
+  void *             context;
+  struct StatsSink * stats;
+  uint64_t *         remaining;
+};
+
+/**
+ * Worker threads busy across the whole process. Every copy of the addon, in
+ * every JS worker thread, draws from the same budget, so that fanning work
+ * out in JS does not multiply the threads each call uses.
+ */
+static uint64_t SPAWNED = 0;
+
+/**
+ * The worker pool. Workers are started on first use and then parked on
+ * `POOL_WORK` for the life of the process, so that neither their start-up
+ * nor the scratch pools of `Array.Scratch`, which live as long as their
+ * thread, are paid again on every call. Chunks wait in `QUEUE` for a worker,
+ * and `POOL_DONE` is signalled as each completes.
+ */
+static pthread_mutex_t  POOL_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   POOL_WORK = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   POOL_DONE = PTHREAD_COND_INITIALIZER;
+static struct __chunk * QUEUE[MAX_THREADS];
+static uint64_t         QUEUED  = 0;
+static uint64_t         WORKERS = 0;
+
+/**
+ * @brief   Determines the number of worker threads available.
+ *
+ * @return  the number of online processors, at least 1
+ */
+static uint64_t num_threads(void)
+{
+  const long online = sysconf(_SC_NPROCESSORS_ONLN);
+  if (online < 1) {
+    return 1;
+  }
+  return online > MAX_THREADS ? MAX_THREADS : (uint64_t)online;
+}
+
+/**
+ * @brief   Runs a single chunk, counting into the stats of its range.
+ *
+ * @param   chunk            the chunk to run
+ */
+static void __run_chunk(const struct __chunk * chunk)
+{
+  struct StatsSink * previous = Stats.sink();
+  Stats.redirect(chunk->stats);
+  chunk->task(chunk->begin, chunk->end, chunk->context);
+  Stats.redirect(previous);
+}
+
+/**
+ * @brief   Runs a queued chunk, then marks it completed.
+ * @note    Called and returns with `POOL_LOCK` held.
+ *
+ * @param   chunk            the chunk to run, already taken off the queue
+ */
+static void __complete_chunk(const struct __chunk * chunk)
+{
+  pthread_mutex_unlock(&POOL_LOCK);
+  __run_chunk(chunk);
+  pthread_mutex_lock(&POOL_LOCK);
+  if (!--*chunk->remaining) {
+    pthread_cond_broadcast(&POOL_DONE);
+  }
+}
+
+/**
+ * @brief   Thread entry point of a worker, running queued chunks for the life
+ *          of the process.
+ *
+ * @param   arg              unused
+ *
+ * @return  never returns
+ */
+static void * __work(void * arg)
+{
+  (void)arg;
+  pthread_mutex_lock(&POOL_LOCK);
+  for (;;) {
+    while (!QUEUED) {
+      pthread_cond_wait(&POOL_WORK, &POOL_LOCK);
+    }
+    __complete_chunk(QUEUE[--QUEUED]);
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Starts workers until the pool can run every thread of the budget.
+ * @details A worker that cannot be started is not retried by this call; its
+ *          chunks are run by the thread that queued them instead.
+ * @note    Called with `POOL_LOCK` held.
+ */
+static void __start_workers(void)
+{
+  const uint64_t limit = num_threads() - 1;
+  while (WORKERS < limit) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, __work, NULL)) {
+      return;
+    }
+    pthread_detach(thread);
+    ++WORKERS;
+  }
+}
+
+/**
+ * @brief   Claims worker threads from the budget shared by the process.
+ *
+ * @param   wanted           number of threads wanted
+ *
+ * @return  number of threads granted, to be released with `__release`
+ */
+static uint64_t __reserve(const uint64_t wanted)
+{
+  const uint64_t limit   = num_threads() - 1;
+  uint64_t       busy    = __atomic_load_n(&SPAWNED, __ATOMIC_RELAXED);
+  uint64_t       granted = 0;
+
+  do {
+    const uint64_t idle = busy < limit ? limit - busy : 0;
+    granted             = wanted < idle ? wanted : idle;
+  } while (granted && !__atomic_compare_exchange_n(&SPAWNED,
+                                                   &busy,
+                                                   busy + granted,
+                                                   false,
+                                                   __ATOMIC_RELAXED,
+                                                   __ATOMIC_RELAXED));
+
+  return granted;
+}
+
+/**
+ * @brief   Returns worker threads to the budget shared by the process.
+ *
+ * @param   granted          number of threads granted by `__reserve`
+ */
+static void __release(const uint64_t granted)
+{
+  __atomic_fetch_sub(&SPAWNED, granted, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief   Runs a task over an index range, split across worker threads.
+ * @details Partitions `[begin, end)` into contiguous chunks of at least
+ *          `grain` indeces, the calling thread running the first and
+ *          parked workers of the pool the rest. Ranges too small to be worth
+ *          splitting run on the calling thread, as does all of the range when
+ *          other calls hold every worker thread. While it waits, the calling
+ *          thread runs any of its chunks no worker has taken yet. Returns once
+ *          every chunk has completed.
+ * @note    Tasks must only write to memory owned by their own chunk.
+ *
+ * @param   begin            first index of the range
+ * @param   end              one past the last index of the range
+ * @param   grain            minimum number of indeces per chunk
+ * @param   task             work to perform on each chunk
+ * @param   context          user data passed to each task
+ */
+static void for_range(const uint64_t     begin,
+                      const uint64_t     end,
+                      const uint64_t     grain,
+                      const ParallelTask task,
+                      void *             context)
+{
+  if (end <= begin) {
+    return;
+  }
+
+  const uint64_t len        = end - begin;
+  const uint64_t min_chunk  = grain ? grain : 1;
+  uint64_t       num_chunks = num_threads();
+  if (num_chunks > len / min_chunk) {
+    num_chunks = len / min_chunk;
+  }
+  const uint64_t granted = num_chunks > 1 ? __reserve(num_chunks - 1) : 0;
+  num_chunks             = granted + 1;
+  if (num_chunks <= 1) {
+    task(begin, end, context);
+    return;
+  }
+
+  struct __chunk chunks[MAX_THREADS];
+  const uint64_t per_chunk = len / num_chunks;
+  const uint64_t remainder = len % num_chunks;
+  uint64_t       remaining = num_chunks - 1;
+
+  struct StatsSink * stats = Stats.sink();
+  uint64_t           lo    = begin;
+  for (uint64_t c = 0; c < num_chunks; ++c) {
+    const uint64_t hi = lo + per_chunk + (c < remainder ? 1 : 0);
+    chunks[c] = (struct __chunk){lo, hi, task, context, stats, &remaining};
+    lo        = hi;
+  }
+
+  // the calling thread takes the first chunk; queue the rest for the pool
+  pthread_mutex_lock(&POOL_LOCK);
+  __start_workers();
+  for (uint64_t c = 1; c < num_chunks; ++c) {
+    QUEUE[QUEUED++] = &chunks[c];
+  }
+  pthread_cond_broadcast(&POOL_WORK);
+  pthread_mutex_unlock(&POOL_LOCK);
+
+  __run_chunk(&chunks[0]);
+
+  pthread_mutex_lock(&POOL_LOCK);
+  while (remaining) {
+    // take back a chunk of this range no worker has started
+    uint64_t q = QUEUED;
+    while (q && QUEUE[q - 1]->remaining != &remaining) {
+      --q;
+    }
+    if (q) {
+      const struct __chunk * chunk = QUEUE[q - 1];
+      QUEUE[q - 1]                 = QUEUE[--QUEUED];
+      __complete_chunk(chunk);
+    } else {
+      pthread_cond_wait(&POOL_DONE, &POOL_LOCK);
+    }
+  }
+  pthread_mutex_unlock(&POOL_LOCK);
+  __release(granted);
+}
+
+const struct parallel Parallel = {.num_threads = num_threads,
+                                  .for_range   = for_range};
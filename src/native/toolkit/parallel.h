@@ -0,0 +1,50 @@
+#ifndef TOOLKIT_PARALLEL_H
+#define TOOLKIT_PARALLEL_H
+
+#include <stdint.h>
+
+/**
+ * @brief   A unit of work over the half-open index range `[begin, end)`.
+ *
+ * @param   begin            first index of the range
+ * @param   end              one past the last index of the range
+ * @param   context          user data shared by all ranges
+ */
+typedef void (*ParallelTask)(uint64_t begin, uint64_t end, void * context);
+
+struct parallel
+{
+  /**
+   * @brief   Determines the number of worker threads available.
+   *
+   * @return  the number of online processors, at least 1
+   */
+  uint64_t (*num_threads)(void);
+
+  /**
+   * @brief   Runs a task over an index range, split across worker threads.
+   * @details Partitions `[begin, end)` into contiguous chunks of at least
+   *          `grain` indeces, the calling thread running the first and a
+   *          pool of worker threads, started on first use and kept for the
+   *          life of the process, the rest. Ranges too small to be worth
+   *          splitting run on the calling thread, as does all of the range
+   *          when other calls hold every worker thread. Returns once every
+   *          chunk has completed.
+   * @note    Tasks must only write to memory owned by their own chunk.
+   *
+   * @param   begin            first index of the range
+   * @param   end              one past the last index of the range
+   * @param   grain            minimum number of indeces per chunk
+   * @param   task             work to perform on each chunk
+   * @param   context          user data passed to each task
+   */
+  void (*for_range)(uint64_t     begin,
+                    uint64_t     end,
+                    uint64_t     grain,
+                    ParallelTask task,
+                    void *       context);
+};
+
+extern const struct parallel Parallel;
+
+#endif
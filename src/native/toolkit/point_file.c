@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "point_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Leading bytes of every point file.
+ */
+static const char MAGIC[4] = {'P', 'S', 'E', 'T'};
+
+/**
+ * Version of the format as read from a file written in the other byte order.
+ */
+static const uint32_t SWAPPED_VERSION = (uint32_t)POINT_FILE_VERSION << 24;
+
+/**
+ * @enum
+ * @brief  Flags of a point file
+ *
+ * @prop   FLAG_FLOAT32  values are stored as float32
+ * @prop   FLAG_WEIGHTS  every point has a weight
+ */
+enum PointFileFlag
+{
+  FLAG_FLOAT32 = 1,
+  FLAG_WEIGHTS = 2
+};
+
+/**
+ * @struct
+ * @brief  The header of a point file, as laid out on disk, in the byte order
+ *         of the host that wrote it
+ *
+ * @prop   magic      "PSET"
+ * @prop   version    version of the format
+ * @prop   flags      `PointFileFlag`s
+ * @prop   reserved   0
+ * @prop   num_points number of points
+ * @prop   reserved2  0
+ */
+struct __header
+{
+  char     magic[4];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t num_points;
+  uint64_t reserved2;
+};
+
+/**
+ * @brief   Writes a set of 2D points to a point file.
+ *
+ * @param   path             file to write
+ * @param   points           points to write
+ * @param   num_points       number of points
+ * @param   weights          weight of each point, or NULL for none
+ * @param   float32          whether to store values as float32, or else
+ *                           float64
+ *
+ * @return  whether the file was written; if not, `errno` tells why
+ */
+static bool write_(const char *   path,
+                   const double   points[][2],
+                   const uint64_t num_points,
+                   const double   weights[],
+                   const bool     float32)
+{
+  FILE * file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  const struct __header header = {
+      {MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]},
+      POINT_FILE_VERSION,
+      (float32 ? FLAG_FLOAT32 : 0) | (weights ? FLAG_WEIGHTS : 0),
+      0,
+      num_points,
+      0};
+  bool ok = fwrite(&header, sizeof header, 1, file) == 1;
+
+  if (!float32) {
+    ok = ok && fwrite(points, sizeof(double[2]), num_points, file) ==
+                   num_points;
+    ok = ok && (!weights || fwrite(weights, sizeof(double), num_points, file) ==
+                                num_points);
+  } else {
+    for (uint64_t i = 0; ok && i < num_points; ++i) {
+      const float point[2] = {(float)points[i][0], (float)points[i][1]};
+      ok                   = fwrite(point, sizeof point, 1, file) == 1;
+    }
+    for (uint64_t i = 0; ok && weights && i < num_points; ++i) {
+      const float weight = (float)weights[i];
+      ok                 = fwrite(&weight, sizeof weight, 1, file) == 1;
+    }
+  }
+
+  return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief   Maps a point file into memory, read-only and shared with every other
+ *          process mapping it.
+ *
+ * @param   path             file to map
+ *
+ * @return  the mapping, to be closed with `close`, or NULL if the file cannot
+ *          be read, is not a point file, or was written in the other byte
+ *          order; `errno` tells why
+ */
+static struct MappedPoints * open_(const char * path)
+{
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info)) {
+    const int error = errno;
+    close(fd);
+    errno = error;
+    return NULL;
+  }
+  if ((uint64_t)info.st_size < sizeof(struct __header)) {
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  const uint64_t length = (uint64_t)info.st_size;
+  void *         base   = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  const int      error  = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    errno = error;
+    return NULL;
+  }
+
+  // values are read in place, so they cannot be swapped into this byte order
+  const struct __header * header = base;
+  if (!memcmp(header->magic, MAGIC, sizeof MAGIC) &&
+      header->version == SWAPPED_VERSION) {
+    munmap(base, length);
+    errno = ENOEXEC;
+    return NULL;
+  }
+
+  // validate the header, and that the file holds every value it promises
+  const uint64_t          width  = header->flags & FLAG_FLOAT32
+                                       ? sizeof(float)
+                                       : sizeof(double);
+  const uint64_t          values = header->flags & FLAG_WEIGHTS ? 3 : 2;
+  if (memcmp(header->magic, MAGIC, sizeof MAGIC) ||
+      header->version != POINT_FILE_VERSION ||
+      header->num_points > (length - sizeof *header) / (values * width)) {
+    munmap(base, length);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  struct MappedPoints * file = malloc(sizeof *file);
+  const char *          data = (const char *)(header + 1);
+  file->num_points           = header->num_points;
+  file->float32              = header->flags & FLAG_FLOAT32;
+  file->coords               = data;
+  file->weights              = header->flags & FLAG_WEIGHTS
+                                   ? data + 2 * width * header->num_points
+                                   : NULL;
+  file->base                 = base;
+  file->length               = length;
+
+  return file;
+}
+
+/**
+ * @brief   Unmaps a point file.
+ *
+ * @param   file             mapping to close, or NULL
+ */
+static void close_(struct MappedPoints * file)
+{
+  if (!file) {
+    return;
+  }
+  munmap(file->base, file->length);
+  free(file);
+}
+
+/**
+ * @brief   Decodes a range of points of a mapped file into doubles.
+ *
+ * @param   file             the mapping
+ * @param   first            first point to decode
+ * @param   count            number of points to decode
+ * @param   points           filled with the points
+ */
+static void read_(const struct MappedPoints * file,
+                  const uint64_t              first,
+                  const uint64_t              count,
+                  double                      points[][2])
+{
+  if (!file->float32) {
+    memcpy(points,
+           (const double(*)[2])file->coords + first,
+           count * sizeof(double[2]));
+    return;
+  }
+
+  const float(*coords)[2] = (const float(*)[2])file->coords + first;
+  for (uint64_t i = 0; i < count; ++i) {
+    points[i][0] = coords[i][0];
+    points[i][1] = coords[i][1];
+  }
+}
+
+/**
+ * @brief   Decodes the weight of a point of a mapped file.
+ *
+ * @param   file             the mapping
+ * @param   i                the point
+ *
+ * @return  weight of the point, or 1 if the file has no weights
+ */
+static double weight(const struct MappedPoints * file, const uint64_t i)
+{
+  if (!file->weights) {
+    return 1;
+  }
+  return file->float32 ? ((const float *)file->weights)[i]
+                       : ((const double *)file->weights)[i];
+}
+
+const struct point_file PointFile = {.write  = write_,
+                                     .open   = open_,
+                                     .close  = close_,
+                                     .read   = read_,
+                                     .weight = weight};
@@ -0,0 +1,115 @@
+#ifndef TOOLKIT_POINT_FILE_H
+#define TOOLKIT_POINT_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @enum
+ * @brief  Version of the point file format written
+ */
+enum POINT_FILE_VERSION
+{
+  POINT_FILE_VERSION = 1
+};
+
+/**
+ * @struct
+ * @brief  A point file mapped into memory
+ * @details A point file is a 32-byte header,
+ *            magic       "PSET"
+ *            version     uint32
+ *            flags       uint32; 1 for float32 values, 2 for weights
+ *            reserved    uint32
+ *            num_points  uint64
+ *            reserved    uint64,
+ *          followed by the interleaved `x, y` coordinates of every point, and
+ *          then the weight of every point if it has weights, all as float64
+ *          or all as float32. Every field and value is in the byte order of
+ *          the host that wrote the file, so that float64 coordinates can be
+ *          read in place; files written on a host of the other byte order
+ *          are rejected.
+ *
+ * @prop   num_points  number of points
+ * @prop   float32     whether values are stored as float32, or else float64
+ * @prop   coords      interleaved coordinates of the points
+ * @prop   weights     weight of each point, or NULL
+ * @prop   base        start of the mapping
+ * @prop   length      bytes mapped
+ */
+struct MappedPoints
+{
+  uint64_t     num_points;
+  bool         float32;
+  const void * coords;
+  const void * weights;
+  void *       base;
+  uint64_t     length;
+};
+
+struct point_file
+{
+  /**
+   * @brief   Writes a set of 2D points to a point file.
+   *
+   * @param   path             file to write
+   * @param   points           points to write
+   * @param   num_points       number of points
+   * @param   weights          weight of each point, or NULL for none
+   * @param   float32          whether to store values as float32, or else
+   *                           float64
+   *
+   * @return  whether the file was written; if not, `errno` tells why
+   */
+  bool (*write)(const char * path,
+                const double points[][2],
+                uint64_t     num_points,
+                const double weights[],
+                bool         float32);
+
+  /**
+   * @brief   Maps a point file into memory, read-only and shared with every
+   *          other process mapping it.
+   *
+   * @param   path             file to map
+   *
+   * @return  the mapping, to be closed with `close`, or NULL if the file
+   *          cannot be read, is not a point file, or was written in the other
+   *          byte order; `errno` tells why
+   */
+  struct MappedPoints * (*open)(const char * path);
+
+  /**
+   * @brief   Unmaps a point file.
+   *
+   * @param   file             mapping to close, or NULL
+   */
+  void (*close)(struct MappedPoints * file);
+
+  /**
+   * @brief   Decodes a range of points of a mapped file into doubles.
+   *
+   * @param   file             the mapping
+   * @param   first            first point to decode
+   * @param   count            number of points to decode
+   * @param   points           filled with the points
+   */
+  void (*read)(const struct MappedPoints * file,
+               uint64_t                    first,
+               uint64_t                    count,
+               double                      points[][2]);
+
+  /**
+   * @brief   Decodes the weight of a point of a mapped file.
+   *
+   * @param   file             the mapping
+   * @param   i                the point
+   *
+   * @return  weight of the point, or 1 if the file has no weights
+   */
+  double (*weight)(const struct MappedPoints * file, uint64_t i);
+};
+
+extern const struct point_file PointFile;
+
+#endif
@@ -0,0 +1,857 @@
+#include "spatial_index.h"
+
+#include "array.h"
+#include "hilbert.h"
+#include "kernel.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Marks a missing child, and a removed point.
+ */
+static const uint64_t NONE = UINT64_MAX;
+
+/**
+ * Depth, beyond twice the depth of a balanced tree, that an insertion may
+ * reach before the subtree it unbalanced is rebuilt.
+ */
+static const uint64_t DEPTH_SLACK = 8;
+
+/**
+ * @struct
+ * @brief  A k-d tree over a changing set of 2D points, identified by their
+ *         position in the set
+ * @details Every slot holds one point and is one node of the tree. Removed
+ *          points stay in the tree, marked, until it is rebuilt.
+ *
+ * @prop   type      how distance between points is measured
+ * @prop   unit      unit of haversine distances
+ * @prop   dim       dimension of the indexed vectors
+ * @prop   capacity  slots allocated
+ * @prop   num_slots slots used
+ * @prop   num_live  points in the set
+ * @prop   points    point held by each slot
+ * @prop   coords    vector indexed for each slot
+ * @prop   ids       position in the set of the point in each slot, or NONE
+ * @prop   left      lesser child of each slot
+ * @prop   right     greater or equal child of each slot
+ * @prop   axis      splitting axis of each slot
+ * @prop   slot_of   slot holding each position in the set
+ * @prop   root      root slot
+ */
+struct SpatialTree
+{
+  enum MetricType type;
+  char            unit;
+  uint64_t        dim;
+  uint64_t        capacity;
+  uint64_t        num_slots;
+  uint64_t        num_live;
+  double *        points;
+  double *        coords;
+  uint64_t *      ids;
+  uint64_t *      left;
+  uint64_t *      right;
+  unsigned char * axis;
+  uint64_t *      slot_of;
+  uint64_t        root;
+};
+
+/**
+ * @brief   Maps a point to the vector indexed for it.
+ *
+ * @param   T                the index
+ * @param   point            point to map
+ * @param   coords           filled with the vector
+ */
+static void __to_coords(const struct SpatialTree * T,
+                        const double               point[2],
+                        double                     coords[])
+{
+  if (T->type != METRIC_HAVERSINE) {
+    coords[0] = point[0];
+    coords[1] = point[1];
+    return;
+  }
+
+  const double lat = point[0] / 180 * KERNEL_PI;
+  const double lng = point[1] / 180 * KERNEL_PI;
+  coords[0]        = cos(lat) * cos(lng);
+  coords[1]        = cos(lat) * sin(lng);
+  coords[2]        = sin(lat);
+}
+
+/**
+ * @brief   Measures between indexed vectors.
+ * @details Ranks points as the metric of the index does.
+ *
+ * @param   T                the index
+ * @param   a                the first vector
+ * @param   b                the second vector
+ *
+ * @return  distance between the vectors
+ */
+static double __tree_distance(const struct SpatialTree * T,
+                              const double               a[],
+                              const double               b[])
+{
+  return T->type == METRIC_L1 ? kernel_l1_distance(a, b, T->dim)
+                              : kernel_l2_distance(a, b, T->dim);
+}
+
+/**
+ * @brief   Measures between points under the metric of the index.
+ *
+ * @param   T                the index
+ * @param   a                the first point
+ * @param   b                the second point
+ *
+ * @return  distance between the points
+ */
+static double __point_distance(const struct SpatialTree * T,
+                               const double               a[2],
+                               const double               b[2])
+{
+  switch (T->type) {
+    case METRIC_L1:
+      return kernel_l1_distance_2d(a, b);
+    case METRIC_HAVERSINE:
+      return kernel_haversine_distance(a, b, T->unit);
+
+    default:
+      return kernel_l2_distance_2d(a, b);
+  }
+}
+
+/**
+ * @brief   Makes room for another slot.
+ *
+ * @param   T                the index
+ */
+static void __reserve(struct SpatialTree * T)
+{
+  if (T->num_slots < T->capacity) {
+    return;
+  }
+
+  const uint64_t cap = T->capacity ? 2 * T->capacity : 16;
+  T->points          = realloc(T->points, cap * 2 * sizeof(double));
+  T->coords          = realloc(T->coords, cap * T->dim * sizeof(double));
+  T->ids             = realloc(T->ids, cap * sizeof(uint64_t));
+  T->left            = realloc(T->left, cap * sizeof(uint64_t));
+  T->right           = realloc(T->right, cap * sizeof(uint64_t));
+  T->axis            = realloc(T->axis, cap);
+  T->slot_of         = realloc(T->slot_of, cap * sizeof(uint64_t));
+  T->capacity        = cap;
+}
+
+/**
+ * @brief   Fills a new slot with a point, outside of the tree.
+ *
+ * @param   T                the index
+ * @param   id               position of the point in the set
+ * @param   point            the point
+ *
+ * @return  the slot
+ */
+static uint64_t __new_slot(struct SpatialTree * T,
+                           const uint64_t       id,
+                           const double         point[2])
+{
+  __reserve(T);
+
+  const uint64_t slot = T->num_slots++;
+  T->points[2 * slot]     = point[0];
+  T->points[2 * slot + 1] = point[1];
+  __to_coords(T, point, T->coords + slot * T->dim);
+  T->ids[slot]   = id;
+  T->left[slot]  = NONE;
+  T->right[slot] = NONE;
+  T->axis[slot]  = 0;
+  T->slot_of[id] = slot;
+  return slot;
+}
+
+/**
+ * @brief   Partially sorts slots so that the median along an axis lands in the
+ *          middle, with lesser vectors before it and greater ones after it.
+ *
+ * @param   T                the index
+ * @param   slots            slots to partition
+ * @param   n                number of slots
+ * @param   axis             axis to compare along
+ */
+static void __select_median(const struct SpatialTree * T,
+                            uint64_t                   slots[],
+                            const uint64_t             n,
+                            const uint64_t             axis)
+{
+  const int64_t mid = (int64_t)n / 2;
+  int64_t       lo  = 0;
+  int64_t       hi  = (int64_t)n - 1;
+
+  while (lo < hi) {
+    const double pivot = T->coords[slots[(lo + hi) / 2] * T->dim + axis];
+    int64_t      i     = lo;
+    int64_t      j     = hi;
+    while (i <= j) {
+      while (T->coords[slots[i] * T->dim + axis] < pivot) {
+        ++i;
+      }
+      while (T->coords[slots[j] * T->dim + axis] > pivot) {
+        --j;
+      }
+      if (i <= j) {
+        const uint64_t tmp = slots[i];
+        slots[i++]         = slots[j];
+        slots[j--]         = tmp;
+      }
+    }
+
+    // between j and i lie only copies of the pivot
+    if (mid <= j) {
+      hi = j;
+    } else if (mid >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Builds a balanced subtree over a set of slots.
+ *
+ * @param   T                the index
+ * @param   slots            slots to build over
+ * @param   n                number of slots
+ * @param   depth            depth of the subtree
+ *
+ * @return  root slot of the subtree
+ */
+static uint64_t __build(struct SpatialTree * T,
+                        uint64_t             slots[],
+                        const uint64_t       n,
+                        const uint64_t       depth)
+{
+  if (!n) {
+    return NONE;
+  }
+
+  const uint64_t axis = depth % T->dim;
+  const uint64_t mid  = n / 2;
+  __select_median(T, slots, n, axis);
+
+  const uint64_t node = slots[mid];
+  T->axis[node]       = (unsigned char)axis;
+  T->left[node]       = __build(T, slots, mid, depth + 1);
+  T->right[node]      = __build(T, slots + mid + 1, n - mid - 1, depth + 1);
+  return node;
+}
+
+/**
+ * @brief   Rebuilds the tree over the points in the set, dropping removed
+ *          points and restoring balance.
+ * @details Live points are compacted into the first slots in their order
+ *          along a Hilbert curve, so that points near each other on the plane,
+ *          which searches visit together, sit near each other in memory.
+ *
+ * @param   T                the index
+ */
+static void __rebuild(struct SpatialTree * T)
+{
+  const uint64_t n      = T->num_live;
+  double *       points = Array.Scratch.double_array(2 * n);
+  double *       coords = Array.Scratch.double_array(n * T->dim);
+  uint64_t *     slots  = Array.Scratch.uint64_t_array(n);
+  for (uint64_t id = 0; id < n; ++id) {
+    const uint64_t from = T->slot_of[id];
+    points[2 * id]      = T->points[2 * from];
+    points[2 * id + 1]  = T->points[2 * from + 1];
+    memcpy(coords + id * T->dim,
+           T->coords + from * T->dim,
+           T->dim * sizeof(double));
+  }
+  Hilbert.order(points, n, 2, slots);
+
+  for (uint64_t slot = 0; slot < n; ++slot) {
+    const uint64_t id       = slots[slot];
+    T->points[2 * slot]     = points[2 * id];
+    T->points[2 * slot + 1] = points[2 * id + 1];
+    memcpy(T->coords + slot * T->dim,
+           coords + id * T->dim,
+           T->dim * sizeof(double));
+    T->ids[slot]   = id;
+    T->slot_of[id] = slot;
+    slots[slot]    = slot;
+  }
+  T->num_slots = n;
+
+  T->root = __build(T, slots, n, 0);
+
+  Array.release(points);
+  Array.release(coords);
+  Array.release(slots);
+}
+
+/**
+ * @brief   Finds the base 2 logarithm of a number, rounded down.
+ *
+ * @param   n                the number, at least 1
+ *
+ * @return  the logarithm
+ */
+static uint64_t __floor_log2(uint64_t n)
+{
+  uint64_t log = 0;
+  while (n >>= 1) {
+    ++log;
+  }
+  return log;
+}
+
+/**
+ * @brief   Collects the slots of a subtree.
+ *
+ * @param   T                the index
+ * @param   node             root of the subtree
+ * @param   slots            filled with the slots, if not NULL
+ *
+ * @return  number of slots in the subtree
+ */
+static uint64_t __collect(const struct SpatialTree * T,
+                          const uint64_t             node,
+                          uint64_t                   slots[])
+{
+  if (node == NONE) {
+    return 0;
+  }
+  const uint64_t left = __collect(T, T->left[node], slots);
+  if (slots) {
+    slots[left] = node;
+  }
+  return left + 1 +
+         __collect(T, T->right[node], slots ? slots + left + 1 : NULL);
+}
+
+/**
+ * @brief   Links a filled slot into the tree as a leaf.
+ * @details A leaf deeper than twice the depth of a balanced tree (plus some
+ *          slack) unbalanced the tree. As in a scapegoat tree, the lowest
+ *          subtree on its path that is too deep for its size is then rebuilt
+ *          balanced, which keeps insertion logarithmic when amortized, even
+ *          for sorted points.
+ *
+ * @param   T                the index
+ * @param   slot             the slot
+ */
+static void __link(struct SpatialTree * T, const uint64_t slot)
+{
+  if (T->root == NONE) {
+    T->root = slot;
+    return;
+  }
+
+  const uint64_t limit = 2 * __floor_log2(T->num_slots) + DEPTH_SLACK;
+  const double * c     = T->coords + slot * T->dim;
+  uint64_t       path[limit + 1];
+  uint64_t       depth = 0;
+  for (uint64_t node = T->root;; ++depth) {
+    if (depth > limit) {  // unbalanced beyond repair; start over
+      __rebuild(T);
+      return;
+    }
+    path[depth] = node;
+
+    const uint64_t axis  = T->axis[node];
+    uint64_t *     child = c[axis] < T->coords[node * T->dim + axis]
+                           ? &T->left[node]
+                           : &T->right[node];
+    if (*child == NONE) {
+      *child        = slot;
+      T->axis[slot] = (unsigned char)((axis + 1) % T->dim);
+      break;
+    }
+    node = *child;
+  }
+  if (depth < limit) {
+    return;
+  }
+
+  // find the scapegoat, walking up from the leaf
+  uint64_t size  = 1;
+  uint64_t child = slot;
+  for (uint64_t i = depth + 1; i-- > 0;) {
+    const uint64_t node    = path[i];
+    const uint64_t sibling = T->left[node] == child ? T->right[node]
+                                                    : T->left[node];
+    size += 1 + __collect(T, sibling, NULL);
+    child = node;
+    if (depth + 1 - i <= 2 * __floor_log2(size) + 1) {
+      continue;
+    }
+
+    uint64_t * slots = malloc(size * sizeof(uint64_t));
+    __collect(T, node, slots);
+    const uint64_t rebuilt = __build(T, slots, size, i);
+    free(slots);
+
+    if (!i) {
+      T->root = rebuilt;
+    } else if (T->left[path[i - 1]] == node) {
+      T->left[path[i - 1]] = rebuilt;
+    } else {
+      T->right[path[i - 1]] = rebuilt;
+    }
+    return;
+  }
+}
+
+/**
+ * @brief   Builds a balanced index over a set of 2D points.
+ * @details Points are identified by their position in the set. Planar metrics
+ *          index the points as given, while haversine indexes
+ *          `[latitude, longitude]` degrees as vectors on the unit sphere,
+ *          where straight-line distance orders points as the great-circle
+ *          distance does. A custom matrix metric falls back to euclidean.
+ *
+ * @param   metric           how distance between points is measured
+ * @param   points           points to index
+ * @param   num_points       number of points
+ *
+ * @return  the index, to be freed with `free`
+ */
+static struct SpatialTree * New(const struct DistanceMetric * metric,
+                                const double                  points[][2],
+                                const uint64_t                num_points)
+{
+  struct SpatialTree * T = calloc(1, sizeof *T);
+  T->type = metric->type == METRIC_L1 || metric->type == METRIC_HAVERSINE
+                ? metric->type
+                : METRIC_L2;
+  T->unit = metric->unit;
+  T->dim  = T->type == METRIC_HAVERSINE ? 3 : 2;
+  T->root = NONE;
+
+  for (uint64_t i = 0; i < num_points; ++i) {
+    __new_slot(T, i, points[i]);
+  }
+  T->num_live = num_points;
+  __rebuild(T);
+
+  return T;
+}
+
+/**
+ * @brief   Frees the memory held by an index.
+ *
+ * @param   tree             index to free
+ */
+static void __free(struct SpatialTree * tree)
+{
+  if (!tree) {
+    return;
+  }
+  free(tree->points);
+  free(tree->coords);
+  free(tree->ids);
+  free(tree->left);
+  free(tree->right);
+  free(tree->axis);
+  free(tree->slot_of);
+  free(tree);
+}
+
+/**
+ * @brief   Determines the number of points in an index.
+ *
+ * @param   tree             index to measure
+ *
+ * @return  number of points
+ */
+static uint64_t size(const struct SpatialTree * tree)
+{
+  return tree->num_live;
+}
+
+/**
+ * @brief   Adds a point to the end of the set.
+ *
+ * @param   tree             index to add to
+ * @param   point            point to add
+ */
+static void insert(struct SpatialTree * tree, const double point[2])
+{
+  const uint64_t slot = __new_slot(tree, tree->num_live++, point);
+  __link(tree, slot);
+}
+
+/**
+ * @brief   Removes a point from the set; the points after it move up one
+ *          position.
+ *
+ * @param   tree             index to remove from
+ * @param   id               position of the point
+ */
+static void __remove(struct SpatialTree * tree, const uint64_t id)
+{
+  if (id >= tree->num_live) {
+    return;
+  }
+
+  tree->ids[tree->slot_of[id]] = NONE;
+  memmove(tree->slot_of + id,
+          tree->slot_of + id + 1,
+          (tree->num_live - id - 1) * sizeof(uint64_t));
+  --tree->num_live;
+  for (uint64_t slot = 0; slot < tree->num_slots; ++slot) {
+    if (tree->ids[slot] != NONE && tree->ids[slot] > id) {
+      --tree->ids[slot];
+    }
+  }
+
+  // rebuild once removed points outnumber the set
+  if (tree->num_slots - tree->num_live > tree->num_live) {
+    __rebuild(tree);
+  }
+}
+
+/**
+ * @brief   Replaces a point, keeping its position in the set.
+ *
+ * @param   tree             index to update
+ * @param   id               position of the point
+ * @param   point            value to move it to
+ */
+static void move(struct SpatialTree * tree,
+                 const uint64_t       id,
+                 const double         point[2])
+{
+  if (id >= tree->num_live) {
+    return;
+  }
+
+  tree->ids[tree->slot_of[id]] = NONE;
+  __link(tree, __new_slot(tree, id, point));
+
+  if (tree->num_slots - tree->num_live > tree->num_live) {
+    __rebuild(tree);
+  }
+}
+
+/**
+ * @struct
+ * @brief  The best points found so far by a nearest-neighbour search, as a
+ *         max-heap on distance
+ *
+ * @prop   k         number of points to find
+ * @prop   size      number of points found
+ * @prop   slots     slot of each point found
+ * @prop   distances distance to each point found
+ */
+struct __heap
+{
+  uint64_t   k;
+  uint64_t   size;
+  uint64_t * slots;
+  double *   distances;
+};
+
+/**
+ * @brief   Swaps two entries of a heap.
+ *
+ * @param   H                the heap
+ * @param   a                the first entry
+ * @param   b                the second entry
+ */
+static void __heap_swap(struct __heap * H, const uint64_t a, const uint64_t b)
+{
+  const uint64_t slot = H->slots[a];
+  const double   dist = H->distances[a];
+  H->slots[a]         = H->slots[b];
+  H->distances[a]     = H->distances[b];
+  H->slots[b]         = slot;
+  H->distances[b]     = dist;
+}
+
+/**
+ * @brief   Restores the heap order below an entry.
+ *
+ * @param   H                the heap
+ * @param   i                the entry
+ */
+static void __heap_sift_down(struct __heap * H, uint64_t i)
+{
+  for (;;) {
+    const uint64_t l       = 2 * i + 1;
+    const uint64_t r       = l + 1;
+    uint64_t       largest = i;
+    if (l < H->size && H->distances[l] > H->distances[largest]) {
+      largest = l;
+    }
+    if (r < H->size && H->distances[r] > H->distances[largest]) {
+      largest = r;
+    }
+    if (largest == i) {
+      return;
+    }
+    __heap_swap(H, i, largest);
+    i = largest;
+  }
+}
+
+/**
+ * @brief   Offers a point to the heap, keeping the `k` nearest.
+ *
+ * @param   H                the heap
+ * @param   slot             slot of the point
+ * @param   dist             distance to the point
+ */
+static void __heap_offer(struct __heap * H,
+                         const uint64_t  slot,
+                         const double    dist)
+{
+  if (H->size < H->k) {
+    uint64_t i = H->size++;
+    H->slots[i]     = slot;
+    H->distances[i] = dist;
+    while (i && H->distances[(i - 1) / 2] < H->distances[i]) {
+      __heap_swap(H, i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  } else if (dist < H->distances[0]) {
+    H->slots[0]     = slot;
+    H->distances[0] = dist;
+    __heap_sift_down(H, 0);
+  }
+}
+
+/**
+ * @brief   Searches a subtree for the points nearest a query vector.
+ *
+ * @param   T                the index
+ * @param   node             root of the subtree
+ * @param   q                the query vector
+ * @param   H                the nearest points found so far
+ */
+static void __nearest(const struct SpatialTree * T,
+                      const uint64_t             node,
+                      const double               q[],
+                      struct __heap *            H)
+{
+  if (node == NONE) {
+    return;
+  }
+
+  const double * c = T->coords + node * T->dim;
+  if (T->ids[node] != NONE) {
+    __heap_offer(H, node, __tree_distance(T, q, c));
+  }
+
+  // the splitting plane bounds the distance to anything beyond it
+  const double diff = q[T->axis[node]] - c[T->axis[node]];
+  __nearest(T, diff < 0 ? T->left[node] : T->right[node], q, H);
+  if (H->size < H->k || fabs(diff) < H->distances[0]) {
+    __nearest(T, diff < 0 ? T->right[node] : T->left[node], q, H);
+  }
+}
+
+/**
+ * @brief   Finds the points nearest to a query point.
+ *
+ * @param   tree             index to search
+ * @param   point            query point
+ * @param   k                number of points to find
+ * @param   ids              filled with the positions of the nearest points,
+ *                           nearest first; room for `k` is needed
+ * @param   distances        filled with the distance to each point found
+ *
+ * @return  number of points found; fewer than `k` for small sets
+ */
+static uint64_t nearest(const struct SpatialTree * tree,
+                        const double               point[2],
+                        const uint64_t             k,
+                        uint64_t                   ids[],
+                        double                     distances[])
+{
+  const uint64_t want = k < tree->num_live ? k : tree->num_live;
+  double         q[3];
+  struct __heap  H = {want, 0, malloc((want ? want : 1) * sizeof(uint64_t)),
+                     distances};
+  __to_coords(tree, point, q);
+  __nearest(tree, tree->root, q, &H);
+
+  // pop the farthest to the back until the heap is in ascending order
+  const uint64_t found = H.size;
+  while (H.size > 1) {
+    __heap_swap(&H, 0, --H.size);
+    __heap_sift_down(&H, 0);
+  }
+
+  for (uint64_t i = 0; i < found; ++i) {
+    ids[i]       = tree->ids[H.slots[i]];
+    distances[i] = __point_distance(tree, point, tree->points + 2 * H.slots[i]);
+  }
+
+  free(H.slots);
+  return found;
+}
+
+/**
+ * @struct
+ * @brief  The points found by a radius search
+ *
+ * @prop   radius    largest distance, between indexed vectors, to include
+ * @prop   size      number of points found
+ * @prop   capacity  room for points found
+ * @prop   slots     slot of each point found
+ */
+struct __range
+{
+  double     radius;
+  uint64_t   size;
+  uint64_t   capacity;
+  uint64_t * slots;
+};
+
+/**
+ * @brief   Searches a subtree for the points within a radius of a query
+ *          vector.
+ *
+ * @param   T                the index
+ * @param   node             root of the subtree
+ * @param   q                the query vector
+ * @param   R                the points found so far
+ */
+static void __within(const struct SpatialTree * T,
+                     const uint64_t             node,
+                     const double               q[],
+                     struct __range *           R)
+{
+  if (node == NONE) {
+    return;
+  }
+
+  const double * c = T->coords + node * T->dim;
+  if (T->ids[node] != NONE && __tree_distance(T, q, c) <= R->radius) {
+    if (R->size == R->capacity) {
+      R->capacity = R->capacity ? 2 * R->capacity : 16;
+      R->slots    = realloc(R->slots, R->capacity * sizeof(uint64_t));
+    }
+    R->slots[R->size++] = node;
+  }
+
+  const double diff = q[T->axis[node]] - c[T->axis[node]];
+  __within(T, diff < 0 ? T->left[node] : T->right[node], q, R);
+  if (fabs(diff) <= R->radius) {
+    __within(T, diff < 0 ? T->right[node] : T->left[node], q, R);
+  }
+}
+
+/**
+ * @struct
+ * @brief  A point found by a radius search, for sorting by distance
+ *
+ * @prop   id        position of the point in the set
+ * @prop   distance  distance to the point
+ */
+struct __hit
+{
+  uint64_t id;
+  double   distance;
+};
+
+/**
+ * @brief   Orders hits by ascending distance, then position.
+ *
+ * @param   a                the first hit
+ * @param   b                the second hit
+ *
+ * @return  negative, zero, or positive as `a` sorts before, with, or after `b`
+ */
+static int __compare_hits(const void * a, const void * b)
+{
+  const struct __hit * x = a;
+  const struct __hit * y = b;
+  if (x->distance < y->distance) {
+    return -1;
+  }
+  if (x->distance > y->distance) {
+    return 1;
+  }
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * @brief   Finds the points within a distance of a query point.
+ * @details Haversine radii are searched as the matching chord of the unit
+ *          sphere, widened slightly against rounding, and the points found
+ *          are then checked against the exact distance.
+ *
+ * @param   tree             index to search
+ * @param   point            query point
+ * @param   radius           largest distance to include
+ * @param   ids              set to a new array of the positions of the points
+ *                           found, nearest first, to be `free`d
+ * @param   distances        set to a new array of the distance to each point
+ *                           found, to be `free`d
+ *
+ * @return  number of points found
+ */
+static uint64_t within(const struct SpatialTree * tree,
+                       const double               point[2],
+                       const double               radius,
+                       uint64_t **                ids,
+                       double **                  distances)
+{
+  double         q[3];
+  struct __range R = {radius, 0, 0, NULL};
+  __to_coords(tree, point, q);
+
+  if (tree->type == METRIC_HAVERSINE) {
+    // the earth's radius, in the unit of the metric
+    const double earth =
+        KERNEL_EARTH_RADIUS_METERS * kernel_meters_to(tree->unit);
+    const double angle = radius / earth;
+
+    R.radius = angle >= KERNEL_PI ? 2 : 2 * sin(angle / 2) * (1 + 1e-9) + 1e-12;
+  }
+  if (radius >= 0) {
+    __within(tree, tree->root, q, &R);
+  }
+
+  struct __hit * hits  = malloc((R.size ? R.size : 1) * sizeof *hits);
+  uint64_t       found = 0;
+  for (uint64_t i = 0; i < R.size; ++i) {
+    const uint64_t slot = R.slots[i];
+    const double   dist =
+        __point_distance(tree, point, tree->points + 2 * slot);
+    if (dist <= radius) {
+      hits[found++] = (struct __hit){tree->ids[slot], dist};
+    }
+  }
+  qsort(hits, found, sizeof *hits, __compare_hits);
+
+  *ids       = malloc((found ? found : 1) * sizeof(uint64_t));
+  *distances = malloc((found ? found : 1) * sizeof(double));
+  for (uint64_t i = 0; i < found; ++i) {
+    (*ids)[i]       = hits[i].id;
+    (*distances)[i] = hits[i].distance;
+  }
+
+  free(hits);
+  free(R.slots);
+  return found;
+}
+
+const struct spatial_index SpatialIndex = {.New     = New,
+                                           .free    = __free,
+                                           .size    = size,
+                                           .insert  = insert,
+                                           .remove  = __remove,
+                                           .move    = move,
+                                           .nearest = nearest,
+                                           .within  = within};
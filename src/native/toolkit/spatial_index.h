@@ -0,0 +1,117 @@
+#ifndef TOOLKIT_SPATIAL_INDEX_H
+#define TOOLKIT_SPATIAL_INDEX_H
+
+#include "metric.h"
+
+#include <stdint.h>
+
+/**
+ * @struct
+ * @brief  A k-d tree over a changing set of 2D points, identified by their
+ *         position in the set
+ */
+struct SpatialTree;
+
+struct spatial_index
+{
+  /**
+   * @brief   Builds a balanced index over a set of 2D points.
+   * @details Points are identified by their position in the set. Planar
+   *          metrics index the points as given, while haversine indexes
+   *          `[latitude, longitude]` degrees as vectors on the unit sphere,
+   *          where straight-line distance orders points as the great-circle
+   *          distance does. A custom matrix metric falls back to euclidean.
+   *
+   * @param   metric           how distance between points is measured
+   * @param   points           points to index
+   * @param   num_points       number of points
+   *
+   * @return  the index, to be freed with `free`
+   */
+  struct SpatialTree * (*New)(const struct DistanceMetric * metric,
+                              const double                  points[][2],
+                              uint64_t                      num_points);
+
+  /**
+   * @brief   Frees the memory held by an index.
+   *
+   * @param   tree             index to free
+   */
+  void (*free)(struct SpatialTree * tree);
+
+  /**
+   * @brief   Determines the number of points in an index.
+   *
+   * @param   tree             index to measure
+   *
+   * @return  number of points
+   */
+  uint64_t (*size)(const struct SpatialTree * tree);
+
+  /**
+   * @brief   Adds a point to the end of the set.
+   *
+   * @param   tree             index to add to
+   * @param   point            point to add
+   */
+  void (*insert)(struct SpatialTree * tree, const double point[2]);
+
+  /**
+   * @brief   Removes a point from the set; the points after it move up one
+   *          position.
+   *
+   * @param   tree             index to remove from
+   * @param   id               position of the point
+   */
+  void (*remove)(struct SpatialTree * tree, uint64_t id);
+
+  /**
+   * @brief   Replaces a point, keeping its position in the set.
+   *
+   * @param   tree             index to update
+   * @param   id               position of the point
+   * @param   point            value to move it to
+   */
+  void (*move)(struct SpatialTree * tree, uint64_t id, const double point[2]);
+
+  /**
+   * @brief   Finds the points nearest to a query point.
+   *
+   * @param   tree             index to search
+   * @param   point            query point
+   * @param   k                number of points to find
+   * @param   ids              filled with the positions of the nearest points,
+   *                           nearest first; room for `k` is needed
+   * @param   distances        filled with the distance to each point found
+   *
+   * @return  number of points found; fewer than `k` for small sets
+   */
+  uint64_t (*nearest)(const struct SpatialTree * tree,
+                      const double               point[2],
+                      uint64_t                   k,
+                      uint64_t                   ids[],
+                      double                     distances[]);
+
+  /**
+   * @brief   Finds the points within a distance of a query point.
+   *
+   * @param   tree             index to search
+   * @param   point            query point
+   * @param   radius           largest distance to include
+   * @param   ids              set to a new array of the positions of the points
+   *                           found, nearest first, to be `free`d
+   * @param   distances        set to a new array of the distance to each point
+   *                           found, to be `free`d
+   *
+   * @return  number of points found
+   */
+  uint64_t (*within)(const struct SpatialTree * tree,
+                     const double               point[2],
+                     double                     radius,
+                     uint64_t **                ids,
+                     double **                  distances);
+};
+
+extern const struct spatial_index SpatialIndex;
+
+#endif
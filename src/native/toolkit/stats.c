@@ -0,0 +1,231 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char * COUNTER_NAMES[NUM_STAT_COUNTERS] = {
+    "calls",
+    "pointsMarshalled",
+    "centerIterations",
+    "netDistancePasses",
+    "costMatrixBuilds",
+    "heldKarpSolves",
+    "branchBoundNodes",
+    "twoOptPasses",
+    "vrpSearchRounds",
+};
+
+static const char * TIMER_NAMES[NUM_STAT_TIMERS] = {
+    "marshal",
+    "compute",
+    "buildResult",
+    "costMatrix",
+};
+
+/**
+ * @struct
+ * @brief  Stats collected since they were last cleared
+ *
+ * @prop   enabled  whether stats are being collected
+ * @prop   counters value of each counter
+ * @prop   timers   nanoseconds spent in each phase
+ */
+struct StatsSink
+{
+  bool     enabled;
+  uint64_t counters[NUM_STAT_COUNTERS];
+  uint64_t timers[NUM_STAT_TIMERS];
+};
+
+/**
+ * Stats of the calling thread.
+ */
+static __thread struct StatsSink OWN = {false, {0}, {0}};
+
+/**
+ * Stats the calling thread collects into, when not its own.
+ */
+static __thread struct StatsSink * REDIRECTED = NULL;
+
+/**
+ * @brief   Finds the stats the calling thread collects into.
+ * @details Every thread collects into stats of its own, so that copies of the
+ *          addon loaded in separate worker threads never mix theirs.
+ *
+ * @return  the stats of the calling thread
+ */
+static struct StatsSink * sink(void)
+{
+  return REDIRECTED ? REDIRECTED : &OWN;
+}
+
+/**
+ * @brief   Makes the calling thread collect into the stats of another, such as
+ *          the thread that handed it a share of its work.
+ *
+ * @param   sink             stats to collect into, or NULL for the calling
+ *                           thread's own
+ */
+static void redirect(struct StatsSink * const to)
+{
+  REDIRECTED = to == &OWN ? NULL : to;
+}
+
+/**
+ * @brief   Clears all counters and timers.
+ */
+static void reset(void)
+{
+  struct StatsSink * const S = sink();
+  memset(S->counters, 0, sizeof S->counters);
+  memset(S->timers, 0, sizeof S->timers);
+}
+
+/**
+ * @brief   Turns collection on or off for the calling thread.
+ * @details Turning collection on clears the collected stats.
+ *
+ * @param   enabled          whether to collect stats
+ *
+ * @return  whether stats were being collected before the call
+ */
+static bool enable(const bool enabled)
+{
+  struct StatsSink * const S           = sink();
+  const bool               was_enabled = S->enabled;
+  if (enabled) {
+    reset();
+  }
+  S->enabled = enabled;
+  return was_enabled;
+}
+
+/**
+ * @brief   Determines whether stats are being collected.
+ *
+ * @return  whether stats are being collected
+ */
+static bool enabled(void)
+{
+  return sink()->enabled;
+}
+
+/**
+ * @brief   Adds to a counter, if stats are being collected.
+ * @note    Counters are updated atomically, so parallel tasks may count.
+ *
+ * @param   counter          counter to add to
+ * @param   amount           amount to add
+ */
+static void count(const enum StatCounter counter, const uint64_t amount)
+{
+  struct StatsSink * const S = sink();
+  if (S->enabled) {
+    __atomic_fetch_add(&S->counters[counter], amount, __ATOMIC_RELAXED);
+  }
+}
+
+/**
+ * @brief   Reads the monotonic clock, whether or not stats are being
+ *          collected, such as to hold work to a time budget.
+ *
+ * @return  a monotonic timestamp in nanoseconds
+ */
+static uint64_t now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief   Starts timing a phase.
+ *
+ * @return  a monotonic timestamp in nanoseconds, or 0 if stats are not
+ *          being collected
+ */
+static uint64_t start(void)
+{
+  return sink()->enabled ? now() : 0;
+}
+
+/**
+ * @brief   Adds the time elapsed since `start` to a timer, if stats are being
+ *          collected.
+ *
+ * @param   timer            timer to add to
+ * @param   started          timestamp returned by `start`
+ */
+static void stop(const enum StatTimer timer, const uint64_t started)
+{
+  struct StatsSink * const S = sink();
+  if (S->enabled && started) {
+    __atomic_fetch_add(&S->timers[timer],
+                       now() - started,
+                       __ATOMIC_RELAXED);
+  }
+}
+
+/**
+ * @brief   Reads a counter.
+ *
+ * @param   counter          counter to read
+ *
+ * @return  the value of the counter
+ */
+static uint64_t counter(const enum StatCounter which)
+{
+  return sink()->counters[which];
+}
+
+/**
+ * @brief   Reads a timer.
+ *
+ * @param   timer            timer to read
+ *
+ * @return  nanoseconds spent in the phase
+ */
+static uint64_t timer(const enum StatTimer which)
+{
+  return sink()->timers[which];
+}
+
+/**
+ * @brief   Names a counter.
+ *
+ * @param   counter          counter to name
+ *
+ * @return  the camel-cased name of the counter
+ */
+static const char * counter_name(const enum StatCounter which)
+{
+  return COUNTER_NAMES[which];
+}
+
+/**
+ * @brief   Names a timer.
+ *
+ * @param   timer            timer to name
+ *
+ * @return  the camel-cased name of the timer
+ */
+static const char * timer_name(const enum StatTimer which)
+{
+  return TIMER_NAMES[which];
+}
+
+const struct stats Stats = {.sink         = sink,
+                            .redirect     = redirect,
+                            .enable       = enable,
+                            .enabled      = enabled,
+                            .reset        = reset,
+                            .count        = count,
+                            .now          = now,
+                            .start        = start,
+                            .stop         = stop,
+                            .counter      = counter,
+                            .timer        = timer,
+                            .counter_name = counter_name,
+                            .timer_name   = timer_name};
@@ -0,0 +1,174 @@
+#ifndef TOOLKIT_STATS_H
+#define TOOLKIT_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @enum
+ * @brief  Events counted while stats are enabled
+ *
+ * @prop   STAT_CALLS                calls into the library from JS
+ * @prop   STAT_POINTS_MARSHALLED    points converted from JS
+ * @prop   STAT_CENTER_ITERATIONS    steps of the geometric center search
+ * @prop   STAT_NET_DISTANCE_PASSES  net distances evaluated over a point set
+ * @prop   STAT_COST_MATRIX_BUILDS   cost matrices built
+ * @prop   STAT_HELD_KARP_SOLVES     tours solved by Held-Karp
+ * @prop   STAT_BRANCH_BOUND_NODES   nodes explored by branch-and-bound
+ * @prop   STAT_TWO_OPT_PASSES       passes of 2-opt over a tour
+ * @prop   STAT_VRP_SEARCH_ROUNDS    rounds of inter-route local search
+ */
+enum StatCounter
+{
+  STAT_CALLS,
+  STAT_POINTS_MARSHALLED,
+  STAT_CENTER_ITERATIONS,
+  STAT_NET_DISTANCE_PASSES,
+  STAT_COST_MATRIX_BUILDS,
+  STAT_HELD_KARP_SOLVES,
+  STAT_BRANCH_BOUND_NODES,
+  STAT_TWO_OPT_PASSES,
+  STAT_VRP_SEARCH_ROUNDS,
+  NUM_STAT_COUNTERS
+};
+
+/**
+ * @enum
+ * @brief  Phases timed while stats are enabled
+ *
+ * @prop   STAT_MARSHAL        converting arguments from JS
+ * @prop   STAT_COMPUTE        running the native computation
+ * @prop   STAT_BUILD_RESULT   converting results back to JS
+ * @prop   STAT_COST_MATRIX    building cost matrices, within compute
+ */
+enum StatTimer
+{
+  STAT_MARSHAL,
+  STAT_COMPUTE,
+  STAT_BUILD_RESULT,
+  STAT_COST_MATRIX,
+  NUM_STAT_TIMERS
+};
+
+/**
+ * @struct
+ * @brief  The counters and timers one thread collects into
+ */
+struct StatsSink;
+
+struct stats
+{
+  /**
+   * @brief   Finds the stats the calling thread collects into.
+   * @details Every thread collects into stats of its own, so that copies of
+   *          the addon loaded in separate worker threads never mix theirs.
+   *
+   * @return  the stats of the calling thread
+   */
+  struct StatsSink * (*sink)(void);
+
+  /**
+   * @brief   Makes the calling thread collect into the stats of another, such
+   *          as the thread that handed it a share of its work.
+   *
+   * @param   sink             stats to collect into, or NULL for the calling
+   *                           thread's own
+   */
+  void (*redirect)(struct StatsSink * sink);
+
+  /**
+   * @brief   Turns collection on or off for the calling thread.
+   * @details Turning collection on clears the collected stats.
+   *
+   * @param   enabled          whether to collect stats
+   *
+   * @return  whether stats were being collected before the call
+   */
+  bool (*enable)(bool enabled);
+
+  /**
+   * @brief   Determines whether stats are being collected.
+   *
+   * @return  whether stats are being collected
+   */
+  bool (*enabled)(void);
+
+  /**
+   * @brief   Clears all counters and timers.
+   */
+  void (*reset)(void);
+
+  /**
+   * @brief   Adds to a counter, if stats are being collected.
+   * @note    Counters are updated atomically, so parallel tasks may count.
+   *
+   * @param   counter          counter to add to
+   * @param   amount           amount to add
+   */
+  void (*count)(enum StatCounter counter, uint64_t amount);
+
+  /**
+   * @brief   Reads the monotonic clock, whether or not stats are being
+   *          collected, such as to hold work to a time budget.
+   *
+   * @return  a monotonic timestamp in nanoseconds
+   */
+  uint64_t (*now)(void);
+
+  /**
+   * @brief   Starts timing a phase.
+   *
+   * @return  a monotonic timestamp in nanoseconds, or 0 if stats are not
+   *          being collected
+   */
+  uint64_t (*start)(void);
+
+  /**
+   * @brief   Adds the time elapsed since `start` to a timer, if stats are
+   *          being collected.
+   *
+   * @param   timer            timer to add to
+   * @param   started          timestamp returned by `start`
+   */
+  void (*stop)(enum StatTimer timer, uint64_t started);
+
+  /**
+   * @brief   Reads a counter.
+   *
+   * @param   counter          counter to read
+   *
+   * @return  the value of the counter
+   */
+  uint64_t (*counter)(enum StatCounter counter);
+
+  /**
+   * @brief   Reads a timer.
+   *
+   * @param   timer            timer to read
+   *
+   * @return  nanoseconds spent in the phase
+   */
+  uint64_t (*timer)(enum StatTimer timer);
+
+  /**
+   * @brief   Names a counter.
+   *
+   * @param   counter          counter to name
+   *
+   * @return  the camel-cased name of the counter
+   */
+  const char * (*counter_name)(enum StatCounter counter);
+
+  /**
+   * @brief   Names a timer.
+   *
+   * @param   timer            timer to name
+   *
+   * @return  the camel-cased name of the timer
+   */
+  const char * (*timer_name)(enum StatTimer timer);
+};
+
+extern const struct stats Stats;
+
+#endif
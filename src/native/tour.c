@@ -0,0 +1,544 @@
+#include "tour.h"
+
+#include "toolkit/kernel.h"
+#include "toolkit/stats.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Passes of 2-opt made over the stretch of a tour around an edit.
+ */
+static const uint64_t REPAIR_MAX_PASSES = 8;
+
+/**
+ * Smallest decrease in cost accepted as an improvement by 2-opt.
+ */
+static const double IMPROVEMENT_EPSILON = 1e-9;
+
+/**
+ * Stops room is first made for.
+ */
+static const uint64_t INITIAL_CAPACITY = 16;
+
+/**
+ * @struct
+ * @brief  A tour kept up to date as stops are added, removed, and moved
+ *
+ * @prop   type        how distance between stops is measured
+ * @prop   unit        unit of haversine distance
+ * @prop   shape       shape of the tour
+ * @prop   num_stops   number of stops
+ * @prop   capacity    number of stops there is room for
+ * @prop   points      the stops, by position in the set
+ * @prop   order       position in the set of each stop, in the order visited
+ * @prop   place       position in the order of each stop of the set
+ * @prop   legs        cost from each stop in the order to the next; the last
+ *                     is the return leg of a closed tour, or else 0
+ * @prop   cost        sum of the legs
+ */
+struct LiveTour
+{
+  enum MetricType type;
+  char            unit;
+  enum TourType   shape;
+  uint64_t        num_stops;
+  uint64_t        capacity;
+  double (*points)[2];
+  uint64_t * order;
+  uint64_t * place;
+  double *   legs;
+  double     cost;
+};
+
+/**
+ * @brief   Measures the distance between two points under a tour's metric.
+ *
+ * @param   T                the tour
+ * @param   a                the first point
+ * @param   b                the second point
+ *
+ * @return  distance between the points
+ */
+static inline double __distance(const struct LiveTour * T,
+                                const double            a[2],
+                                const double            b[2])
+{
+  const struct DistanceMetric metric = {T->type, T->unit, NULL, 0};
+  return kernel_metric_distance(&metric, a, b, 2);
+}
+
+/**
+ * @brief   Measures the leg from a stop of the order to the next.
+ *
+ * @param   T                the tour
+ * @param   k                position of the stop in the order
+ *
+ * @return  cost of the leg; for the last stop, the return leg of a closed
+ *          tour, or else 0
+ */
+static double __leg(const struct LiveTour * T, const uint64_t k)
+{
+  const uint64_t n = T->num_stops;
+  if (k + 1 < n) {
+    return __distance(T, T->points[T->order[k]], T->points[T->order[k + 1]]);
+  }
+  if (T->shape == TOUR_CLOSED && n > 1) {
+    return __distance(T, T->points[T->order[k]], T->points[T->order[0]]);
+  }
+  return 0;
+}
+
+/**
+ * @brief   Sums the legs of a tour into its cost.
+ *
+ * @param   T                the tour
+ */
+static void __total(struct LiveTour * T)
+{
+  double cost = 0;
+  for (uint64_t k = 0; k < T->num_stops; ++k) {
+    cost += T->legs[k];
+  }
+  T->cost = cost;
+}
+
+/**
+ * @brief   Makes room for a number of stops.
+ *
+ * @param   T                the tour
+ * @param   num_stops        number of stops to make room for
+ */
+static void __reserve(struct LiveTour * T, const uint64_t num_stops)
+{
+  if (num_stops <= T->capacity) {
+    return;
+  }
+  uint64_t capacity = T->capacity ? T->capacity : INITIAL_CAPACITY;
+  while (capacity < num_stops) {
+    capacity *= 2;
+  }
+  T->points   = realloc(T->points, capacity * sizeof *T->points);
+  T->order    = realloc(T->order, capacity * sizeof *T->order);
+  T->place    = realloc(T->place, capacity * sizeof *T->place);
+  T->legs     = realloc(T->legs, capacity * sizeof *T->legs);
+  T->capacity = capacity;
+}
+
+/**
+ * @brief   Records where the stops of a stretch of the order are.
+ *
+ * @param   T                the tour
+ * @param   first            first position of the stretch
+ * @param   last             last position of the stretch
+ */
+static void __place(struct LiveTour * T,
+                    const uint64_t    first,
+                    const uint64_t    last)
+{
+  for (uint64_t k = first; k <= last && k < T->num_stops; ++k) {
+    T->place[T->order[k]] = k;
+  }
+}
+
+/**
+ * @brief   Finds where visiting a point adds the least cost to a tour.
+ * @details The distance from the point to each stop is measured once, and
+ *          paired with the legs already known, so the search takes one
+ *          distance per stop. The start, and the end of a fixed-end tour,
+ *          keep their places.
+ *
+ * @param   T                a tour of at least one stop
+ * @param   point            point to visit
+ *
+ * @return  position in the order to visit the point at
+ */
+static uint64_t __cheapest(const struct LiveTour * T, const double point[2])
+{
+  const uint64_t n     = T->num_stops;
+  const double   first = __distance(T, T->points[T->order[0]], point);
+
+  uint64_t best      = n;
+  double   best_cost = INFINITY;
+  double   to_prev   = first;
+  for (uint64_t k = 0; k < n; ++k) {
+    double added;
+    double to_next = 0;
+    if (k + 1 < n) {
+      to_next = __distance(T, T->points[T->order[k + 1]], point);
+      added   = to_prev + to_next - T->legs[k];
+    } else if (T->shape == TOUR_FIXED_ENDS && n > 1) {
+      break;
+    } else if (T->shape == TOUR_CLOSED) {
+      added = to_prev + first - T->legs[k];
+    } else {
+      added = to_prev;
+    }
+
+    if (added < best_cost) {
+      best_cost = added;
+      best      = k + 1;
+    }
+    to_prev = to_next;
+  }
+
+  return best;
+}
+
+/**
+ * @brief   Visits a stop of the set at a position in the order.
+ *
+ * @param   T                the tour, with room for another stop
+ * @param   pos              position in the order to visit the stop at
+ * @param   id               position of the stop in the set
+ */
+static void __insert_at(struct LiveTour * T,
+                        const uint64_t    pos,
+                        const uint64_t    id)
+{
+  const uint64_t tail = T->num_stops - pos;
+  memmove(T->order + pos + 1, T->order + pos, tail * sizeof *T->order);
+  memmove(T->legs + pos + 1, T->legs + pos, tail * sizeof *T->legs);
+  T->order[pos] = id;
+  ++T->num_stops;
+
+  if (pos > 0) {
+    T->legs[pos - 1] = __leg(T, pos - 1);
+  }
+  T->legs[pos] = __leg(T, pos);
+  __place(T, pos, T->num_stops - 1);
+}
+
+/**
+ * @brief   Stops visiting the stop at a position in the order, joining the
+ *          stops either side of it. The set of points is left as it is.
+ *
+ * @param   T                the tour
+ * @param   pos              position in the order of the stop
+ */
+static void __splice(struct LiveTour * T, const uint64_t pos)
+{
+  const uint64_t tail = T->num_stops - pos - 1;
+  memmove(T->order + pos, T->order + pos + 1, tail * sizeof *T->order);
+  memmove(T->legs + pos, T->legs + pos + 1, tail * sizeof *T->legs);
+  --T->num_stops;
+
+  const uint64_t n = T->num_stops;
+  if (pos > 0) {
+    T->legs[pos - 1] = __leg(T, pos - 1);
+  }
+  if (n > 0) {
+    // the return leg ends at a new start when the start is spliced out
+    T->legs[n - 1] = __leg(T, n - 1);
+    __place(T, pos, n - 1);
+  }
+}
+
+/**
+ * @brief   Reverses a stretch of the order.
+ * @details The legs within the stretch are reversed along with it, as every
+ *          metric kept by a tour is symmetric; only the legs into and out of
+ *          the stretch are measured again.
+ *
+ * @param   T                the tour
+ * @param   i                first position of the stretch, after the start
+ * @param   k                last position of the stretch
+ */
+static void __reverse(struct LiveTour * T, const uint64_t i, const uint64_t k)
+{
+  for (uint64_t lo = i, hi = k; lo < hi; ++lo, --hi) {
+    const uint64_t swap = T->order[lo];
+    T->order[lo]        = T->order[hi];
+    T->order[hi]        = swap;
+  }
+  for (uint64_t lo = i, hi = k - 1; lo < hi; ++lo, --hi) {
+    const double swap = T->legs[lo];
+    T->legs[lo]       = T->legs[hi];
+    T->legs[hi]       = swap;
+  }
+  T->legs[i - 1] = __leg(T, i - 1);
+  T->legs[k]     = __leg(T, k);
+  __place(T, i, k);
+}
+
+/**
+ * @brief   Improves the stretch of a tour around an edit with 2-opt.
+ * @details Reverses any stretch within `radius` stops of `center` whose
+ *          reversal lowers the cost, until none remains or
+ *          `REPAIR_MAX_PASSES` passes have been made, respecting the shape of
+ *          the tour as `TSP.solve` does. Each candidate takes two distances,
+ *          the legs it replaces being known.
+ *
+ * @param   T                the tour
+ * @param   center           position in the order of the edit
+ * @param   radius           stops either side of the edit that may move
+ */
+static void __repair(struct LiveTour * T,
+                     const uint64_t    center,
+                     const uint64_t    radius)
+{
+  const uint64_t n = T->num_stops;
+  if (!radius || n < 4) {
+    return;
+  }
+
+  const uint64_t last = T->shape == TOUR_FIXED_ENDS ? n - 2 : n - 1;
+  const uint64_t lo   = center > radius + 1 ? center - radius : 1;
+  const uint64_t hi   = center + radius < last ? center + radius : last;
+  uint64_t *     o    = T->order;
+
+  for (uint64_t pass = 0; pass < REPAIR_MAX_PASSES; ++pass) {
+    bool improved = false;
+    Stats.count(STAT_TWO_OPT_PASSES, 1);
+
+    for (uint64_t i = lo; i < hi; ++i) {
+      for (uint64_t k = i + 1; k <= hi; ++k) {
+        // the stop following the stretch, if any
+        const bool     has_after = k + 1 < n || T->shape == TOUR_CLOSED;
+        const uint64_t after     = k + 1 < n ? o[k + 1] : o[0];
+
+        double delta =
+            __distance(T, T->points[o[i - 1]], T->points[o[k]]) -
+            T->legs[i - 1];
+        if (has_after) {
+          delta += __distance(T, T->points[o[i]], T->points[after]) -
+                   T->legs[k];
+        }
+
+        if (delta < -IMPROVEMENT_EPSILON) {
+          __reverse(T, i, k);
+          improved = true;
+        }
+      }
+    }
+
+    if (!improved) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Solves a tour over a set of 2D points, to be kept up to date.
+ * @details The first tour is solved as by `TSP.solve`. A custom matrix metric
+ *          only describes the points it was built for, so tours measured by
+ *          one are kept under euclidean distance.
+ *
+ * @param   metric           how distance between points is measured
+ * @param   points           points to visit
+ * @param   num_points       number of points
+ * @param   options          shape of the tour, and its start and end
+ *
+ * @return  the tour, to be freed with `free`
+ */
+static struct LiveTour * New(const struct DistanceMetric * metric,
+                             const double                  points[][2],
+                             const uint64_t                num_points,
+                             const struct TSPOptions *     options)
+{
+  struct LiveTour * T = calloc(1, sizeof *T);
+  T->type  = metric->type == METRIC_MATRIX ? METRIC_L2 : metric->type;
+  T->unit  = metric->unit;
+  T->shape = options->type;
+  __reserve(T, num_points);
+
+  if (num_points) {
+    memcpy(T->points, points, num_points * sizeof *T->points);
+
+    const struct DistanceMetric kept = {T->type, T->unit, NULL, 0};
+    uint64_t * solved                = TSP.solve((const double **)points,
+                                  num_points,
+                                  2,
+                                  options,
+                                  &kept,
+                                  NULL,
+                                  NULL);
+    memcpy(T->order, solved, num_points * sizeof *T->order);
+    free(solved);
+  }
+
+  T->num_stops = num_points;
+  for (uint64_t k = 0; k < num_points; ++k) {
+    T->legs[k] = __leg(T, k);
+  }
+  __place(T, 0, num_points - 1);
+  __total(T);
+
+  return T;
+}
+
+/**
+ * @brief   Frees the memory held by a tour.
+ *
+ * @param   tour             tour to free
+ */
+static void free_(struct LiveTour * T)
+{
+  if (!T) {
+    return;
+  }
+  free(T->points);
+  free(T->order);
+  free(T->place);
+  free(T->legs);
+  free(T);
+}
+
+/**
+ * @brief   Determines the number of stops of a tour.
+ *
+ * @param   tour             tour to measure
+ *
+ * @return  number of stops
+ */
+static uint64_t size(const struct LiveTour * T)
+{
+  return T->num_stops;
+}
+
+/**
+ * @brief   Reads the order in which a tour visits its stops.
+ *
+ * @param   tour             tour to read
+ *
+ * @return  the position in the set of each stop visited, in order; valid
+ *          until the tour next changes
+ */
+static const uint64_t * order(const struct LiveTour * T)
+{
+  return T->order;
+}
+
+/**
+ * @brief   Determines the cost of a tour, including the return leg of closed
+ *          tours.
+ *
+ * @param   tour             tour to measure
+ *
+ * @return  cost of the tour
+ */
+static double cost(const struct LiveTour * T)
+{
+  return T->cost;
+}
+
+/**
+ * @brief   Adds a stop to the end of the set, visiting it where it adds the
+ *          least cost to the tour.
+ * @details Takes time linear in the number of stops. The start of the tour,
+ *          and the end of a fixed-end tour, never change.
+ *
+ * @param   tour             tour to add to
+ * @param   point            stop to add
+ * @param   repair           if not 0, how many stops either side of the new
+ *                           one may be reordered by 2-opt afterwards
+ *
+ * @return  position of the new stop in the order
+ */
+static uint64_t add_stop(struct LiveTour * T,
+                         const double      point[2],
+                         const uint64_t    repair)
+{
+  const uint64_t id = T->num_stops;
+  __reserve(T, id + 1);
+  T->points[id][0] = point[0];
+  T->points[id][1] = point[1];
+
+  const uint64_t pos = id ? __cheapest(T, point) : 0;
+  __insert_at(T, pos, id);
+  __repair(T, pos, repair);
+  __total(T);
+
+  return T->place[id];
+}
+
+/**
+ * @brief   Removes a stop from the set, joining the stops either side of it;
+ *          the stops after it in the set move up one position.
+ * @details Takes time linear in the number of stops. Removing the start of the
+ *          tour makes the next stop the start.
+ *
+ * @param   tour             tour to remove from
+ * @param   id               position of the stop in the set
+ * @param   repair           if not 0, how many stops either side of the gap
+ *                           may be reordered by 2-opt afterwards
+ */
+static void remove_stop(struct LiveTour * T,
+                        const uint64_t    id,
+                        const uint64_t    repair)
+{
+  if (id >= T->num_stops) {
+    return;
+  }
+
+  const uint64_t pos = T->place[id];
+  __splice(T, pos);
+
+  // the stops after it in the set move up one position
+  const uint64_t n = T->num_stops;
+  memmove(T->points + id, T->points + id + 1, (n - id) * sizeof *T->points);
+  for (uint64_t k = 0; k < n; ++k) {
+    if (T->order[k] > id) {
+      --T->order[k];
+    }
+    T->place[T->order[k]] = k;
+  }
+
+  __repair(T, pos, repair);
+  __total(T);
+}
+
+/**
+ * @brief   Moves a stop, keeping its position in the set, and visits it where
+ *          it adds the least cost to the tour.
+ * @details A moved start, or end of a fixed-end tour, keeps its place in the
+ *          order.
+ *
+ * @param   tour             tour to update
+ * @param   id               position of the stop in the set
+ * @param   point            value to move it to
+ * @param   repair           if not 0, how many stops either side of the moved
+ *                           one may be reordered by 2-opt afterwards
+ */
+static void move_stop(struct LiveTour * T,
+                      const uint64_t    id,
+                      const double      point[2],
+                      const uint64_t    repair)
+{
+  if (id >= T->num_stops) {
+    return;
+  }
+
+  const uint64_t n      = T->num_stops;
+  uint64_t       pos    = T->place[id];
+  const bool     pinned = pos == 0 ||
+                      (T->shape == TOUR_FIXED_ENDS && n > 1 && pos == n - 1);
+  T->points[id][0] = point[0];
+  T->points[id][1] = point[1];
+
+  if (pinned) {
+    if (pos > 0) {
+      T->legs[pos - 1] = __leg(T, pos - 1);
+    }
+    T->legs[pos]   = __leg(T, pos);
+    T->legs[n - 1] = __leg(T, n - 1);
+  } else {
+    __splice(T, pos);
+    pos = __cheapest(T, point);
+    __insert_at(T, pos, id);
+  }
+
+  __repair(T, pos, repair);
+  __total(T);
+}
+
+const struct tour Tour = {.New         = New,
+                          .free        = free_,
+                          .size        = size,
+                          .order       = order,
+                          .cost        = cost,
+                          .add_stop    = add_stop,
+                          .remove_stop = remove_stop,
+                          .move_stop   = move_stop};
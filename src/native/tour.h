@@ -0,0 +1,122 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include "toolkit/metric.h"
+#include "tsp.h"
+
+#include <stdint.h>
+
+/**
+ * @struct
+ * @brief  A tour kept up to date as stops are added, removed, and moved, with
+ *         stops identified by their position in the set of points
+ */
+struct LiveTour;
+
+struct tour
+{
+  /**
+   * @brief   Solves a tour over a set of 2D points, to be kept up to date.
+   * @details The first tour is solved as by `TSP.solve`. A custom matrix
+   *          metric only describes the points it was built for, so tours
+   *          measured by one are kept under euclidean distance.
+   *
+   * @param   metric           how distance between points is measured
+   * @param   points           points to visit
+   * @param   num_points       number of points
+   * @param   options          shape of the tour, and its start and end
+   *
+   * @return  the tour, to be freed with `free`
+   */
+  struct LiveTour * (*New)(const struct DistanceMetric * metric,
+                           const double                  points[][2],
+                           uint64_t                      num_points,
+                           const struct TSPOptions *     options);
+
+  /**
+   * @brief   Frees the memory held by a tour.
+   *
+   * @param   tour             tour to free
+   */
+  void (*free)(struct LiveTour * tour);
+
+  /**
+   * @brief   Determines the number of stops of a tour.
+   *
+   * @param   tour             tour to measure
+   *
+   * @return  number of stops
+   */
+  uint64_t (*size)(const struct LiveTour * tour);
+
+  /**
+   * @brief   Reads the order in which a tour visits its stops.
+   *
+   * @param   tour             tour to read
+   *
+   * @return  the position in the set of each stop visited, in order; valid
+   *          until the tour next changes
+   */
+  const uint64_t * (*order)(const struct LiveTour * tour);
+
+  /**
+   * @brief   Determines the cost of a tour, including the return leg of closed
+   *          tours.
+   *
+   * @param   tour             tour to measure
+   *
+   * @return  cost of the tour
+   */
+  double (*cost)(const struct LiveTour * tour);
+
+  /**
+   * @brief   Adds a stop to the end of the set, visiting it where it adds the
+   *          least cost to the tour.
+   * @details Takes time linear in the number of stops. The start of the tour,
+   *          and the end of a fixed-end tour, never change.
+   *
+   * @param   tour             tour to add to
+   * @param   point            stop to add
+   * @param   repair           if not 0, how many stops either side of the new
+   *                           one may be reordered by 2-opt afterwards
+   *
+   * @return  position of the new stop in the order
+   */
+  uint64_t (*add_stop)(struct LiveTour * tour,
+                       const double      point[2],
+                       uint64_t          repair);
+
+  /**
+   * @brief   Removes a stop from the set, joining the stops either side of it;
+   *          the stops after it in the set move up one position.
+   * @details Takes time linear in the number of stops. Removing the start of
+   *          the tour makes the next stop the start.
+   *
+   * @param   tour             tour to remove from
+   * @param   id               position of the stop in the set
+   * @param   repair           if not 0, how many stops either side of the gap
+   *                           may be reordered by 2-opt afterwards
+   */
+  void (*remove_stop)(struct LiveTour * tour, uint64_t id, uint64_t repair);
+
+  /**
+   * @brief   Moves a stop, keeping its position in the set, and visits it
+   *          where it adds the least cost to the tour.
+   * @details A moved start, or end of a fixed-end tour, keeps its place in
+   *          the order.
+   *
+   * @param   tour             tour to update
+   * @param   id               position of the stop in the set
+   * @param   point            value to move it to
+   * @param   repair           if not 0, how many stops either side of the
+   *                           moved one may be reordered by 2-opt afterwards
+   */
+  void (*move_stop)(struct LiveTour * tour,
+                    uint64_t          id,
+                    const double      point[2],
+                    uint64_t          repair);
+};
+
+extern const struct tour Tour;
+
+#endif
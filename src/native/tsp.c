@@ -1,12 +1,93 @@
 #include "tsp.h"
 
 #include "toolkit/array.h"
+#include "toolkit/hilbert.h"
+#include "toolkit/kernel.h"
 #include "toolkit/matrix.h"
+#include "toolkit/parallel.h"
+#include "toolkit/stats.h"
 
-#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+/**
+ * Largest instance solved exactly by bitmask dynamic programming. The DP table
+ * holds `2^(n-1) * (n-1)` doubles, about 80MB at this size.
+ */
+static const uint64_t HELD_KARP_MAX_POINTS = 20;
+
+/**
+ * Largest instance solved by branch-and-bound; beyond this the nearest
+ * neighbour ordering, improved by 2-opt, is returned.
+ */
+static const uint64_t BRANCH_BOUND_MAX_POINTS = 40;
+
+/**
+ * Search nodes expanded by branch-and-bound before settling for the best
+ * ordering found so far.
+ */
+static const uint64_t BRANCH_BOUND_MAX_NODES = 200000;
+
+/**
+ * Minimum number of subsets evaluated per thread in a Held-Karp layer.
+ */
+static const uint64_t HELD_KARP_GRAIN = 1 << 12;
+
+/**
+ * Passes of 2-opt made over a heuristic ordering before settling.
+ */
+static const uint64_t TWO_OPT_MAX_PASSES = 32;
+
+/**
+ * Smallest decrease in cost accepted as an improvement by 2-opt.
+ */
+static const double IMPROVEMENT_EPSILON = 1e-9;
+
+/**
+ * Points ahead along a Hilbert curve tour that 2-opt tries to reconnect each
+ * point with.
+ */
+static const uint64_t CURVE_TWO_OPT_WINDOW = 8;
+
+/**
+ * Passes of windowed 2-opt made over a Hilbert curve tour before settling.
+ */
+static const uint64_t CURVE_TWO_OPT_MAX_PASSES = 4;
+
+/**
+ * Points of the order passed by windowed 2-opt between checks of the deadline
+ * within a pass.
+ */
+static const uint64_t CURVE_DEADLINE_STRIDE = 256;
+
+/**
+ * Minimum number of tours solved by each thread of a batch.
+ */
+static const uint64_t BATCH_GRAIN = 4;
+
+/**
+ * @struct
+ * @brief  A travelling salesman instance over a cost matrix
+ *
+ * @prop   cost_matrix distances among the points
+ * @prop   num_points  number of points
+ * @prop   type        shape of the tour
+ * @prop   start       point the tour starts at
+ * @prop   end         point the tour ends at, for `TOUR_FIXED_ENDS`
+ * @prop   deadline    limits on improving the tour
+ */
+struct __tour
+{
+  const double *    cost_matrix;
+  uint64_t          num_points;
+  enum TourType     type;
+  uint64_t          start;
+  uint64_t          end;
+  struct Deadline * deadline;
+};
+
 /**
  * @brief   Finds the nearest, unvisited point to a specified one.
  * @details Iterates over a cost matrix to find the point `k` nearest a
@@ -27,14 +108,14 @@ static int __nearest_unvisited_point(const double * cost_matrix,
                                      const uint64_t num_points,
                                      const uint64_t visited_points[])
 {
-  int      k        = -1;
-  uint64_t min_cost = SIZE_MAX;
+  int    k        = -1;
+  double min_cost = INFINITY;
 
   for (uint64_t cand = 0; cand < num_points; ++cand) {
-    const uint64_t _min_cost = cost_matrix[Array.idx_2d(o, cand, num_points)];
+    const double _min_cost = cost_matrix[kernel_idx_2d(o, cand, num_points)];
 
     if (visited_points[cand] == 0) {
-      if (_min_cost < min_cost) {
+      if (k < 0 || _min_cost < min_cost) {
         min_cost = _min_cost;
         k        = cand;
       }
@@ -45,42 +126,62 @@ static int __nearest_unvisited_point(const double * cost_matrix,
 }
 
 /**
- * @brief   Solves the travelling salesman problem for a set of points.
- * @details Creates a cost matrix for travelling between points, then travels
- *          to the consequently nearest points until all points have been
- *          traversed.
+ * @brief   Calculates the cost of travelling an ordering of every point.
+ * @details Closed tours include the leg from the last point back to the
+ *          start.
  *
- * @param   points           set of points to solve the TSP for
- * @param   num_points       number of points
- * @param   dimension        dimension of the point vectors
- * @param   start_index      point from which to find a solution to
- * @param   norm_degree      degree of the norm to use in calculating distance
- *                           between point vectors
+ * @param   T                 the instance
+ * @param   travel_order      the indeces to travel, in order
  *
- * @return  a pointer to the indeces to travel, in order
+ * @return  cost of the tour
+ */
+static double __tour_cost(const struct __tour * T,
+                          const uint64_t        travel_order[])
+{
+  const uint64_t n    = T->num_points;
+  double         cost = 0;
+  for (uint64_t i = 1; i < n; ++i) {
+    cost += T->cost_matrix[kernel_idx_2d(travel_order[i - 1],
+                                         travel_order[i],
+                                         n)];
+  }
+  if (T->type == TOUR_CLOSED && n > 1) {
+    cost += T->cost_matrix[kernel_idx_2d(travel_order[n - 1],
+                                         travel_order[0],
+                                         n)];
+  }
+  return cost;
+}
+
+/**
+ * @brief   Orders points by repeatedly travelling to the nearest unvisited one.
+ * @details A fixed end point is held back until every other point has been
+ *          visited.
+ *
+ * @param   T                 the instance
+ * @param   travel_order      filled with the indeces to travel, in order
  */
-static uint64_t * solve(const double * points,
-                        const uint64_t num_points,
-                        const uint64_t dimension,
-                        const uint64_t start_index,
-                        const uint64_t norm_degree)
-{
-  double *   cost_matrix    = Matrix.cost_matrix((const double **)points,
-                                            num_points,
-                                            dimension,
-                                            norm_degree);
-  uint64_t * visited_points = Array.New.uint64_t_array(num_points);
-  uint64_t * travel_order   = Array.New.uint64_t_array(num_points);
-  travel_order[0]           = start_index;
-
-  uint64_t current_point = start_index;
+static void __nearest_neighbour(const struct __tour * T,
+                                uint64_t              travel_order[])
+{
+  const uint64_t n              = T->num_points;
+  uint64_t *     visited_points = Array.New.uint64_t_array(n);
+  travel_order[0]               = T->start;
+
+  uint64_t current_point = T->start;
   uint64_t idx           = 1;
 
-  while (idx < num_points) {
+  if (T->type == TOUR_FIXED_ENDS) {
+    visited_points[T->end] = 1;
+    travel_order[n - 1]    = T->end;
+  }
+  const uint64_t last_free = T->type == TOUR_FIXED_ENDS ? n - 1 : n;
+
+  while (idx < last_free) {
     visited_points[current_point] = 1;
-    const int nearest_point       = __nearest_unvisited_point(cost_matrix,
+    const int nearest_point       = __nearest_unvisited_point(T->cost_matrix,
                                                         current_point,
-                                                        num_points,
+                                                        n,
                                                         visited_points);
 
     travel_order[idx] = (uint64_t)nearest_point;
@@ -88,8 +189,831 @@ static uint64_t * solve(const double * points,
     ++idx;
   }
 
-  free(cost_matrix);
   free(visited_points);
+}
+
+/**
+ * @brief   Improves an ordering with 2-opt, respecting the tour type.
+ * @details Reverses any stretch `[i, k]` of the ordering whose reversal
+ *          lowers the cost, until none remains, `TWO_OPT_MAX_PASSES` passes
+ *          have been made, or a limit of the instance is reached, checked
+ *          between passes and between the stretches of each start `i`. The
+ *          start never moves. Open tours may reverse their tail, since the
+ *          last point is free; closed tours account for the leg back to the
+ *          start; fixed-end tours never move the end.
+ *
+ * @param   T                 the instance
+ * @param   travel_order      the ordering to improve in place
+ */
+static void __two_opt(const struct __tour * T, uint64_t travel_order[])
+{
+  const uint64_t n = T->num_points;
+  const double * C = T->cost_matrix;
+  uint64_t *     o = travel_order;
+
+  if (n < 4) {
+    return;
+  }
+  const uint64_t last = T->type == TOUR_FIXED_ENDS ? n - 2 : n - 1;
+
+  for (uint64_t pass = 0; pass < TWO_OPT_MAX_PASSES; ++pass) {
+    if (deadline_reached(T->deadline)) {
+      break;
+    }
+    bool improved = false;
+    Stats.count(STAT_TWO_OPT_PASSES, 1);
+
+    for (uint64_t i = 1; i < last && !deadline_passed(T->deadline); ++i) {
+      for (uint64_t k = i + 1; k <= last; ++k) {
+        // the point following the stretch, if any
+        const bool     has_after = k + 1 < n || T->type == TOUR_CLOSED;
+        const uint64_t after     = k + 1 < n ? o[k + 1] : o[0];
+
+        double delta = C[kernel_idx_2d(o[i - 1], o[k], n)] -
+                       C[kernel_idx_2d(o[i - 1], o[i], n)];
+        if (has_after) {
+          delta += C[kernel_idx_2d(o[i], after, n)] -
+                   C[kernel_idx_2d(o[k], after, n)];
+        }
+
+        if (delta < -IMPROVEMENT_EPSILON) {
+          for (uint64_t lo = i, hi = k; lo < hi; ++lo, --hi) {
+            const uint64_t swap = o[lo];
+            o[lo]               = o[hi];
+            o[hi]               = swap;
+          }
+          improved = true;
+        }
+      }
+    }
+
+    if (!improved) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Counts the set bits of a subset mask.
+ *
+ * @param   mask              the subset
+ *
+ * @return  number of members of the subset
+ */
+static inline uint64_t __popcount(uint64_t mask)
+{
+  uint64_t count = 0;
+  for (; mask; mask &= mask - 1) {
+    ++count;
+  }
+  return count;
+}
+
+/**
+ * @struct
+ * @brief  State shared by the threads evaluating one Held-Karp layer
+ *
+ * @prop   dp          cheapest path cost from the start through subset `S`
+ *                     ending at member `j`, stored at `(S, j)`
+ * @prop   cost_matrix distances among the points
+ * @prop   members     point index of each subset bit
+ * @prop   num_bits    number of subset bits; i.e. points other than the start
+ * @prop   num_points  number of points
+ * @prop   layer       size of the subsets being evaluated
+ */
+struct __held_karp_layer
+{
+  double *         dp;
+  const double *   cost_matrix;
+  const uint64_t * members;
+  uint64_t         num_bits;
+  uint64_t         num_points;
+  uint64_t         layer;
+};
+
+/**
+ * @brief   Evaluates the subsets of one Held-Karp layer within a mask range.
+ * @details For every subset `S` of size `layer`, and every member `j` of `S`,
+ *          the cheapest path ending at `j` is the cheapest path through
+ *          `S \ {j}` ending at some `i`, extended by the edge `(i, j)`. All
+ *          reads come from the previous layer, so mask ranges are independent.
+ *
+ * @param   begin             first subset mask
+ * @param   end               one past the last subset mask
+ * @param   context           the layer being evaluated
+ */
+static void __held_karp_task(const uint64_t begin,
+                             const uint64_t end,
+                             void *         context)
+{
+  const struct __held_karp_layer * L    = context;
+  const uint64_t                   bits = L->num_bits;
+
+  for (uint64_t mask = begin; mask < end; ++mask) {
+    if (__popcount(mask) != L->layer) {
+      continue;
+    }
+
+    for (uint64_t j = 0; j < bits; ++j) {
+      if (!(mask & ((uint64_t)1 << j))) {
+        continue;
+      }
+
+      const uint64_t prev   = mask ^ ((uint64_t)1 << j);
+      const uint64_t to     = L->members[j];
+      double         best   = INFINITY;
+      const double * prev_r = L->dp + kernel_idx_2d(prev, 0, bits);
+
+      for (uint64_t i = 0; i < bits; ++i) {
+        if (!(prev & ((uint64_t)1 << i))) {
+          continue;
+        }
+        const double cand = prev_r[i] +
+                            L->cost_matrix[kernel_idx_2d(L->members[i],
+                                                         to,
+                                                         L->num_points)];
+        if (cand < best) {
+          best = cand;
+        }
+      }
+
+      L->dp[kernel_idx_2d(mask, j, bits)] = best;
+    }
+  }
+}
+
+/**
+ * @brief   Finds the cheapest tour visiting every point exactly once by
+ *          bitmask dynamic programming (Held-Karp).
+ * @details Builds the table of cheapest paths from the start through every
+ *          subset of the remaining points, one subset size at a time. Each
+ *          layer only depends on the one before it, so the subsets of a layer
+ *          are evaluated in parallel. The last point is then chosen by tour
+ *          type: the cheapest full path for open tours, the cheapest full path
+ *          plus the leg home for closed tours, or the fixed end. The optimal
+ *          ordering is recovered by walking the table backwards from it.
+ *          Each layer takes an iteration of the limits of the instance, and
+ *          the table is abandoned once a limit is reached.
+ * @note    Runs in `O(2^n * n^2)` time and `O(2^n * n)` space.
+ *
+ * @param   T                 the instance
+ * @param   travel_order      filled with the indeces to travel, in order
+ *
+ * @return  whether the table was completed, and the ordering filled
+ */
+static bool __held_karp(const struct __tour * T, uint64_t travel_order[])
+{
+  const double * cost_matrix = T->cost_matrix;
+  const uint64_t num_points  = T->num_points;
+  const uint64_t bits        = num_points - 1;
+  const uint64_t num_masks   = (uint64_t)1 << bits;
+  const uint64_t full        = num_masks - 1;
+  uint64_t *     members     = Array.Scratch.uint64_t_array(bits);
+  double *       dp          = Array.Scratch.double_array(num_masks * bits);
+
+  uint64_t last = 0;
+  for (uint64_t p = 0, b = 0; p < num_points; ++p) {
+    if (p != T->start) {
+      if (p == T->end) {
+        last = b;
+      }
+      members[b++] = p;
+    }
+  }
+
+  // paths of a single edge out of the start
+  for (uint64_t j = 0; j < bits; ++j) {
+    dp[kernel_idx_2d((uint64_t)1 << j, j, bits)] =
+        cost_matrix[kernel_idx_2d(T->start, members[j], num_points)];
+  }
+
+  struct __held_karp_layer layer = {
+      dp, cost_matrix, members, bits, num_points, 2};
+  for (; layer.layer <= bits; ++layer.layer) {
+    if (deadline_reached(T->deadline)) {
+      Array.release(members);
+      Array.release(dp);
+      return false;
+    }
+    Parallel.for_range(1, num_masks, HELD_KARP_GRAIN, __held_karp_task, &layer);
+  }
+
+  // choose the last point, then walk back through the table
+  if (T->type != TOUR_FIXED_ENDS) {
+    double best = INFINITY;
+    for (uint64_t j = 0; j < bits; ++j) {
+      double cand = dp[kernel_idx_2d(full, j, bits)];
+      if (T->type == TOUR_CLOSED) {
+        cand += cost_matrix[kernel_idx_2d(members[j], T->start, num_points)];
+      }
+      if (cand < best) {
+        best = cand;
+        last = j;
+      }
+    }
+  }
+
+  travel_order[0] = T->start;
+  uint64_t mask   = full;
+  for (uint64_t pos = bits; pos > 0; --pos) {
+    travel_order[pos]   = members[last];
+    const uint64_t prev = mask ^ ((uint64_t)1 << last);
+    if (!prev) {
+      break;
+    }
+
+    uint64_t best_i = bits;
+    double   best   = INFINITY;
+    for (uint64_t i = 0; i < bits; ++i) {
+      if (!(prev & ((uint64_t)1 << i))) {
+        continue;
+      }
+      const double cand = dp[kernel_idx_2d(prev, i, bits)] +
+                          cost_matrix[kernel_idx_2d(members[i],
+                                                    members[last],
+                                                    num_points)];
+      if (cand < best) {
+        best   = cand;
+        best_i = i;
+      }
+    }
+
+    mask = prev;
+    last = best_i;
+  }
+
+  Array.release(members);
+  Array.release(dp);
+  return true;
+}
+
+/**
+ * @struct
+ * @brief  Search state of a branch-and-bound solve
+ *
+ * @prop   T            the instance
+ * @prop   target       point every completion must finish at, or
+ *                      `num_points` if the tour is open
+ * @prop   visited      whether each point is on the current partial path
+ * @prop   path         the current partial path
+ * @prop   best_path    the cheapest complete path found so far
+ * @prop   best_cost    cost of `best_path`
+ * @prop   nodes        number of search nodes expanded so far
+ * @prop   key          scratch space for the lower bound's spanning tree
+ * @prop   in_tree      scratch space for the lower bound's spanning tree
+ */
+struct __branch_bound
+{
+  const struct __tour * T;
+  uint64_t              target;
+  uint64_t *            visited;
+  uint64_t *            path;
+  uint64_t *            best_path;
+  double                best_cost;
+  uint64_t              nodes;
+  double *              key;
+  uint64_t *            in_tree;
+};
+
+/**
+ * @brief   Bounds the cost of completing a partial path from below.
+ * @details Any completion leaves the last point `o` along one edge into the
+ *          unvisited set `U`, travels a Hamiltonian path within `U`, and, if
+ *          the tour has a target (the start of a closed tour, or a fixed end),
+ *          leaves `U` along one more edge into the target. The path within `U`
+ *          is a spanning tree of `U`, so the cheapest edges out of `o` and into
+ *          the target plus the minimum spanning tree of `U` (a 1-tree) never
+ *          exceed the true completion cost.
+ *
+ * @param   B                 the search state
+ * @param   o                 last point of the partial path
+ *
+ * @return  a lower bound on the cost of completing the path
+ */
+static double __one_tree_bound(struct __branch_bound * B, const uint64_t o)
+{
+  const double * C      = B->T->cost_matrix;
+  const uint64_t n      = B->T->num_points;
+  const bool     target = B->target < n;
+  double         bound  = 0;
+  double         enter  = INFINITY;
+  double         leave  = INFINITY;
+  uint64_t       root   = n;
+
+  // Prim's algorithm over the unvisited points
+  for (uint64_t p = 0; p < n; ++p) {
+    B->in_tree[p] = B->visited[p] || p == B->target;
+    B->key[p]     = INFINITY;
+    if (!B->in_tree[p]) {
+      const double c = C[kernel_idx_2d(o, p, n)];
+      if (c < enter) {
+        enter = c;
+      }
+      if (target && C[kernel_idx_2d(p, B->target, n)] < leave) {
+        leave = C[kernel_idx_2d(p, B->target, n)];
+      }
+      if (root == n) {
+        root = p;
+      }
+    }
+  }
+  if (root == n) {
+    return target ? C[kernel_idx_2d(o, B->target, n)] : 0;
+  }
+
+  B->key[root] = 0;
+  for (;;) {
+    uint64_t next = n;
+    for (uint64_t p = 0; p < n; ++p) {
+      if (!B->in_tree[p] && (next == n || B->key[p] < B->key[next])) {
+        next = p;
+      }
+    }
+    if (next == n) {
+      break;
+    }
+
+    B->in_tree[next] = 1;
+    bound += B->key[next];
+    for (uint64_t p = 0; p < n; ++p) {
+      const double c = C[kernel_idx_2d(next, p, n)];
+      if (!B->in_tree[p] && c < B->key[p]) {
+        B->key[p] = c;
+      }
+    }
+  }
+
+  return bound + enter + (target ? leave : 0);
+}
+
+/**
+ * @brief   Extends a partial path depth-first, pruning by the 1-tree bound.
+ *
+ * @param   B                 the search state
+ * @param   depth             number of points on the partial path
+ * @param   cost              cost of the partial path
+ */
+static void __branch(struct __branch_bound * B,
+                     const uint64_t          depth,
+                     const double            cost)
+{
+  const struct __tour * T    = B->T;
+  const uint64_t        n    = T->num_points;
+  const uint64_t        last = B->path[depth - 1];
+
+  if (depth == n) {
+    const double total = T->type == TOUR_CLOSED
+                             ? cost + T->cost_matrix[kernel_idx_2d(last,
+                                                                   T->start,
+                                                                   n)]
+                             : cost;
+    if (total < B->best_cost) {
+      B->best_cost = total;
+      for (uint64_t p = 0; p < n; ++p) {
+        B->best_path[p] = B->path[p];
+      }
+    }
+    return;
+  }
+  if (++B->nodes > BRANCH_BOUND_MAX_NODES ||
+      deadline_reached(B->T->deadline) ||
+      cost + __one_tree_bound(B, last) >= B->best_cost) {
+    return;
+  }
+
+  // try the nearest unvisited points first to tighten the bound early; a
+  // fixed end may only be taken last
+  uint64_t tried[n];
+  for (uint64_t p = 0; p < n; ++p) {
+    tried[p] = B->visited[p];
+  }
+  if (T->type == TOUR_FIXED_ENDS && depth < n - 1) {
+    tried[T->end] = 1;
+  }
+  for (;;) {
+    const int next = __nearest_unvisited_point(T->cost_matrix, last, n, tried);
+    if (next < 0) {
+      break;
+    }
+    tried[next] = 1;
+
+    const double step = T->cost_matrix[kernel_idx_2d(last, (uint64_t)next, n)];
+    B->visited[next]  = 1;
+    B->path[depth]    = (uint64_t)next;
+    __branch(B, depth + 1, cost + step);
+    B->visited[next] = 0;
+  }
+}
+
+/**
+ * @brief   Finds the cheapest tour visiting every point exactly once by
+ *          branch-and-bound.
+ * @details Seeds the incumbent with the nearest neighbour ordering improved by
+ *          2-opt, then searches partial paths depth-first, discarding any
+ *          whose cost plus 1-tree lower bound cannot beat the incumbent. The
+ *          search is capped at `BRANCH_BOUND_MAX_NODES` nodes, and by the
+ *          limits of the instance, each node taking an iteration; once capped,
+ *          the best ordering found so far is kept.
+ *
+ * @param   T                 the instance
+ * @param   travel_order      filled with the indeces to travel, in order
+ *
+ * @return  whether the search finished, proving the ordering optimal
+ */
+static bool __branch_and_bound(const struct __tour * T,
+                               uint64_t              travel_order[])
+{
+  const uint64_t n = T->num_points;
+  __nearest_neighbour(T, travel_order);
+  __two_opt(T, travel_order);
+
+  struct __branch_bound B = {
+      .T         = T,
+      .target    = T->type == TOUR_OPEN
+                       ? n
+                       : T->type == TOUR_CLOSED ? T->start : T->end,
+      .visited   = Array.New.uint64_t_array(n),
+      .path      = Array.New.uint64_t_array(n),
+      .best_path = travel_order,
+      .best_cost = __tour_cost(T, travel_order),
+      .nodes     = 0,
+      .key       = Array.New.double_array(n),
+      .in_tree   = Array.New.uint64_t_array(n),
+  };
+
+  B.visited[T->start] = 1;
+  B.path[0]           = T->start;
+  __branch(&B, 1, 0);
+  Stats.count(STAT_BRANCH_BOUND_NODES, B.nodes);
+
+  free(B.visited);
+  free(B.path);
+  free(B.key);
+  free(B.in_tree);
+
+  return B.nodes <= BRANCH_BOUND_MAX_NODES && !T->deadline->reached;
+}
+
+/**
+ * @brief   Bounds the cost of every tour of an instance from below.
+ * @details Takes the 1-tree bound of the empty path at the start, as the
+ *          branch-and-bound search does: the cheapest edge out of the start,
+ *          the minimum spanning tree of the other points, and, if the tour
+ *          has a target, the cheapest edge into it. The tree is grown by
+ *          Prim's algorithm over a list of the points left out of it, which
+ *          shrinks as it grows.
+ *
+ * @param   T                 the instance
+ *
+ * @return  a lower bound on the cost of the optimal tour
+ */
+static double __lower_bound(const struct __tour * T)
+{
+  const double * C      = T->cost_matrix;
+  const uint64_t n      = T->num_points;
+  const uint64_t target = T->type == TOUR_OPEN
+                              ? n
+                              : T->type == TOUR_CLOSED ? T->start : T->end;
+  uint64_t *     rest   = Array.Scratch.uint64_t_array(n);
+  double *       key    = Array.Scratch.double_array(n);
+  double         enter  = INFINITY;
+  double         leave  = target < n ? INFINITY : 0;
+  double         bound  = 0;
+
+  uint64_t left = 0;
+  for (uint64_t p = 0; p < n; ++p) {
+    if (p != T->start && p != target) {
+      enter = fmin(enter, C[kernel_idx_2d(T->start, p, n)]);
+      if (target < n) {
+        leave = fmin(leave, C[kernel_idx_2d(p, target, n)]);
+      }
+      rest[left]  = p;
+      key[left++] = INFINITY;
+    }
+  }
+
+  if (!left) {
+    bound = target < n ? C[kernel_idx_2d(T->start, target, n)] : 0;
+  } else {
+    key[0] = 0;
+    while (left) {
+      uint64_t next = 0;
+      for (uint64_t i = 1; i < left; ++i) {
+        next = key[i] < key[next] ? i : next;
+      }
+
+      const double * row = C + kernel_idx_2d(rest[next], 0, n);
+      bound += key[next];
+      --left;
+      rest[next] = rest[left];
+      key[next]  = key[left];
+      for (uint64_t i = 0; i < left; ++i) {
+        key[i] = fmin(key[i], row[rest[i]]);
+      }
+    }
+    bound += enter + leave;
+  }
+
+  Array.release(rest);
+  Array.release(key);
+
+  return bound;
+}
+
+/**
+ * @brief   Measures a leg between two points without a cost matrix.
+ * @details A custom matrix metric is read directly when it was built for the
+ *          points, and measures euclidean distance otherwise.
+ *
+ * @param   points           set of points
+ * @param   num_points       number of points
+ * @param   dimension        dimension of the point vectors
+ * @param   metric           how distance between point vectors is measured
+ * @param   from             index of the point the leg leaves
+ * @param   to               index of the point the leg reaches
+ *
+ * @return  cost of the leg
+ */
+static double __leg_cost(const double *                points,
+                         const uint64_t                num_points,
+                         const uint64_t                dimension,
+                         const struct DistanceMetric * metric,
+                         const uint64_t                from,
+                         const uint64_t                to)
+{
+  if (metric->type == METRIC_MATRIX && metric->matrix &&
+      metric->size == num_points) {
+    return metric->matrix[kernel_idx_2d(from, to, num_points)];
+  }
+  return kernel_metric_distance(metric,
+                                points + kernel_idx_2d(from, 0, dimension),
+                                points + kernel_idx_2d(to, 0, dimension),
+                                dimension);
+}
+
+/**
+ * @brief   Improves a tour by 2-opt moves between points close in the order.
+ * @details Each leg is only tried against the `CURVE_TWO_OPT_WINDOW` legs
+ *          after it, so a pass takes time linear in the number of points. The
+ *          first point stays in place, and so does the last of a
+ *          `TOUR_FIXED_ENDS` tour; the tail of an open tour may be reversed,
+ *          and the return leg of a closed tour is tried like any other. Each
+ *          pass takes an iteration of the limits, and the clock is also
+ *          checked every `CURVE_DEADLINE_STRIDE` legs within a pass.
+ *
+ * @param   points           set of points travelled
+ * @param   num_points       number of points
+ * @param   dimension        dimension of the point vectors
+ * @param   metric           how distance between point vectors is measured
+ * @param   type             shape of the tour
+ * @param   deadline         limits on improving the tour
+ * @param   travel_order     the indeces to travel, in order
+ */
+static void __curve_two_opt(const double *                points,
+                            const uint64_t                num_points,
+                            const uint64_t                dimension,
+                            const struct DistanceMetric * metric,
+                            const enum TourType           type,
+                            struct Deadline *             deadline,
+                            uint64_t                      travel_order[])
+{
+  const uint64_t n   = num_points;
+  const uint64_t dim = dimension;
+  uint64_t *     o   = travel_order;
+  if (n < 3) {
+    return;
+  }
+
+  // last position a reversed stretch may end at
+  const uint64_t end = type == TOUR_FIXED_ENDS ? n - 2 : n - 1;
+
+  for (uint64_t pass = 0; pass < CURVE_TWO_OPT_MAX_PASSES; ++pass) {
+    if (deadline_reached(deadline)) {
+      break;
+    }
+    bool improved = false;
+    for (uint64_t i = 0; i + 2 <= end; ++i) {
+      if (!(i % CURVE_DEADLINE_STRIDE) && deadline_passed(deadline)) {
+        break;
+      }
+      const uint64_t last =
+          i + CURVE_TWO_OPT_WINDOW < end ? i + CURVE_TWO_OPT_WINDOW : end;
+      for (uint64_t j = i + 2; j <= last; ++j) {
+        // the stop following the stretch, if any
+        const bool     has_after = j + 1 < n || type == TOUR_CLOSED;
+        const uint64_t a         = o[i];
+        const uint64_t b         = o[i + 1];
+        const uint64_t c         = o[j];
+        const uint64_t d         = j + 1 < n ? o[j + 1] : o[0];
+
+        double before = __leg_cost(points, n, dim, metric, a, b);
+        double after  = __leg_cost(points, n, dim, metric, a, c);
+        if (has_after) {
+          before += __leg_cost(points, n, dim, metric, c, d);
+          after += __leg_cost(points, n, dim, metric, b, d);
+        }
+        if (after < before - IMPROVEMENT_EPSILON) {
+          for (uint64_t l = i + 1, r = j; l < r; ++l, --r) {
+            const uint64_t tmp = o[l];
+            o[l]               = o[r];
+            o[r]               = tmp;
+          }
+          improved = true;
+        }
+      }
+    }
+    Stats.count(STAT_TWO_OPT_PASSES, 1);
+    if (!improved) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief   Travels a set of points in their order along a Hilbert curve.
+ * @details The curve is taken as a cycle, rotated to begin at the start, and
+ *          the fixed end of a `TOUR_FIXED_ENDS` tour is moved to the back,
+ *          then improved by windowed 2-opt. Only the legs tried are measured,
+ *          so the tour takes `O(n log n)` time and linear memory.
+ *
+ * @param   points           set of points to travel
+ * @param   num_points       number of points
+ * @param   dimension        dimension of the point vectors
+ * @param   T                shape of the tour, and its start and end
+ * @param   metric           how distance between point vectors is measured
+ * @param   travel_order     filled with the indeces to travel, in order
+ *
+ * @return  cost of the tour
+ */
+static double __curve_tour(const double *                points,
+                           const uint64_t                num_points,
+                           const uint64_t                dimension,
+                           const struct __tour *         T,
+                           const struct DistanceMetric * metric,
+                           uint64_t                      travel_order[])
+{
+  uint64_t * curve = Array.Scratch.uint64_t_array(num_points);
+  Hilbert.order(points, num_points, dimension, curve);
+
+  uint64_t first = 0;
+  while (first < num_points && curve[first] != T->start) {
+    ++first;
+  }
+
+  uint64_t visited = 0;
+  for (uint64_t i = 0; i < num_points; ++i) {
+    const uint64_t point = curve[(first + i) % num_points];
+    if (T->type != TOUR_FIXED_ENDS || point != T->end) {
+      travel_order[visited++] = point;
+    }
+  }
+  if (visited < num_points) {
+    travel_order[visited++] = T->end;
+  }
+  Array.release(curve);
+
+  __curve_two_opt(points,
+                  num_points,
+                  dimension,
+                  metric,
+                  T->type,
+                  T->deadline,
+                  travel_order);
+
+  double cost = 0;
+  for (uint64_t i = 1; i < visited; ++i) {
+    cost += __leg_cost(points,
+                       num_points,
+                       dimension,
+                       metric,
+                       travel_order[i - 1],
+                       travel_order[i]);
+  }
+  if (T->type == TOUR_CLOSED && visited > 1) {
+    cost += __leg_cost(points,
+                       num_points,
+                       dimension,
+                       metric,
+                       travel_order[visited - 1],
+                       travel_order[0]);
+  }
+  return cost;
+}
+
+/**
+ * @brief   Solves the travelling salesman problem for a set of points.
+ * @details Creates a cost matrix for travelling between points, then picks a
+ *          solver by size: Held-Karp dynamic programming up to
+ *          `HELD_KARP_MAX_POINTS` points, which gives the optimal tour,
+ *          branch-and-bound up to `BRANCH_BOUND_MAX_POINTS` points, which
+ *          gives it only if its search finishes within
+ *          `BRANCH_BOUND_MAX_NODES` nodes, or travelling to the consequently
+ *          nearest points followed by 2-opt for anything larger. A precision
+ *          of 0 in the report marks a tour proven optimal. `TSP_HILBERT_CURVE`
+ *          instead travels the points in their order along a Hilbert curve,
+ *          measuring only the legs taken. Every solver honors the tour type.
+ *
+ *          Solving is anytime: once the deadline or iteration limit of the
+ *          options is reached, the best tour so far is kept. Held-Karp cut
+ *          short falls back to the nearest neighbour tour, and search and
+ *          2-opt keep the tour they had reached. The cost matrix and the first
+ *          tour are always built in full.
+ *
+ * @param   points           set of points to solve the TSP for
+ * @param   num_points       number of points
+ * @param   dimension        dimension of the point vectors
+ * @param   options          shape of the tour, its start and end, and limits
+ * @param   metric           how distance between point vectors is measured
+ * @param   cost             if not NULL, filled with the cost of the tour
+ * @param   report           if not NULL, filled with whether a limit stopped
+ *                           the solve, the improvements made, and the
+ *                           relative gap between the cost and a 1-tree lower
+ *                           bound: 0 for a tour proven optimal, and not a
+ *                           number along a Hilbert curve
+ *
+ * @return  a pointer to the indeces to travel, in order
+ */
+static uint64_t * solve(const double *                points,
+                        const uint64_t                num_points,
+                        const uint64_t                dimension,
+                        const struct TSPOptions *     options,
+                        const struct DistanceMetric * metric,
+                        double *                      cost,
+                        struct SolveReport *          report)
+{
+  uint64_t *      travel_order = Array.New.uint64_t_array(num_points);
+  struct Deadline deadline =
+      deadline_start(options->deadline_ms, options->max_iterations);
+
+  // a path that ends where it starts is a closed tour
+  struct __tour T = {NULL,
+                     num_points,
+                     options->type,
+                     options->start_index,
+                     options->end_index,
+                     &deadline};
+  if (T.type == TOUR_FIXED_ENDS && T.start == T.end) {
+    T.type = TOUR_CLOSED;
+  }
+  if (T.type != TOUR_FIXED_ENDS) {
+    T.end = num_points;
+  }
+
+  if (options->method == TSP_HILBERT_CURVE) {
+    const double curve_cost =
+        __curve_tour(points, num_points, dimension, &T, metric, travel_order);
+    if (cost) {
+      *cost = curve_cost;
+    }
+    if (report) {
+      report->partial    = deadline.reached;
+      report->precision  = NAN;
+      report->iterations = deadline.iterations;
+    }
+    return travel_order;
+  }
+
+  double * cost_matrix = Matrix.metric_cost_matrix(metric,
+                                                   (const double **)points,
+                                                   num_points,
+                                                   dimension);
+  T.cost_matrix        = cost_matrix;
+
+  bool optimal = true;
+  if (!num_points) {
+    // nothing to travel
+  } else if (num_points <= 3) {
+    __nearest_neighbour(&T, travel_order);
+  } else if (num_points <= HELD_KARP_MAX_POINTS) {
+    optimal = __held_karp(&T, travel_order);
+    if (optimal) {
+      Stats.count(STAT_HELD_KARP_SOLVES, 1);
+    } else {
+      __nearest_neighbour(&T, travel_order);
+    }
+  } else if (num_points <= BRANCH_BOUND_MAX_POINTS) {
+    optimal = __branch_and_bound(&T, travel_order);
+  } else {
+    __nearest_neighbour(&T, travel_order);
+    __two_opt(&T, travel_order);
+    optimal = false;
+  }
+
+  const double tour_cost = __tour_cost(&T, travel_order);
+  if (cost) {
+    *cost = tour_cost;
+  }
+  if (report) {
+    double gap = 0;
+    if (!optimal && tour_cost > 0) {
+      gap = fmax((tour_cost - __lower_bound(&T)) / tour_cost, 0);
+    }
+    report->partial    = deadline.reached;
+    report->precision  = gap;
+    report->iterations = deadline.iterations;
+  }
+
+  Array.release(cost_matrix);
 
   return travel_order;
 }
@@ -100,23 +1024,124 @@ static uint64_t * solve(const double * points,
  * @param   points           set of points to solve the TSP for
  * @param   num_points       number of points
  * @param   dimension        dimension of the point vectors
- * @param   start_index      point from which to find a solution to
- * @param   norm_degree      degree of the norm to use in calculating distance
- *                           between point vectors
+ * @param   options          shape of the tour, its start and end, and limits
+ * @param   metric           how distance between point vectors is measured
+ * @param   cost             if not NULL, filled with the cost of the tour
+ * @param   report           if not NULL, filled with how far the solve got
  *
  * @return  a pointer to the indeces to travel, in order
  */
-static uint64_t * __WRAPPER_solve(const double * points[],
-                                  uint64_t       num_points,
-                                  uint64_t       dimension,
-                                  uint64_t       start_index,
-                                  uint64_t       norm_degree)
+static uint64_t * __WRAPPER_solve(const double *                points[],
+                                  uint64_t                      num_points,
+                                  uint64_t                      dimension,
+                                  const struct TSPOptions *     options,
+                                  const struct DistanceMetric * metric,
+                                  double *                      cost,
+                                  struct SolveReport *          report)
 {
   return solve((const double *)points,
                num_points,
                dimension,
-               start_index,
-               norm_degree);
+               options,
+               metric,
+               cost,
+               report);
+}
+
+/**
+ * @struct
+ * @brief  A batch of point sets, packed one after another
+ *
+ * @prop   points    points of every set
+ * @prop   offsets   index of the first point of each set, followed by the total
+ *                   number of points
+ * @prop   dimension dimension of the point vectors
+ * @prop   options   shape of every tour, and its start and end
+ * @prop   metric    how distance between point vectors is measured
+ * @prop   orders    filled with the order of each tour
+ * @prop   costs     filled with the cost of each tour
+ */
+struct __batch
+{
+  const double *                points;
+  const uint64_t *              offsets;
+  uint64_t                      dimension;
+  const struct TSPOptions *     options;
+  const struct DistanceMetric * metric;
+  uint64_t *                    orders;
+  double *                      costs;
+};
+
+/**
+ * @brief   Solves the tours of a range of sets in a batch.
+ * @details Each set is held to the limits of the options on its own.
+ *
+ * @param   begin            first set of the range
+ * @param   end              one past the last set of the range
+ * @param   context          the batch
+ */
+static void __batch_task(const uint64_t begin,
+                         const uint64_t end,
+                         void *         context)
+{
+  const struct __batch * B = context;
+
+  for (uint64_t s = begin; s < end; ++s) {
+    const uint64_t first      = B->offsets[s];
+    const uint64_t num_points = B->offsets[s + 1] - first;
+
+    uint64_t * order = solve(B->points + kernel_idx_2d(first, 0, B->dimension),
+                             num_points,
+                             B->dimension,
+                             B->options,
+                             B->metric,
+                             B->costs + s,
+                             NULL);
+
+    for (uint64_t i = 0; i < num_points; ++i) {
+      B->orders[first + i] = order[i];
+    }
+    free(order);
+  }
+}
+
+/**
+ * @brief   Solves the travelling salesman problem for each of a batch of sets
+ *          of points.
+ * @details Set `s` is made of the points from `offsets[s]` up to
+ *          `offsets[s + 1]`, and its tour is written to the same range of
+ *          `orders`, as indeces into the set. Sets are spread across worker
+ *          threads, and each is solved as by `solve`. The start and end points
+ *          must lie in every set with any points.
+ *
+ * @param   points           points of every set, packed one set after another
+ * @param   offsets          index of the first point of each set, followed by
+ *                           the total number of points
+ * @param   num_sets         number of sets
+ * @param   dimension        dimension of the point vectors
+ * @param   options          shape of every tour, and its start and end
+ * @param   metric           how distance between point vectors is measured
+ * @param   orders           filled with the indeces to travel in each set
+ * @param   costs            filled with the cost of each tour
+ */
+static void solve_batch(const double *                points[],
+                        const uint64_t                offsets[],
+                        const uint64_t                num_sets,
+                        const uint64_t                dimension,
+                        const struct TSPOptions *     options,
+                        const struct DistanceMetric * metric,
+                        uint64_t                      orders[],
+                        double                        costs[])
+{
+  struct __batch batch = {(const double *)points,
+                          offsets,
+                          dimension,
+                          options,
+                          metric,
+                          orders,
+                          costs};
+  Parallel.for_range(0, num_sets, BATCH_GRAIN, __batch_task, &batch);
 }
 
-const struct travelling_salesman_problem TSP = {.solve = __WRAPPER_solve};
+const struct travelling_salesman_problem TSP = {.solve       = __WRAPPER_solve,
+                                                .solve_batch = solve_batch};
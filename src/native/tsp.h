@@ -1,15 +1,138 @@
 #ifndef TSP_H
 #define TSP_H
 
+#include "toolkit/deadline.h"
+#include "toolkit/metric.h"
+
 #include <stdint.h>
 
+/**
+ * @enum
+ * @brief  Shape of a tour
+ *
+ * @prop   TOUR_OPEN       starts at a fixed point and ends anywhere
+ * @prop   TOUR_CLOSED     starts at a fixed point and returns to it
+ * @prop   TOUR_FIXED_ENDS starts and ends at fixed points
+ */
+enum TourType
+{
+  TOUR_OPEN,
+  TOUR_CLOSED,
+  TOUR_FIXED_ENDS
+};
+
+/**
+ * @enum
+ * @brief  How a tour is constructed
+ *
+ * @prop   TSP_BY_SIZE       the solver picked by the size of the instance
+ * @prop   TSP_HILBERT_CURVE the order of the points along a Hilbert curve, in
+ *                           `O(n log n)` and without a cost matrix, typically
+ *                           within 25% of the optimal tour
+ */
+enum TSPMethod
+{
+  TSP_BY_SIZE,
+  TSP_HILBERT_CURVE
+};
+
+/**
+ * @struct
+ * @brief  Options for the shape of a tour
+ *
+ * @prop   type           shape of the tour
+ * @prop   start_index    point from which to start the tour
+ * @prop   end_index      point at which to end the tour, for `TOUR_FIXED_ENDS`
+ * @prop   method         how the tour is constructed
+ * @prop   deadline_ms    milliseconds to improve the tour before settling for
+ *                        the best one so far, or 0 for no limit
+ * @prop   max_iterations improvements to make before settling for the best
+ *                        tour so far, or 0 for no limit; layers of Held-Karp,
+ *                        nodes of branch-and-bound, and passes of 2-opt each
+ *                        count as one
+ */
+struct TSPOptions
+{
+  const enum TourType  type;
+  const uint64_t       start_index;
+  const uint64_t       end_index;
+  const enum TSPMethod method;
+  const double         deadline_ms;
+  const uint64_t       max_iterations;
+};
+
 struct travelling_salesman_problem
 {
-  uint64_t * (*solve)(const double * points[],
-                      uint64_t       num_points,
-                      uint64_t       dimension,
-                      uint64_t       start_index,
-                      uint64_t       norm_degree);
+  /**
+   * @brief   Solves the travelling salesman problem for a set of points.
+   * @details Creates a cost matrix for travelling between points, then picks a
+   *          solver by size: Held-Karp dynamic programming up to 20 points,
+   *          which gives the optimal tour, branch-and-bound up to 40 points,
+   *          which gives it only if its search finishes within a cap on the
+   *          nodes it visits, or travelling to the consequently nearest points
+   *          followed by 2-opt for anything larger. A precision of 0 in the
+   *          report marks a tour proven optimal. `TSP_HILBERT_CURVE` instead
+   *          travels the points in their order along a Hilbert curve,
+   *          measuring only the legs taken. Every solver honors the tour type.
+   *
+   *          Solving is anytime: once the deadline or iteration limit of the
+   *          options is reached, the best tour so far is kept. An exact solver
+   *          cut short falls back to the nearest neighbour tour, and search
+   *          and 2-opt keep the tour they had reached. The cost matrix and the
+   *          first tour are always built in full.
+   *
+   * @param   points           set of points to solve the TSP for
+   * @param   num_points       number of points
+   * @param   dimension        dimension of the point vectors
+   * @param   options          shape of the tour, its start and end, and limits
+   * @param   metric           how distance between point vectors is measured
+   * @param   cost             if not NULL, filled with the cost of the tour,
+   *                           including the return leg of closed tours
+   * @param   report           if not NULL, filled with whether a limit stopped
+   *                           the solve, the improvements made, and as its
+   *                           precision the relative gap between the cost and
+   *                           a 1-tree lower bound: 0 for a tour proven
+   *                           optimal, and not a number along a Hilbert curve
+   *
+   * @return  a pointer to the indeces to travel, in order
+   */
+  uint64_t * (*solve)(const double *                points[],
+                      uint64_t                      num_points,
+                      uint64_t                      dimension,
+                      const struct TSPOptions *     options,
+                      const struct DistanceMetric * metric,
+                      double *                      cost,
+                      struct SolveReport *          report);
+
+  /**
+   * @brief   Solves the travelling salesman problem for each of a batch of
+   *          sets of points.
+   * @details Set `s` is made of the points from `offsets[s]` up to
+   *          `offsets[s + 1]`, and its tour is written to the same range of
+   *          `orders`, as indeces into the set. Sets are spread across worker
+   *          threads, and each is solved as by `solve`. The start and end
+   *          points must lie in every set with any points, and each set is
+   *          held to the limits of the options on its own.
+   *
+   * @param   points           points of every set, packed one set after
+   *                           another
+   * @param   offsets          index of the first point of each set, followed
+   *                           by the total number of points
+   * @param   num_sets         number of sets
+   * @param   dimension        dimension of the point vectors
+   * @param   options          shape of every tour, and its start and end
+   * @param   metric           how distance between point vectors is measured
+   * @param   orders           filled with the indeces to travel in each set
+   * @param   costs            filled with the cost of each tour
+   */
+  void (*solve_batch)(const double *                points[],
+                      const uint64_t                offsets[],
+                      uint64_t                      num_sets,
+                      uint64_t                      dimension,
+                      const struct TSPOptions *     options,
+                      const struct DistanceMetric * metric,
+                      uint64_t                      orders[],
+                      double                        costs[]);
 };
 
 extern const struct travelling_salesman_problem TSP;
@@ -0,0 +1,919 @@
+#include "vrp.h"
+
+#include "toolkit/array.h"
+#include "toolkit/kernel.h"
+#include "toolkit/matrix.h"
+#include "toolkit/parallel.h"
+#include "toolkit/stats.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Smallest decrease in cost accepted as an improvement by local search.
+ */
+static const double IMPROVEMENT_EPSILON = 1e-9;
+
+/**
+ * Rounds of inter-route local search performed before settling.
+ */
+static const uint64_t LOCAL_SEARCH_MAX_ROUNDS = 1000;
+
+/**
+ * Minimum number of stops whose savings are computed per thread.
+ */
+static const uint64_t SAVINGS_GRAIN = 32;
+
+enum MOVE
+{
+  MOVE_NONE,
+  MOVE_RELOCATE,
+  MOVE_SWAP,
+  MOVE_TWO_OPT_STAR
+};
+
+/**
+ * @struct
+ * @brief  The saving of joining two stops into the same route
+ *
+ * @prop   value  travel saved by visiting `i` and `j` consecutively instead of
+ *                returning to the depot in between
+ * @prop   i      first stop
+ * @prop   j      second stop
+ */
+struct __saving
+{
+  double   value;
+  uint64_t i;
+  uint64_t j;
+};
+
+/**
+ * @struct
+ * @brief  A vehicle's route, bracketed by the depot
+ *
+ * @prop   seq      the depot, followed by `len` stops, followed by the depot
+ * @prop   len      number of stops
+ * @prop   load     total demand of the stops
+ * @prop   capacity capacity of the vehicle
+ */
+struct __route
+{
+  uint64_t * seq;
+  uint64_t   len;
+  double     load;
+  double     capacity;
+};
+
+/**
+ * @struct
+ * @brief  A local search move between two routes
+ *
+ * @prop   type   kind of move
+ * @prop   a      first route
+ * @prop   b      second route
+ * @prop   i      position in `a` the move applies to
+ * @prop   j      position in `b` the move applies to
+ * @prop   delta  change in total cost
+ */
+struct __move
+{
+  enum MOVE type;
+  uint64_t  a;
+  uint64_t  b;
+  uint64_t  i;
+  uint64_t  j;
+  double    delta;
+};
+
+/**
+ * @struct
+ * @brief  Routes under construction, as doubly-linked chains of stops
+ *
+ * @prop   next     successor of each stop, or `none`
+ * @prop   prev     predecessor of each stop, or `none`
+ * @prop   head     first stop of each route
+ * @prop   tail     last stop of each route
+ * @prop   route_of route id of each stop
+ * @prop   size     number of stops of each route; 0 once merged away
+ * @prop   load     total demand of each route
+ * @prop   count    number of routes
+ * @prop   none     sentinel for a missing successor or predecessor
+ */
+struct __chains
+{
+  uint64_t * next;
+  uint64_t * prev;
+  uint64_t * head;
+  uint64_t * tail;
+  uint64_t * route_of;
+  uint64_t * size;
+  double *   load;
+  uint64_t   count;
+  uint64_t   none;
+};
+
+/**
+ * @struct
+ * @brief  State shared by threads computing the savings list
+ *
+ * @prop   cost_matrix distances among the points
+ * @prop   num_points  number of points
+ * @prop   depot       index of the depot
+ * @prop   stops       indeces of all points but the depot
+ * @prop   num_stops   number of stops
+ * @prop   savings     savings of every pair of stops, row by row
+ */
+struct __savings_task
+{
+  const double *    cost_matrix;
+  uint64_t          num_points;
+  uint64_t          depot;
+  const uint64_t *  stops;
+  uint64_t          num_stops;
+  struct __saving * savings;
+};
+
+/**
+ * @struct
+ * @brief  State shared by threads evaluating local search moves
+ *
+ * @prop   cost_matrix distances among the points
+ * @prop   num_points  number of points
+ * @prop   demands     demand of each point
+ * @prop   routes      routes of every vehicle
+ * @prop   num_routes  number of routes
+ * @prop   best        best move found starting from each route
+ */
+struct __search_task
+{
+  const double *   cost_matrix;
+  uint64_t         num_points;
+  const double *   demands;
+  struct __route * routes;
+  uint64_t         num_routes;
+  struct __move *  best;
+};
+
+/**
+ * @brief   Orders savings from largest to smallest, breaking ties by stop.
+ */
+static int __compare_savings(const void * lhs, const void * rhs)
+{
+  const struct __saving * a = lhs;
+  const struct __saving * b = rhs;
+  if (a->value < b->value) {
+    return 1;
+  }
+  if (a->value > b->value) {
+    return -1;
+  }
+  if (a->i != b->i) {
+    return a->i < b->i ? -1 : 1;
+  }
+  return a->j < b->j ? -1 : (a->j > b->j);
+}
+
+/**
+ * @brief   Computes the savings of a range of rows of stop pairs.
+ * @details The saving of joining stops `i` and `j` is
+ *            s(i, j) = c(depot, i) + c(depot, j) - c(i, j).
+ *          Row `a` holds the pairs `(a, b)` for every `b > a`.
+ *
+ * @param   begin             first row
+ * @param   end               one past the last row
+ * @param   context           the savings being computed
+ */
+static void __savings_rows(const uint64_t begin,
+                           const uint64_t end,
+                           void *         context)
+{
+  const struct __savings_task * T = context;
+  const uint64_t                m = T->num_stops;
+  const uint64_t                n = T->num_points;
+
+  for (uint64_t a = begin; a < end; ++a) {
+    const uint64_t    i    = T->stops[a];
+    const double      c_di = T->cost_matrix[kernel_idx_2d(T->depot, i, n)];
+    struct __saving * row  = T->savings + a * m - a * (a + 1) / 2;
+
+    for (uint64_t b = a + 1; b < m; ++b) {
+      const uint64_t j = T->stops[b];
+      row[b - a - 1]   = (struct __saving){
+          c_di + T->cost_matrix[kernel_idx_2d(T->depot, j, n)] -
+              T->cost_matrix[kernel_idx_2d(i, j, n)],
+          i,
+          j};
+    }
+  }
+}
+
+/**
+ * @brief   Reverses a route of the savings construction in place.
+ *
+ * @param   R                 routes under construction
+ * @param   r                 id of the route to reverse
+ */
+static void __reverse_chain(struct __chains * R, const uint64_t r)
+{
+  for (uint64_t s = R->head[r]; s != R->none;) {
+    const uint64_t following = R->next[s];
+    R->next[s]               = R->prev[s];
+    R->prev[s]               = following;
+    s                        = following;
+  }
+  const uint64_t first = R->head[r];
+  R->head[r]           = R->tail[r];
+  R->tail[r]           = first;
+}
+
+/**
+ * @brief   Merges routes along a list of savings (Clarke-Wright).
+ * @details Walks the savings in order; whenever the two stops of a saving end
+ *          different routes and the joined route fits in the largest vehicle,
+ *          the routes are joined through that pair. Stops of the smaller route
+ *          are relabelled to the larger one, keeping relabelling `O(n log n)`.
+ *
+ * @param   R                 routes under construction
+ * @param   savings           savings, largest first
+ * @param   num_savings       number of savings
+ * @param   max_capacity      capacity of the largest vehicle
+ * @param   target_routes     stop merging once this many routes remain
+ * @param   allow_negative    whether to take savings that increase cost
+ */
+static void __merge_routes(struct __chains *       R,
+                           const struct __saving * savings,
+                           const uint64_t          num_savings,
+                           const double            max_capacity,
+                           const uint64_t          target_routes,
+                           const bool              allow_negative)
+{
+  for (uint64_t s = 0; s < num_savings && R->count > target_routes; ++s) {
+    if (!allow_negative && savings[s].value <= 0) {
+      break;
+    }
+
+    const uint64_t i  = savings[s].i;
+    const uint64_t j  = savings[s].j;
+    const uint64_t ri = R->route_of[i];
+    const uint64_t rj = R->route_of[j];
+
+    if (ri == rj || R->load[ri] + R->load[rj] > max_capacity) {
+      continue;
+    }
+    if ((R->head[ri] != i && R->tail[ri] != i) ||
+        (R->head[rj] != j && R->tail[rj] != j)) {
+      continue;  // interior stops cannot be joined
+    }
+
+    // orient the routes as ri -> i, j -> rj
+    if (R->tail[ri] != i) {
+      __reverse_chain(R, ri);
+    }
+    if (R->head[rj] != j) {
+      __reverse_chain(R, rj);
+    }
+    R->next[i] = j;
+    R->prev[j] = i;
+
+    const uint64_t keep = R->size[ri] >= R->size[rj] ? ri : rj;
+    const uint64_t drop = keep == ri ? rj : ri;
+    for (uint64_t p = R->head[drop]; p != R->none; p = R->next[p]) {
+      if (R->route_of[p] != drop) {
+        break;
+      }
+      R->route_of[p] = keep;
+    }
+    R->head[keep] = R->head[ri];
+    R->tail[keep] = R->tail[rj];
+    R->size[keep] += R->size[drop];
+    R->load[keep] += R->load[drop];
+    R->size[drop] = 0;
+    R->load[drop] = 0;
+    --R->count;
+  }
+}
+
+/**
+ * @brief   Calculates the travel cost of a route, including the depot legs.
+ *
+ * @param   route             the route
+ * @param   cost_matrix       distances among the points
+ * @param   num_points        number of points
+ *
+ * @return  cost of the route
+ */
+static double __route_cost(const struct __route * route,
+                           const double *         cost_matrix,
+                           const uint64_t         num_points)
+{
+  if (!route->len) {
+    return 0;
+  }
+  double cost = 0;
+  for (uint64_t k = 0; k <= route->len; ++k) {
+    cost += cost_matrix[kernel_idx_2d(route->seq[k],
+                                      route->seq[k + 1],
+                                      num_points)];
+  }
+  return cost;
+}
+
+/**
+ * @brief   Inserts a stop into the cheapest position of any route with room.
+ *
+ * @param   stop              the stop to insert
+ * @param   routes            routes of every vehicle
+ * @param   num_routes        number of routes
+ * @param   cost_matrix       distances among the points
+ * @param   num_points        number of points
+ * @param   demands           demand of each point
+ *
+ * @return  whether the stop was inserted
+ */
+static bool __insert_cheapest(const uint64_t   stop,
+                              struct __route * routes,
+                              const uint64_t   num_routes,
+                              const double *   cost_matrix,
+                              const uint64_t   num_points,
+                              const double *   demands)
+{
+  uint64_t best_r = num_routes;
+  uint64_t best_k = 0;
+  double   best   = INFINITY;
+
+  for (uint64_t r = 0; r < num_routes; ++r) {
+    if (routes[r].load + demands[stop] > routes[r].capacity) {
+      continue;
+    }
+    for (uint64_t k = 0; k <= routes[r].len; ++k) {
+      const uint64_t u     = routes[r].seq[k];
+      const uint64_t v     = routes[r].seq[k + 1];
+      const double   extra = cost_matrix[kernel_idx_2d(u, stop, num_points)] +
+                           cost_matrix[kernel_idx_2d(stop, v, num_points)] -
+                           cost_matrix[kernel_idx_2d(u, v, num_points)];
+      if (extra < best) {
+        best   = extra;
+        best_r = r;
+        best_k = k;
+      }
+    }
+  }
+
+  if (best_r == num_routes) {
+    return false;
+  }
+
+  struct __route * route = &routes[best_r];
+  memmove(route->seq + best_k + 2,
+          route->seq + best_k + 1,
+          (route->len - best_k + 1) * sizeof(uint64_t));
+  route->seq[best_k + 1] = stop;
+  route->len += 1;
+  route->load += demands[stop];
+  return true;
+}
+
+/**
+ * @brief   Finds the best move from route `a` into each other route.
+ * @details Evaluates, for every other route `b`:
+ *            relocate  - moving one stop of `a` anywhere into `b`,
+ *            swap      - exchanging one stop of `a` with one of `b`,
+ *            2-opt*    - exchanging the tails of `a` and `b`,
+ *          keeping only moves that respect both vehicles' capacities.
+ *
+ * @param   begin             first route `a`
+ * @param   end               one past the last route `a`
+ * @param   context           the routes being searched
+ */
+static void __search_routes(const uint64_t begin,
+                            const uint64_t end,
+                            void *         context)
+{
+  const struct __search_task * T = context;
+  const uint64_t               n = T->num_points;
+  const double *               C = T->cost_matrix;
+  const double *               D = T->demands;
+
+#define __COST(u, v) C[kernel_idx_2d((u), (v), n)]
+
+  for (uint64_t a = begin; a < end; ++a) {
+    const struct __route * A    = &T->routes[a];
+    struct __move          best = {MOVE_NONE, a, a, 0, 0, -IMPROVEMENT_EPSILON};
+
+    for (uint64_t b = 0; b < T->num_routes; ++b) {
+      const struct __route * B = &T->routes[b];
+      if (a == b) {
+        continue;
+      }
+
+      // relocate A[i] between B[j] and B[j + 1]
+      for (uint64_t i = 1; i <= A->len; ++i) {
+        const uint64_t u = A->seq[i];
+        if (B->load + D[u] > B->capacity) {
+          continue;
+        }
+        const double removed = __COST(A->seq[i - 1], u) +
+                               __COST(u, A->seq[i + 1]) -
+                               __COST(A->seq[i - 1], A->seq[i + 1]);
+        for (uint64_t j = 0; j <= B->len; ++j) {
+          const double delta = __COST(B->seq[j], u) +
+                               __COST(u, B->seq[j + 1]) -
+                               __COST(B->seq[j], B->seq[j + 1]) - removed;
+          if (delta < best.delta) {
+            best = (struct __move){MOVE_RELOCATE, a, b, i, j, delta};
+          }
+        }
+      }
+
+      if (b < a) {
+        continue;  // symmetric moves are evaluated once per pair
+      }
+
+      // swap A[i] and B[j]
+      for (uint64_t i = 1; i <= A->len; ++i) {
+        const uint64_t u  = A->seq[i];
+        const uint64_t ap = A->seq[i - 1];
+        const uint64_t an = A->seq[i + 1];
+        for (uint64_t j = 1; j <= B->len; ++j) {
+          const uint64_t v = B->seq[j];
+          if (A->load - D[u] + D[v] > A->capacity ||
+              B->load - D[v] + D[u] > B->capacity) {
+            continue;
+          }
+          const uint64_t bp    = B->seq[j - 1];
+          const uint64_t bn    = B->seq[j + 1];
+          const double   delta = __COST(ap, v) + __COST(v, an) -
+                               __COST(ap, u) - __COST(u, an) +
+                               __COST(bp, u) + __COST(u, bn) -
+                               __COST(bp, v) - __COST(v, bn);
+          if (delta < best.delta) {
+            best = (struct __move){MOVE_SWAP, a, b, i, j, delta};
+          }
+        }
+      }
+
+      // 2-opt*: A[0..i] + B[j+1..] and B[0..j] + A[i+1..]
+      double prefix_a = 0;
+      for (uint64_t i = 0; i <= A->len; ++i) {
+        if (i) {
+          prefix_a += D[A->seq[i]];
+        }
+        double prefix_b = 0;
+        for (uint64_t j = 0; j <= B->len; ++j) {
+          if (j) {
+            prefix_b += D[B->seq[j]];
+          }
+          if (prefix_a + B->load - prefix_b > A->capacity ||
+              prefix_b + A->load - prefix_a > B->capacity) {
+            continue;
+          }
+          const double delta = __COST(A->seq[i], B->seq[j + 1]) +
+                               __COST(B->seq[j], A->seq[i + 1]) -
+                               __COST(A->seq[i], A->seq[i + 1]) -
+                               __COST(B->seq[j], B->seq[j + 1]);
+          if (delta < best.delta) {
+            best = (struct __move){MOVE_TWO_OPT_STAR, a, b, i, j, delta};
+          }
+        }
+      }
+    }
+
+    T->best[a] = best;
+  }
+
+#undef __COST
+}
+
+/**
+ * @brief   Applies a local search move to its two routes.
+ *
+ * @param   move              the move to apply
+ * @param   routes            routes of every vehicle
+ * @param   demands           demand of each point
+ * @param   scratch           buffer with room for any route
+ */
+static void __apply_move(const struct __move * move,
+                         struct __route *      routes,
+                         const double *        demands,
+                         uint64_t              scratch[])
+{
+  struct __route * A = &routes[move->a];
+  struct __route * B = &routes[move->b];
+  const uint64_t   i = move->i;
+  const uint64_t   j = move->j;
+
+  switch (move->type) {
+    case MOVE_RELOCATE: {
+      const uint64_t u = A->seq[i];
+      memmove(A->seq + i, A->seq + i + 1, (A->len - i + 1) * sizeof(uint64_t));
+      A->len -= 1;
+      A->load -= demands[u];
+      memmove(B->seq + j + 2,
+              B->seq + j + 1,
+              (B->len - j + 1) * sizeof(uint64_t));
+      B->seq[j + 1] = u;
+      B->len += 1;
+      B->load += demands[u];
+      break;
+    }
+    case MOVE_SWAP: {
+      const uint64_t u = A->seq[i];
+      const uint64_t v = B->seq[j];
+      A->seq[i]        = v;
+      B->seq[j]        = u;
+      A->load += demands[v] - demands[u];
+      B->load += demands[u] - demands[v];
+      break;
+    }
+    case MOVE_TWO_OPT_STAR: {
+      const uint64_t tail_a = A->len - i;  // stops after A[i]
+      const uint64_t tail_b = B->len - j;  // stops after B[j]
+      memcpy(scratch, A->seq + i + 1, (tail_a + 1) * sizeof(uint64_t));
+      memcpy(A->seq + i + 1, B->seq + j + 1, (tail_b + 1) * sizeof(uint64_t));
+      memcpy(B->seq + j + 1, scratch, (tail_a + 1) * sizeof(uint64_t));
+      A->len = i + tail_b;
+      B->len = j + tail_a;
+
+      A->load = 0;
+      B->load = 0;
+      for (uint64_t k = 1; k <= A->len; ++k) {
+        A->load += demands[A->seq[k]];
+      }
+      for (uint64_t k = 1; k <= B->len; ++k) {
+        B->load += demands[B->seq[k]];
+      }
+      break;
+    }
+    case MOVE_NONE:
+      break;
+  }
+}
+
+/**
+ * @brief   Orders moves from most to least improving.
+ */
+static int __compare_moves(const void * lhs, const void * rhs)
+{
+  const struct __move * a = lhs;
+  const struct __move * b = rhs;
+  if (a->delta < b->delta) {
+    return -1;
+  }
+  return a->delta > b->delta;
+}
+
+/**
+ * @brief   Improves each route in a range with 2-opt.
+ * @details Reverses any stretch of stops whose reversal shortens the route,
+ *          until no such stretch remains. Loads are unaffected.
+ *
+ * @param   begin             first route
+ * @param   end               one past the last route
+ * @param   context           the routes being improved
+ */
+static void __two_opt_routes(const uint64_t begin,
+                             const uint64_t end,
+                             void *         context)
+{
+  const struct __search_task * T = context;
+  const uint64_t               n = T->num_points;
+  const double *               C = T->cost_matrix;
+
+  for (uint64_t r = begin; r < end; ++r) {
+    uint64_t *     s        = T->routes[r].seq;
+    const uint64_t len      = T->routes[r].len;
+    bool           improved = true;
+
+    while (improved) {
+      improved = false;
+      for (uint64_t i = 1; i < len; ++i) {
+        for (uint64_t k = i + 1; k <= len; ++k) {
+          const double delta = C[kernel_idx_2d(s[i - 1], s[k], n)] +
+                               C[kernel_idx_2d(s[i], s[k + 1], n)] -
+                               C[kernel_idx_2d(s[i - 1], s[i], n)] -
+                               C[kernel_idx_2d(s[k], s[k + 1], n)];
+          if (delta < -IMPROVEMENT_EPSILON) {
+            for (uint64_t lo = i, hi = k; lo < hi; ++lo, --hi) {
+              const uint64_t swap = s[lo];
+              s[lo]               = s[hi];
+              s[hi]               = swap;
+            }
+            improved = true;
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Builds routes with the Clarke-Wright savings heuristic and assigns
+ *          them to vehicles.
+ * @details Merges routes along positive savings first, then along any saving
+ *          while there are more routes than vehicles. The heaviest routes go to
+ *          the largest vehicles; stops that still do not fit are trimmed from
+ *          the end of their route and reinserted wherever capacity allows.
+ *
+ * @param   cost_matrix       distances among the points
+ * @param   num_points        number of points
+ * @param   fleet             vehicles, capacities, demands, and depot
+ * @param   routes            filled with the route of each vehicle
+ * @param   unserved          filled with the stops that fit no vehicle
+ * @param   num_unserved      filled with the number of unserved stops
+ */
+static void __clarke_wright(const double *          cost_matrix,
+                            const uint64_t          num_points,
+                            const struct VRPFleet * fleet,
+                            struct __route *        routes,
+                            uint64_t                unserved[],
+                            uint64_t *              num_unserved)
+{
+  const uint64_t n        = num_points;
+  const uint64_t m        = n - 1;
+  const uint64_t vehicles = fleet->num_vehicles;
+  const double * demands  = fleet->demands;
+
+  double max_capacity = 0;
+  for (uint64_t v = 0; v < vehicles; ++v) {
+    if (fleet->capacities[v] > max_capacity) {
+      max_capacity = fleet->capacities[v];
+    }
+  }
+
+  // one route per stop
+  uint64_t *      stops = Array.New.uint64_t_array(m);
+  struct __chains R     = {
+      .next     = Array.New.uint64_t_array(n),
+      .prev     = Array.New.uint64_t_array(n),
+      .head     = Array.New.uint64_t_array(n),
+      .tail     = Array.New.uint64_t_array(n),
+      .route_of = Array.New.uint64_t_array(n),
+      .size     = Array.New.uint64_t_array(n),
+      .load     = Array.New.double_array(n),
+      .count    = m,
+      .none     = n,
+  };
+  for (uint64_t p = 0, k = 0; p < n; ++p) {
+    R.next[p] = R.prev[p] = R.none;
+    R.head[p] = R.tail[p] = R.route_of[p] = p;
+    if (p != fleet->depot) {
+      stops[k++] = p;
+      R.size[p]  = 1;
+      R.load[p]  = demands[p];
+    }
+  }
+
+  // savings of every pair of stops, largest first
+  const uint64_t        num_savings = m * (m - 1) / 2;
+  struct __saving *     savings     = malloc(num_savings * sizeof *savings);
+  struct __savings_task task        = {cost_matrix,
+                                n,
+                                fleet->depot,
+                                stops,
+                                m,
+                                savings};
+  Parallel.for_range(0, m, SAVINGS_GRAIN, __savings_rows, &task);
+  qsort(savings, num_savings, sizeof *savings, __compare_savings);
+
+  __merge_routes(&R, savings, num_savings, max_capacity, 0, false);
+  __merge_routes(&R, savings, num_savings, max_capacity, vehicles, true);
+  free(savings);
+
+  // match the heaviest routes to the largest vehicles
+  uint64_t * by_load     = Array.New.uint64_t_array(R.count);
+  uint64_t * by_capacity = Array.New.uint64_t_array(vehicles);
+  for (uint64_t p = 0, k = 0; p < n; ++p) {
+    if (R.size[p]) {
+      by_load[k++] = p;
+    }
+  }
+  for (uint64_t v = 0; v < vehicles; ++v) {
+    by_capacity[v] = v;
+  }
+  for (uint64_t x = 1; x < R.count; ++x) {  // insertion sort, descending
+    for (uint64_t y = x; y > 0 && R.load[by_load[y]] > R.load[by_load[y - 1]];
+         --y) {
+      const uint64_t swap = by_load[y];
+      by_load[y]          = by_load[y - 1];
+      by_load[y - 1]      = swap;
+    }
+  }
+  for (uint64_t x = 1; x < vehicles; ++x) {
+    for (uint64_t y = x; y > 0 && fleet->capacities[by_capacity[y]] >
+                                      fleet->capacities[by_capacity[y - 1]];
+         --y) {
+      const uint64_t swap = by_capacity[y];
+      by_capacity[y]      = by_capacity[y - 1];
+      by_capacity[y - 1]  = swap;
+    }
+  }
+
+  *num_unserved = 0;
+  for (uint64_t k = 0; k < R.count; ++k) {
+    const uint64_t r = by_load[k];
+    if (k >= vehicles) {  // more routes than vehicles
+      for (uint64_t p = R.head[r]; p != R.none; p = R.next[p]) {
+        unserved[(*num_unserved)++] = p;
+      }
+      continue;
+    }
+
+    struct __route * route = &routes[by_capacity[k]];
+    for (uint64_t p = R.head[r]; p != R.none; p = R.next[p]) {
+      route->seq[++route->len] = p;
+      route->load += demands[p];
+    }
+    while (route->len && route->load > route->capacity) {
+      const uint64_t p = route->seq[route->len--];
+      route->load -= demands[p];
+      unserved[(*num_unserved)++] = p;
+    }
+    route->seq[route->len + 1] = fleet->depot;
+  }
+
+  // give trimmed stops another chance wherever there is room
+  uint64_t still_unserved = 0;
+  for (uint64_t k = 0; k < *num_unserved; ++k) {
+    if (!__insert_cheapest(unserved[k],
+                           routes,
+                           vehicles,
+                           cost_matrix,
+                           n,
+                           demands)) {
+      unserved[still_unserved++] = unserved[k];
+    }
+  }
+  *num_unserved = still_unserved;
+
+  free(stops);
+  free(R.next);
+  free(R.prev);
+  free(R.head);
+  free(R.tail);
+  free(R.route_of);
+  free(R.size);
+  free(R.load);
+  free(by_load);
+  free(by_capacity);
+}
+
+/**
+ * @brief   Solves the capacitated vehicle routing problem for a set of points.
+ * @details Creates a cost matrix for travelling between points, then builds
+ *          routes with the Clarke-Wright savings heuristic: starting from one
+ *          route per stop, the routes whose joining saves the most travel are
+ *          merged while capacity allows. Routes are matched to vehicles by
+ *          load, and then improved by inter-route local search (relocate,
+ *          swap, and 2-opt*), evaluated in parallel, followed by a 2-opt pass
+ *          over each route.
+ *
+ * @param   points           set of points to route
+ * @param   num_points       number of points, including the depot
+ * @param   dimension        dimension of the point vectors
+ * @param   fleet            vehicles, capacities, demands, and depot
+ * @param   metric           how distance between point vectors is measured
+ *
+ * @return  the routes of each vehicle; every stop is unserved when there are
+ *          no vehicles or the depot is not one of the points
+ */
+static struct VRPSolution solve(const double *                points,
+                                const uint64_t                num_points,
+                                const uint64_t                dimension,
+                                const struct VRPFleet *       fleet,
+                                const struct DistanceMetric * metric)
+{
+  const uint64_t     n        = num_points;
+  const uint64_t     vehicles = fleet->num_vehicles;
+  struct VRPSolution solution = {
+      .route_offsets = Array.New.uint64_t_array(vehicles + 1),
+      .stops         = Array.New.uint64_t_array(n ? n : 1),
+      .unserved      = Array.New.uint64_t_array(n ? n : 1),
+      .num_unserved  = 0,
+      .cost          = 0,
+  };
+
+  if (n <= 1) {
+    return solution;
+  }
+  if (!vehicles || fleet->depot >= n) {
+    for (uint64_t p = 0; p < n; ++p) {
+      if (p != fleet->depot) {
+        solution.unserved[solution.num_unserved++] = p;
+      }
+    }
+    return solution;
+  }
+
+  double *         cost_matrix = Matrix.metric_cost_matrix(metric,
+                                                   (const double **)points,
+                                                   n,
+                                                   dimension);
+  struct __route * routes      = malloc(vehicles * sizeof *routes);
+  for (uint64_t v = 0; v < vehicles; ++v) {
+    routes[v] = (struct __route){Array.New.uint64_t_array(n + 1),
+                                 0,
+                                 0,
+                                 fleet->capacities[v]};
+    routes[v].seq[0] = fleet->depot;
+    routes[v].seq[1] = fleet->depot;
+  }
+
+  __clarke_wright(cost_matrix,
+                  n,
+                  fleet,
+                  routes,
+                  solution.unserved,
+                  &solution.num_unserved);
+
+  // inter-route local search, applying non-overlapping moves each round
+  struct __move *      best    = malloc(vehicles * sizeof *best);
+  uint64_t *           touched = Array.New.uint64_t_array(vehicles);
+  uint64_t *           scratch = Array.New.uint64_t_array(n + 1);
+  struct __search_task task    = {cost_matrix,
+                               n,
+                               fleet->demands,
+                               routes,
+                               vehicles,
+                               best};
+  for (uint64_t round = 0; round < LOCAL_SEARCH_MAX_ROUNDS; ++round) {
+    Stats.count(STAT_VRP_SEARCH_ROUNDS, 1);
+    Parallel.for_range(0, vehicles, 1, __search_routes, &task);
+    qsort(best, vehicles, sizeof *best, __compare_moves);
+
+    bool applied = false;
+    memset(touched, 0, vehicles * sizeof(uint64_t));
+    for (uint64_t k = 0; k < vehicles && best[k].type != MOVE_NONE; ++k) {
+      if (touched[best[k].a] || touched[best[k].b]) {
+        continue;
+      }
+      __apply_move(&best[k], routes, fleet->demands, scratch);
+      touched[best[k].a] = touched[best[k].b] = 1;
+      applied                                 = true;
+    }
+    if (!applied) {
+      break;
+    }
+  }
+  Parallel.for_range(0, vehicles, 1, __two_opt_routes, &task);
+
+  for (uint64_t v = 0, k = 0; v < vehicles; ++v) {
+    solution.route_offsets[v] = k;
+    for (uint64_t s = 1; s <= routes[v].len; ++s) {
+      solution.stops[k++] = routes[v].seq[s];
+    }
+    solution.route_offsets[v + 1] = k;
+    solution.cost += __route_cost(&routes[v], cost_matrix, n);
+    free(routes[v].seq);
+  }
+
+  Array.release(cost_matrix);
+  free(routes);
+  free(best);
+  free(touched);
+  free(scratch);
+
+  return solution;
+}
+
+/**
+ * @brief   Frees the memory held by a solution.
+ *
+ * @param   solution         solution to free
+ */
+static void free_solution(struct VRPSolution * solution)
+{
+  free(solution->route_offsets);
+  free(solution->stops);
+  free(solution->unserved);
+  solution->route_offsets = NULL;
+  solution->stops         = NULL;
+  solution->unserved      = NULL;
+}
+
+/**
+ * @brief   Wraps solve for a better user API.
+ *
+ * @param   points           set of points to route
+ * @param   num_points       number of points, including the depot
+ * @param   dimension        dimension of the point vectors
+ * @param   fleet            vehicles, capacities, demands, and depot
+ * @param   metric           how distance between point vectors is measured
+ *
+ * @return  the routes of each vehicle; every stop is unserved when there are
+ *          no vehicles or the depot is not one of the points
+ */
+static struct VRPSolution
+__WRAPPER_solve(const double *                points[],
+                uint64_t                      num_points,
+                uint64_t                      dimension,
+                const struct VRPFleet *       fleet,
+                const struct DistanceMetric * metric)
+{
+  return solve((const double *)points, num_points, dimension, fleet, metric);
+}
+
+const struct vehicle_routing_problem VRP = {.solve = __WRAPPER_solve,
+                                            .free_solution = free_solution};
@@ -0,0 +1,86 @@
+#ifndef VRP_H
+#define VRP_H
+
+#include "toolkit/metric.h"
+
+#include <stdint.h>
+
+/**
+ * @struct
+ * @brief  A fleet of vehicles serving a set of stops from a depot
+ *
+ * @prop   num_vehicles number of vehicles
+ * @prop   capacities   capacity of each vehicle
+ * @prop   demands      demand of each point; the depot's demand is ignored
+ * @prop   depot        index of the point every route starts and ends at
+ */
+struct VRPFleet
+{
+  const uint64_t num_vehicles;
+  const double * capacities;
+  const double * demands;
+  const uint64_t depot;
+};
+
+/**
+ * @struct
+ * @brief  Routes of a solved vehicle routing problem
+ * @note   Routes do not include the depot, which implicitly begins and ends
+ *         every route.
+ *
+ * @prop   route_offsets the stops of vehicle `v` are
+ *                       `stops[route_offsets[v]]` up to but not including
+ *                       `stops[route_offsets[v + 1]]`
+ * @prop   stops         indeces of the stops of every route, in order
+ * @prop   unserved      indeces of stops no vehicle has capacity for
+ * @prop   num_unserved  number of unserved stops
+ * @prop   cost          total travel cost of all routes
+ */
+struct VRPSolution
+{
+  uint64_t * route_offsets;
+  uint64_t * stops;
+  uint64_t * unserved;
+  uint64_t   num_unserved;
+  double     cost;
+};
+
+struct vehicle_routing_problem
+{
+  /**
+   * @brief   Solves the capacitated vehicle routing problem for a set of
+   *          points.
+   * @details Creates a cost matrix for travelling between points, then builds
+   *          routes with the Clarke-Wright savings heuristic: starting from one
+   *          route per stop, the routes whose joining saves the most travel
+   *          are merged while capacity allows. Routes are matched to vehicles
+   *          by load, and then improved by inter-route local search (relocate,
+   *          swap, and 2-opt*), evaluated in parallel, followed by a 2-opt
+   *          pass over each route.
+   *
+   * @param   points           set of points to route
+   * @param   num_points       number of points, including the depot
+   * @param   dimension        dimension of the point vectors
+   * @param   fleet            vehicles, capacities, demands, and depot
+   * @param   metric           how distance between point vectors is measured
+   *
+   * @return  the routes of each vehicle; every stop is unserved when there
+   *          are no vehicles or the depot is not one of the points
+   */
+  struct VRPSolution (*solve)(const double *                points[],
+                              uint64_t                      num_points,
+                              uint64_t                      dimension,
+                              const struct VRPFleet *       fleet,
+                              const struct DistanceMetric * metric);
+
+  /**
+   * @brief   Frees the memory held by a solution.
+   *
+   * @param   solution         solution to free
+   */
+  void (*free_solution)(struct VRPSolution * solution);
+};
+
+extern const struct vehicle_routing_problem VRP;
+
+#endif
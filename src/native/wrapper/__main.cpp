@@ -1,7 +1,13 @@
+#include "batch.h"
 #include "cartesian.h"
+#include "point_file.h"
 #include "point_set.h"
 #include "polynomial.h"
+#include "spatial_index.h"
+#include "stats.h"
+#include "tour.h"
 #include "tsp.h"
+#include "vrp.h"
 
 #include <node.h>
 
@@ -10,8 +16,29 @@ void init(v8::Local<v8::Object> exports)
   NODE_SET_METHOD(exports, "distance", CartesianWrapper::distance);
   NODE_SET_METHOD(exports, "mean", PointSetWrapper::mean);
   NODE_SET_METHOD(exports, "geometric", PointSetWrapper::geometric);
+  NODE_SET_METHOD(exports, "summary", PointSetWrapper::summary);
+  NODE_SET_METHOD(exports, "minimax", PointSetWrapper::minimax);
+  NODE_SET_METHOD(exports, "assign", PointSetWrapper::assign);
+  NODE_SET_METHOD(exports, "medoid", PointSetWrapper::medoid);
   NODE_SET_METHOD(exports, "bestFit", PolynomialWrapper::bestFit);
+  NODE_SET_METHOD(exports, "robustFit", PolynomialWrapper::robustFit);
+  NODE_SET_METHOD(exports, "evalPolynomial", PolynomialWrapper::evaluate);
   NODE_SET_METHOD(exports, "tsp", TSPWrapper::solve);
+  NODE_SET_METHOD(exports, "vrp", VRPWrapper::solve);
+  NODE_SET_METHOD(exports, "meanBatch", BatchWrapper::mean);
+  NODE_SET_METHOD(exports, "geometricBatch", BatchWrapper::geometric);
+  NODE_SET_METHOD(exports, "tspBatch", BatchWrapper::tsp);
+  NODE_SET_METHOD(exports, "bestFitBatch", BatchWrapper::bestFit);
+  SpatialIndexWrapper::Init(exports);
+  PointFileWrapper::Init(exports);
+  TourWrapper::Init(exports);
+  NODE_SET_METHOD(exports, "stats", StatsWrapper::stats);
+  NODE_SET_METHOD(exports, "setStats", StatsWrapper::setStats);
+  NODE_SET_METHOD(exports, "resetStats", StatsWrapper::resetStats);
 }
 
-NODE_MODULE(addon, init);
+// context-aware, so that every worker thread may load its own copy
+NODE_MODULE_INIT()
+{
+  init(exports);
+}
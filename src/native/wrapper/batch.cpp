@@ -0,0 +1,356 @@
+#include "batch.h"
+
+#include "tsp.h"
+#include "typed.h"
+
+extern "C"
+{
+#include "../point_set.h"
+#include "../polynomial.h"
+#include "../toolkit/stats.h"
+#include "../tsp.h"
+}
+
+#include <stdlib.h>
+
+/**
+ * @struct
+ * @brief  A batch of point sets read from JS
+ *
+ * @prop   points     points of every set, read in place
+ * @prop   offsets    index of the first point of each set, followed by the
+ *                    total number of points
+ * @prop   num_sets   number of sets
+ * @prop   num_points total number of points
+ */
+struct Batch
+{
+  const double * points;
+  uint64_t *     offsets;
+  uint64_t       num_sets;
+  uint64_t       num_points;
+};
+
+/**
+ * @brief   Reads a batch of point sets from a `Float64Array` of packed
+ *          `[x, y]` coordinates and an array of offsets into it.
+ * @details Set `s` is made of the points from `offsets[s]` up to
+ *          `offsets[s + 1]`. The coordinates are read in place, so they must
+ *          outlive the batch. Throws a `TypeError` into JS for malformed
+ *          batches.
+ *
+ * @param   isolate          isolate to throw into
+ * @param   points           packed coordinates
+ * @param   offsets          index of the first point of each set, followed by
+ *                           the total number of points
+ * @param   batch            filled with the batch; its offsets must be
+ *                           `delete[]`d
+ *
+ * @return  whether the batch is well-formed
+ */
+static bool visitBatch(v8::Isolate *                isolate,
+                       const v8::Local<v8::Value> & points,
+                       const v8::Local<v8::Value> & offsets,
+                       Batch *                      batch)
+{
+  if (!points->IsFloat64Array() ||
+      !(offsets->IsArray() || offsets->IsTypedArray())) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "expected a Float64Array of points and an array of offsets")));
+    return false;
+  }
+
+  v8::Local<v8::Float64Array> _points =
+      v8::Local<v8::Float64Array>::Cast(points);
+  v8::Local<v8::Object> _offsets = v8::Local<v8::Object>::Cast(offsets);
+  const uint64_t        length =
+      offsets->IsArray() ? v8::Local<v8::Array>::Cast(offsets)->Length()
+                         : v8::Local<v8::TypedArray>::Cast(offsets)->Length();
+  const char * data = (const char *)_points->Buffer()->GetContents().Data();
+
+  batch->points     = (const double *)(data + _points->ByteOffset());
+  batch->num_sets   = length ? length - 1 : 0;
+  batch->offsets    = new uint64_t[batch->num_sets + 1];
+  // offsets are checked as signed integers, so negative ones are caught
+  // before they wrap around
+  const int64_t first = length ? _offsets->Get(0)->IntegerValue() : 0;
+  bool          valid = first >= 0;
+  batch->offsets[0]   = valid ? (uint64_t)first : 0;
+
+  for (uint64_t s = 1; s <= batch->num_sets; ++s) {
+    const int64_t offset = _offsets->Get(s)->IntegerValue();
+    valid             = valid && offset >= (int64_t)batch->offsets[s - 1];
+    batch->offsets[s] = valid ? (uint64_t)offset : batch->offsets[s - 1];
+  }
+  batch->num_points = batch->offsets[batch->num_sets];
+  if (!valid || 2 * batch->num_points > _points->Length()) {
+    delete[] batch->offsets;
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "offsets must be ascending and within the points")));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Creates a `Float64Array` over a new buffer.
+ *
+ * @param   isolate          isolate to allocate in
+ * @param   length           number of elements
+ * @param   data             filled with the contents of the buffer
+ *
+ * @return  the array
+ */
+static v8::Local<v8::Float64Array> newFloat64Array(v8::Isolate *  isolate,
+                                                   const uint64_t length,
+                                                   double **      data)
+{
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, length * sizeof(double));
+  *data = (double *)buffer->GetContents().Data();
+  return v8::Float64Array::New(buffer, 0, length);
+}
+
+/**
+ * @brief   Converts the centers of a batch back to JS.
+ *
+ * @param   isolate          isolate to allocate in
+ * @param   centers          packed `[x, y]` center of each set
+ * @param   scores           net distance to the center of each set
+ *
+ * @return  an object holding the centers and scores
+ */
+static v8::Local<v8::Object> centersResult(
+    v8::Isolate *                       isolate,
+    const v8::Local<v8::Float64Array> & centers,
+    const v8::Local<v8::Float64Array> & scores)
+{
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "centers"), centers);
+  result->Set(v8::String::NewFromUtf8(isolate, "scores"), scores);
+  return result;
+}
+
+/**
+ * @brief   Calculates the mean of each of a batch of point sets, interfaced
+ *          with Node.js.
+ */
+void BatchWrapper::mean(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  Batch batch;
+  if (!visitBatch(isolate, args[0], args[1], &batch)) {
+    return;
+  }
+  double *                    centers;
+  double *                    scores;
+  v8::Local<v8::Float64Array> _centers =
+      newFloat64Array(isolate, 2 * batch.num_sets, &centers);
+  v8::Local<v8::Float64Array> _scores =
+      newFloat64Array(isolate, batch.num_sets, &scores);
+
+  Stats.count(STAT_POINTS_MARSHALLED, batch.num_points);
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // calculate means straight into the result buffers
+  PointSet.mean_batch((const double(*)[2])batch.points,
+                      batch.offsets,
+                      batch.num_sets,
+                      (double(*)[2])centers,
+                      scores);
+  delete[] batch.offsets;
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  args.GetReturnValue().Set(centersResult(isolate, _centers, _scores));
+}
+
+/**
+ * @brief   Calculates the geometric median of each of a batch of point sets,
+ *          interfaced with Node.js.
+ */
+void BatchWrapper::geometric(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  Batch batch;
+  if (!visitBatch(isolate, args[0], args[1], &batch)) {
+    return;
+  }
+  const bool   subsearch = args[2]->BooleanValue();
+  const double epsilon   = args[3]->NumberValue();
+  const double bounds    = args[4]->NumberValue();
+  const char   method    = (char)(args[5]->Uint32Value());
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+  const struct GeometricCenterOptions opts = {epsilon,
+                                              bounds,
+                                              subsearch,
+                                              &metric,
+                                              0,
+                                              0};
+
+  double *                    centers;
+  double *                    scores;
+  v8::Local<v8::Float64Array> _centers =
+      newFloat64Array(isolate, 2 * batch.num_sets, &centers);
+  v8::Local<v8::Float64Array> _scores =
+      newFloat64Array(isolate, batch.num_sets, &scores);
+
+  Stats.count(STAT_POINTS_MARSHALLED, batch.num_points);
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // calculate geometric centers straight into the result buffers
+  PointSet.geometric_median_batch((const double(*)[2])batch.points,
+                                  batch.offsets,
+                                  batch.num_sets,
+                                  &opts,
+                                  (double(*)[2])centers,
+                                  scores);
+  delete[] batch.offsets;
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  args.GetReturnValue().Set(centersResult(isolate, _centers, _scores));
+}
+
+/**
+ * @brief   Determines the shortest-travel path through each of a batch of
+ *          point sets, interfaced with Node.js.
+ * @details Each tour is returned in the range of `orders` its set spans, as
+ *          indeces into the set.
+ */
+void BatchWrapper::tsp(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  Batch batch;
+  if (!visitBatch(isolate, args[0], args[1], &batch)) {
+    return;
+  }
+  const uint64_t startCity = args[2]->Uint32Value();
+  const char     method    = (char)(args[3]->Uint32Value());
+  const char     type      = (char)(args[4]->Uint32Value());
+  const uint64_t endCity   = args[5]->Uint32Value();
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+  const enum TSPMethod solver =
+      args[6]->BooleanValue() ? TSP_HILBERT_CURVE : TSP_BY_SIZE;
+  const struct TSPOptions opts = {
+      tourType(type), startCity, endCity, solver, 0, 0};
+
+  // the start and end must lie in every set that has points
+  uint64_t smallest = 0;
+  for (uint64_t s = 0; s < batch.num_sets; ++s) {
+    const uint64_t size = batch.offsets[s + 1] - batch.offsets[s];
+    smallest            = size && (!smallest || size < smallest) ? size
+                                                                 : smallest;
+  }
+  if (!checkEnds(isolate, startCity, endCity, smallest)) {
+    delete[] batch.offsets;
+    return;
+  }
+
+  double *                    costs;
+  v8::Local<v8::Float64Array> _costs =
+      newFloat64Array(isolate, batch.num_sets, &costs);
+  uint64_t * orders =
+      (uint64_t *)malloc((batch.num_points ? batch.num_points : 1) *
+                         sizeof(uint64_t));
+
+  Stats.count(STAT_POINTS_MARSHALLED, batch.num_points);
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  TSP.solve_batch((const double **)batch.points,
+                  batch.offsets,
+                  batch.num_sets,
+                  2,
+                  &opts,
+                  &metric,
+                  orders,
+                  costs);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // hand the orders over as a typed array
+  v8::Local<v8::Uint32Array> _orders =
+      externalUint32Array(isolate, orders, batch.num_points);
+  delete[] batch.offsets;
+
+  // create object to hold orders and costs
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "orders"), _orders);
+  result->Set(v8::String::NewFromUtf8(isolate, "costs"), _costs);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Calculates the best-fit polynomial of each of a batch of series
+ *          sampled at the same x coordinates, interfaced with Node.js.
+ * @details The series are read in place from a column-major `Float64Array`,
+ *          one series after another, and the coefficients of every fit are
+ *          returned packed in the same order. A degree of 0 is guessed from
+ *          the first series.
+ */
+void BatchWrapper::bestFit(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args, reading typed arrays in place
+  uint64_t       numPoints = 0;
+  uint64_t       numValues = 0;
+  const double * x         = float64Data(args[0], &numPoints);
+  const double * series    = float64Data(args[1], &numValues);
+  if (!x || !series) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "expected Float64Arrays of x coordinates and of series")));
+    return;
+  }
+  if (!numPoints || numValues % numPoints) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "every series needs a value for each x coordinate")));
+    return;
+  }
+  const uint64_t numSeries = numValues / numPoints;
+  uint64_t       degree    = args[2]->Uint32Value();
+  if (!degree) {
+    degree = Polynomial.guess_degree(x, series, numPoints);
+  }
+
+  double *                    coeffs;
+  v8::Local<v8::Float64Array> _coeffs =
+      newFloat64Array(isolate, numSeries * (degree + 1), &coeffs);
+
+  Stats.count(STAT_POINTS_MARSHALLED, numValues);
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  Polynomial.best_fit_batch(x, numPoints, series, numSeries, degree, coeffs);
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  args.GetReturnValue().Set(_coeffs);
+}
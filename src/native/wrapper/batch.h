@@ -0,0 +1,34 @@
+#ifndef WRAPPER_BATCH_H
+#define WRAPPER_BATCH_H
+
+#include <node.h>
+
+namespace BatchWrapper
+{
+/**
+ * @brief   Calculates the mean of each of a batch of point sets, interfaced
+ *          with Node.js.
+ */
+void mean(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Calculates the geometric median of each of a batch of point sets,
+ *          interfaced with Node.js.
+ */
+void geometric(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Determines the shortest-travel path through each of a batch of
+ *          point sets, interfaced with Node.js.
+ */
+void tsp(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Calculates the best-fit polynomial of each of a batch of series
+ *          sampled at the same x coordinates, interfaced with Node.js.
+ */
+void bestFit(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+}  // namespace BatchWrapper
+
+#endif
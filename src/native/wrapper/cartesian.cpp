@@ -1,10 +1,16 @@
 #include "cartesian.h"
 
+#include "point_file.h"
+#include "typed.h"
+
 extern "C"
 {
 #include "../cartesian.h"
+#include "../toolkit/stats.h"
 }
 
+#include <stdlib.h>
+
 static const double PI = 3.14159265358979323846;
 
 /**
@@ -20,26 +26,30 @@ double degtorad(double degrees)
 /**
  * @brief   Calculates the cartesian (earthly) distance between two lat/lng
  *          points, interfaced with Node.js.
+ * @details The distances are returned as a `Float64Array` over native memory
+ *          when a typed result is asked for. The origins are returned as an
+ *          Array of `[lat, lng]` points, read back out of a mapped file.
  */
 void CartesianWrapper::distance(
     const v8::FunctionCallbackInfo<v8::Value> & args)
 {
   v8::Isolate * isolate = args.GetIsolate();
 
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
   // get args
-  v8::Local<v8::Array> _points = v8::Local<v8::Array>::Cast(args[0]);
   v8::Local<v8::Array> _center = v8::Local<v8::Array>::Cast(args[1]);
   const char           unit    = (char)(args[2]->Uint32Value());
+  const bool           typed   = args[3]->BooleanValue();
 
-  const uint64_t length = _points->Length();
-
-  // pass locations to C++ array
-  double points[length][2];
-  for (uint64_t i = 0; i < length; ++i) {
-    v8::Local<v8::Array> _element = v8::Local<v8::Array>::Cast(_points->Get(i));
-    points[i][0]                  = _element->Get(0)->NumberValue();
-    points[i][1]                  = _element->Get(1)->NumberValue();
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
   }
+  const Point *  points = source.points();
+  const uint64_t length = source.size();
   double center[2];
   {
     v8::Local<v8::Array> _centerElement = v8::Local<v8::Array>::Cast(_center);
@@ -47,8 +57,11 @@ void CartesianWrapper::distance(
     center[1]                           = _centerElement->Get(1)->NumberValue();
   }
 
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
   // record distances from each location to center
-  v8::Local<v8::Array> distances = v8::Array::New(isolate);
+  double * distances = (double *)malloc((length ? length : 1) * sizeof(double));
   for (uint64_t i = 0; i < length; ++i) {
     // start lat, lng
     const double sLat = degtorad(center[0]);
@@ -64,14 +77,35 @@ void CartesianWrapper::distance(
                                                          eLng,
                                                          unit);
 
-    distances->Set(i, v8::Number::New(isolate, distance));
+    distances[i] = distance;
+  }
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  v8::Local<v8::Value> _distances =
+      numberArray(isolate, distances, length, typed);
+
+  // echo locations, reading a mapped file back into points
+  v8::Local<v8::Value> _origins = args[0];
+  if (!_origins->IsArray()) {
+    v8::Local<v8::Array> _locations = v8::Array::New(isolate, length);
+    for (uint64_t i = 0; i < length; ++i) {
+      v8::Local<v8::Array> _point = v8::Array::New(isolate, 2);
+      _point->Set(0, v8::Number::New(isolate, points[i][0]));
+      _point->Set(1, v8::Number::New(isolate, points[i][1]));
+      _locations->Set(i, _point);
+    }
+    _origins = _locations;
   }
 
   // create object to hold results
   v8::Local<v8::Object> result = v8::Object::New(isolate);
-  result->Set(v8::String::NewFromUtf8(isolate, "origins"), _points);
+  result->Set(v8::String::NewFromUtf8(isolate, "origins"), _origins);
   result->Set(v8::String::NewFromUtf8(isolate, "destination"), _center);
-  result->Set(v8::String::NewFromUtf8(isolate, "distances"), distances);
+  result->Set(v8::String::NewFromUtf8(isolate, "distances"), _distances);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
 
   args.GetReturnValue().Set(result);
 }
@@ -0,0 +1,301 @@
+#include "point_file.h"
+
+#include "typed.h"
+
+extern "C"
+{
+#include "../toolkit/stats.h"
+}
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Held in the second internal field of every `PointFile`, to tell it apart
+ * from other wrapped objects.
+ */
+static const uint64_t POINT_FILE_TAG = 0;
+
+/**
+ * @brief   Reads a `[x, y]` point from JS.
+ *
+ * @param   value            the JS point
+ * @param   point            filled with the point
+ */
+void visitPoint(const v8::Local<v8::Value> & value, Point point)
+{
+  v8::Local<v8::Array> _point = v8::Local<v8::Array>::Cast(value);
+  point[0]                    = _point->Get(0)->NumberValue();
+  point[1]                    = _point->Get(1)->NumberValue();
+}
+
+PointFileWrapper::PointFileWrapper(struct MappedPoints * file) : file(file)
+{
+}
+
+PointFileWrapper::~PointFileWrapper()
+{
+  PointFile.close(file);
+}
+
+/**
+ * @brief   Adds the `PointFile` constructor, and `writePoints`, to the
+ *          exports.
+ */
+void PointFileWrapper::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate * isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "PointFile"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(2);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "size", size);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "locations", locations);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "weights", weights);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "close", close);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "PointFile"),
+               tpl->GetFunction());
+  NODE_SET_METHOD(exports, "writePoints", write);
+}
+
+/**
+ * @brief   Determines whether a JS value is a `PointFile`.
+ */
+bool PointFileWrapper::IsPointFile(const v8::Local<v8::Value> & value)
+{
+  if (!value->IsObject() || value->IsArray()) {
+    return false;
+  }
+
+  v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(value);
+  return object->InternalFieldCount() == 2 &&
+         object->GetAlignedPointerFromInternalField(1) == &POINT_FILE_TAG;
+}
+
+/**
+ * @brief   Maps the point file at a path.
+ */
+void PointFileWrapper::New(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "PointFile must be constructed with new")));
+    return;
+  }
+
+  v8::String::Utf8Value path(args[0]);
+  struct MappedPoints * file = PointFile.open(*path);
+  if (!file) {
+    const char * reason =
+        errno == ENOEXEC ? "Point file was written in the other byte order"
+                         : strerror(errno);
+    isolate->ThrowException(
+        v8::Exception::Error(v8::String::NewFromUtf8(isolate, reason)));
+    return;
+  }
+
+  PointFileWrapper * wrapper = new PointFileWrapper(file);
+  wrapper->Wrap(args.This());
+  args.This()->SetAlignedPointerInInternalField(1, (void *)&POINT_FILE_TAG);
+  args.GetReturnValue().Set(args.This());
+}
+
+/**
+ * @brief   Returns the number of points in the file.
+ */
+void PointFileWrapper::size(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  PointFileWrapper * wrapper =
+      node::ObjectWrap::Unwrap<PointFileWrapper>(args.Holder());
+
+  const uint64_t size = wrapper->file ? wrapper->file->num_points : 0;
+  args.GetReturnValue().Set(v8::Number::New(args.GetIsolate(), (double)size));
+}
+
+/**
+ * @brief   Reads every point of the file into an Array of `[x, y]` points.
+ */
+void PointFileWrapper::locations(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  PointSource source(isolate, args.Holder());
+  if (!source.ok()) {
+    return;
+  }
+
+  v8::Local<v8::Array> _locations = v8::Array::New(isolate, source.size());
+  for (uint64_t i = 0; i < source.size(); ++i) {
+    v8::Local<v8::Array> _point = v8::Array::New(isolate, 2);
+    _point->Set(0, v8::Number::New(isolate, source.points()[i][0]));
+    _point->Set(1, v8::Number::New(isolate, source.points()[i][1]));
+    _locations->Set(i, _point);
+  }
+
+  args.GetReturnValue().Set(_locations);
+}
+
+/**
+ * @brief   Reads the weight of every point of the file, or null if it has no
+ *          weights.
+ * @details The weights are returned as a `Float64Array` over native memory
+ *          when a typed result is asked for.
+ */
+void PointFileWrapper::weights(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate *      isolate = args.GetIsolate();
+  PointFileWrapper * wrapper =
+      node::ObjectWrap::Unwrap<PointFileWrapper>(args.Holder());
+  const bool typed = args[0]->BooleanValue();
+
+  if (!wrapper->file || !wrapper->file->weights) {
+    args.GetReturnValue().SetNull();
+    return;
+  }
+
+  const uint64_t n       = wrapper->file->num_points;
+  double *       weights = (double *)malloc((n ? n : 1) * sizeof(double));
+  for (uint64_t i = 0; i < n; ++i) {
+    weights[i] = PointFile.weight(wrapper->file, i);
+  }
+
+  args.GetReturnValue().Set(numberArray(isolate, weights, n, typed));
+}
+
+/**
+ * @brief   Unmaps the file.
+ */
+void PointFileWrapper::close(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  PointFileWrapper * wrapper =
+      node::ObjectWrap::Unwrap<PointFileWrapper>(args.Holder());
+
+  PointFile.close(wrapper->file);
+  wrapper->file = NULL;
+}
+
+/**
+ * @brief   Writes a set of points, and optionally their weights, to a point
+ *          file.
+ */
+void PointFileWrapper::write(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  // get args
+  v8::String::Utf8Value path(args[0]);
+  PointSource           source(isolate, args[1]);
+  const bool            float32 = args[3]->BooleanValue();
+  if (!source.ok()) {
+    return;
+  }
+
+  double * weights = NULL;
+  if (args[2]->IsArray()) {
+    v8::Local<v8::Array> _weights = v8::Local<v8::Array>::Cast(args[2]);
+    if (_weights->Length() != source.size()) {
+      isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+          isolate, "there must be one weight per point")));
+      return;
+    }
+
+    weights = (double *)malloc((source.size() ? source.size() : 1) *
+                               sizeof(double));
+    for (uint64_t i = 0; i < source.size(); ++i) {
+      weights[i] = _weights->Get(i)->NumberValue();
+    }
+  }
+
+  const bool written = PointFile.write(*path,
+                                       source.points(),
+                                       source.size(),
+                                       weights,
+                                       float32);
+  free(weights);
+
+  if (!written) {
+    isolate->ThrowException(v8::Exception::Error(
+        v8::String::NewFromUtf8(isolate, strerror(errno))));
+  }
+}
+
+PointSource::PointSource(v8::Isolate * isolate,
+                         const v8::Local<v8::Value> & value)
+    : owned(NULL), data(NULL), length(0), valid(true)
+{
+  if (value->IsArray()) {
+    v8::Local<v8::Array> _points = v8::Local<v8::Array>::Cast(value);
+    length                       = _points->Length();
+    owned = (Point *)malloc((length ? length : 1) * sizeof(Point));
+    for (uint64_t i = 0; i < length; ++i) {
+      v8::Local<v8::Array> _point = v8::Local<v8::Array>::Cast(_points->Get(i));
+      owned[i][0]                 = _point->Get(0)->NumberValue();
+      owned[i][1]                 = _point->Get(1)->NumberValue();
+    }
+    data = owned;
+    Stats.count(STAT_POINTS_MARSHALLED, length);
+    return;
+  }
+
+  if (!PointFileWrapper::IsPointFile(value)) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "expected an Array of points or a PointFile")));
+    valid = false;
+    return;
+  }
+
+  const struct MappedPoints * file =
+      node::ObjectWrap::Unwrap<PointFileWrapper>(
+          v8::Local<v8::Object>::Cast(value))
+          ->file;
+  if (!file) {
+    isolate->ThrowException(v8::Exception::Error(
+        v8::String::NewFromUtf8(isolate, "the PointFile is closed")));
+    valid = false;
+    return;
+  }
+
+  length = file->num_points;
+  if (file->float32) {
+    owned = (Point *)malloc((length ? length : 1) * sizeof(Point));
+    PointFile.read(file, 0, length, owned);
+    data = owned;
+  } else {
+    data = (const Point *)file->coords;
+  }
+}
+
+PointSource::~PointSource()
+{
+  free(owned);
+}
+
+/**
+ * @brief   Whether the points could be read.
+ */
+bool PointSource::ok() const
+{
+  return valid;
+}
+
+/**
+ * @brief   The points.
+ */
+const Point * PointSource::points() const
+{
+  return data;
+}
+
+/**
+ * @brief   The number of points.
+ */
+uint64_t PointSource::size() const
+{
+  return length;
+}
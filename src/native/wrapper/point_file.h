@@ -0,0 +1,123 @@
+#ifndef WRAPPER_POINT_FILE_H
+#define WRAPPER_POINT_FILE_H
+
+#include <node.h>
+#include <node_object_wrap.h>
+
+extern "C"
+{
+#include "../toolkit/point_file.h"
+}
+
+/**
+ * @brief   A 2D point, as bindings hand points to the native library.
+ */
+typedef double Point[2];
+
+/**
+ * @brief   Reads a `[x, y]` point from JS.
+ *
+ * @param   value            the JS point
+ * @param   point            filled with the point
+ */
+void visitPoint(const v8::Local<v8::Value> & value, Point point);
+
+/**
+ * @brief   A point file mapped into memory, interfaced with Node.js as
+ *          `PointFile`.
+ */
+class PointFileWrapper : public node::ObjectWrap
+{
+ public:
+  /**
+   * @brief   Adds the `PointFile` constructor, and `writePoints`, to the
+   *          exports.
+   */
+  static void Init(v8::Local<v8::Object> exports);
+
+  /**
+   * @brief   Determines whether a JS value is a `PointFile`.
+   */
+  static bool IsPointFile(const v8::Local<v8::Value> & value);
+
+  /**
+   * @brief   The mapping, or NULL once closed.
+   */
+  struct MappedPoints * file;
+
+ private:
+  explicit PointFileWrapper(struct MappedPoints * file);
+  ~PointFileWrapper();
+
+  /**
+   * @brief   Maps the point file at a path.
+   */
+  static void New(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Returns the number of points in the file.
+   */
+  static void size(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Reads every point of the file into an Array of `[x, y]` points.
+   */
+  static void locations(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Reads the weight of every point of the file, or null if it has
+   *          no weights.
+   */
+  static void weights(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Unmaps the file.
+   */
+  static void close(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Writes a set of points, and optionally their weights, to a point
+   *          file.
+   */
+  static void write(const v8::FunctionCallbackInfo<v8::Value> & args);
+};
+
+/**
+ * @brief   The points a binding was called with: an Array of `[x, y]` points,
+ *          or a `PointFile`, whose float64 coordinates are used in place.
+ * @details Arrays, and float32 files, are converted into native memory held
+ *          until the source is destroyed. When the points cannot be read, a
+ *          JS exception is thrown and `ok` is false.
+ */
+class PointSource
+{
+ public:
+  PointSource(v8::Isolate * isolate, const v8::Local<v8::Value> & value);
+  ~PointSource();
+
+  /**
+   * @brief   Whether the points could be read.
+   */
+  bool ok() const;
+
+  /**
+   * @brief   The points.
+   */
+  const Point * points() const;
+
+  /**
+   * @brief   The number of points.
+   */
+  uint64_t size() const;
+
+ private:
+  PointSource(const PointSource &);
+  PointSource & operator=(const PointSource &);
+
+  Point *       owned;
+  const Point * data;
+  uint64_t      length;
+  bool          valid;
+};
+
+#endif
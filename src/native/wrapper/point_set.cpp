@@ -1,45 +1,84 @@
 #include "point_set.h"
 
+#include "point_file.h"
+#include "tsp.h"
+#include "typed.h"
+
 extern "C"
 {
 #include "../point_set.h"
-#include "../toolkit/ips.h"
+#include "../toolkit/metric.h"
+#include "../toolkit/stats.h"
+}
+
+#include <stdlib.h>
+
+/**
+ * @brief   Copies a 2D point into a JS Array.
+ *
+ * @param   isolate          isolate to create the array in
+ * @param   point            the point
+ *
+ * @return  the JS array
+ */
+static v8::Local<v8::Value> pointArray(v8::Isolate * isolate,
+                                       const Grid_2D point)
+{
+  double * data = (double *)malloc(2 * sizeof(double));
+  data[0]       = point.x;
+  data[1]       = point.y;
+  return numberArray(isolate, data, 2, false);
 }
 
 /**
  * @brief   Calculates the mean of an arbitrary amount of points, interfaced
  *          with Node.js.
+ * @details The center is returned as a `Float64Array` over native memory when
+ *          a typed result is asked for, and its score is measured under the
+ *          metric given, euclidean by default.
  */
 void PointSetWrapper::mean(const v8::FunctionCallbackInfo<v8::Value> & args)
 {
   v8::Isolate * isolate = args.GetIsolate();
 
-  // get args
-  v8::Local<v8::Array> _points = v8::Local<v8::Array>::Cast(args[0]);
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
 
-  const unsigned int length = _points->Length();
+  // get args
+  const bool                  typed  = args[1]->BooleanValue();
+  const char                  method = (char)(args[2]->Uint32Value());
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
 
-  // pass locations to C++ array
-  double points[length][2];
-  for (unsigned int i = 0; i < length; ++i) {
-    v8::Local<v8::Array> element = v8::Local<v8::Array>::Cast(_points->Get(i));
-    points[i][0]                 = element->Get(0)->NumberValue();
-    points[i][1]                 = element->Get(1)->NumberValue();
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
   }
+  const Point *  points = source.points();
+  const uint64_t length = source.size();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
 
   // get results
   Grid_2D      center        = PointSet.mean(points, length);
   double       center_arr[2] = {center.x, center.y};
-  const double score         = IPS.net_distance(2,
-                                        (const double *)center_arr,
-                                        2,
-                                        (const double **)points,
-                                        length);
+  const double score         = Metric.net_distance(&metric,
+                                           center_arr,
+                                           2,
+                                           (const double **)points,
+                                           length);
 
-  // convert center back to JS Array
-  v8::Local<v8::Array> _center = v8::Array::New(isolate);
-  _center->Set(0, v8::Number::New(isolate, center.x));
-  _center->Set(1, v8::Number::New(isolate, center.y));
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // convert center back to JS
+  double * center_out = (double *)malloc(sizeof center_arr);
+  center_out[0]       = center.x;
+  center_out[1]       = center.y;
+
+  v8::Local<v8::Value> _center = numberArray(isolate, center_out, 2, typed);
 
   // create object to hold center and score
   v8::Local<v8::Object> result = v8::Object::New(isolate);
@@ -47,53 +86,344 @@ void PointSetWrapper::mean(const v8::FunctionCallbackInfo<v8::Value> & args)
   result->Set(v8::String::NewFromUtf8(isolate, "score"),
               v8::Number::New(isolate, score));
 
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
   args.GetReturnValue().Set(result);
 }
 
 /**
  * @brief   Calculates the geometric median of an arbitrary amount of points,
  *          interfaced with Node.js.
+ * @details The center is returned as a `Float64Array` over native memory when
+ *          a typed result is asked for. The search stops at the deadline or
+ *          iteration limit if given, and the result tells whether it did, the
+ *          steps taken, and the step size reached.
  */
 void PointSetWrapper::geometric(
     const v8::FunctionCallbackInfo<v8::Value> & args)
 {
   v8::Isolate * isolate = args.GetIsolate();
 
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
   // get args
-  v8::Local<v8::Array> _points   = v8::Local<v8::Array>::Cast(args[0]);
-  const uint64_t       numPoints = _points->Length();
-  const bool           subsearch = args[1]->BooleanValue();
-  const double         epsilon   = args[2]->NumberValue();
-  const double         bounds    = args[3]->NumberValue();
-  const struct GeometricCenterOptions opts = {epsilon, bounds, subsearch};
-
-  // pass locations to native array
-  double points[numPoints][2];
-  for (unsigned int i = 0; i < numPoints; ++i) {
-    v8::Local<v8::Array> _element = v8::Local<v8::Array>::Cast(_points->Get(i));
-    points[i][0]                  = _element->Get(0)->NumberValue();
-    points[i][1]                  = _element->Get(1)->NumberValue();
+  const bool   subsearch = args[1]->BooleanValue();
+  const double epsilon   = args[2]->NumberValue();
+  const double bounds    = args[3]->NumberValue();
+  const char   method    = (char)(args[4]->Uint32Value());
+  const struct DistanceMetric metric = visitMetric(method, args[5]);
+  const bool                  typed  = args[6]->BooleanValue();
+  const double                deadline      = args[7]->NumberValue();
+  const uint64_t              maxIterations = args[8]->Uint32Value();
+  const struct GeometricCenterOptions opts  = {epsilon,
+                                              bounds,
+                                              subsearch,
+                                              &metric,
+                                              deadline,
+                                              maxIterations};
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok() || !checkMatrix(isolate, metric, args[5], source.size())) {
+    return;
   }
+  const Point *  points    = source.points();
+  const uint64_t numPoints = source.size();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
 
   // calculate geometric center
-  Grid_2D      center = PointSet.geometric_median(points, numPoints, &opts);
+  struct SolveReport report;
+  Grid_2D            center =
+      PointSet.geometric_median(points, numPoints, &opts, &report);
   double       center_arr[2] = {center.x, center.y};
-  const double score         = IPS.net_distance(2,
-                                        (const double *)center_arr,
-                                        2,
-                                        (const double **)points,
-                                        numPoints);
+  const double score         = Metric.net_distance(&metric,
+                                           center_arr,
+                                           2,
+                                           (const double **)points,
+                                           numPoints);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
 
-  // convert center back to JS Array
-  v8::Local<v8::Array> _center = v8::Array::New(isolate);
-  _center->Set(0, v8::Number::New(isolate, center.x));
-  _center->Set(1, v8::Number::New(isolate, center.y));
+  // convert center back to JS
+  double * center_out = (double *)malloc(sizeof center_arr);
+  center_out[0]       = center.x;
+  center_out[1]       = center.y;
+
+  v8::Local<v8::Value> _center = numberArray(isolate, center_out, 2, typed);
 
   // create object to hold center and score
   v8::Local<v8::Object> result = v8::Object::New(isolate);
   result->Set(v8::String::NewFromUtf8(isolate, "center"), _center);
   result->Set(v8::String::NewFromUtf8(isolate, "score"),
               v8::Number::New(isolate, score));
+  setReport(isolate, result, &report);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Summarizes an arbitrary amount of points in one pass, interfaced
+ *          with Node.js.
+ * @details Marshals the points once, and returns their mean and geometric
+ *          center with the cost of each, the improvement of one cost over the
+ *          other, and the bounding box and variance of the points.
+ */
+void PointSetWrapper::summary(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const bool   subsearch = args[1]->BooleanValue();
+  const double epsilon   = args[2]->NumberValue();
+  const double bounds    = args[3]->NumberValue();
+  const char   method    = (char)(args[4]->Uint32Value());
+  const struct DistanceMetric metric = visitMetric(method, args[5]);
+  const double                deadline      = args[6]->NumberValue();
+  const uint64_t              maxIterations = args[7]->Uint32Value();
+  const struct GeometricCenterOptions opts  = {epsilon,
+                                              bounds,
+                                              subsearch,
+                                              &metric,
+                                              deadline,
+                                              maxIterations};
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok() || !checkMatrix(isolate, metric, args[5], source.size())) {
+    return;
+  }
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // summarize the points
+  const struct PointSummary summary =
+      PointSet.summary(source.points(), source.size(), &opts);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // create object to hold each statistic
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "mean"),
+              pointArray(isolate, summary.mean));
+  result->Set(v8::String::NewFromUtf8(isolate, "meanCost"),
+              v8::Number::New(isolate, summary.mean_cost));
+  result->Set(v8::String::NewFromUtf8(isolate, "center"),
+              pointArray(isolate, summary.center));
+  result->Set(v8::String::NewFromUtf8(isolate, "centerCost"),
+              v8::Number::New(isolate, summary.center_cost));
+  result->Set(
+      v8::String::NewFromUtf8(isolate, "significance"),
+      v8::Number::New(isolate,
+                      (summary.mean_cost - summary.center_cost) /
+                          summary.mean_cost));
+  result->Set(v8::String::NewFromUtf8(isolate, "min"),
+              pointArray(isolate, summary.min));
+  result->Set(v8::String::NewFromUtf8(isolate, "max"),
+              pointArray(isolate, summary.max));
+  result->Set(v8::String::NewFromUtf8(isolate, "variance"),
+              pointArray(isolate, summary.variance));
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Calculates the minimax center of an arbitrary amount of points,
+ *          interfaced with Node.js.
+ * @details The score is the greatest distance from the center to a point. The
+ *          center is returned as a `Float64Array` over native memory when a
+ *          typed result is asked for.
+ */
+void PointSetWrapper::minimax(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const char method = (char)(args[1]->Uint32Value());
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+  const bool typed = args[2]->BooleanValue();
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+  const Point *  points    = source.points();
+  const uint64_t numPoints = source.size();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // calculate minimax center
+  double  radius;
+  Grid_2D center =
+      PointSet.minimax_center(points, numPoints, &metric, &radius);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // convert center back to JS
+  double * center_out = (double *)malloc(2 * sizeof(double));
+  center_out[0]       = center.x;
+  center_out[1]       = center.y;
+
+  v8::Local<v8::Value> _center = numberArray(isolate, center_out, 2, typed);
+
+  // create object to hold center and score
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "center"), _center);
+  result->Set(v8::String::NewFromUtf8(isolate, "score"),
+              v8::Number::New(isolate, radius));
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Assigns each of an arbitrary amount of points to its nearest
+ *          center, interfaced with Node.js.
+ * @details Returns the index of the nearest center to each point and the
+ *          distance to it, as typed arrays over native memory when a typed
+ *          result is asked for.
+ */
+void PointSetWrapper::assign(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const char method = (char)(args[2]->Uint32Value());
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+  const bool typed = args[3]->BooleanValue();
+
+  // read locations and centers, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+  PointSource centers(isolate, args[1]);
+  if (!centers.ok()) {
+    return;
+  }
+  if (!centers.size()) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "At least one center is needed to assign points to")));
+    return;
+  }
+  const uint64_t numPoints = source.size();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // assign points straight into the result buffers
+  uint64_t * nearest =
+      (uint64_t *)malloc((numPoints ? numPoints : 1) * sizeof(uint64_t));
+  double * distances =
+      (double *)malloc((numPoints ? numPoints : 1) * sizeof(double));
+  PointSet.assign(source.points(),
+                  numPoints,
+                  centers.points(),
+                  centers.size(),
+                  &metric,
+                  nearest,
+                  distances);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // create object to hold indices and distances
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "indices"),
+              indexArray(isolate, nearest, numPoints, typed));
+  result->Set(v8::String::NewFromUtf8(isolate, "distances"),
+              numberArray(isolate, distances, numPoints, typed));
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Finds the medoid of an arbitrary amount of points, interfaced with
+ *          Node.js.
+ * @details Returns the index of the medoid among the points, the point itself,
+ *          and the net distance to it.
+ */
+void PointSetWrapper::medoid(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const bool   subsearch = args[1]->BooleanValue();
+  const double epsilon   = args[2]->NumberValue();
+  const double bounds    = args[3]->NumberValue();
+  const char   method    = (char)(args[4]->Uint32Value());
+  const struct DistanceMetric metric = visitMetric(method, args[5]);
+  const double                deadline      = args[6]->NumberValue();
+  const uint64_t              maxIterations = args[7]->Uint32Value();
+  const struct GeometricCenterOptions opts  = {epsilon,
+                                              bounds,
+                                              subsearch,
+                                              &metric,
+                                              deadline,
+                                              maxIterations};
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok() || !checkMatrix(isolate, metric, args[5], source.size())) {
+    return;
+  }
+  if (!source.size()) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "At least one point is needed to find a medoid")));
+    return;
+  }
+  const Point * points = source.points();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  // find the medoid
+  double         cost;
+  const uint64_t index = PointSet.medoid(points, source.size(), &opts, &cost);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // create object to hold the medoid and its cost
+  const Grid_2D         location = {points[index][0], points[index][1]};
+  v8::Local<v8::Object> result   = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "index"),
+              v8::Number::New(isolate, (double)index));
+  result->Set(v8::String::NewFromUtf8(isolate, "location"),
+              pointArray(isolate, location));
+  result->Set(v8::String::NewFromUtf8(isolate, "cost"),
+              v8::Number::New(isolate, cost));
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
 
   args.GetReturnValue().Set(result);
 }
@@ -17,6 +17,30 @@ void mean(const v8::FunctionCallbackInfo<v8::Value> & args);
  */
 void geometric(const v8::FunctionCallbackInfo<v8::Value> & args);
 
+/**
+ * @brief   Summarizes an arbitrary amount of points in one pass, interfaced
+ *          with Node.js.
+ */
+void summary(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Calculates the minimax center of an arbitrary amount of points,
+ *          interfaced with Node.js.
+ */
+void minimax(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Assigns each of an arbitrary amount of points to its nearest
+ *          center, interfaced with Node.js.
+ */
+void assign(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Finds the medoid of an arbitrary amount of points, interfaced with
+ *          Node.js.
+ */
+void medoid(const v8::FunctionCallbackInfo<v8::Value> & args);
+
 }  // namespace PointSetWrapper
 
 #endif
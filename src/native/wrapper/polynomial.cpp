@@ -1,42 +1,198 @@
 #include "polynomial.h"
 
+#include "point_file.h"
+#include "tsp.h"
+#include "typed.h"
+
 extern "C"
 {
 #include "../polynomial.h"
+#include "../toolkit/stats.h"
 }
 
+#include <stdlib.h>
+
 void PolynomialWrapper::bestFit(
     const v8::FunctionCallbackInfo<v8::Value> & args)
 {
   v8::Isolate * isolate = args.GetIsolate();
 
-  v8::Local<v8::Array> _points   = v8::Local<v8::Array>::Cast(args[0]);
-  const uint64_t       numPoints = _points->Length();
-  double               xPos[numPoints];
-  double               yPos[numPoints];
-  v8::Local<v8::Array> orig;
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
 
+  const uint64_t numPoints = source.size();
+  const uint64_t room      = numPoints ? numPoints : 1;
+  double *       xPos      = (double *)malloc(room * sizeof(double));
+  double *       yPos      = (double *)malloc(room * sizeof(double));
   for (uint64_t i = 0; i < numPoints; ++i) {
-    orig    = v8::Local<v8::Array>::Cast(_points->Get(i));
-    xPos[i] = orig->Get(0)->NumberValue();
-    yPos[i] = orig->Get(1)->NumberValue();
+    xPos[i] = source.points()[i][0];
+    yPos[i] = source.points()[i][1];
   }
 
-  uint64_t degree = args[1]->Uint32Value();
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  uint64_t   degree = args[1]->Uint32Value();
+  const bool typed  = args[2]->BooleanValue();
   if (!degree) {
     degree = Polynomial.guess_degree(xPos, yPos, numPoints);
   }
 
   // calculate polynomial
   double * coeffs = Polynomial.best_fit(xPos, yPos, numPoints, degree);
+  free(xPos);
+  free(yPos);
 
-  // pass coeffs back to JS Array
-  v8::Local<v8::Array> _coeffs = v8::Array::New(isolate);
-  for (unsigned char i = 0; i < degree + 1; ++i) {
-    _coeffs->Set(i, v8::Number::New(isolate, coeffs[i]));
-  }
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // pass coeffs back to JS
+  v8::Local<v8::Value> _coeffs =
+      numberArray(isolate, coeffs, degree + 1, typed);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
 
   args.GetReturnValue().Set(_coeffs);
+}
+
+/**
+ * @brief   Calculates a polynomial function of an arbitrary set of points
+ *          that resists outliers, interfaced with Node.js.
+ * @details Returns the coefficients, a `Uint8Array` marking each inlier, the
+ *          number of inliers, and how far the fit got within its budget.
+ */
+void PolynomialWrapper::robustFit(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+
+  const uint64_t numPoints = source.size();
+  const uint64_t room      = numPoints ? numPoints : 1;
+  double *       xPos      = (double *)malloc(room * sizeof(double));
+  double *       yPos      = (double *)malloc(room * sizeof(double));
+  for (uint64_t i = 0; i < numPoints; ++i) {
+    xPos[i] = source.points()[i][0];
+    yPos[i] = source.points()[i][1];
+  }
+
+  uint64_t   degree = args[1]->Uint32Value();
+  const char method = (char)(args[2]->Uint32Value());
+
+  const struct FitOptions options = {
+      method == 'r' ? FIT_RANSAC : method == 't' ? FIT_TUKEY : FIT_HUBER,
+      args[3]->NumberValue(),
+      args[4]->Uint32Value(),
+      args[5]->NumberValue()};
+
+  v8::Local<v8::ArrayBuffer> buffer  = v8::ArrayBuffer::New(isolate, numPoints);
+  uint8_t *                  inliers = (uint8_t *)buffer->GetContents().Data();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  if (!degree) {
+    degree = Polynomial.guess_degree(xPos, yPos, numPoints);
+  }
+  struct SolveReport report;
+  double *           coeffs = (double *)malloc((degree + 1) * sizeof(double));
+  const uint64_t     count  = Polynomial.robust_fit(
+      xPos, yPos, numPoints, degree, &options, coeffs, inliers, &report);
+  free(xPos);
+  free(yPos);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "coefficients"),
+              numberArray(isolate, coeffs, degree + 1, false));
+  result->Set(v8::String::NewFromUtf8(isolate, "inliers"),
+              v8::Uint8Array::New(buffer, 0, numPoints));
+  result->Set(v8::String::NewFromUtf8(isolate, "count"),
+              v8::Number::New(isolate, (double)count));
+  setReport(isolate, result, &report);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Evaluates a polynomial, and optionally its derivatives, into
+ *          caller-provided `Float64Array`s, interfaced with Node.js.
+ * @details The coordinates and results are read and written in place, so no
+ *          memory is allocated for them. Returns the array of values.
+ */
+void PolynomialWrapper::evaluate(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args, reading typed arrays in place
+  uint64_t numCoeffs = 0;
+  uint64_t numPoints = 0;
+  uint64_t numValues = 0;
+  uint64_t numFirst  = 0;
+  uint64_t numSecond = 0;
+  double * typed     = float64Data(args[0], &numCoeffs);
+  double * x         = float64Data(args[1], &numPoints);
+  double * values    = float64Data(args[2], &numValues);
+  double * first     = float64Data(args[3], &numFirst);
+  double * second    = float64Data(args[4], &numSecond);
+  if (!(typed || args[0]->IsArray()) || !x || !values ||
+      !(first || args[3]->IsUndefined() || args[3]->IsNull()) ||
+      !(second || args[4]->IsUndefined() || args[4]->IsNull())) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate,
+        "expected coefficients, and Float64Arrays of coordinates and "
+        "results")));
+    return;
+  }
+  if (numValues < numPoints || (first && numFirst < numPoints) ||
+      (second && numSecond < numPoints)) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "every result array needs room for each coordinate")));
+    return;
+  }
+
+  double * coeffs = typed;
+  if (!typed) {
+    v8::Local<v8::Array> _coeffs = v8::Local<v8::Array>::Cast(args[0]);
+    numCoeffs                    = _coeffs->Length();
+    coeffs = (double *)malloc((numCoeffs ? numCoeffs : 1) * sizeof(double));
+    for (uint64_t i = 0; i < numCoeffs; ++i) {
+      coeffs[i] = _coeffs->Get(i)->NumberValue();
+    }
+  }
+
+  Stats.count(STAT_POINTS_MARSHALLED, numPoints);
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  Polynomial.evaluate(coeffs, numCoeffs, x, numPoints, values, first, second);
+  if (!typed) {
+    free(coeffs);
+  }
+
+  Stats.stop(STAT_COMPUTE, phase);
 
-  delete[] coeffs;
+  args.GetReturnValue().Set(args[2]);
 }
@@ -11,6 +11,19 @@ namespace PolynomialWrapper
  */
 void bestFit(const v8::FunctionCallbackInfo<v8::Value> & args);
 
+/**
+ * @brief   Calculates a polynomial function of an arbitrary set of points that
+ *          resists outliers, interfaced with Node.js.
+ */
+void robustFit(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Evaluates a polynomial, and optionally its first and second
+ *          derivatives, over a `Float64Array` of coordinates, interfaced with
+ *          Node.js.
+ */
+void evaluate(const v8::FunctionCallbackInfo<v8::Value> & args);
+
 }  // namespace PolynomialWrapper
 
 #endif
@@ -0,0 +1,241 @@
+#include "spatial_index.h"
+
+#include "point_file.h"
+#include "tsp.h"
+#include "typed.h"
+
+extern "C"
+{
+#include "../toolkit/stats.h"
+}
+
+#include <stdlib.h>
+
+/**
+ * @brief   Creates the object holding the results of a query.
+ *
+ * @param   isolate          isolate to allocate in
+ * @param   ids              positions of the points found
+ * @param   distances        distance to each point found
+ * @param   found            number of points found
+ * @param   typed            whether to hand the results over as typed arrays
+ *
+ * @return  an object holding the positions and distances
+ */
+static v8::Local<v8::Object> queryResult(v8::Isolate *  isolate,
+                                         uint64_t *     ids,
+                                         double *       distances,
+                                         const uint64_t found,
+                                         const bool     typed)
+{
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "indices"),
+              indexArray(isolate, ids, found, typed));
+  result->Set(v8::String::NewFromUtf8(isolate, "distances"),
+              numberArray(isolate, distances, found, typed));
+  return result;
+}
+
+SpatialIndexWrapper::SpatialIndexWrapper(struct SpatialTree * tree)
+    : tree(tree)
+{
+}
+
+SpatialIndexWrapper::~SpatialIndexWrapper()
+{
+  SpatialIndex.free(tree);
+}
+
+/**
+ * @brief   Adds the `SpatialIndex` constructor to the exports.
+ */
+void SpatialIndexWrapper::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate * isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "SpatialIndex"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "size", size);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "insert", insert);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "remove", remove);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "move", move);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "nearest", nearest);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "within", within);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "SpatialIndex"),
+               tpl->GetFunction());
+}
+
+/**
+ * @brief   Builds an index over an array of points, measuring with a method
+ *          code.
+ */
+void SpatialIndexWrapper::New(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "SpatialIndex must be constructed with new")));
+    return;
+  }
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const char method = (char)(args[1]->Uint32Value());
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  SpatialIndexWrapper * index = new SpatialIndexWrapper(
+      SpatialIndex.New(&metric, source.points(), source.size()));
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  index->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+/**
+ * @brief   Returns the number of points indexed.
+ */
+void SpatialIndexWrapper::size(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate *         isolate = args.GetIsolate();
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  args.GetReturnValue().Set(
+      v8::Number::New(isolate, (double)SpatialIndex.size(index->tree)));
+}
+
+/**
+ * @brief   Adds a point to the end of the set.
+ */
+void SpatialIndexWrapper::insert(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  double point[2];
+  visitPoint(args[0], point);
+  SpatialIndex.insert(index->tree, point);
+}
+
+/**
+ * @brief   Removes the point at a position in the set.
+ */
+void SpatialIndexWrapper::remove(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  SpatialIndex.remove(index->tree, args[0]->Uint32Value());
+}
+
+/**
+ * @brief   Replaces the point at a position in the set.
+ */
+void SpatialIndexWrapper::move(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  double point[2];
+  visitPoint(args[1], point);
+  SpatialIndex.move(index->tree, args[0]->Uint32Value(), point);
+}
+
+/**
+ * @brief   Finds the `k` points nearest a query point.
+ * @details Returns the positions of the points, nearest first, and their
+ *          distances.
+ */
+void SpatialIndexWrapper::nearest(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate *         isolate = args.GetIsolate();
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  double point[2];
+  visitPoint(args[0], point);
+  const uint64_t k     = args[1]->Uint32Value();
+  const uint64_t size  = SpatialIndex.size(index->tree);
+  const uint64_t room  = k < size ? k : size;
+  const bool     typed = args[2]->BooleanValue();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  uint64_t *     ids       = (uint64_t *)malloc((room + 1) * sizeof(uint64_t));
+  double *       distances = (double *)malloc((room + 1) * sizeof(double));
+  const uint64_t found =
+      SpatialIndex.nearest(index->tree, point, k, ids, distances);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  v8::Local<v8::Object> result =
+      queryResult(isolate, ids, distances, found, typed);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Finds the points within a distance of a query point.
+ * @details Returns the positions of the points, nearest first, and their
+ *          distances.
+ */
+void SpatialIndexWrapper::within(
+    const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate *         isolate = args.GetIsolate();
+  SpatialIndexWrapper * index =
+      node::ObjectWrap::Unwrap<SpatialIndexWrapper>(args.Holder());
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  double point[2];
+  visitPoint(args[0], point);
+  const double radius = args[1]->NumberValue();
+  const bool   typed  = args[2]->BooleanValue();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  uint64_t *     ids;
+  double *       distances;
+  const uint64_t found =
+      SpatialIndex.within(index->tree, point, radius, &ids, &distances);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  v8::Local<v8::Object> result =
+      queryResult(isolate, ids, distances, found, typed);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
@@ -0,0 +1,67 @@
+#ifndef WRAPPER_SPATIAL_INDEX_H
+#define WRAPPER_SPATIAL_INDEX_H
+
+#include <node.h>
+#include <node_object_wrap.h>
+
+extern "C"
+{
+#include "../toolkit/spatial_index.h"
+}
+
+/**
+ * @brief   A native spatial index over a set of points, interfaced with
+ *          Node.js as `SpatialIndex`.
+ */
+class SpatialIndexWrapper : public node::ObjectWrap
+{
+ public:
+  /**
+   * @brief   Adds the `SpatialIndex` constructor to the exports.
+   */
+  static void Init(v8::Local<v8::Object> exports);
+
+ private:
+  explicit SpatialIndexWrapper(struct SpatialTree * tree);
+  ~SpatialIndexWrapper();
+
+  /**
+   * @brief   Builds an index over an array of points, measuring with a
+   *          method code.
+   */
+  static void New(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Returns the number of points indexed.
+   */
+  static void size(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Adds a point to the end of the set.
+   */
+  static void insert(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Removes the point at a position in the set.
+   */
+  static void remove(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Replaces the point at a position in the set.
+   */
+  static void move(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Finds the `k` points nearest a query point.
+   */
+  static void nearest(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Finds the points within a distance of a query point.
+   */
+  static void within(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  struct SpatialTree * tree;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "stats.h"
+
+extern "C"
+{
+#include "../toolkit/stats.h"
+}
+
+/**
+ * @brief   Returns the counters and phase timers collected since stats were
+ *          last enabled or reset, interfaced with Node.js.
+ * @details Timers are reported in milliseconds.
+ */
+void StatsWrapper::stats(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  v8::Local<v8::Object> _counters = v8::Object::New(isolate);
+  for (int c = 0; c < NUM_STAT_COUNTERS; ++c) {
+    const enum StatCounter counter = (enum StatCounter)c;
+    _counters->Set(
+        v8::String::NewFromUtf8(isolate, Stats.counter_name(counter)),
+        v8::Number::New(isolate, (double)Stats.counter(counter)));
+  }
+
+  v8::Local<v8::Object> _timers = v8::Object::New(isolate);
+  for (int t = 0; t < NUM_STAT_TIMERS; ++t) {
+    const enum StatTimer timer = (enum StatTimer)t;
+    _timers->Set(v8::String::NewFromUtf8(isolate, Stats.timer_name(timer)),
+                 v8::Number::New(isolate, (double)Stats.timer(timer) / 1e6));
+  }
+
+  // create object to hold counters and timers
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "enabled"),
+              v8::Boolean::New(isolate, Stats.enabled()));
+  result->Set(v8::String::NewFromUtf8(isolate, "counters"), _counters);
+  result->Set(v8::String::NewFromUtf8(isolate, "timers"), _timers);
+
+  args.GetReturnValue().Set(result);
+}
+
+/**
+ * @brief   Turns stats collection on or off, interfaced with Node.js.
+ * @details Turning collection on clears the collected stats. Returns whether
+ *          stats were being collected before the call.
+ */
+void StatsWrapper::setStats(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  const bool was_enabled = Stats.enable(args[0]->BooleanValue());
+
+  args.GetReturnValue().Set(v8::Boolean::New(isolate, was_enabled));
+}
+
+/**
+ * @brief   Clears the collected stats, interfaced with Node.js.
+ */
+void StatsWrapper::resetStats(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  (void)args;
+  Stats.reset();
+}
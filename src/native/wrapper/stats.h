@@ -0,0 +1,26 @@
+#ifndef WRAPPER_STATS_H
+#define WRAPPER_STATS_H
+
+#include <node.h>
+
+namespace StatsWrapper
+{
+/**
+ * @brief   Returns the counters and phase timers collected since stats were
+ *          last enabled or reset, interfaced with Node.js.
+ */
+void stats(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Turns stats collection on or off, interfaced with Node.js.
+ */
+void setStats(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+/**
+ * @brief   Clears the collected stats, interfaced with Node.js.
+ */
+void resetStats(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+}  // namespace StatsWrapper
+
+#endif
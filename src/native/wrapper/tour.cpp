@@ -0,0 +1,240 @@
+#include "tour.h"
+
+#include "point_file.h"
+#include "tsp.h"
+#include "typed.h"
+
+extern "C"
+{
+#include "../toolkit/stats.h"
+}
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Reads the position of a stop in the set, throwing a `RangeError`
+ *          if the tour has no such stop.
+ *
+ * @param   isolate          isolate to throw in
+ * @param   value            the JS position
+ * @param   tour             the tour
+ * @param   id               filled with the position
+ *
+ * @return  whether the tour has the stop
+ */
+static bool visitStop(v8::Isolate *                isolate,
+                      const v8::Local<v8::Value> & value,
+                      const struct LiveTour *      tour,
+                      uint64_t *                   id)
+{
+  *id = value->Uint32Value();
+  if (!value->IsUint32() || *id >= Tour.size(tour)) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "the tour has no stop at that index")));
+    return false;
+  }
+  return true;
+}
+
+TourWrapper::TourWrapper(struct LiveTour * tour) : tour(tour)
+{
+}
+
+TourWrapper::~TourWrapper()
+{
+  Tour.free(tour);
+}
+
+/**
+ * @brief   Adds the `Tour` constructor to the exports.
+ */
+void TourWrapper::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate * isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Tour"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "size", size);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "order", order);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "cost", cost);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "addStop", addStop);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "removeStop", removeStop);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "moveStop", moveStop);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Tour"), tpl->GetFunction());
+}
+
+/**
+ * @brief   Solves a tour over an array of points, with the same arguments as
+ *          `tsp`.
+ */
+void TourWrapper::New(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "Tour must be constructed with new")));
+    return;
+  }
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const uint64_t startCity = args[1]->Uint32Value();
+  const char     method    = (char)(args[2]->Uint32Value());
+  const char     type      = (char)(args[3]->Uint32Value());
+  const uint64_t endCity   = args[4]->Uint32Value();
+  const struct DistanceMetric metric =
+      visitMetric(method, v8::Undefined(isolate));
+  const enum TSPMethod solver =
+      args[5]->BooleanValue() ? TSP_HILBERT_CURVE : TSP_BY_SIZE;
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok() || !checkEnds(isolate, startCity, endCity, source.size())) {
+    return;
+  }
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  const struct TSPOptions opts = {
+      tourType(type), startCity, endCity, solver, 0, 0};
+  TourWrapper *           tour = new TourWrapper(
+      Tour.New(&metric, source.points(), source.size(), &opts));
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  tour->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+/**
+ * @brief   Returns the number of stops.
+ */
+void TourWrapper::size(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  args.GetReturnValue().Set(
+      v8::Number::New(isolate, (double)Tour.size(tour->tour)));
+}
+
+/**
+ * @brief   Returns the order in which the stops are visited, as positions in
+ *          the set.
+ */
+void TourWrapper::order(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  const bool     typed = args[0]->BooleanValue();
+  const uint64_t n     = Tour.size(tour->tour);
+
+  // the order changes with the tour, so JS is handed a copy
+  uint64_t * order = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+  memcpy(order, Tour.order(tour->tour), n * sizeof(uint64_t));
+
+  args.GetReturnValue().Set(indexArray(isolate, order, n, typed));
+}
+
+/**
+ * @brief   Returns the cost of the tour, including the return leg of closed
+ *          tours.
+ */
+void TourWrapper::cost(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  args.GetReturnValue().Set(v8::Number::New(isolate, Tour.cost(tour->tour)));
+}
+
+/**
+ * @brief   Adds a stop to the end of the set where it adds the least cost,
+ *          optionally reordering the stops around it with 2-opt. Returns the
+ *          position of the new stop in the order.
+ */
+void TourWrapper::addStop(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  Point point;
+  visitPoint(args[0], point);
+  const uint64_t repair = args[1]->Uint32Value();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  const uint64_t pos = Tour.add_stop(tour->tour, point, repair);
+
+  Stats.stop(STAT_COMPUTE, phase);
+
+  args.GetReturnValue().Set(v8::Number::New(isolate, (double)pos));
+}
+
+/**
+ * @brief   Removes the stop at a position in the set, joining the stops either
+ *          side of it, and optionally reordering the stops around the gap with
+ *          2-opt.
+ */
+void TourWrapper::removeStop(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  uint64_t id;
+  if (!visitStop(isolate, args[0], tour->tour, &id)) {
+    return;
+  }
+  const uint64_t repair = args[1]->Uint32Value();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  Tour.remove_stop(tour->tour, id, repair);
+
+  Stats.stop(STAT_COMPUTE, phase);
+}
+
+/**
+ * @brief   Moves the stop at a position in the set where it adds the least
+ *          cost, optionally reordering the stops around it with 2-opt.
+ */
+void TourWrapper::moveStop(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+  TourWrapper * tour = node::ObjectWrap::Unwrap<TourWrapper>(args.Holder());
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  uint64_t id;
+  if (!visitStop(isolate, args[0], tour->tour, &id)) {
+    return;
+  }
+  Point point;
+  visitPoint(args[1], point);
+  const uint64_t repair = args[2]->Uint32Value();
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  Tour.move_stop(tour->tour, id, point, repair);
+
+  Stats.stop(STAT_COMPUTE, phase);
+}
@@ -0,0 +1,67 @@
+#ifndef WRAPPER_TOUR_H
+#define WRAPPER_TOUR_H
+
+#include <node.h>
+#include <node_object_wrap.h>
+
+extern "C"
+{
+#include "../tour.h"
+}
+
+/**
+ * @brief   A native tour kept up to date as stops change, interfaced with
+ *          Node.js as `Tour`.
+ */
+class TourWrapper : public node::ObjectWrap
+{
+ public:
+  /**
+   * @brief   Adds the `Tour` constructor to the exports.
+   */
+  static void Init(v8::Local<v8::Object> exports);
+
+ private:
+  explicit TourWrapper(struct LiveTour * tour);
+  ~TourWrapper();
+
+  /**
+   * @brief   Solves a tour over an array of points, with the same arguments
+   *          as `tsp`.
+   */
+  static void New(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Returns the number of stops.
+   */
+  static void size(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Returns the order in which the stops are visited.
+   */
+  static void order(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Returns the cost of the tour.
+   */
+  static void cost(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Adds a stop where it adds the least cost.
+   */
+  static void addStop(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Removes the stop at a position in the set.
+   */
+  static void removeStop(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  /**
+   * @brief   Moves the stop at a position in the set.
+   */
+  static void moveStop(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+  struct LiveTour * tour;
+};
+
+#endif
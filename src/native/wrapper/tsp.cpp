@@ -1,65 +1,220 @@
 #include "tsp.h"
 
+#include "point_file.h"
+#include "typed.h"
+
 extern "C"
 {
+#include "../toolkit/stats.h"
 #include "../tsp.h"
 }
 
+#include <math.h>
+
 /**
- * @brief   Returns the degree of norm corresponding to a method of the
- *          Travelling Salesman Problem.
+ * @brief   Returns the metric corresponding to a method of measuring distance.
+ * @details A custom matrix is read in place from a `Float64Array` of `n * n`
+ *          distances, so it must outlive the metric.
  *
  * @param   m      method
+ * @param   matrix precomputed distances, for the custom matrix method
  *
- * @return  the degree of norm to use
+ * @return  the metric to measure with
  */
-uint64_t visitMethod(const char m)
+struct DistanceMetric visitMetric(const char m,
+                                  const v8::Local<v8::Value> & matrix)
 {
   switch (m) {
     case 't':  // TSP
-      return 2;
+      return METRIC_EUCLIDEAN;
     case 'n':  // Naive VRP
-      return 1;
+      return {METRIC_L1, 'm', NULL, 0};
+    case 'h':  // haversine, in kilometers
+      return {METRIC_HAVERSINE, 'm', NULL, 0};
+    case 'm':  // custom matrix
+      if (matrix->IsFloat64Array()) {
+        v8::Local<v8::Float64Array> _matrix =
+            v8::Local<v8::Float64Array>::Cast(matrix);
+        const char * data =
+            (const char *)_matrix->Buffer()->GetContents().Data();
+        return {METRIC_MATRIX,
+                'm',
+                (const double *)(data + _matrix->ByteOffset()),
+                (uint64_t)sqrt((double)_matrix->Length())};
+      }
+      return METRIC_EUCLIDEAN;
+
+    default:
+      return METRIC_EUCLIDEAN;
+  }
+}
+
+/**
+ * @brief   Returns the shape of tour corresponding to a tour type code.
+ *
+ * @param   t      tour type
+ *
+ * @return  the shape of tour to solve for
+ */
+enum TourType tourType(const char t)
+{
+  switch (t) {
+    case 'c':  // closed
+      return TOUR_CLOSED;
+    case 'f':  // fixed start and end
+      return TOUR_FIXED_ENDS;
+    case 'o':  // open
+      return TOUR_OPEN;
 
     default:
-      return 2;
+      return TOUR_OPEN;
+  }
+}
+
+/**
+ * @brief   Checks that the start and end of a tour are among its points,
+ *          throwing a RangeError if not.
+ *
+ * @param   isolate    isolate to throw in
+ * @param   start      index of the first point of the tour
+ * @param   end        index of the last point of the tour
+ * @param   numPoints  number of points in the tour; nothing is checked for
+ *                     none
+ *
+ * @return  whether both are among the points
+ */
+bool checkEnds(v8::Isolate *  isolate,
+               const uint64_t start,
+               const uint64_t end,
+               const uint64_t numPoints)
+{
+  if (numPoints && (start >= numPoints || end >= numPoints)) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "The start and end must be indices of the points")));
+    return false;
   }
+  return true;
+}
+
+/**
+ * @brief   Checks that a custom matrix has a distance for each pair of points,
+ *          throwing a RangeError if not.
+ *
+ * @param   isolate    isolate to throw in
+ * @param   metric     metric from `visitMetric`; only a custom matrix is
+ *                     checked
+ * @param   matrix     precomputed distances the metric was read from
+ * @param   numPoints  number of points to measure
+ *
+ * @return  whether the matrix fits the points
+ */
+bool checkMatrix(v8::Isolate *                 isolate,
+                 const struct DistanceMetric & metric,
+                 const v8::Local<v8::Value> &  matrix,
+                 const uint64_t                numPoints)
+{
+  if (metric.type == METRIC_MATRIX &&
+      v8::Local<v8::Float64Array>::Cast(matrix)->Length() !=
+          numPoints * numPoints) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "The cost matrix must have n * n entries for n points")));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Adds how far an anytime solve got to the object holding its
+ *          results, as `partial`, `precision`, and `iterations`.
+ *
+ * @param   isolate  isolate to allocate in
+ * @param   result   object holding the results of the solve
+ * @param   report   how far the solve got
+ */
+void setReport(v8::Isolate *                 isolate,
+               const v8::Local<v8::Object> & result,
+               const struct SolveReport *    report)
+{
+  result->Set(v8::String::NewFromUtf8(isolate, "partial"),
+              v8::Boolean::New(isolate, report->partial));
+  result->Set(v8::String::NewFromUtf8(isolate, "precision"),
+              v8::Number::New(isolate, report->precision));
+  result->Set(v8::String::NewFromUtf8(isolate, "iterations"),
+              v8::Number::New(isolate, (double)report->iterations));
 }
 
 /**
  * @brief   Determines the shortest-travel path between planar points,
  *          interfaced with Node.js.
+ * @details The order is returned as a `Uint32Array` over native memory when
+ *          a typed result is asked for. Solving stops at the deadline or
+ *          iteration limit if given. If asked, the result also tells whether
+ *          it did, the improvements made, and the gap to a lower bound on the
+ *          cost, which takes another pass over the cost matrix.
  */
 void TSPWrapper::solve(const v8::FunctionCallbackInfo<v8::Value> & args)
 {
   v8::Isolate * isolate = args.GetIsolate();
 
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
   // get args
-  v8::Local<v8::Array> _points   = v8::Local<v8::Array>::Cast(args[0]);
-  const uint64_t       numPoints = _points->Length();
-  const uint64_t       startCity = args[1]->Uint32Value();
-  const char           method    = (char)(args[2]->Uint32Value());
-
-  // pass locations to C++ array
-  double points[numPoints][2];
-  for (uint64_t i = 0; i < numPoints; ++i) {
-    v8::Local<v8::Array> _element = v8::Local<v8::Array>::Cast(_points->Get(i));
-    points[i][0]                  = _element->Get(0)->NumberValue();
-    points[i][1]                  = _element->Get(1)->NumberValue();
+  const uint64_t startCity = args[1]->Uint32Value();
+  const char     method    = (char)(args[2]->Uint32Value());
+  const char     type      = (char)(args[3]->Uint32Value());
+  const uint64_t endCity   = args[4]->Uint32Value();
+  const struct DistanceMetric metric = visitMetric(method, args[5]);
+  const bool                  typed  = args[6]->BooleanValue();
+  const enum TSPMethod solver =
+      args[7]->BooleanValue() ? TSP_HILBERT_CURVE : TSP_BY_SIZE;
+  const double   deadline      = args[8]->NumberValue();
+  const uint64_t maxIterations = args[9]->Uint32Value();
+  const bool     reported      = args[10]->BooleanValue();
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+  const Point *  points    = source.points();
+  const uint64_t numPoints = source.size();
+  if (!checkEnds(isolate, startCity, endCity, numPoints) ||
+      !checkMatrix(isolate, metric, args[5], numPoints)) {
+    return;
   }
 
-  uint64_t * order = TSP.solve((const double **)points,
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  const struct TSPOptions opts = {
+      tourType(type), startCity, endCity, solver, deadline, maxIterations};
+  double             cost  = 0;
+  struct SolveReport report;
+  uint64_t *         order = TSP.solve((const double **)points,
                                numPoints,
                                2,
-                               startCity,
-                               visitMethod(method));
+                               &opts,
+                               &metric,
+                               &cost,
+                               reported ? &report : NULL);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // hand the order over to JS
+  v8::Local<v8::Value> _order = indexArray(isolate, order, numPoints, typed);
 
-  v8::Local<v8::Array> _order = v8::Array::New(isolate);
-  for (uint64_t i = 0; i < numPoints; ++i) {
-    _order->Set(i, v8::Number::New(isolate, order[i]));
+  // create object to hold order and cost
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "order"), _order);
+  result->Set(v8::String::NewFromUtf8(isolate, "cost"),
+              v8::Number::New(isolate, cost));
+  if (reported) {
+    setReport(isolate, result, &report);
   }
 
-  delete[] order;
+  Stats.stop(STAT_BUILD_RESULT, phase);
 
-  args.GetReturnValue().Set(_order);
+  args.GetReturnValue().Set(result);
 }
@@ -2,6 +2,80 @@
 #define WRAPPER_TSP_H
 
 #include <node.h>
+#include <stdint.h>
+
+extern "C"
+{
+#include "../toolkit/metric.h"
+#include "../tsp.h"
+}
+
+/**
+ * @brief   Returns the metric corresponding to a method of measuring distance.
+ * @details A custom matrix is read in place from a `Float64Array` of `n * n`
+ *          distances, so it must outlive the metric.
+ *
+ * @param   m      method
+ * @param   matrix precomputed distances, for the custom matrix method
+ *
+ * @return  the metric to measure with
+ */
+struct DistanceMetric visitMetric(char m, const v8::Local<v8::Value> & matrix);
+
+/**
+ * @brief   Returns the shape of tour corresponding to a tour type code.
+ *
+ * @param   t      tour type
+ *
+ * @return  the shape of tour to solve for
+ */
+enum TourType tourType(char t);
+
+/**
+ * @brief   Checks that the start and end of a tour are among its points,
+ *          throwing a RangeError if not.
+ *
+ * @param   isolate    isolate to throw in
+ * @param   start      index of the first point of the tour
+ * @param   end        index of the last point of the tour
+ * @param   numPoints  number of points in the tour; nothing is checked for
+ *                     none
+ *
+ * @return  whether both are among the points
+ */
+bool checkEnds(v8::Isolate *  isolate,
+               uint64_t       start,
+               uint64_t       end,
+               uint64_t       numPoints);
+
+/**
+ * @brief   Checks that a custom matrix has a distance for each pair of points,
+ *          throwing a RangeError if not.
+ *
+ * @param   isolate    isolate to throw in
+ * @param   metric     metric from `visitMetric`; only a custom matrix is
+ *                     checked
+ * @param   matrix     precomputed distances the metric was read from
+ * @param   numPoints  number of points to measure
+ *
+ * @return  whether the matrix fits the points
+ */
+bool checkMatrix(v8::Isolate *                 isolate,
+                 const struct DistanceMetric & metric,
+                 const v8::Local<v8::Value> &  matrix,
+                 uint64_t                      numPoints);
+
+/**
+ * @brief   Adds how far an anytime solve got to the object holding its
+ *          results, as `partial`, `precision`, and `iterations`.
+ *
+ * @param   isolate  isolate to allocate in
+ * @param   result   object holding the results of the solve
+ * @param   report   how far the solve got
+ */
+void setReport(v8::Isolate *                 isolate,
+               const v8::Local<v8::Object> & result,
+               const struct SolveReport *    report);
 
 namespace TSPWrapper
 {
@@ -0,0 +1,166 @@
+#include "typed.h"
+
+#include <node_buffer.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Frees a native array once the JS view over it is collected.
+ *
+ * @param   data             array to free
+ * @param   hint             unused
+ */
+static void freeExternal(char * data, void * hint)
+{
+  (void)hint;
+  free(data);
+}
+
+/**
+ * @brief   Wraps a native buffer in an `ArrayBuffer` that owns it.
+ *
+ * @param   isolate          isolate to create the buffer in
+ * @param   data             buffer to hand over
+ * @param   bytes            size of the buffer
+ *
+ * @return  the buffer
+ */
+static v8::Local<v8::ArrayBuffer> externalArrayBuffer(v8::Isolate * isolate,
+                                                      void *        data,
+                                                      const size_t  bytes)
+{
+  if (!bytes) {
+    free(data);
+    return v8::ArrayBuffer::New(isolate, 0);
+  }
+  v8::Local<v8::Object> buffer =
+      node::Buffer::New(isolate, (char *)data, bytes, freeExternal, NULL)
+          .ToLocalChecked();
+  return v8::Local<v8::Uint8Array>::Cast(buffer)->Buffer();
+}
+
+/**
+ * @brief   Hands a native array of doubles to JS as a `Float64Array`, without
+ *          copying it.
+ * @details The array must have been allocated with `malloc`; the returned view
+ *          takes ownership of it, and frees it once garbage collected.
+ *
+ * @param   isolate          isolate to create the view in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ *
+ * @return  a view over the array
+ */
+v8::Local<v8::Float64Array> externalFloat64Array(v8::Isolate *  isolate,
+                                                 double *       data,
+                                                 const uint64_t length)
+{
+  return v8::Float64Array::New(
+      externalArrayBuffer(isolate, data, length * sizeof(double)), 0, length);
+}
+
+/**
+ * @brief   Hands a native array of indeces to JS as a `Uint32Array`, without
+ *          copying it.
+ * @details The indeces are narrowed to 32 bits in place. The array must have
+ *          been allocated with `malloc`; the returned view takes ownership of
+ *          it, and frees it once garbage collected.
+ *
+ * @param   isolate          isolate to create the view in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ *
+ * @return  a view over the array
+ */
+v8::Local<v8::Uint32Array> externalUint32Array(v8::Isolate *  isolate,
+                                               uint64_t *     data,
+                                               const uint64_t length)
+{
+  // each narrowed index lands at or before the wide one it came from
+  char * bytes = (char *)data;
+  for (uint64_t i = 0; i < length; ++i) {
+    const uint32_t index = (uint32_t)data[i];
+    memcpy(bytes + i * sizeof index, &index, sizeof index);
+  }
+  return v8::Uint32Array::New(
+      externalArrayBuffer(isolate, data, length * sizeof(uint32_t)), 0, length);
+}
+
+/**
+ * @brief   Hands a native array of doubles to JS.
+ * @details Returns a `Float64Array` view over the array if `typed`, or else
+ *          copies it into an Array and frees it. Either way, the array must
+ *          have been allocated with `malloc`, and is owned by JS afterwards.
+ *
+ * @param   isolate          isolate to create the array in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ * @param   typed            whether to hand over a view
+ *
+ * @return  the JS array
+ */
+v8::Local<v8::Value> numberArray(v8::Isolate *  isolate,
+                                 double *       data,
+                                 const uint64_t length,
+                                 const bool     typed)
+{
+  if (typed) {
+    return externalFloat64Array(isolate, data, length);
+  }
+
+  v8::Local<v8::Array> array = v8::Array::New(isolate, length);
+  for (uint64_t i = 0; i < length; ++i) {
+    array->Set(i, v8::Number::New(isolate, data[i]));
+  }
+  free(data);
+  return array;
+}
+
+/**
+ * @brief   Hands a native array of indeces to JS.
+ * @details Returns a `Uint32Array` view over the array if `typed`, or else
+ *          copies it into an Array and frees it. Either way, the array must
+ *          have been allocated with `malloc`, and is owned by JS afterwards.
+ *
+ * @param   isolate          isolate to create the array in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ * @param   typed            whether to hand over a view
+ *
+ * @return  the JS array
+ */
+v8::Local<v8::Value> indexArray(v8::Isolate *  isolate,
+                                uint64_t *     data,
+                                const uint64_t length,
+                                const bool     typed)
+{
+  if (typed) {
+    return externalUint32Array(isolate, data, length);
+  }
+
+  v8::Local<v8::Array> array = v8::Array::New(isolate, length);
+  for (uint64_t i = 0; i < length; ++i) {
+    array->Set(i, v8::Number::New(isolate, (double)data[i]));
+  }
+  free(data);
+  return array;
+}
+
+/**
+ * @brief   Reads the doubles of a `Float64Array` in place.
+ *
+ * @param   value            the array
+ * @param   length           filled with the number of elements
+ *
+ * @return  the elements, or NULL if the value is not a `Float64Array`
+ */
+double * float64Data(const v8::Local<v8::Value> & value, uint64_t * length)
+{
+  if (!value->IsFloat64Array()) {
+    return NULL;
+  }
+  v8::Local<v8::Float64Array> array = v8::Local<v8::Float64Array>::Cast(value);
+  char * data = (char *)array->Buffer()->GetContents().Data();
+  *length     = array->Length();
+  return (double *)(data + array->ByteOffset());
+}
@@ -0,0 +1,86 @@
+#ifndef WRAPPER_TYPED_H
+#define WRAPPER_TYPED_H
+
+#include <node.h>
+#include <stdint.h>
+
+/**
+ * @brief   Hands a native array of doubles to JS as a `Float64Array`, without
+ *          copying it.
+ * @details The array must have been allocated with `malloc`; the returned view
+ *          takes ownership of it, and frees it once garbage collected.
+ *
+ * @param   isolate          isolate to create the view in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ *
+ * @return  a view over the array
+ */
+v8::Local<v8::Float64Array> externalFloat64Array(v8::Isolate * isolate,
+                                                 double *      data,
+                                                 uint64_t      length);
+
+/**
+ * @brief   Hands a native array of indeces to JS as a `Uint32Array`, without
+ *          copying it.
+ * @details The indeces are narrowed to 32 bits in place. The array must have
+ *          been allocated with `malloc`; the returned view takes ownership of
+ *          it, and frees it once garbage collected.
+ *
+ * @param   isolate          isolate to create the view in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ *
+ * @return  a view over the array
+ */
+v8::Local<v8::Uint32Array> externalUint32Array(v8::Isolate * isolate,
+                                               uint64_t *    data,
+                                               uint64_t      length);
+
+/**
+ * @brief   Hands a native array of doubles to JS.
+ * @details Returns a `Float64Array` view over the array if `typed`, or else
+ *          copies it into an Array and frees it. Either way, the array must
+ *          have been allocated with `malloc`, and is owned by JS afterwards.
+ *
+ * @param   isolate          isolate to create the array in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ * @param   typed            whether to hand over a view
+ *
+ * @return  the JS array
+ */
+v8::Local<v8::Value> numberArray(v8::Isolate * isolate,
+                                 double *      data,
+                                 uint64_t      length,
+                                 bool          typed);
+
+/**
+ * @brief   Hands a native array of indeces to JS.
+ * @details Returns a `Uint32Array` view over the array if `typed`, or else
+ *          copies it into an Array and frees it. Either way, the array must
+ *          have been allocated with `malloc`, and is owned by JS afterwards.
+ *
+ * @param   isolate          isolate to create the array in
+ * @param   data             array to hand over
+ * @param   length           number of elements
+ * @param   typed            whether to hand over a view
+ *
+ * @return  the JS array
+ */
+v8::Local<v8::Value> indexArray(v8::Isolate * isolate,
+                                uint64_t *    data,
+                                uint64_t      length,
+                                bool          typed);
+
+/**
+ * @brief   Reads the doubles of a `Float64Array` in place.
+ *
+ * @param   value            the array
+ * @param   length           filled with the number of elements
+ *
+ * @return  the elements, or NULL if the value is not a `Float64Array`
+ */
+double * float64Data(const v8::Local<v8::Value> & value, uint64_t * length);
+
+#endif
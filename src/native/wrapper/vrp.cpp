@@ -0,0 +1,147 @@
+#include "vrp.h"
+
+#include "point_file.h"
+#include "tsp.h"
+#include "typed.h"
+
+extern "C"
+{
+#include "../toolkit/stats.h"
+#include "../vrp.h"
+}
+
+#include <stdlib.h>
+
+/**
+ * @brief   Determines capacitated routes for a fleet of vehicles between
+ *          planar points, interfaced with Node.js.
+ * @details Routes are returned as `Uint32Array`s over native memory when a
+ *          typed result is asked for. A `PointFile` is routed in place.
+ */
+void VRPWrapper::solve(const v8::FunctionCallbackInfo<v8::Value> & args)
+{
+  v8::Isolate * isolate = args.GetIsolate();
+
+  Stats.count(STAT_CALLS, 1);
+  uint64_t phase = Stats.start();
+
+  // get args
+  const uint64_t              numVehicles = args[1]->Uint32Value();
+  const uint64_t              depot       = args[4]->Uint32Value();
+  const char                  method      = (char)(args[5]->Uint32Value());
+  const struct DistanceMetric metric      = visitMetric(method, args[6]);
+  const bool                  typed       = args[7]->BooleanValue();
+
+  // read locations, in place for a mapped file
+  PointSource source(isolate, args[0]);
+  if (!source.ok()) {
+    return;
+  }
+  const Point *  points    = source.points();
+  const uint64_t numPoints = source.size();
+
+  if (numPoints && depot >= numPoints) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "The depot must be the index of one of the points")));
+    return;
+  }
+  if (!checkMatrix(isolate, metric, args[6], numPoints)) {
+    return;
+  }
+
+  // capacities may be given per vehicle, or once for the whole fleet; an
+  // infinite one leaves a vehicle unlimited
+  if (args[2]->IsArray() &&
+      v8::Local<v8::Array>::Cast(args[2])->Length() != numVehicles) {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "There must be one capacity for each vehicle")));
+    return;
+  }
+  double * capacities =
+      (double *)malloc((numVehicles ? numVehicles : 1) * sizeof(double));
+  bool valid = true;
+  for (uint64_t v = 0; v < numVehicles; ++v) {
+    capacities[v] = args[2]->IsArray()
+                        ? v8::Local<v8::Array>::Cast(args[2])
+                              ->Get(v)
+                              ->NumberValue()
+                        : args[2]->NumberValue();
+    valid         = valid && capacities[v] >= 0;
+  }
+  if (!valid) {
+    free(capacities);
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(
+        isolate, "Capacities must be numbers of at least 0")));
+    return;
+  }
+
+  // stops without a demand take up no capacity
+  double * demands =
+      (double *)malloc((numPoints ? numPoints : 1) * sizeof(double));
+  for (uint64_t i = 0; i < numPoints; ++i) {
+    demands[i] = 0;
+  }
+  if (args[3]->IsArray()) {
+    v8::Local<v8::Array> _demands = v8::Local<v8::Array>::Cast(args[3]);
+    for (uint64_t i = 0; i < numPoints && i < _demands->Length(); ++i) {
+      demands[i] = _demands->Get(i)->NumberValue();
+    }
+  }
+
+  Stats.stop(STAT_MARSHAL, phase);
+  phase = Stats.start();
+
+  const struct VRPFleet fleet    = {numVehicles, capacities, demands, depot};
+  struct VRPSolution    solution = VRP.solve((const double **)points,
+                                          numPoints,
+                                          2,
+                                          &fleet,
+                                          &metric);
+  free(capacities);
+  free(demands);
+
+  Stats.stop(STAT_COMPUTE, phase);
+  phase = Stats.start();
+
+  // convert each vehicle's route back to JS, as views over the stops when
+  // typed
+  v8::Local<v8::Array> _routes = v8::Array::New(isolate, numVehicles);
+  if (typed) {
+    v8::Local<v8::Uint32Array> _stops = externalUint32Array(
+        isolate, solution.stops, solution.route_offsets[numVehicles]);
+    solution.stops = NULL;
+    for (uint64_t v = 0; v < numVehicles; ++v) {
+      const uint64_t first = solution.route_offsets[v];
+      const uint64_t last  = solution.route_offsets[v + 1];
+      _routes->Set(v,
+                   v8::Uint32Array::New(_stops->Buffer(),
+                                        first * sizeof(uint32_t),
+                                        last - first));
+    }
+  } else {
+    for (uint64_t v = 0; v < numVehicles; ++v) {
+      v8::Local<v8::Array> _route = v8::Array::New(isolate);
+      const uint64_t       first  = solution.route_offsets[v];
+      for (uint64_t k = first; k < solution.route_offsets[v + 1]; ++k) {
+        _route->Set(k - first, v8::Number::New(isolate, solution.stops[k]));
+      }
+      _routes->Set(v, _route);
+    }
+  }
+  v8::Local<v8::Value> _unserved =
+      indexArray(isolate, solution.unserved, solution.num_unserved, typed);
+  solution.unserved = NULL;
+
+  // create object to hold routes, unserved stops, and cost
+  v8::Local<v8::Object> result = v8::Object::New(isolate);
+  result->Set(v8::String::NewFromUtf8(isolate, "routes"), _routes);
+  result->Set(v8::String::NewFromUtf8(isolate, "unserved"), _unserved);
+  result->Set(v8::String::NewFromUtf8(isolate, "cost"),
+              v8::Number::New(isolate, solution.cost));
+
+  VRP.free_solution(&solution);
+
+  Stats.stop(STAT_BUILD_RESULT, phase);
+
+  args.GetReturnValue().Set(result);
+}
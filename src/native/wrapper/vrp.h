@@ -0,0 +1,16 @@
+#ifndef WRAPPER_VRP_H
+#define WRAPPER_VRP_H
+
+#include <node.h>
+
+namespace VRPWrapper
+{
+/**
+ * @brief   Determines capacitated routes for a fleet of vehicles between
+ *          planar points, interfaced with Node.js.
+ */
+void solve(const v8::FunctionCallbackInfo<v8::Value> & args);
+
+}  // namespace VRPWrapper
+
+#endif
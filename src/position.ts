@@ -1,4 +1,19 @@
-import { CenterOptions } from './interfaces/index';
+import {
+  AnytimeCenter,
+  AnytimePath,
+  CenterOptions,
+  FleetOptions,
+  FleetRoutes,
+  Medoid,
+  NativeStats,
+  Neighbors,
+  PointBatch,
+  PointFileOptions,
+  RobustFit,
+  RobustFitOptions,
+  Summary,
+  TypedFleetRoutes,
+} from './interfaces/index';
 import { arrayUtil as importArrayUtil } from './util/array';
 import * as Bindings from 'bindings';
 const CLIB = Bindings('api');
@@ -6,6 +21,22 @@ const Method = {
   tsp: 't'.charCodeAt(0),
   naiveVrp: 'n'.charCodeAt(0),
 };
+const Metric = {
+  l2: Method['tsp'],
+  l1: Method['naiveVrp'],
+  haversine: 'h'.charCodeAt(0),
+  matrix: 'm'.charCodeAt(0),
+};
+const TourType = {
+  open: 'o'.charCodeAt(0),
+  closed: 'c'.charCodeAt(0),
+  fixed: 'f'.charCodeAt(0),
+};
+const FitMethod = {
+  huber: 'h'.charCodeAt(0),
+  tukey: 't'.charCodeAt(0),
+  ransac: 'r'.charCodeAt(0),
+};
 
 importArrayUtil();
 
@@ -30,11 +61,30 @@ importArrayUtil();
  * Plane.score // => 0.010113270070291593
  * ```
  *
+ * With the `stats` option, every native call records what it did in
+ * `Plane.stats`: counters of the work done (`calls`, `pointsMarshalled`,
+ * `centerIterations`, `twoOptPasses`, ...), and the milliseconds spent
+ * converting arguments (`marshal`), computing (`compute`), and building the
+ * result (`buildResult`).
+ *
+ * The `deadlineMs` and `maxIterations` options bound the geometric center
+ * search and the tour solvers: once either runs out, they settle for the best
+ * result found so far. Position#anytimeCenter and Position#anytimePath tell
+ * whether they did, and how close the result is known to be.
+ *
  * @class
  */
 class Position {
   locations: Array<Array<number>>;
   options: CenterOptions;
+  stats: NativeStats;
+  private file: any;
+  private index: any;
+  private indexed: any;
+  private indexMetric: number;
+  private tour: any;
+  private toured: any;
+  private tourShape: string;
 
   /**
    * Default geometric center options
@@ -48,7 +98,13 @@ class Position {
     epsilon: 1e-3,
     bounds: 10,
     startIndex: 0,
+    endIndex: 0,
+    tour: 'open',
+    approximate: false,
     degree: null,
+    stats: false,
+    deadlineMs: 0,
+    maxIterations: 0,
   };
 
   /**
@@ -64,6 +120,128 @@ class Position {
     this.options = { ...Position.defaultCenterOptions, ...options };
   }
 
+  /**
+   * Packs sets of locations into the layout of the native batch calls,
+   * `CLIB.meanBatch`, `CLIB.geometricBatch`, and `CLIB.tspBatch`: the
+   * coordinates of every set one after another, and the index of the first
+   * location of each set, followed by the total number of locations. A batch
+   * solves all of its sets in a single native call, spread across threads.
+   *
+   * @name Position.pack
+   * @function
+   * @param {Array} sets 3D Array of sets of locations
+   * @return {PointBatch} Packed coordinates and offsets of the sets
+   *
+   * ```
+   * const { points, offsets } = Position.pack([[[0, 0], [2, 0]], [[1, 1]]]);
+   * CLIB.meanBatch(points, offsets).centers; // => [1, 0, 1, 1]
+   * ```
+   */
+  static pack(sets: Array<Array<Array<number>>>): PointBatch {
+    const offsets = new Uint32Array(sets.length + 1);
+    sets.forEach((set, s) => (offsets[s + 1] = offsets[s] + set.length));
+    const points = new Float64Array(2 * offsets[sets.length]);
+    sets.forEach((set, s) =>
+      set.forEach((location, i) => {
+        points[2 * (offsets[s] + i)] = location[0];
+        points[2 * (offsets[s] + i) + 1] = location[1];
+      }),
+    );
+    return { points, offsets };
+  }
+
+  /**
+   * Fits a best-fit polynomial to each of many series sampled at the same x
+   * coordinates. The Vandermonde system is built and factored once for the
+   * shared coordinates, and every series is then solved against it, spread
+   * across threads.
+   *
+   * @name Position.bestFits
+   * @function
+   * @param {Float64Array} xs x coordinates shared by every series
+   * @param {Float64Array} series y coordinates of every series, one series
+   * after another
+   * @param {number} [degree=0] Degree of every polynomial, or 0 to guess it
+   * from the first series
+   * @return {Float64Array} Coefficients of each fit, one fit after another,
+   * where each index of a fit corresponds to its degree
+   *
+   * ```
+   * const xs = new Float64Array([0, 1, 2]);
+   * const series = new Float64Array([1, 2, 5, 0, 2, 4]); // 1 + x^2, 2x
+   * Position.bestFits(xs, series, 2); // => [1, 0, 1, 0, 2, 0]
+   * ```
+   */
+  static bestFits(
+    xs: Float64Array,
+    series: Float64Array,
+    degree: number = 0,
+  ): Float64Array {
+    return CLIB.bestFitBatch(xs, series, degree);
+  }
+
+  /**
+   * Creates a Position over the points of a binary point file, written by
+   * Position#toFile. The file is memory-mapped, and native calls read the
+   * points from it directly rather than converting them from JS. The
+   * locations are only read into an Array when first accessed, after which
+   * the Position behaves as one created from that Array.
+   *
+   * @name Position.fromFile
+   * @function
+   * @param {string} path Path of the point file
+   * @param {CenterOptions} [options=Position.defaultCenterOptions] General
+   * search options
+   * @return {Position} Position over the points of the file
+   *
+   * ```
+   * new Position([[0, 1], [1, 0]]).toFile('points.bin');
+   * Position.fromFile('points.bin').center; // => [0.5, 0.5]
+   * ```
+   */
+  static fromFile(path: string, options: CenterOptions = {}): Position {
+    const plane = new Position([], options);
+    const file = new CLIB.PointFile(path);
+    const detach = (locations: Array<Array<number>>) => {
+      Object.defineProperty(plane, 'locations', {
+        configurable: true,
+        enumerable: true,
+        writable: true,
+        value: locations,
+      });
+      plane.file = null;
+      file.close();
+    };
+    Object.defineProperty(plane, 'locations', {
+      configurable: true,
+      enumerable: true,
+      get: () => {
+        detach(file.locations());
+        return plane.locations;
+      },
+      set: detach,
+    });
+    plane.file = file;
+    return plane;
+  }
+
+  /**
+   * Writes the locations to a binary point file, to be loaded with
+   * Position.fromFile. The file is in the byte order of this machine, and
+   * machines of the other byte order refuse to load it.
+   *
+   * @name Position#toFile
+   * @function
+   * @param {string} path Path of the point file
+   * @param {PointFileOptions} [options={}] A weight for each location, and
+   * whether to store coordinates in single precision
+   */
+  toFile(path: string, options: PointFileOptions = {}): void {
+    this.native(() =>
+      CLIB.writePoints(path, this.points, options.weights, options.float32),
+    );
+  }
+
   /**
    * Adds a location to the set of points.
    *
@@ -77,7 +255,15 @@ class Position {
    * ```
    */
   add(location: Array<number>): void {
+    const index = this.keptIndex;
+    const tour = this.keptTour;
     this.locations.push(location);
+    if (index) {
+      index.insert(location);
+    }
+    if (tour) {
+      tour.addStop(location, 0);
+    }
   }
 
   /**
@@ -96,6 +282,14 @@ class Position {
   remove(location: Array<number>): Array<number> | number {
     const idx = this.locations.deepIndexOf(location);
     if (idx > -1) {
+      const index = this.keptIndex;
+      const tour = this.keptTour;
+      if (index) {
+        index.remove(idx);
+      }
+      if (tour) {
+        tour.removeStop(idx, 0);
+      }
       return this.locations.splice(idx, 1)[0];
     }
     return idx;
@@ -118,13 +312,150 @@ class Position {
   move(location: Array<number>, to: Array<number>): Array<number> | number {
     const idx = this.locations.deepIndexOf(location);
     if (idx > -1) {
+      const index = this.keptIndex;
+      const tour = this.keptTour;
+      if (index) {
+        index.move(idx, to);
+      }
+      if (tour) {
+        tour.moveStop(idx, to, 0);
+      }
       return this.locations.splice(idx, 1, to)[0];
     }
     return idx;
   }
 
   /**
-   * Calculates the geometric center of the Position.
+   * Adds a location as a stop of Position#path, visited where it adds the
+   * least cost, without solving the tour again. Takes time linear in the
+   * number of locations, where Position#bestPath is quadratic or worse.
+   *
+   * @name Position#addStop
+   * @function
+   * @param {Array} location Point to add
+   * @param {number} [repair=0] If not 0, how many stops either side of the
+   * new one may be reordered by 2-opt afterwards
+   * @return {number} Position of the new stop in Position#path
+   *
+   * ```
+   * let plane = new Position([[0, 0], [2, 0]]);
+   * plane.addStop([1, 0]); // => 1
+   * plane.path; // => [0, 2, 1]
+   * ```
+   */
+  addStop(location: Array<number>, repair: number = 0): number {
+    const locations = this.locations;
+    const tour = this.liveTour;
+    const index = this.keptIndex;
+    locations.push(location);
+    if (index) {
+      index.insert(location);
+    }
+    return this.native(() => tour.addStop(location, repair));
+  }
+
+  /**
+   * Removes a location, and its stop from Position#path, joining the stops
+   * either side of it without solving the tour again.
+   *
+   * @name Position#removeStop
+   * @function
+   * @param {Array} location Point to remove
+   * @param {number} [repair=0] If not 0, how many stops either side of the
+   * gap may be reordered by 2-opt afterwards
+   * @return {Array|number} The removed location, or `-1` if no match is found
+   *
+   * ```
+   * let plane = new Position([[0, 0], [1, 0], [2, 0]]);
+   * plane.removeStop([1, 0]); // => [1, 0]
+   * plane.path; // => [0, 1]
+   * ```
+   */
+  removeStop(
+    location: Array<number>,
+    repair: number = 0,
+  ): Array<number> | number {
+    const idx = this.locations.deepIndexOf(location);
+    if (idx > -1) {
+      const tour = this.liveTour;
+      const index = this.keptIndex;
+      if (index) {
+        index.remove(idx);
+      }
+      this.native(() => tour.removeStop(idx, repair));
+      return this.locations.splice(idx, 1)[0];
+    }
+    return idx;
+  }
+
+  /**
+   * Finds the `k` locations nearest to a point, under the configured `metric`
+   * (a custom matrix measures euclidean). Queries run against a native k-d
+   * tree, built on first use and kept up to date by Position#add,
+   * Position#remove, and Position#move.
+   *
+   * @name Position#nearest
+   * @function
+   * @param {Array} point Point to search around
+   * @param {number} [k=1] Number of locations to find
+   * @return {Neighbors} Indeces of the nearest locations, nearest first, and
+   * their distances
+   *
+   * ```
+   * let plane = new Position([[0, 0], [5, 5], [1, 1]]);
+   * plane.nearest([0.9, 0.9], 2); // => { indices: [2, 0], distances: ... }
+   * ```
+   */
+  nearest(point: Array<number>, k: number = 1): Neighbors {
+    return this.native(() => this.spatialIndex.nearest(point, k, false));
+  }
+
+  /**
+   * Finds the locations within a distance of a point, under the configured
+   * `metric`, with the same native index as Position#nearest.
+   *
+   * @name Position#within
+   * @function
+   * @param {Array} point Point to search around
+   * @param {number} radius Largest distance to include
+   * @return {Neighbors} Indeces of the locations found, nearest first, and
+   * their distances
+   *
+   * ```
+   * let plane = new Position([[0, 0], [5, 5], [1, 1]]);
+   * plane.within([0, 0], 2).indices; // => [0, 2]
+   * ```
+   */
+  within(point: Array<number>, radius: number): Neighbors {
+    return this.native(() => this.spatialIndex.within(point, radius, false));
+  }
+
+  /**
+   * Assigns each location to its nearest center, under the configured `metric`
+   * (a custom matrix measures euclidean), in one native pass split across
+   * threads. Many centers are searched through a k-d tree over them.
+   *
+   * @name Position#assign
+   * @function
+   * @param {Array} centers 2D Array of centers
+   * @return {Neighbors} Index of the nearest center to each location, and the
+   * distance to it
+   *
+   * ```
+   * let plane = new Position([[0, 0], [5, 5], [1, 1]]);
+   * plane.assign([[0, 1], [6, 6]]); // => { indices: [0, 1, 0], ... }
+   * ```
+   */
+  assign(centers: Array<Array<number>>): Neighbors {
+    return this.native(() =>
+      CLIB.assign(this.points, centers, this.metric, false),
+    );
+  }
+
+  /**
+   * Calculates the geometric center of the Position, under the configured
+   * `metric`. A custom matrix only relates the locations themselves, so the
+   * center is measured euclidean under it.
    *
    * @name Position#center
    * @see https://stackoverflow.com/a/12934484
@@ -138,12 +469,27 @@ class Position {
    * ```
    */
   get center(): Array<number> {
-    return CLIB.geometric(
-      this.locations,
-      this.options.subsearch,
-      this.options.epsilon,
-      this.options.bounds,
-    ).center;
+    return this.geometric(false).center;
+  }
+
+  /**
+   * Calculates the geometric center as Position#center does, within the
+   * `deadlineMs` and `maxIterations` options, and reports how far the search
+   * got: whether a limit stopped it (`partial`), the steps it took, and the
+   * step size it reached (`precision`), which is below `epsilon` once the
+   * search is complete.
+   *
+   * @name Position#anytimeCenter
+   * @function
+   * @return {AnytimeCenter} The center, its cost, and how far the search got
+   *
+   * ```
+   * let plane = new Position([[0, 0], [0, 1], [1, 0]], { maxIterations: 2 });
+   * plane.anytimeCenter().partial; // => true
+   * ```
+   */
+  anytimeCenter(): AnytimeCenter {
+    return this.geometric(false);
   }
 
   /**
@@ -160,15 +506,31 @@ class Position {
    * ```
    */
   get mean(): Array<number> {
-    return CLIB.mean(this.locations).center;
+    return this.native(() => CLIB.mean(this.points, false)).center;
   }
 
   /**
    * Returns the index order of the least-costly path between all locations on
-   * the plane through a solution of the TSP (~80 point efficiency).
+   * the plane through a solution of the TSP. The path is optimal for up to 20
+   * locations, near-optimal up to 40, and a nearest-neighbour approximation
+   * improved by 2-opt beyond that.
+   *
+   * The path starts at `startIndex`. With the `tour` option, it ends anywhere
+   * (`'open'`, the default), returns to the start (`'closed'`), or ends at
+   * `endIndex` (`'fixed'`).
+   *
+   * With the `approximate` option, the locations are instead travelled in
+   * their order along a Hilbert curve, improved by 2-opt between nearby
+   * locations. The path comes back in O(n log n) time without a cost matrix,
+   * typically within 25% of optimal, for sets too large to solve otherwise.
+   *
+   * Distance is euclidean unless the `metric` option names `'l1'`,
+   * `'haversine'` (kilometers between `[latitude, longitude]` degrees), or
+   * `'matrix'`, which reads `costMatrix`: a `Float64Array` whose entry
+   * `i * n + j` is the cost of travelling from location `i` to location `j`,
+   * and which throws a RangeError unless it has `n * n` entries.
    *
    * @name Position#bestPath
-   * @TODO More involved TSP solution (figure out or-tools bindings)
    * @function
    * @return {Array} Order of indeces of the locations on the plane that gives
    * the shortest path
@@ -179,16 +541,53 @@ class Position {
    * ```
    */
   get bestPath(): Array<number> {
-    return CLIB.tsp(this.locations, this.options.startIndex, Method['tsp']);
+    return this.solveTour(this.metric, false).order;
+  }
+
+  /**
+   * Calculates the cost of travelling Position#bestPath, including the return
+   * to the start of a closed tour.
+   *
+   * @name Position#bestPathCost
+   * @function
+   * @return {number} Cost of travelling
+   *
+   * ```
+   * let plane = new Position([[0, 0], [3, 4], [3, 0]], { tour: 'closed' });
+   * plane.bestPathCost; // => 12
+   * ```
+   */
+  get bestPathCost(): number {
+    return this.solveTour(this.metric, false).cost;
+  }
+
+  /**
+   * Solves Position#bestPath within the `deadlineMs` and `maxIterations`
+   * options, and reports how far the solver got: whether a limit stopped it
+   * (`partial`), the improvements it made, and the relative gap between the
+   * cost and a lower bound on the optimal cost (`precision`). The gap is 0 for
+   * a tour proven optimal, and not a number for an `approximate` tour, which
+   * has no bound.
+   *
+   * @name Position#anytimePath
+   * @function
+   * @return {AnytimePath} The order, its cost, and how far the solver got
+   *
+   * ```
+   * let plane = new Position([[0, 0], [5, 10], [3, 4]], { deadlineMs: 50 });
+   * plane.anytimePath(); // => { order: [0, 2, 1], precision: 0, ... }
+   * ```
+   */
+  anytimePath(): AnytimePath {
+    return this.solveTour(this.metric, false, true);
   }
 
   /**
    * Returns the index order of the least-costly manhattan-style drive between
-   * all locations on the plane through a solution of the VRP (~80 point
-   * efficiency).
+   * all locations on the plane, honoring the same `tour` options as
+   * Position#bestPath.
    *
    * @name Position#quickPath
-   * @TODO More involved VRP solution (figure out or-tools bindings)
    * @function
    * @return {Array} Order of indeces of the locations on the plane that gives
    * the shortest manhattan path
@@ -199,11 +598,85 @@ class Position {
    * ```
    */
   get quickPath() {
-    return CLIB.tsp(
-      this.locations,
-      this.options.startIndex,
-      Method['naiveVrp'],
-    );
+    return this.solveTour(Method['naiveVrp'], false).order;
+  }
+
+  /**
+   * Calculates the cost of travelling Position#quickPath, including the return
+   * to the start of a closed tour.
+   *
+   * @name Position#quickPathCost
+   * @function
+   * @return {number} Cost of travelling
+   *
+   * ```
+   * let plane = new Position([[0, 0], [3, 4], [3, 0]], { tour: 'closed' });
+   * plane.quickPathCost; // => 14
+   * ```
+   */
+  get quickPathCost(): number {
+    return this.solveTour(Method['naiveVrp'], false).cost;
+  }
+
+  /**
+   * Returns the index order of a tour of the locations under the configured
+   * `metric` and `tour` options (a custom matrix measures euclidean), kept up
+   * to date by Position#addStop, Position#removeStop, Position#add,
+   * Position#remove, and Position#move instead of being solved again. The
+   * tour is solved as Position#bestPath on first use, and again when the
+   * locations are replaced or changed otherwise.
+   *
+   * @name Position#path
+   * @function
+   * @return {Array} Order of indeces of the locations on the plane
+   *
+   * ```
+   * let plane = new Position([[0, 0], [5, 10], [3, 4]]);
+   * plane.path; // => [0, 2, 1]
+   * plane.add([4, 7]);
+   * plane.path; // => [0, 2, 3, 1]
+   * ```
+   */
+  get path(): Array<number> {
+    return this.liveTour.order(false);
+  }
+
+  /**
+   * Calculates the cost of travelling Position#path, including the return to
+   * the start of a closed tour.
+   *
+   * @name Position#pathCost
+   * @function
+   * @return {number} Cost of travelling
+   */
+  get pathCost(): number {
+    return this.liveTour.cost();
+  }
+
+  /**
+   * Routes a fleet of capacitated vehicles between all locations on the plane,
+   * manhattan-style, through a solution of the VRP. Every route starts and
+   * ends at the location at `startIndex`, which is left out of the routes.
+   * A configured `metric`, or a `costMatrix`, replaces the manhattan distance.
+   * Stops without a demand take up no capacity, and capacities default to
+   * unlimited. An array of capacities needs one for each vehicle, and each
+   * capacity must be at least 0; `Infinity` leaves a vehicle unlimited.
+   *
+   * @name Position#vrp
+   * @function
+   * @param {FleetOptions} fleet Number of vehicles, their capacities, and the
+   * demand of each location
+   * @return {FleetRoutes} The ordered stops of each vehicle, the stops no
+   * vehicle had room for, and the total cost of the routes
+   *
+   * ```
+   * let plane = new Position([[0, 0], [1, 0], [2, 0], [0, 1], [0, 2]]);
+   * plane.vrp({ vehicles: 2, capacities: 2, demands: [0, 1, 1, 1, 1] });
+   * // => { routes: [[1, 2], [3, 4]], unserved: [], cost: 8 }
+   * ```
+   */
+  vrp(fleet: FleetOptions): FleetRoutes {
+    return this.routeFleet(fleet, false);
   }
 
   /**
@@ -222,11 +695,92 @@ class Position {
    * ```
    */
   get polynomial(): Array<number> {
-    return CLIB.bestFit(this.locations, this.options.degree);
+    return this.native(() =>
+      CLIB.bestFit(this.points, this.options.degree, false),
+    );
+  }
+
+  /**
+   * Fits a polynomial to the locations on the plane that resists outliers,
+   * such as GPS fixes that jumped. `huber` and `tukey` reweigh each location
+   * by its residual until the fit settles, `tukey` ignoring gross outliers
+   * altogether; `ransac` keeps the fit through random samples that most
+   * locations agree with, trying samples in parallel until it is 99% sure to
+   * have drawn one free of outliers. Without a `threshold`, outliers are told
+   * apart by the median residual, which tolerates up to half of the
+   * locations being outliers; with one, `ransac` tolerates far more. Degree
+   * is specified during class instantiation, and is auto-calculated by
+   * default.
+   *
+   * @name Position#robustPolynomial
+   * @function
+   * @param {RobustFitOptions} [fit] Method, the residual beyond which a
+   * location is an outlier, the most rounds or trials, and a budget in
+   * milliseconds after which the best fit so far is returned
+   * @return {RobustFit} Coefficients of the fit, where each index corresponds
+   * to its degree, 1 for each inlier and 0 for each outlier, the number of
+   * inliers, and how far the fit got: whether the budget stopped it
+   * (`partial`), the rounds or trials it took, and as its `precision` the
+   * relative movement of the coefficients in the last round, or for `ransac`
+   * the chance that no trial was free of outliers
+   *
+   * ```
+   * let plane = new Position([[0, 1], [1, 2], [2, 5], [3, 40], [4, 17]], {
+   *   degree: 2,
+   * });
+   * plane.robustPolynomial({ method: 'ransac', threshold: 0.5 }).count;
+   * // => 4
+   * ```
+   */
+  robustPolynomial(fit: RobustFitOptions = {}): RobustFit {
+    return this.native(() =>
+      CLIB.robustFit(
+        this.points,
+        this.options.degree,
+        FitMethod[fit.method] || FitMethod['huber'],
+        fit.threshold || 0,
+        fit.iterations || 0,
+        fit.budget || 0,
+      ),
+    );
+  }
+
+  /**
+   * Evaluates the best-fit polynomial of the locations at each of a set of x
+   * coordinates, and optionally its first and second derivatives. Results are
+   * written into the arrays given, so evaluating over the same grid again
+   * allocates nothing; large grids are split across threads.
+   *
+   * @name Position#evaluate
+   * @function
+   * @param {Float64Array} xs Coordinates to evaluate at
+   * @param {Float64Array} [values] Filled with the value at each coordinate
+   * @param {Float64Array} [first] Filled with the first derivative
+   * @param {Float64Array} [second] Filled with the second derivative
+   * @return {Float64Array} The values
+   *
+   * ```
+   * let plane = new Position([[0, 1], [1, 2], [3, 10]]); // y = 1 + x^2
+   * const slopes = new Float64Array(2);
+   * plane.evaluate(new Float64Array([0, 2]), undefined, slopes); // => [1, 5]
+   * slopes; // => [0, 4]
+   * ```
+   */
+  evaluate(
+    xs: Float64Array,
+    values: Float64Array = new Float64Array(xs.length),
+    first?: Float64Array,
+    second?: Float64Array,
+  ): Float64Array {
+    const coeffs = this.typedPolynomial;
+    return this.native(() =>
+      CLIB.evalPolynomial(coeffs, xs, values, first, second),
+    );
   }
 
   /**
-   * Calculates the net cost of travelling from the points to their mean.
+   * Calculates the net cost of travelling from the points to their mean,
+   * under the configured metric.
    *
    * @name Position#meanCost
    * @function
@@ -238,7 +792,8 @@ class Position {
    * ```
    */
   get meanCost(): number {
-    return CLIB.mean(this.locations).score;
+    return this.native(() => CLIB.mean(this.points, false, this.metric))
+      .score;
   }
 
   /**
@@ -255,12 +810,107 @@ class Position {
    * ```
    */
   get centerCost(): number {
-    return CLIB.geometric(
-      this.locations,
-      this.options.subsearch,
-      this.options.epsilon,
-      this.options.bounds,
-    ).score;
+    return this.geometric(false).score;
+  }
+
+  /**
+   * Calculates the minimax center of the Position, under the configured
+   * `metric`: the point whose greatest distance to any location is least, such
+   * as a depot that minimizes the longest trip out. A custom matrix measures
+   * euclidean, and haversine locations should lie within a hemisphere.
+   *
+   * @name Position#minimaxCenter
+   * @function
+   * @return {Array} Minimax center of the Position
+   *
+   * ```
+   * let plane = new Position([[0, 0], [4, 0], [0, 4], [1, 1]]);
+   * plane.minimaxCenter; // => [2, 2]
+   * ```
+   */
+  get minimaxCenter(): Array<number> {
+    return this.minimax().center;
+  }
+
+  /**
+   * Calculates the greatest cost of travelling from the minimax center to any
+   * of the points: the radius of the smallest circle enclosing them.
+   *
+   * @name Position#minimaxCost
+   * @function
+   * @return {number} Cost of the longest trip
+   *
+   * ```
+   * let plane = new Position([[0, 0], [4, 0], [0, 4], [1, 1]]);
+   * plane.minimaxCost; // => 2.8284271247461903
+   * ```
+   */
+  get minimaxCost(): number {
+    return this.minimax().score;
+  }
+
+  /**
+   * Finds the medoid of the Position, under the configured `metric`: the
+   * location whose net cost of travelling from the others is least, for when
+   * the meeting point must be one of the locations, such as a venue. The
+   * result is exact, though only a few locations are usually measured against
+   * all the others. A custom matrix is summed directly.
+   *
+   * @name Position#medoid
+   * @function
+   * @return {Medoid} Index of the medoid, its location, and the net cost of
+   * travelling to it
+   *
+   * ```
+   * let plane = new Position([[0, 0], [1, 0], [2, 0], [10, 0], [11, 0]]);
+   * plane.medoid(); // => { index: 2, location: [2, 0], cost: 20 }
+   * ```
+   */
+  medoid(): Medoid {
+    return this.native(() =>
+      CLIB.medoid(
+        this.points,
+        this.options.subsearch,
+        this.options.epsilon,
+        this.options.bounds,
+        this.metric,
+        this.options.costMatrix,
+        this.options.deadlineMs,
+        this.options.maxIterations,
+      ),
+    );
+  }
+
+  /**
+   * Summarizes the locations in one native call, which reads them once: the
+   * Position#mean and Position#center with their costs, the
+   * Position#geometricSignificance, and the bounding box and variance of the
+   * locations in each dimension. Prefer it to reading several of those getters,
+   * which each call into native code on their own.
+   *
+   * @name Position#summary
+   * @function
+   * @return {Summary} `mean`, `meanCost`, `center`, `centerCost`,
+   * `significance`, and the `min`, `max`, and `variance` in each dimension
+   *
+   * ```
+   * let plane = new Position([[0, 0], [2, 0], [0, 2]]);
+   * plane.summary().max; // => [2, 2]
+   * ```
+   */
+  summary(): Summary {
+    return this.native(() =>
+      CLIB.summary(
+        this.points,
+        this.options.subsearch,
+        this.options.epsilon,
+        this.options.bounds,
+        this.metric,
+        this.options.costMatrix,
+        this.options.deadlineMs,
+        this.options.maxIterations,
+      ),
+    );
   }
 
   /**
@@ -277,8 +927,332 @@ class Position {
    * ```
    */
   get geometricSignificance(): number {
-    const [mean, center] = [this.meanCost, this.centerCost];
-    return (mean - center) / mean;
+    return this.summary().significance;
+  }
+
+  /**
+   * Position#center as a Float64Array over native memory.
+   *
+   * The `typed*` members give the results of their namesakes as typed arrays
+   * the native library hands over without copying, rather than as Arrays
+   * built an element at a time. Prefer them for large results.
+   *
+   * @name Position#typedCenter
+   * @function
+   * @return {Float64Array} Geometric center of the Position
+   */
+  get typedCenter(): Float64Array {
+    return this.geometric(true).center;
+  }
+
+  /**
+   * Position#mean as a Float64Array over native memory.
+   *
+   * @name Position#typedMean
+   * @function
+   * @return {Float64Array} Mean of the Position
+   */
+  get typedMean(): Float64Array {
+    return this.native(() => CLIB.mean(this.points, true)).center;
+  }
+
+  /**
+   * Position#bestPath as a Uint32Array over native memory.
+   *
+   * @name Position#typedBestPath
+   * @function
+   * @return {Uint32Array} Order of indeces of the locations on the plane that
+   * gives the shortest path
+   */
+  get typedBestPath(): Uint32Array {
+    return this.solveTour(this.metric, true).order;
+  }
+
+  /**
+   * Position#quickPath as a Uint32Array over native memory.
+   *
+   * @name Position#typedQuickPath
+   * @function
+   * @return {Uint32Array} Order of indeces of the locations on the plane that
+   * gives the shortest manhattan path
+   */
+  get typedQuickPath(): Uint32Array {
+    return this.solveTour(Method['naiveVrp'], true).order;
+  }
+
+  /**
+   * Position#vrp with each route, and the unserved stops, as Uint32Arrays
+   * over native memory.
+   *
+   * @name Position#typedVrp
+   * @function
+   * @param {FleetOptions} fleet Number of vehicles, their capacities, and the
+   * demand of each location
+   * @return {TypedFleetRoutes} The ordered stops of each vehicle, the stops no
+   * vehicle had room for, and the total cost of the routes
+   */
+  typedVrp(fleet: FleetOptions): TypedFleetRoutes {
+    return this.routeFleet(fleet, true);
+  }
+
+  /**
+   * Position#polynomial as a Float64Array over native memory.
+   *
+   * @name Position#typedPolynomial
+   * @function
+   * @return {Float64Array} Coefficients of a best-fit polynomial, where each
+   * index corresponds to its degree
+   */
+  get typedPolynomial(): Float64Array {
+    return this.native(() =>
+      CLIB.bestFit(this.points, this.options.degree, true),
+    );
+  }
+
+  /**
+   * Solves the TSP over the locations with the configured tour shape.
+   *
+   * @private
+   * @param {number} method Method code selecting the norm
+   * @param {boolean} typed Whether to return the order as a Uint32Array
+   * @param {boolean} [reported=false] Whether to report how far the solver
+   * got, which bounds the optimal cost in another pass
+   * @return {Object} Order of indeces to travel, and the cost of travelling
+   */
+  private solveTour(
+    method: number,
+    typed: boolean,
+    reported: boolean = false,
+  ) {
+    return this.native(() =>
+      CLIB.tsp(
+        this.points,
+        this.options.startIndex,
+        method,
+        TourType[this.options.tour] || TourType['open'],
+        this.options.endIndex,
+        this.options.costMatrix,
+        typed,
+        this.options.approximate,
+        this.options.deadlineMs,
+        this.options.maxIterations,
+        reported,
+      ),
+    );
+  }
+
+  /**
+   * Finds the geometric center of the locations.
+   *
+   * @private
+   * @param {boolean} typed Whether to return the center as a Float64Array
+   * @return {Object} Geometric center, and the net cost of travelling to it
+   */
+  private geometric(typed: boolean) {
+    return this.native(() =>
+      CLIB.geometric(
+        this.points,
+        this.options.subsearch,
+        this.options.epsilon,
+        this.options.bounds,
+        this.metric,
+        this.options.costMatrix,
+        typed,
+        this.options.deadlineMs,
+        this.options.maxIterations,
+      ),
+    );
+  }
+
+  /**
+   * Finds the minimax center of the locations.
+   *
+   * @private
+   * @return {Object} Minimax center, and the greatest distance to it
+   */
+  private minimax() {
+    return this.native(() => CLIB.minimax(this.points, this.metric, false));
+  }
+
+  /**
+   * Routes a fleet of vehicles between the locations.
+   *
+   * @private
+   * @param {FleetOptions} fleet Number of vehicles, their capacities, and the
+   * demand of each location
+   * @param {boolean} typed Whether to return routes as Uint32Arrays
+   * @return {Object} Routes, unserved stops, and the total cost of the routes
+   */
+  private routeFleet(fleet: FleetOptions, typed: boolean) {
+    const capacities =
+      fleet.capacities === undefined ? Infinity : fleet.capacities;
+    const configured = this.options.metric || this.options.costMatrix;
+    return this.native(() =>
+      CLIB.vrp(
+        this.points,
+        fleet.vehicles,
+        capacities,
+        fleet.demands || [],
+        this.options.startIndex,
+        configured ? this.metric : Method['naiveVrp'],
+        this.options.costMatrix,
+        typed,
+      ),
+    );
+  }
+
+  /**
+   * Makes a call into the native library. With the `stats` option, the stats
+   * the call collected are kept in Position#stats.
+   *
+   * @private
+   * @param {Function} call Call into the native library
+   * @return {*} Result of the call
+   */
+  private native<T>(call: () => T): T {
+    if (!this.options.stats) {
+      return call();
+    }
+    const wasEnabled = CLIB.setStats(true);
+    try {
+      return call();
+    } finally {
+      this.stats = CLIB.stats();
+      CLIB.setStats(wasEnabled);
+    }
+  }
+
+  /**
+   * The spatial index, if one is built and still describes the locations, to
+   * be kept up to date by an edit. An index left behind by replaced or
+   * resized locations is dropped, so the next query builds it again.
+   *
+   * @private
+   * @return {CLIB.SpatialIndex} Index over the locations, or null
+   */
+  private get keptIndex() {
+    if (
+      this.index &&
+      (this.indexed !== this.points || this.index.size() !== this.size)
+    ) {
+      this.index = null;
+    }
+    return this.index;
+  }
+
+  /**
+   * The tour, if one is solved and still describes the locations, to be kept
+   * up to date by an edit. A tour left behind by replaced or resized
+   * locations is dropped, so the next Position#path solves it again.
+   *
+   * @private
+   * @return {CLIB.Tour} Tour of the locations, or null
+   */
+  private get keptTour() {
+    if (
+      this.tour &&
+      (this.toured !== this.points || this.tour.size() !== this.size)
+    ) {
+      this.tour = null;
+    }
+    return this.tour;
+  }
+
+  /**
+   * Native spatial index over the locations, rebuilt when the locations are
+   * replaced or changed outside of Position#add, Position#remove, and
+   * Position#move, or when the metric changes.
+   *
+   * @private
+   * @return {CLIB.SpatialIndex} Index over the locations
+   */
+  private get spatialIndex() {
+    const metric = this.metric;
+    const points = this.points;
+    if (
+      !this.index ||
+      this.indexed !== points ||
+      this.indexMetric !== metric ||
+      this.index.size() !== this.size
+    ) {
+      this.index = new CLIB.SpatialIndex(points, metric);
+      this.indexed = points;
+      this.indexMetric = metric;
+    }
+    return this.index;
+  }
+
+  /**
+   * Native tour of the locations, solved again when the locations are
+   * replaced or changed outside of Position#addStop, Position#removeStop,
+   * Position#add, Position#remove, and Position#move, or when the metric or
+   * shape of the tour changes.
+   *
+   * @private
+   * @return {CLIB.Tour} Tour of the locations
+   */
+  private get liveTour() {
+    const points = this.points;
+    const { startIndex, endIndex, tour, approximate } = this.options;
+    const shape = [this.metric, tour, startIndex, endIndex, approximate].join();
+    if (
+      !this.tour ||
+      this.toured !== points ||
+      this.tourShape !== shape ||
+      this.tour.size() !== this.size
+    ) {
+      this.tour = this.native(
+        () =>
+          new CLIB.Tour(
+            points,
+            startIndex,
+            this.metric,
+            TourType[tour] || TourType['open'],
+            endIndex,
+            approximate,
+          ),
+      );
+      this.toured = points;
+      this.tourShape = shape;
+    }
+    return this.tour;
+  }
+
+  /**
+   * Number of locations, read from the point file of a Position created by
+   * Position.fromFile until its locations are accessed.
+   *
+   * @private
+   * @return {number} Number of locations
+   */
+  private get size(): number {
+    return this.file ? this.file.size() : this.locations.length;
+  }
+
+  /**
+   * Points handed to native calls: the point file of a Position created by
+   * Position.fromFile until its locations are accessed, or else the
+   * locations.
+   *
+   * @private
+   * @return {*} PointFile or 2D Array of points
+   */
+  private get points(): any {
+    return this.file || this.locations;
+  }
+
+  /**
+   * Code of the configured distance metric. A `costMatrix` selects the custom
+   * matrix metric unless another metric is named.
+   *
+   * @private
+   * @return {number} Metric code
+   */
+  private get metric(): number {
+    if (!this.options.metric && this.options.costMatrix) {
+      return Metric['matrix'];
+    }
+    return Metric[this.options.metric] || Metric['l2'];
   }
 }
 